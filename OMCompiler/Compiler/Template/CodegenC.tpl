@@ -195,6 +195,7 @@ end translateModel;
     <%if Flags.isSet(Flags.PARMODAUTO) then "#include \"ParModelica/auto/om_pm_interface.hpp\""%>
 
     <%if stringEq(getConfigString(HPCOM_CODE),"pthreads_spin") then "#include \"util/omc_spinlock.h\""%>
+    <%if stringEq(getConfigString(HPCOM_SCHEDULER),"adapt") then "#include \"simulation/solver/hpcom_adaptive.h\""%>
 
     <%if Flags.isSet(HPCOM) then "#define HPCOM"%>
 
@@ -1052,6 +1053,7 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
 
     <%simulationFileHeader(simCode.fileNamePrefix)%>
     #include "simulation/solver/events.h"
+    #include "simulation/results/simulation_result_memory.h"
 
     <% if stringEq("",isModelExchangeFMU) then
     <<
@@ -1175,8 +1177,8 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
     #if defined(threadData)
     #undef threadData
     #endif
-    /* call the simulation runtime main from our main! */
-    int main(int argc, char**argv)
+    /* run one simulation, the memory management has to be initialized by the caller */
+    static int <%symbolName(modelNamePrefixStr,"runSimulation")%>(int argc, char**argv)
     {
       int res;
       DATA data;
@@ -1187,8 +1189,16 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
       measure_time_flag = <% if profileHtml() then "5" else if profileSome() then "1" else if profileAll() then "2" else "0" /* Would be good if this was not a global variable...*/ %>;
       compiledInDAEMode = <% if Flags.getConfigBool(Flags.DAE_MODE) then 1 else 0%>;
       compiledWithSymSolver = <% intSub(Flags.getConfigEnum(Flags.SYM_SOLVER), 0) %>;
-      <%mainInit%>
       <%mainTop(mainBody,"https://trac.openmodelica.org/OpenModelica/newticket")%>
+      return res;
+    }
+
+    /* call the simulation runtime main from our main! */
+    int main(int argc, char**argv)
+    {
+      int res;
+      <%mainInit%>
+      res = <%symbolName(modelNamePrefixStr,"runSimulation")%>(argc, argv);
 
       <%if Flags.isSet(HPCOM) then "terminateHpcOmThreads();" %>
       <%if Flags.isSet(Flags.PARMODAUTO) then "dump_times();" %>
@@ -1197,6 +1207,20 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
       return res;
     }
 
+    /* Entry point of the model built as shared library (see simulateInMemory in omc): runs one
+     * simulation in the calling process, which has already initialized the memory management,
+     * and stores the emitted points in result instead of a result file.
+     * The simulation runtime has global state, so only one simulation may run at a time.
+     */
+    DLLExport int omc_simulateInMemory(int argc, char**argv, SIMULATION_MEMORY_RESULT *result)
+    {
+      int res;
+      sim_memory_result = result;
+      res = <%symbolName(modelNamePrefixStr,"runSimulation")%>(argc, argv);
+      sim_memory_result = NULL;
+      return res;
+    }
+
     #ifdef __cplusplus
     }
     #endif
@@ -3371,6 +3395,7 @@ template functionXXX_system_HPCOM(list<SimEqSystem> derivativEquations, String n
       <%functionXXX_system(derivativEquations,name,n,modelNamePrefixStr)%>
       >>
     case SOME((hpcOmSchedule as TASKDEPSCHEDULE(__),_,_)) then
+      if stringEq(getConfigString(HPCOM_SCHEDULER),"adapt") then functionXXX_system_HPCOM_Adaptive(hpcOmSchedule.tasks, derivativEquations, name, n, modelNamePrefixStr) else
       let taskEqs = functionXXX_system0_HPCOM_TaskDep(hpcOmSchedule.tasks, derivativEquations, type, name, modelNamePrefixStr); separator="\n"
       <<
       void terminateHpcOmThreads()
@@ -3631,6 +3656,138 @@ template functionXXX_system0_HPCOM_TaskDep(list<tuple<Task,list<Integer>>> tasks
   >>
 end functionXXX_system0_HPCOM_TaskDep;
 
+template functionXXX_system_HPCOM_Adaptive(list<tuple<Task,list<Integer>>> tasks, list<SimEqSystem> derivativEquations, String name, Integer n, String modelNamePrefixStr)
+"Generates the tasks of the system and an OpenMP region that executes them in the order of the
+ adaptive list schedule (see simulation/solver/hpcom_adaptive.h). The tasks are topologically
+ sorted and the parents are given as positions in the task list."
+::=
+  let prefix = 'function<%name%>_system<%n%>'
+  let taskFuncs = tasks |> t hasindex i0 fromindex 0 => functionXXX_system0_HPCOM_AdaptiveTask(t, i0, derivativEquations, prefix, modelNamePrefixStr); separator="\n"
+  let taskNames = tasks |> t hasindex i0 fromindex 0 => '<%prefix%>_task<%i0%>'; separator=",\n"
+  let nParents = tasks |> (_,parents) => listLength(parents); separator=", "
+  let parentIdx = tasks |> (_,parents) => (parents |> p => '<%p%>, ')
+  let nEqs = tasks |> (task as CALCTASK(__),_) => listLength(task.eqIdc); separator=", "
+  let eqIdx = tasks |> (task as CALCTASK(__),_) => (task.eqIdc |> eq => '<%eq%>, ')
+  let costs = tasks |> (task as CALCTASK(__),_) => task.calcTime; separator=", "
+  let nThreads = getConfigInt(NUM_PROC)
+  <<
+  /* using type: openmp, adaptive list schedule */
+  <%taskFuncs%>
+
+  static const HPCOM_TASK_FUNCTION <%prefix%>_tasks[<%listLength(tasks)%>] = {
+    <%taskNames%>
+  };
+  static const int <%prefix%>_nParents[<%listLength(tasks)%>] = {<%nParents%>};
+  static const int <%prefix%>_parentIdx[] = {<%parentIdx%>-1};
+  static const int <%prefix%>_nEqs[<%listLength(tasks)%>] = {<%nEqs%>};
+  static const int <%prefix%>_eqIdx[] = {<%eqIdx%>-1};
+  static const double <%prefix%>_costs[<%listLength(tasks)%>] = {<%costs%>};
+  static HPCOM_ADAPTIVE_SCHEDULE <%prefix%>_schedule;
+  static int <%prefix%>_initialized = 0;
+
+  void terminateHpcOmThreads()
+  {
+    if(<%prefix%>_initialized)
+    {
+      if(HPCOM_ADAPTIVE_MEASURING(&<%prefix%>_schedule))
+        hpcom_adaptive_write_profile(&<%prefix%>_schedule);
+      hpcom_adaptive_free(&<%prefix%>_schedule);
+      <%prefix%>_initialized = 0;
+    }
+  }
+
+  void <%prefix%>(DATA *data, threadData_t *threadData)
+  {
+    HPCOM_ADAPTIVE_SCHEDULE *schedule = &<%prefix%>_schedule;
+    if(!<%prefix%>_initialized)
+    {
+      hpcom_adaptive_init(schedule, data, <%listLength(tasks)%>, <%nThreads%>, <%prefix%>_tasks, <%prefix%>_nParents, <%prefix%>_parentIdx, <%prefix%>_nEqs, <%prefix%>_eqIdx, <%prefix%>_costs);
+      <%prefix%>_initialized = 1;
+    }
+    hpcom_adaptive_begin_evaluation(schedule);
+    omp_set_dynamic(0);
+    #pragma omp parallel num_threads(<%nThreads%>)
+    {
+      const int thread = omp_get_thread_num();
+      const int active = schedule->active;
+      const long evaluation = schedule->evaluation;
+      const int measuring = HPCOM_ADAPTIVE_MEASURING(schedule);
+      int i, j, task, failed = 0, threadFail = 0;
+      long done;
+      double start = 0.0;
+      MMC_TRY_TOP()
+      if(omp_get_num_threads() != schedule->nThreads)
+      {
+        /* fewer threads than scheduled, evaluate the tasks in topological order */
+        if(thread == 0)
+        {
+          for(task=0; task<schedule->nTasks; task++)
+          {
+            if(measuring)
+              start = omp_get_wtime();
+            schedule->taskFunctions[task](data, threadData);
+            if(measuring)
+              schedule->taskTime[task] += omp_get_wtime() - start;
+          }
+        }
+      }
+      else
+      {
+        for(i=schedule->threadTaskPtr[active][thread]; i<schedule->threadTaskPtr[active][thread+1] && !failed; i++)
+        {
+          task = schedule->threadTasks[active][i];
+          for(j=schedule->parentPtr[task]; j<schedule->parentPtr[task+1] && !failed; j++)
+          {
+            do
+            {
+              #pragma omp atomic read
+              done = schedule->taskDone[schedule->parentIdx[j]];
+              #pragma omp atomic read
+              failed = schedule->failed;
+            } while(done != evaluation && !failed);
+          }
+          if(failed)
+            break;
+          #pragma omp flush
+          if(measuring)
+            start = omp_get_wtime();
+          schedule->taskFunctions[task](data, threadData);
+          if(measuring)
+            schedule->taskTime[task] += omp_get_wtime() - start;
+          #pragma omp flush
+          #pragma omp atomic write
+          schedule->taskDone[task] = evaluation;
+        }
+      }
+      MMC_CATCH_TOP(threadFail=1)
+      if(threadFail)
+      {
+        #pragma omp atomic write
+        schedule->failed = 1;
+      }
+    }
+    if(schedule->failed)
+    {
+      MMC_THROW_INTERNAL()
+    }
+    hpcom_adaptive_end_evaluation(schedule);
+  }
+  >>
+end functionXXX_system_HPCOM_Adaptive;
+
+template functionXXX_system0_HPCOM_AdaptiveTask(tuple<Task,list<Integer>> taskIn, Integer idx, list<SimEqSystem> derivativEquations, String prefix, String modelNamePrefixStr)
+::=
+  match taskIn
+    case ((task as CALCTASK(__),_)) then
+      let taskEqs = function_HPCOM_Task(derivativEquations, prefix, task, "openmp", modelNamePrefixStr)
+      <<
+      static void <%prefix%>_task<%idx%>(DATA *data, threadData_t *threadData)
+      {
+        <%taskEqs%>
+      }
+      >>
+end functionXXX_system0_HPCOM_AdaptiveTask;
+
 template functionXXX_system0_HPCOM_TaskDep0(tuple<Task,list<Integer>> taskIn, list<SimEqSystem> derivativEquations, String iType, String name, String modelNamePrefixStr)
 ::=
   match taskIn
@@ -5511,19 +5668,23 @@ template equationForLoop(SimEqSystem eq, Context context, Text &varDecls, Text &
 match eq
 case SES_FOR_LOOP(__) then
   let &preExp = buffer ""
-  let expPart = daeExp(exp, context, &preExp, &varDecls, &auxFunction)
-  let crefPart = daeExp(crefExp(cref), context, &preExp, &varDecls, &auxFunction)
-  //let bodyStr = daeExpIteratedCref(body)
-  let start = dumpExp(startIt,"\"")
-  let stop = dumpExp(endIt,"\"")
+  let &bodyExp = buffer ""
   let iterVar = daeExp(iter, context, &preExp, &varDecls, &auxFunction)
+  let start = daeExp(startIt, context, &preExp, &varDecls, &auxFunction)
+  let stop = daeExp(endIt, context, &preExp, &varDecls, &auxFunction)
+  let expPart = daeExp(exp, context, &bodyExp, &varDecls, &auxFunction)
+  let crefPart = daeExp(crefExp(cref), context, &bodyExp, &varDecls, &auxFunction)
   <<
   <%modelicaLine(eqInfo(eq))%>
-  modelica_integer  $P<%dumpExp(iter,"\"")%> = 0; // the iterator
-  // the for-equation
-  for($P<%dumpExp(iter,"\"")%> = <%start%>; $P<%dumpExp(iter,"\"")%> != <%stop%>+1; $P<%dumpExp(iter,"\"")%>++)
+  <%preExp%>
   {
-    <%crefPart%> += <%expPart%>;
+    modelica_integer <%iterVar%>; // the iterator
+    // the for-equation
+    for(<%iterVar%> = <%start%>; <%iterVar%> <= <%stop%>; <%iterVar%>++)
+    {
+      <%bodyExp%>
+      <%crefPart%> = <%expPart%>;
+    }
   }
   <%endModelicaLine()%>
   >>
@@ -6231,19 +6392,38 @@ case SIMCODE(modelInfo=MODELINFO(varInfo=varInfo as VARINFO(__)), delayedExps=DE
 
   OFILES=$(CFILES:.c=.o)
   GENERATEDFILES=$(MAINFILE) <%fileNamePrefix%>.makefile <%fileNamePrefix%>_literals.h <%fileNamePrefix%>_functions.h $(CFILES)
+  # CPU time (user and system) of every compiled object, read and removed by omc after the build
+  COMPILETIMES=<%fileNamePrefix%>_compile.times
 
-  .PHONY: omc_main_target clean bundle
+  # Use ccache if available; set CCACHE= to disable it
+  ifeq ($(origin CCACHE),undefined)
+  CCACHE:=$(shell command -v ccache 2>/dev/null)
+  endif
 
-  # This is to make sure that <%fileNamePrefix%>_*.c are always compiled.
-  .PHONY: $(CFILES)
+  .PHONY: omc_main_target omc_shared_library clean bundle
 
   omc_main_target: $(MAINOBJ) <%fileNamePrefix%>_functions.h <%fileNamePrefix%>_literals.h $(OFILES)
   <%\t%>$(CC) -I. -o <%fileNamePrefix%>$(EXEEXT) $(MAINOBJ) $(OFILES) $(CPPFLAGS) $(DIREXTRA) <%libsPos1%> <%libsPos2%> $(CFLAGS) $(CPPFLAGS) $(LDFLAGS)
   <% if stringEq(Config.simCodeTarget(),"JavaScript") then '<%\t%>rm -f <%fileNamePrefix%>'%>
   <% if stringEq(Config.simCodeTarget(),"JavaScript") then '<%\t%>ln -s <%fileNamePrefix%>_node.js <%fileNamePrefix%>'%>
   <% if stringEq(Config.simCodeTarget(),"JavaScript") then '<%\t%>chmod +x <%fileNamePrefix%>_node.js'%>
+
+  # The model as shared library that omc loads to run simulations in its own process, see simulateInMemory
+  omc_shared_library: <%fileNamePrefix%>_shared$(DLLEXT)
+
+  <%fileNamePrefix%>_shared$(DLLEXT): $(MAINOBJ) <%fileNamePrefix%>_functions.h <%fileNamePrefix%>_literals.h $(OFILES)
+  <%\t%>$(CC) -shared -I. -o $@ $(MAINOBJ) $(OFILES) $(CPPFLAGS) $(DIREXTRA) <%libsPos1%> <%libsPos2%> $(CFLAGS) $(CPPFLAGS) $(LDFLAGS)
+
+  # The generated files are only rewritten if their contents change, so only changed files
+  # (or files including changed headers, see the .d files) are compiled again.
+  # The makefile itself is a prerequisite since it contains the compiler flags.
+  %.o: %.c <%fileNamePrefix%>.makefile
+  <%\t%>$(CCACHE) $(CC) $(CFLAGS) $(CPPFLAGS) -MMD -MP -c -o $@ $< && { times > $@.time; sed -n '2s|^|$@ |p' $@.time <%">>"%> $(COMPILETIMES); rm -f $@.time; }
+
+  -include $(MAINOBJ:.o=.d) $(OFILES:.o=.d)
+
   clean:
-  <%\t%>@rm -f <%fileNamePrefix%>_records.o $(MAINOBJ)
+  <%\t%>@rm -f <%fileNamePrefix%>_records.o $(MAINOBJ) $(MAINOBJ:.o=.d) $(OFILES:.o=.d)
 
   bundle:
   <%\t%>@tar -cvf <%fileNamePrefix%>_Files.tar $(GENERATEDFILES)
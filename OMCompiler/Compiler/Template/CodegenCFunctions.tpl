@@ -5203,7 +5203,9 @@ template daeExpCrefRhsSimContext(Exp ecr, Context context, Text &preExp,
       // let cast = typeCastContextInt(context, ty)
       '<%contextCref(cr,context, &auxFunction)%>'
     else if crefIsScalarWithVariableSubs(cr) then
-      let nosubname = contextCref(crefStripSubs(cr),context, &auxFunction)
+      // address the element relative to the first element of the array, which is
+      // a simulation variable also if the array was scalarized
+      let nosubname = contextCref(crefArrayGetFirstCref(crefStripSubs(cr)),context, &auxFunction)
       // let cast = typeCastContextInt(context, ty)
       '(&<%nosubname%>)<%indexSubs(crefDims(cr), crefSubs(crefArrayGetFirstCref(cr)), context, &preExp, &varDecls, &auxFunction)%>'
     else
@@ -5348,7 +5350,7 @@ template daeExpCrefLhsSimContext(Exp ecr, Context context, Text &preExp,
     if crefIsScalarWithAllConstSubs(cr) then
         contextCrefIsPre(cr,context, &auxFunction, isPre)
     else if crefIsScalarWithVariableSubs(cr) then
-      '(&<%contextCrefIsPre(crefStripSubs(cr),context, &auxFunction, isPre)%>)<%indexSubs(crefDims(cr), crefSubs(crefArrayGetFirstCref(cr)), context, &preExp, &varDecls, &auxFunction)%>'
+      '(&<%contextCrefIsPre(crefArrayGetFirstCref(crefStripSubs(cr)),context, &auxFunction, isPre)%>)<%indexSubs(crefDims(cr), crefSubs(crefArrayGetFirstCref(cr)), context, &preExp, &varDecls, &auxFunction)%>'
     else
       error(sourceInfo(),'daeExpCrefLhsSimContext: UNHANDLED CREF: <%ExpressionDumpTpl.dumpExp(ecr,"\"")%>')
 end daeExpCrefLhsSimContext;
@@ -5358,8 +5360,8 @@ template indexSubs(list<Dimension> dims, list<Subscript> subs, Context context,
   if intNe(listLength(dims),listLength(subs)) then
     error(sourceInfo(),'indexSubs got different number of dimensions and subscripts')
   else '[calc_base_index_dims_subs(<%listLength(dims)%><%
-    dims |> dim => ', <%dimension(dim, context, &preExp, &varDecls, &auxFunction)%>'%><%
-    subs |> INDEX(__) => ', <%daeSubscriptExp(exp, context, &preExp, &varDecls, &auxFunction)%>'
+    dims |> dim => ', (_index_t)<%dimension(dim, context, &preExp, &varDecls, &auxFunction)%>'%><%
+    subs |> INDEX(__) => ', (_index_t)<%daeSubscriptExp(exp, context, &preExp, &varDecls, &auxFunction)%>'
     %>)]'
 end indexSubs;
 
@@ -508,6 +508,7 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
 
    <%lastIdentOfPath(modelInfo.name)%>Initialize::<%lastIdentOfPath(modelInfo.name)%>Initialize(<%lastIdentOfPath(modelInfo.name)%>Initialize& instance)
    : <%lastIdentOfPath(modelInfo.name)%>WriteOutput(instance)
+   , _constructedExternalObjects(false)
    {
      InitializeDummyTypeElems();
    }
@@ -3943,6 +3944,8 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
    <%initAlgloop(simCode, &extraFuncs, &extraFuncsDecl, extraFuncsNamespace, eq, context, clockIndex, stateDerVectorName, useFlatArrayNotation)%>
 
    <%queryDensity(simCode , &extraFuncs , &extraFuncsDecl,  extraFuncsNamespace,eq,context, useFlatArrayNotation)%>
+   <%getSparsityPatternCode(simCode, eq)%>
+   <%algloopCopyCode(simCode, eq, context)%>
    <%updateAlgloop(simCode, &extraFuncs, &extraFuncsDecl, extraFuncsNamespace, eq, context, clockIndex, stateDerVectorName, useFlatArrayNotation)%>
    <%updateAlgloopNonLinear(simCode , &extraFuncs , &extraFuncsDecl, extraFuncsNamespace, eq, context, clockIndex, stateDerVectorName, useFlatArrayNotation)%>
 
@@ -3985,6 +3988,106 @@ match simCode
       >>
 end queryDensity;
 
+template getSparsityPatternCode(SimCode simCode, SimEqSystem eqn)
+ "Generates the sparsity pattern of the Jacobian of a nonlinear algloop in compressed sparse column format,
+  it is used by the solvers for colored finite differences."
+::=
+match simCode
+  case SIMCODE(modelInfo = MODELINFO(__)) then
+    let modelname = lastIdentOfPath(modelInfo.name)
+    match eqn
+      case SES_NONLINEAR(nlSystem = nls as NONLINEARSYSTEM(jacobianMatrix = SOME(JAC_MATRIX(sparsity = sparsepattern as _::_)))) then
+        let nnz = lengthListElements(unzipSecond(sparsepattern))
+        if intGt(lengthListElements(unzipSecond(sparsepattern)), 0) then
+          let colNonZeros = (sparsepattern |> (i, indexes) => listLength(indexes) ;separator=",")
+          let rowIndices = (sparsepattern |> (i, indexes) => (indexes |> indexrow => indexrow ;separator=",") ;separator=",")
+          <<
+          bool <%modelname%>Algloop<%nls.index%>::getSparsityPattern(vector<int>& colPtr, vector<int>& rowIndex) const
+          {
+            static const int colNonZeros[<%listLength(sparsepattern)%>] = {<%colNonZeros%>};
+            static const int rowIndices[<%nnz%>] = {<%rowIndices%>};
+            colPtr.assign(1, 0);
+            for (int j = 0; j < <%listLength(sparsepattern)%>; j++)
+              colPtr.push_back(colPtr[j] + colNonZeros[j]);
+            rowIndex.assign(rowIndices, rowIndices + <%nnz%>);
+            return true;
+          }
+          >>
+        else
+          <<
+          bool <%modelname%>Algloop<%nls.index%>::getSparsityPattern(vector<int>& colPtr, vector<int>& rowIndex) const
+          {
+            return false;
+          }
+          >>
+      case SES_NONLINEAR(nlSystem = nls as NONLINEARSYSTEM(__)) then
+        <<
+        bool <%modelname%>Algloop<%nls.index%>::getSparsityPattern(vector<int>& colPtr, vector<int>& rowIndex) const
+        {
+          return false;
+        }
+        >>
+end getSparsityPatternCode;
+
+template algloopCopyCode(SimCode simCode, SimEqSystem eqn, Context context)
+ "Generates createCopy and updateCopy of a nonlinear algloop. The copy evaluates the residuals on its own
+  clone of the system, so that the solvers can compute columns of the Jacobian in parallel."
+::=
+match simCode
+  case SIMCODE(modelInfo = MODELINFO(__), extObjInfo = EXTOBJINFO(__)) then
+    let modelname = lastIdentOfPath(modelInfo.name)
+    match eqn
+      case SES_NONLINEAR(nlSystem = nls as NONLINEARSYSTEM(__)) then
+        let nestedAlgloops = (nls.eqs |> eq =>
+          match eq
+            case SES_LINEAR(__) then "1"
+            case SES_NONLINEAR(__) then "1"
+            case SES_MIXED(__) then "1"
+            else ""
+          ;separator="")
+        let extObjs = (extObjInfo.vars |> var => "1" ;separator="")
+        let unsupported = match context
+          case ALGLOOP_CONTEXT(genJacobian=true) then "1"
+          else '<%nestedAlgloops%><%extObjs%>'
+        if unsupported then
+          <<
+          shared_ptr<INonLinearAlgLoop> <%modelname%>Algloop<%nls.index%>::createCopy()
+          {
+            //nested algloops and external objects are not part of a clone of the system
+            return shared_ptr<INonLinearAlgLoop>();
+          }
+
+          void <%modelname%>Algloop<%nls.index%>::updateCopy(INonLinearAlgLoop* copy)
+          {
+          }
+          >>
+        else
+          <<
+          shared_ptr<INonLinearAlgLoop> <%modelname%>Algloop<%nls.index%>::createCopy()
+          {
+            //variables of an omsu are not stored in the simvars of the system
+            if (_system->_omsu)
+              return shared_ptr<INonLinearAlgLoop>();
+
+            shared_ptr<IMixedSystem> system(dynamic_cast<IMixedSystem*>(_system)->clone());
+            <%modelname%>* copySystem = dynamic_cast<<%modelname%>*>(system.get());
+            copySystem->_discrete_events = copySystem->_event_handling->initialize(copySystem, copySystem->getSimVars());
+            <%modelname%>Algloop<%nls.index%>* copy = new <%modelname%>Algloop<%nls.index%>(copySystem, copySystem->__z, copySystem->__zDot, copySystem->_conditions, copySystem->_discrete_events);
+            copy->_systemCopy = system;
+            return shared_ptr<INonLinearAlgLoop>(copy);
+          }
+
+          void <%modelname%>Algloop<%nls.index%>::updateCopy(INonLinearAlgLoop* copy)
+          {
+            <%modelname%>Algloop<%nls.index%>* loop = dynamic_cast<<%modelname%>Algloop<%nls.index%>*>(copy);
+            loop->_system->getSimVars()->copyVariables(_system->getSimVars().get());
+            loop->_system->setTime(_system->getTime());
+            dynamic_cast<ISystemInitialization*>(loop->_systemCopy.get())->setInitial(dynamic_cast<ISystemInitialization*>(_system)->initial());
+            std::copy(_conditions, _conditions + _dimZeroFunc, loop->_conditions);
+          }
+          >>
+end algloopCopyCode;
+
 
 template updateAlgloop(SimCode simCode, Text& extraFuncs, Text& extraFuncsDecl, Text extraFuncsNamespace, SimEqSystem eqn, Context context, Integer clockIndex, Text stateDerVectorName /*=__zDot*/, Boolean useFlatArrayNotation)
 ::=
@@ -7182,6 +7285,9 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
     bool getUseSparseFormat();
     void setUseSparseFormat(bool value);
     float queryDensity();
+    virtual bool getSparsityPattern(vector<int>& colPtr, vector<int>& rowIndex) const;
+    virtual shared_ptr<INonLinearAlgLoop> createCopy();
+    virtual void updateCopy(INonLinearAlgLoop* copy);
     virtual int getDimZeroFunc() const;
   private:
     AlgloopVarAttributes _vars[<%listLength(nls.crefs)%>];
@@ -7193,6 +7299,8 @@ case SIMCODE(modelInfo = MODELINFO(__)) then
     bool* _conditions;
     shared_ptr<DiscreteEvents> _discrete_events;
     <%systemname%>* _system;
+    //clone of the system, if the algloop is a copy created with createCopy
+    shared_ptr<IMixedSystem> _systemCopy;
    };
   >>
 end generateAlgloopClassDeclarationCode;
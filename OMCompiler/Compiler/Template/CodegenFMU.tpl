@@ -1193,6 +1193,7 @@ template settingsfile(SimCode simCode)
   #define OMC_NDELAY_EXPRESSIONS <%maxDelayedIndex%>
   #define OMC_NVAR_STRING <%varInfo.numStringAlgVars%>
   <% if Flags.isSet(Flags.FMU_EXPERIMENTAL) then '#define FMU_EXPERIMENTAL 1'%>
+  <% if stringEq(Flags.getConfigString(Flags.FMU_CS_SOLVER), "rk23") then '#define OMC_FMU_CS_SOLVER_RK23 1'%>
   #define OMC_MODEL_PREFIX "<%modelNamePrefix(simCode)%>"
   #define OMC_MINIMAL_RUNTIME 1
   #define OMC_FMI_RUNTIME 1
@@ -134,6 +134,7 @@ template CoSimulation(SimCode simCode, list<String> sourceFiles)
 match simCode
 case SIMCODE(__) then
   let modelIdentifier = modelNamePrefix(simCode)
+  let fmuState = if stringEq(Config.simCodeTarget(), "C") then "true" else "false"
   <<
   <CoSimulation
     modelIdentifier="<%Util.escapeModelicaStringToXmlString(modelIdentifier)%>"
@@ -144,8 +145,8 @@ case SIMCODE(__) then
     canRunAsynchronuously = "false"
     canBeInstantiatedOnlyOncePerProcess="false"
     canNotUseMemoryManagementFunctions="false"
-    canGetAndSetFMUstate="false"
-    canSerializeFMUstate="false"
+    canGetAndSetFMUstate="<%fmuState%>"
+    canSerializeFMUstate="<%fmuState%>"
     <% if Flags.isSet(FMU_EXPERIMENTAL) then 'providesDirectionalDerivative="true"'%>>
     <%SourceFiles(sourceFiles)%>
   </CoSimulation>
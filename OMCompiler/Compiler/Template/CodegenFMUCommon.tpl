@@ -59,9 +59,10 @@ match simCode
 case SIMCODE(__) then
   let modelIdentifier = modelNamePrefix(simCode)
   let pdd = if providesDirectionalDerivative(simCode) then ' providesDirectionalDerivative="true"' else ''
+  let fmuState = if stringEq(Config.simCodeTarget(), "C") then ' canGetAndSetFMUstate="true" canSerializeFMUstate="true"' else ''
   <<
   <ModelExchange
-    modelIdentifier="<%modelIdentifier%>"<%pdd%>>
+    modelIdentifier="<%modelIdentifier%>"<%pdd%><%fmuState%>>
     <%SourceFiles(sourceFiles)%>
   </ModelExchange>
   >>
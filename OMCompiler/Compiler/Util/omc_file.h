@@ -33,6 +33,7 @@
 #define __OMC_FILE_H
 
 #include <stdio.h>
+#include <string.h>
 #include <gc.h>
 #include <errno.h>
 #include "ModelicaUtilities.h"
@@ -41,6 +42,7 @@ typedef struct {
   FILE* file /* the file */;
   mmc_sint_t cnt /* reference count */;
   const char* name /* the file name */;
+  char* tmpName /* for mode WriteIfChanged: the file that is written, moved to name when closed */;
 } __OMC_FILE;
 
 enum escape_t {
@@ -64,6 +66,7 @@ static inline void* om_file_new(void *fromID)
     res->file = NULL;
     res->cnt = 0;
     res->name = "[no open file]";
+    res->tmpName = NULL;
 #if defined(__OMC_FILE_DEBUG)
     fprintf(stderr,"File.constructor: new %s\n", res->name); fflush(NULL);
 #endif
@@ -77,6 +80,54 @@ static inline void* om_file_new(void *fromID)
   }
 }
 
+/* Returns 1 if the two files exist and have the same contents */
+static inline int om_file_same_contents(const char *name1, const char *name2)
+{
+  char buf1[4096], buf2[4096];
+  size_t n1, n2;
+  int res = 0;
+  FILE *f1 = fopen(name1, "rb"), *f2 = f1 ? fopen(name2, "rb") : NULL;
+  if (f1 && f2) {
+    do {
+      n1 = fread(buf1, 1, sizeof(buf1), f1);
+      n2 = fread(buf2, 1, sizeof(buf2), f2);
+      res = n1 == n2 && 0 == memcmp(buf1, buf2, n1);
+    } while (res && n1 == sizeof(buf1));
+  }
+  if (f1) {
+    fclose(f1);
+  }
+  if (f2) {
+    fclose(f2);
+  }
+  return res;
+}
+
+static inline void om_file_close(__OMC_FILE *file)
+{
+  int written = 0 != file->file;
+  if (file->file) {
+    fclose(file->file);
+  }
+  file->file = 0;
+  if (file->tmpName) {
+    /* Keep the old file (and its time stamp) if nothing changed, so make does not rebuild it.
+     * If the temporary file could not be opened, the old file is not touched. */
+    if (!written || om_file_same_contents(file->tmpName, file->name)) {
+      remove(file->tmpName);
+    } else {
+#if defined(__MINGW32__) || defined(__MINGW64__) || defined(_MSC_VER)
+      /* rename does not replace an existing file on Windows */
+      remove(file->name);
+#endif
+      if (rename(file->tmpName, file->name)) {
+        ModelicaFormatError("File.close: Failed to rename %s to %s: %s\n", file->tmpName, file->name, strerror(errno));
+      }
+    }
+    file->tmpName = NULL;
+  }
+}
+
 static inline void om_file_free(__OMC_FILE *file)
 {
   if (file->cnt /* reference count */) {
@@ -86,8 +137,7 @@ static inline void om_file_free(__OMC_FILE *file)
 #if defined(__OMC_FILE_DEBUG)
   fprintf(stderr,"File.destructor: close:%s,%p,%p\n",file->name, file->file, file); fflush(NULL);
 #endif
-  fclose(file->file);
-  file->file = 0;
+  om_file_close(file);
   file->name = "[closed]";
   GC_free(file);
 }
@@ -98,7 +148,14 @@ static inline void om_file_open(__OMC_FILE *file, const char *filename, int mode
 #if defined(__OMC_FILE_DEBUG)
     fprintf(stderr,"File.open: close :%s,%p,%p\n",file->name, file->file, file); fflush(NULL);
 #endif
-    fclose(file->file);
+    om_file_close(file);
+  }
+  file->name = filename;
+  if (mode == 3) {
+    /* WriteIfChanged: write to a temporary file that replaces filename when the file is closed */
+    file->tmpName = (char*) GC_malloc_atomic(strlen(filename) + 5);
+    sprintf(file->tmpName, "%s.tmp", filename);
+    filename = file->tmpName;
   }
 #if defined(__APPLE_CC__)||defined(__MINGW32__)||defined(__MINGW64__)
   if (mode == 1) {
@@ -110,11 +167,11 @@ static inline void om_file_open(__OMC_FILE *file, const char *filename, int mode
 #else
   file->file = fopen(filename, mode == 1 ? "rb" : "wb");
 #endif
-  file->name = filename;
 #if defined(__OMC_FILE_DEBUG)
   fprintf(stderr,"File.open: f:%s,%p,%p\n",file->name,file->file,file); fflush(NULL);
 #endif
   if (0 == file->file) {
+    file->tmpName = NULL;
     ModelicaFormatError("File.open: Failed to open file %s with mode %d: %s\n", filename, mode, strerror(errno));
   }
 }
@@ -69,6 +69,7 @@ static int* match=NULL;
 static int* row_match=NULL;
 static int* col_ptrs=NULL;
 static int* col_ids=NULL;
+static int matching_threads=0; /* number of threads for the parallel matching, 0 for all cores */
 
 void BackendDAEEXTImpl__initMarks(int nvars, int neqns)
 {
@@ -344,8 +345,77 @@ void BackendDAEExtImpl__matching(int nvars, int neqns, int matchingID, int cheap
     m = nvars;
   }
   if ((match != NULL) && (row_match != NULL)) {
-    matching(col_ptrs,col_ids,match,row_match,neqns,nvars,matchingID,cheapID,relabel_period,0 /*clear_match already done*/);
+    matching(col_ptrs,col_ids,match,row_match,neqns,nvars,matchingID,cheapID,relabel_period,0 /*clear_match already done*/,matching_threads);
   }
 }
 
+void BackendDAEExtImpl__setMatchingThreads(int nthreads)
+{
+  matching_threads = nthreads;
+}
+
+/* Iterative version of Tarjan's algorithm for a graph with nnodes nodes given in CSR format,
+ * succ_ids[succ_ptr[i]..succ_ptr[i+1]-1] are the successors of node i (0-based). The nodes
+ * in roots are used as start nodes in the given order. The components are stored in the
+ * order they are completed, the nodes of component c are comp_ids[comp_ptr[c]..comp_ptr[c+1]-1]
+ * in the order they are popped from the stack. The function keeps no state and does not
+ * allocate, all work arrays have to be provided with nnodes entries (comp_ptr nnodes+1).
+ * After the call number[i] is -1 for all nodes that were not reached.
+ * Returns the number of components.
+ */
+int BackendDAEExtImpl__tarjan(int nnodes, const int* succ_ptr, const int* succ_ids, int nroots, const int* roots,
+                              int* number, int* lowlink, int* stack, int* callstack, int* edge, int* comp_ptr, int* comp_ids)
+{
+  int index = 0, sp = 0, cs, ncomp = 0, nids = 0;
+  int i, r, u, v, w;
+
+  /* number[i] == -1: not visited, >= 0: on the stack, -2: assigned to a component */
+  for (i = 0; i < nnodes; i++) {
+    number[i] = -1;
+  }
+  comp_ptr[0] = 0;
+
+  for (r = 0; r < nroots; r++) {
+    v = roots[r];
+    if (number[v] != -1) {
+      continue;
+    }
+    number[v] = lowlink[v] = index++;
+    stack[sp++] = v;
+    edge[v] = succ_ptr[v];
+    callstack[cs = 0] = v;
+
+    while (cs >= 0) {
+      v = callstack[cs];
+      if (edge[v] < succ_ptr[v+1]) {
+        w = succ_ids[edge[v]++];
+        if (number[w] == -1) {
+          number[w] = lowlink[w] = index++;
+          stack[sp++] = w;
+          edge[w] = succ_ptr[w];
+          callstack[++cs] = w;
+        } else if (number[w] >= 0 && number[w] < lowlink[v]) {
+          lowlink[v] = number[w];
+        }
+      } else {
+        if (lowlink[v] == number[v]) {
+          do {
+            w = stack[--sp];
+            number[w] = -2;
+            comp_ids[nids++] = w;
+          } while (w != v);
+          comp_ptr[++ncomp] = nids;
+        }
+        if (--cs >= 0) {
+          u = callstack[cs];
+          if (lowlink[v] < lowlink[u]) {
+            lowlink[u] = lowlink[v];
+          }
+        }
+      }
+    }
+  }
+  return ncomp;
+}
+
 }
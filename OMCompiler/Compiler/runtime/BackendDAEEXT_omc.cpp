@@ -205,4 +205,168 @@ extern int BackendDAEEXT_setAssignment(int lenass1, int lenass2, modelica_metaty
   return 1;
 }
 
+extern void BackendDAEEXT_setMatchingThreads(modelica_integer nthreads)
+{
+  BackendDAEExtImpl__setMatchingThreads(nthreads);
+}
+
+/* Work arrays for BackendDAEExtImpl__tarjan, allocated in one block. */
+typedef struct {
+  int *succ_ptr, *succ_ids, *roots, *number, *lowlink, *stack, *callstack, *edge, *comp_ptr, *comp_ids;
+} tarjan_work;
+
+static int* tarjanWorkAlloc(tarjan_work *w, int nnodes, int nz)
+{
+  int *block = (int*) malloc((9 * (size_t)nnodes + 2 + nz) * sizeof(int));
+  if (!block) {
+    return NULL;
+  }
+  w->succ_ptr = block;
+  w->roots = w->succ_ptr + nnodes + 1;
+  w->number = w->roots + nnodes;
+  w->lowlink = w->number + nnodes;
+  w->stack = w->lowlink + nnodes;
+  w->callstack = w->stack + nnodes;
+  w->edge = w->callstack + nnodes;
+  w->comp_ptr = w->edge + nnodes;
+  w->comp_ids = w->comp_ptr + nnodes + 1;
+  w->succ_ids = w->comp_ids + nnodes;
+  return block;
+}
+
+/* Converts the components to list<list<Integer>> with 1-based indices, either in the order
+ * they were completed or in reversed order. */
+static modelica_metatype tarjanComponents(const tarjan_work *w, int ncomp, int completionOrder)
+{
+  modelica_metatype res = mmc_mk_nil(), comp;
+  int c, k, i;
+  for (k = 0; k < ncomp; k++) {
+    c = completionOrder ? ncomp - 1 - k : k;
+    comp = mmc_mk_nil();
+    for (i = w->comp_ptr[c+1] - 1; i >= w->comp_ptr[c]; i--) {
+      comp = mmc_mk_cons(mmc_mk_icon(w->comp_ids[i] + 1), comp);
+    }
+    res = mmc_mk_cons(comp, res);
+  }
+  return res;
+}
+
+/* Strong components of the equations, equation e depends on the equations that are assigned
+ * to the variables in m[e]. Same result as Sorting.Tarjan. */
+extern modelica_metatype BackendDAEEXT_tarjan(modelica_metatype m, modelica_metatype ass1)
+{
+  int nnodes = MMC_HDRSLOTS(MMC_GETHDR(ass1));
+  int nm = MMC_HDRSLOTS(MMC_GETHDR(m));
+  int nz = 0, nroots = 0, ncomp, e, v, e2, invalid = 0;
+  modelica_metatype lst, res;
+  tarjan_work w;
+  int *block;
+  char *bad = (char*) calloc(nnodes + 1, sizeof(char));
+
+  for (e = 0; e < nnodes; e++) {
+    if (e >= nm) {
+      bad[e] = 1;
+      continue;
+    }
+    for (lst = MMC_STRUCTDATA(m)[e]; !listEmpty(lst); lst = MMC_CDR(lst)) {
+      v = MMC_UNTAGFIXNUM(MMC_CAR(lst));
+      if (v > nnodes) {
+        bad[e] = 1;
+      } else if (v > 0) {
+        e2 = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[v-1]);
+        if (e2 > nnodes) bad[e] = 1;
+        else if (e2 > 0 && e2 != e+1) nz++;
+      }
+    }
+  }
+
+  block = tarjanWorkAlloc(&w, nnodes, nz);
+  if (!block) {
+    free(bad);
+    MMC_THROW();
+  }
+  nz = 0;
+  for (e = 0; e < nnodes; e++) {
+    w.succ_ptr[e] = nz;
+    if (bad[e]) continue;
+    for (lst = MMC_STRUCTDATA(m)[e]; !listEmpty(lst); lst = MMC_CDR(lst)) {
+      v = MMC_UNTAGFIXNUM(MMC_CAR(lst));
+      if (v > 0) {
+        e2 = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[v-1]);
+        if (e2 > 0 && e2 != e+1) w.succ_ids[nz++] = e2-1;
+      }
+    }
+  }
+  w.succ_ptr[nnodes] = nz;
+  for (v = 0; v < nnodes; v++) {
+    e = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass1)[v]);
+    if (e > nnodes) {
+      invalid = 1;
+      break;
+    }
+    if (e > 0) w.roots[nroots++] = e-1;
+  }
+
+  if (!invalid) {
+    ncomp = BackendDAEExtImpl__tarjan(nnodes, w.succ_ptr, w.succ_ids, nroots, w.roots, w.number, w.lowlink, w.stack, w.callstack, w.edge, w.comp_ptr, w.comp_ids);
+    /* an equation that could not be traversed was reached */
+    for (e = 0; e < nnodes && !invalid; e++) {
+      invalid = bad[e] && w.number[e] != -1;
+    }
+  }
+  free(bad);
+  if (invalid) {
+    free(block);
+    MMC_THROW();
+  }
+  res = tarjanComponents(&w, ncomp, 1);
+  free(block);
+  return res;
+}
+
+/* Strong components of the equations, the equations in mT[ass2[e]] depend on equation e.
+ * Same result as Sorting.TarjanTransposed. */
+extern modelica_metatype BackendDAEEXT_tarjanTransposed(modelica_metatype mT, modelica_metatype ass2)
+{
+  int nnodes = MMC_HDRSLOTS(MMC_GETHDR(ass2));
+  int nv = MMC_HDRSLOTS(MMC_GETHDR(mT));
+  int nz = 0, nroots = 0, ncomp, e, v, e2;
+  modelica_metatype lst, res;
+  tarjan_work w;
+  int *block;
+
+  for (e = 0; e < nnodes; e++) {
+    v = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass2)[e]);
+    if (v <= 0) continue;
+    if (v > nv) MMC_THROW();
+    for (lst = MMC_STRUCTDATA(mT)[v-1]; !listEmpty(lst); lst = MMC_CDR(lst)) {
+      e2 = MMC_UNTAGFIXNUM(MMC_CAR(lst));
+      if (e2 > nnodes) MMC_THROW();
+      if (e2 > 0 && e2 != e+1) nz++;
+    }
+  }
+
+  block = tarjanWorkAlloc(&w, nnodes, nz);
+  if (!block) {
+    MMC_THROW();
+  }
+  nz = 0;
+  for (e = 0; e < nnodes; e++) {
+    w.succ_ptr[e] = nz;
+    v = MMC_UNTAGFIXNUM(MMC_STRUCTDATA(ass2)[e]);
+    if (v <= 0) continue;
+    w.roots[nroots++] = e;
+    for (lst = MMC_STRUCTDATA(mT)[v-1]; !listEmpty(lst); lst = MMC_CDR(lst)) {
+      e2 = MMC_UNTAGFIXNUM(MMC_CAR(lst));
+      if (e2 > 0 && e2 != e+1) w.succ_ids[nz++] = e2-1;
+    }
+  }
+  w.succ_ptr[nnodes] = nz;
+
+  ncomp = BackendDAEExtImpl__tarjan(nnodes, w.succ_ptr, w.succ_ids, nroots, w.roots, w.number, w.lowlink, w.stack, w.callstack, w.edge, w.comp_ptr, w.comp_ids);
+  res = tarjanComponents(&w, ncomp, 0);
+  free(block);
+  return res;
+}
+
 }
@@ -27,7 +27,15 @@
 #include <sstream>
 #include <stdio.h>
 #include <fstream>
+#include <map>
+#include <vector>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
 #include "cJSON.h"
+#include "omc_spinlock.h"
 
 struct Equation {
   int id;
@@ -216,6 +224,409 @@ void* HpcOmBenchmarkExtImpl__requiredTimeForComm() {
   return res;
 }
 
+/*
+ * Machine profile
+ *
+ * The calibration benchmarks measure the latency of the operations counted by the cost
+ * estimation (except function calls, their costs depend on the called function), the
+ * one-way cache-line transfer latency between every pair of cores and the cost to hand a
+ * lock over to another core for every lock type used by the hpcom code.
+ * All values are stored in cycles of a dependent integer add, so they can be compared with
+ * the cycle-based costs of the scheduler without knowing the clock frequency.
+ */
+
+#define BENCH_OPS 1000000
+#define BENCH_ROUND_TRIPS 5000
+#define BENCH_WARMUP 500
+#define BENCH_MAX_CORES 64
+#define BENCH_PACKAGE_SIZE_BIG 128
+
+/* prevents the compiler from folding dependent chains of integer operations */
+#define BENCH_KEEP(x) __asm__ __volatile__("" : "+r"(x))
+
+struct BenchCacheLine {
+  volatile long value;
+  char padding[128 - sizeof(long)];
+};
+
+static double benchNow()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* the cores the compiler may run on */
+static std::vector<int> benchCores()
+{
+  std::vector<int> cores;
+#if defined(__linux__)
+  cpu_set_t set;
+  if (0 == sched_getaffinity(0, sizeof(set), &set)) {
+    for (int i = 0; i < CPU_SETSIZE && (int) cores.size() < BENCH_MAX_CORES; i++) {
+      if (CPU_ISSET(i, &set))
+        cores.push_back(i);
+    }
+  }
+#elif defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int i = 0; i < n && i < BENCH_MAX_CORES; i++)
+    cores.push_back(i);
+#endif
+  if (cores.empty())
+    cores.push_back(0);
+  return cores;
+}
+
+static bool benchPinThread(int core)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  return false;
+#endif
+}
+
+/* false if a benchmark thread could not be bound to its core */
+static bool benchPinned = true;
+
+static volatile double benchSeed = 1.0000001;
+
+/* time of one dependent operation of the given kind in seconds, the operands are loaded from and
+ * the result is stored to memory like in the generated code */
+static double benchOperation(int kind)
+{
+  volatile double v[4];
+  double t;
+  long i, k = 1;
+  v[0] = v[1] = benchSeed;
+  v[2] = 0.5;
+  v[3] = 0.25;
+  t = benchNow();
+  switch (kind) {
+  case 0: /* reference: integer add in registers */
+    for (i = 0; i < BENCH_OPS; i++) { k = k + 3; BENCH_KEEP(k); }
+    break;
+  case 1: /* add */
+    for (i = 0; i < BENCH_OPS; i++) v[0] = v[0] + v[1];
+    break;
+  case 2: /* mul */
+    for (i = 0; i < BENCH_OPS; i++) v[0] = v[0] * v[1];
+    break;
+  case 3: /* div */
+    for (i = 0; i < BENCH_OPS; i++) v[0] = v[0] / v[1];
+    break;
+  case 4: /* trigonometric functions */
+    for (i = 0; i < BENCH_OPS / 10; i++) v[0] = sin(v[0]);
+    break;
+  case 5: /* relations */
+    for (i = 0; i < BENCH_OPS; i++) v[0] = (v[0] < v[1]) ? v[2] : v[3];
+    break;
+  case 6: /* logical operations */
+    for (i = 0; i < BENCH_OPS; i++) { k = k & (k < 5); BENCH_KEEP(k); }
+    break;
+  case 7: /* other operations (pow, exp, ...) */
+    for (i = 0; i < BENCH_OPS / 10; i++) v[0] = pow(v[0], v[1]);
+    break;
+  }
+  t = benchNow() - t;
+  benchSeed = (v[0] + k) * 0.0 + 1.0000001; /* keep the results alive */
+  return t / ((kind == 4 || kind == 7) ? BENCH_OPS / 10 : BENCH_OPS);
+}
+
+/* ping-pong between two threads, used for cache lines and all lock types */
+enum BenchHandoff { BENCH_HANDOFF_FLAG, BENCH_HANDOFF_MUTEX, BENCH_HANDOFF_SPIN };
+
+struct BenchPingPong {
+  int cores[2];
+  int handoff;
+  int packageSize;
+  BenchCacheLine *flag;
+  double *items;
+  pthread_mutex_t *mutex;
+  pthread_spinlock_t *spin;
+  double time;
+};
+
+struct BenchPingPongThread {
+  BenchPingPong *pp;
+  int side;
+};
+
+static long benchReadFlag(BenchPingPong *pp)
+{
+  long v;
+  switch (pp->handoff) {
+  case BENCH_HANDOFF_MUTEX:
+    pthread_mutex_lock(pp->mutex);
+    v = pp->flag->value;
+    pthread_mutex_unlock(pp->mutex);
+    return v;
+  case BENCH_HANDOFF_SPIN:
+    pthread_spin_lock(pp->spin);
+    v = pp->flag->value;
+    pthread_spin_unlock(pp->spin);
+    return v;
+  default:
+    return __atomic_load_n(&pp->flag->value, __ATOMIC_ACQUIRE);
+  }
+}
+
+static void benchWriteFlag(BenchPingPong *pp, long v)
+{
+  switch (pp->handoff) {
+  case BENCH_HANDOFF_MUTEX:
+    pthread_mutex_lock(pp->mutex);
+    pp->flag->value = v;
+    pthread_mutex_unlock(pp->mutex);
+    break;
+  case BENCH_HANDOFF_SPIN:
+    pthread_spin_lock(pp->spin);
+    pp->flag->value = v;
+    pthread_spin_unlock(pp->spin);
+    break;
+  default:
+    __atomic_store_n(&pp->flag->value, v, __ATOMIC_RELEASE);
+  }
+}
+
+/* busy waiting, yields the core if the other thread does not seem to run at the same time */
+static void benchWaitForFlag(BenchPingPong *pp, long v)
+{
+  long spins = 0;
+  while (benchReadFlag(pp) != v) {
+    if (++spins > 10000) {
+      sched_yield();
+      spins = 0;
+    }
+  }
+}
+
+static void* benchPingPongThread(void *arg)
+{
+  BenchPingPongThread *thread = (BenchPingPongThread*) arg;
+  BenchPingPong *pp = thread->pp;
+  volatile double sink = 0.0;
+  double t = 0.0;
+  long i, j;
+
+  if (!benchPinThread(pp->cores[thread->side]))
+    benchPinned = false;
+  for (i = 0; i < BENCH_WARMUP + BENCH_ROUND_TRIPS; i++) {
+    if (i == BENCH_WARMUP)
+      t = benchNow();
+    if (thread->side == 0) {
+      /* send the package and wait for the answer */
+      for (j = 0; j < pp->packageSize; j++)
+        pp->items[j] = i + j;
+      benchWriteFlag(pp, 2 * i + 1);
+      benchWaitForFlag(pp, 2 * i + 2);
+    } else {
+      /* receive the package and answer */
+      benchWaitForFlag(pp, 2 * i + 1);
+      for (j = 0; j < pp->packageSize; j++)
+        sink += pp->items[j];
+      benchWriteFlag(pp, 2 * i + 2);
+    }
+  }
+  if (thread->side == 0)
+    pp->time = benchNow() - t;
+  return NULL;
+}
+
+/* one-way latency of a handoff between two cores (cpu ids) in seconds */
+static double benchPingPong(int core0, int core1, int handoff, int packageSize)
+{
+  BenchPingPong pp;
+  BenchPingPongThread threads[2];
+  pthread_t threadIds[2];
+  std::vector<BenchCacheLine> flag(1);
+  std::vector<double> items(BENCH_PACKAGE_SIZE_BIG + 16);
+  pthread_mutex_t mutex;
+  pthread_spinlock_t spin;
+  int i;
+
+  flag[0].value = 0;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_spin_init(&spin, 0);
+  pp.cores[0] = core0;
+  pp.cores[1] = core1;
+  pp.handoff = handoff;
+  pp.packageSize = packageSize;
+  pp.flag = &flag[0];
+  pp.items = &items[8];
+  pp.mutex = &mutex;
+  pp.spin = &spin;
+  pp.time = 0.0;
+  for (i = 0; i < 2; i++) {
+    threads[i].pp = &pp;
+    threads[i].side = i;
+    pthread_create(&threadIds[i], NULL, benchPingPongThread, &threads[i]);
+  }
+  for (i = 0; i < 2; i++)
+    pthread_join(threadIds[i], NULL);
+  pthread_mutex_destroy(&mutex);
+  return pp.time / (2.0 * BENCH_ROUND_TRIPS);
+}
+
+/**
+ * Run the calibration benchmarks and write the machine profile to the given json-file.
+ * The benchmarks run at most once per file, a failed calibration is not repeated.
+ * result: true if the file has been written
+ */
+bool HpcOmBenchmarkExtImpl__calibrateMachine(const char *fileName)
+{
+  static const char *operationNames[] = {"add", "mul", "div", "trig", "rel", "log", "oth"};
+  static const char *lockNames[] = {"atomic", "pthreads", "pthreads_spin", "openmp"};
+  /* openmp locks are futex-based like the mutex */
+  static const int lockHandoffs[] = {BENCH_HANDOFF_FLAG, BENCH_HANDOFF_MUTEX, BENCH_HANDOFF_SPIN, BENCH_HANDOFF_MUTEX};
+  static std::map<std::string, bool> calibrated;
+  std::map<std::string, bool>::iterator it = calibrated.find(fileName);
+  std::vector<int> cores;
+  int numCores;
+  std::vector<double> latency;
+  double cycle, operations[7], locks[4], transferPerDouble = 0.0;
+  int i, j;
+  FILE *fout;
+
+  if (it != calibrated.end())
+    return it->second;
+  calibrated[fileName] = false;
+  printf("Calibrating the machine profile %s, this may take a few seconds.\n", fileName);
+
+  cores = benchCores();
+  numCores = cores.size();
+  latency.assign(numCores * numCores, 0.0);
+
+  /* the best of several runs is used to filter out interruptions */
+  cycle = benchOperation(0);
+  for (i = 0; i < 4; i++)
+    cycle = fmin(cycle, benchOperation(0));
+  for (i = 0; i < 7; i++) {
+    operations[i] = benchOperation(i + 1);
+    for (j = 0; j < 2; j++)
+      operations[i] = fmin(operations[i], benchOperation(i + 1));
+    operations[i] /= cycle;
+  }
+
+  /* cache-line latency between all pairs of cores and lock handoff between the first two cores,
+   * there is no communication on a single core */
+  benchPinned = numCores > 1;
+  for (i = 0; i < numCores; i++) {
+    for (j = i + 1; j < numCores; j++)
+      latency[i * numCores + j] = latency[j * numCores + i] = benchPingPong(cores[i], cores[j], BENCH_HANDOFF_FLAG, 1) / cycle;
+  }
+  for (i = 0; i < 4; i++)
+    locks[i] = numCores > 1 ? benchPingPong(cores[0], cores[1], lockHandoffs[i], 1) / cycle : 0.0;
+  if (numCores > 1) {
+    double big = benchPingPong(cores[0], cores[1], BENCH_HANDOFF_FLAG, BENCH_PACKAGE_SIZE_BIG) / cycle;
+    transferPerDouble = fmax(big - latency[1], 0.0) / (BENCH_PACKAGE_SIZE_BIG - 1);
+  }
+
+  fout = fopen(fileName, "w");
+  if (!fout) {
+    printf("The machine profile %s could not be written, the built-in costs are used.\n", fileName);
+    return false;
+  }
+  fprintf(fout, "{\n\"format\":\"omc-hpcom-machine-profile\",\n\"version\":1,\n\"unit\":\"cycles\",\n");
+  fprintf(fout, "\"cycleTime\":%.6e,\n\"cores\":%d,\n\"pinned\":%s,\n", cycle, numCores, benchPinned ? "true" : "false");
+  fprintf(fout, "\"operations\":{");
+  for (i = 0; i < 7; i++)
+    fprintf(fout, "%s\n  \"%s\":%.2f", i == 0 ? "" : ",", operationNames[i], operations[i]);
+  fprintf(fout, "\n},\n\"cacheLineLatency\":[");
+  for (i = 0; i < numCores; i++) {
+    fprintf(fout, "%s\n  [", i == 0 ? "" : ",");
+    for (j = 0; j < numCores; j++)
+      fprintf(fout, "%s%.1f", j == 0 ? "" : ",", latency[i * numCores + j]);
+    fprintf(fout, "]");
+  }
+  fprintf(fout, "\n],\n\"transferPerDouble\":%.3f,\n\"locks\":{", transferPerDouble);
+  for (i = 0; i < 4; i++)
+    fprintf(fout, "%s\n  \"%s\":%.1f", i == 0 ? "" : ",", lockNames[i], locks[i]);
+  fprintf(fout, "\n}\n}\n");
+  fclose(fout);
+  calibrated[fileName] = true;
+  return true;
+}
+
+static double jsonNumber(cJSON *object, const char *name, double defaultValue)
+{
+  cJSON *item = object ? cJSON_GetObjectItem(object, name) : 0;
+  return (item && item->type == cJSON_Number) ? item->valuedouble : defaultValue;
+}
+
+/**
+ * Read the costs of the machine profile for the given number of threads and hpcom code type.
+ * The communication latency is the mean cache-line latency between the first numThreads cores
+ * (the threads are assumed to be placed compactly) plus the lock handoff of the code type.
+ * result: {add,mul,div,trig,rel,log,oth,commM,commN} or an empty list if the file is invalid
+ */
+std::vector<double> HpcOmBenchmarkExtImpl__readMachineProfile(const char *fileName, int numThreads, const char *codeType)
+{
+  static const char *operationNames[] = {"add", "mul", "div", "trig", "rel", "log", "oth"};
+  static std::map<std::string, std::vector<double> > cache;
+  std::stringstream keyStream;
+  keyStream << fileName << "|" << numThreads << "|" << codeType;
+  std::string key = keyStream.str();
+  std::map<std::string, std::vector<double> >::iterator it = cache.find(key);
+  std::vector<double> result;
+  cJSON *root, *operations, *latency, *locks, *row, *item;
+  double latencySum = 0.0;
+  int latencyCount = 0, numCores, i, j;
+
+  if (it != cache.end())
+    return it->second;
+
+  std::ifstream ifile(fileName);
+  std::stringstream buffer;
+  buffer << ifile.rdbuf();
+  root = ifile ? cJSON_Parse(buffer.str().c_str()) : 0;
+  operations = root ? cJSON_GetObjectItem(root, "operations") : 0;
+  latency = root ? cJSON_GetObjectItem(root, "cacheLineLatency") : 0;
+  locks = root ? cJSON_GetObjectItem(root, "locks") : 0;
+  if (!operations || !latency || !locks) {
+    printf("The machine profile '%s' is invalid, the built-in costs are used.\n", fileName);
+    if (root)
+      cJSON_Delete(root);
+    cache[key] = result;
+    return result;
+  }
+
+  for (i = 0; i < 7; i++)
+    result.push_back(jsonNumber(operations, operationNames[i], -1.0));
+
+  numCores = cJSON_GetArraySize(latency);
+  if (numThreads <= 0 || numThreads > numCores)
+    numThreads = numCores;
+  for (i = 0; i < numThreads; i++) {
+    row = cJSON_GetArrayItem(latency, i);
+    for (j = i + 1; j < numThreads && row; j++) {
+      item = cJSON_GetArrayItem(row, j);
+      if (item && item->valuedouble > 0.0) {
+        latencySum += item->valuedouble;
+        latencyCount++;
+      }
+    }
+  }
+
+  result.push_back(jsonNumber(root, "transferPerDouble", -1.0));
+  result.push_back((latencyCount ? latencySum / latencyCount : 0.0) + jsonNumber(locks, codeType, jsonNumber(locks, "atomic", 0.0)));
+  cJSON_Delete(root);
+
+  for (i = 0; i < (int) result.size(); i++) {
+    if (result[i] < 0.0) {
+      printf("The machine profile '%s' is incomplete, the built-in costs are used.\n", fileName);
+      result.clear();
+      break;
+    }
+  }
+  cache[key] = result;
+  return result;
+}
+
 class XmlBenchReader {
 private:
   struct ParserUserData {
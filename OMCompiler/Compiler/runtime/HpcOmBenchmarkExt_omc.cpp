@@ -46,4 +46,26 @@ extern void* HpcOmBenchmarkExt_readCalcTimesFromJson(const char *filename)
   return HpcOmBenchmarkExtImpl__readCalcTimesFromJson(filename);
 #endif
 }
+
+extern int HpcOmBenchmarkExt_calibrateMachine(const char *fileName)
+{
+#if defined(_MSC_VER)
+  HPC_OM_VS();
+#else
+  return HpcOmBenchmarkExtImpl__calibrateMachine(fileName);
+#endif
+}
+
+extern void* HpcOmBenchmarkExt_readMachineProfile(const char *fileName, int numThreads, const char *codeType)
+{
+#if defined(_MSC_VER)
+  HPC_OM_VS();
+#else
+  std::vector<double> costs = HpcOmBenchmarkExtImpl__readMachineProfile(fileName, numThreads, codeType);
+  void *res = mmc_mk_nil();
+  for (std::vector<double>::reverse_iterator it = costs.rbegin(); it != costs.rend(); it++)
+    res = mmc_mk_cons(mmc_mk_rcon(*it), res);
+  return res;
+#endif
+}
 }
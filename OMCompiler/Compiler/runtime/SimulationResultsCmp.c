@@ -584,7 +584,7 @@ static const char* getTimeVarName(void *vars) {
 #include "SimulationResultsCmpTubes.c"
 
 /* Common, huge function, for both result comparison and result diff */
-void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success, int isHtml, char **htmlOut)
+void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success, int isHtml, char **htmlOut, int numThreads)
 {
   char **cmpvars=NULL;
   char **cmpdiffvars=NULL;
@@ -599,6 +599,10 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   const char *msg[2] = {"",""};
   const char *timeVarName, *timeVarNameRef;
   int suggestReadAll=0;
+  /* variables read for the tube comparison, compared in batches by cmpDataTubesBatch */
+  tubesJob *jobs=NULL;
+  int njobs=0, maxjobs=0, timelineSettled=0;
+  tubesWorkspace ws = {0};
   ddf.data=NULL;
   ddf.n=0;
   ddf.n_max=0;
@@ -678,6 +682,15 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   for(offsetRef=0; offsetRef<timeref.n-1 && timeref.data[offsetRef] == timeref.data[offsetRef+1]; ++offsetRef);
   var1=NULL;
   var2=NULL;
+  if (!isResultCmp && tubesWorkspaceReserve(&ws, timeref.n)) {
+    msg[0] = runningTestsuite ? SystemImpl__basename(reffilename) : reffilename;
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to allocate memory for the tubes of %s."), msg, 1);
+    return mmc_mk_cons(mmc_mk_scon("Error allocating memory for the tubes!"),mmc_mk_nil());
+  }
+  if (!isHtml && !isResultCmp) {
+    maxjobs = 4*(numThreads > 1 ? numThreads : 1);
+    jobs = (tubesJob*) malloc(sizeof(tubesJob)*maxjobs);
+  }
   /* compare vars */
   /* fprintf(stderr, "compare vars\n"); */
   for (i=0;i<ncmpvars;i++) {
@@ -736,11 +749,25 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
       dataref.data[j-1] = dataref.data[j];
     /* compare */
     if (isHtml) {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,1,htmlOut);
+      if (cmpDataTubes(&ws,isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,resultfilename,1,htmlOut)) {
+        cmpdiffvars[vardiffindx++] = var;
+        if (!isResultCmp) {
+          res = mmc_mk_cons(mmc_mk_scon(var),res);
+        }
+      }
     } else if (isResultCmp) {
       vardiffindx = cmpData(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,abstol,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename);
     } else {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,0,0);
+      /* the batch frees the data */
+      jobs[njobs].varname = var;
+      jobs[njobs].data = data;
+      jobs[njobs].refdata = dataref;
+      if (++njobs == maxjobs) {
+        vardiffindx = cmpDataTubesBatch(jobs,njobs,numThreads,&ws,&timelineSettled,offsetRef,&time,&timeref,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,resultfilename,cmpdiffvars,vardiffindx,&res);
+        njobs = 0;
+      }
+      data.data = NULL;
+      dataref.data = NULL;
     }
     /* free */
     if (dataref.data) {
@@ -755,6 +782,12 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
     }
   }
 
+  if (njobs) {
+    vardiffindx = cmpDataTubesBatch(jobs,njobs,numThreads,&ws,&timelineSettled,offsetRef,&time,&timeref,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,resultfilename,cmpdiffvars,vardiffindx,&res);
+  }
+  if (jobs) free(jobs);
+  tubesWorkspaceFree(&ws);
+
   if (isResultCmp) {
     if (writeLogFile(resultfilename,&ddf,filename,reffilename,reltol,abstol)) {
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Cannot write to the difference (.csv) file!\n"), msg, 0);
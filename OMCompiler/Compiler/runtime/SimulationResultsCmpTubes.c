@@ -67,6 +67,7 @@
 #include <math.h>
 #include <gc.h>
 #include <stdio.h>
+#include <pthread.h>
 
 typedef struct {
   double *mh,*ml,*xHigh,*xLow,*yHigh,*yLow;
@@ -75,6 +76,66 @@ typedef struct {
   size_t countLow,countHigh,length;
 } privates;
 
+/* Scratch memory for comparing variables against their tubes. Every thread has its
+ * own workspace, which is reused for all the variables it compares; the buffers only
+ * grow if a reference has more points than the previous ones.
+ */
+typedef struct {
+  size_t size;
+  double *mh,*ml,*xHigh,*xLow,*yHigh,*yLow,*calibrated,*high,*low,*error;
+  int *i0h,*i1h,*i0l,*i1l;
+} tubesWorkspace;
+
+static void tubesWorkspaceFree(tubesWorkspace *ws)
+{
+  free(ws->mh);
+  free(ws->ml);
+  free(ws->xHigh);
+  free(ws->xLow);
+  free(ws->yHigh);
+  free(ws->yLow);
+  free(ws->calibrated);
+  free(ws->high);
+  free(ws->low);
+  free(ws->error);
+  free(ws->i0h);
+  free(ws->i1h);
+  free(ws->i0l);
+  free(ws->i1l);
+  memset(ws, 0, sizeof(tubesWorkspace));
+}
+
+/* Makes room for size points in the workspace. The old contents are not kept. Returns 0
+ * on success; if the memory could not be allocated the workspace is empty and 1 is returned.
+ */
+static int tubesWorkspaceReserve(tubesWorkspace *ws, size_t size)
+{
+  if (size <= ws->size) {
+    return 0;
+  }
+  tubesWorkspaceFree(ws);
+  ws->mh = (double*) malloc(sizeof(double)*size);
+  ws->ml = (double*) malloc(sizeof(double)*size);
+  ws->xHigh = (double*) malloc(sizeof(double)*size);
+  ws->xLow = (double*) malloc(sizeof(double)*size);
+  ws->yHigh = (double*) malloc(sizeof(double)*size);
+  ws->yLow = (double*) malloc(sizeof(double)*size);
+  ws->calibrated = (double*) malloc(sizeof(double)*size);
+  ws->high = (double*) malloc(sizeof(double)*size);
+  ws->low = (double*) malloc(sizeof(double)*size);
+  ws->error = (double*) malloc(sizeof(double)*size);
+  ws->i0h = (int*) malloc(sizeof(int)*size);
+  ws->i1h = (int*) malloc(sizeof(int)*size);
+  ws->i0l = (int*) malloc(sizeof(int)*size);
+  ws->i1l = (int*) malloc(sizeof(int)*size);
+  if (!(ws->mh && ws->ml && ws->xHigh && ws->xLow && ws->yHigh && ws->yLow && ws->calibrated && ws->high && ws->low && ws->error && ws->i0h && ws->i1h && ws->i0l && ws->i1l)) {
+    tubesWorkspaceFree(ws);
+    return 1;
+  }
+  ws->size = size;
+  return 0;
+}
+
 static inline int intmax(int a, int b) {
   return a>b ? a : b;
 }
@@ -199,10 +260,9 @@ static void generateLowTube(privates *priv, double *x, double *y)
   }
 }
 
-static privates* skipCalculateTubes(double *x, double *y, size_t length)
+static void skipCalculateTubes(privates *priv, tubesWorkspace *ws, double *x, double *y, size_t length)
 {
-  privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
-
+  memset(priv, 0, sizeof(privates));
   /* set tStart and tStop */
   priv->length = length;
   priv->tStart = x[0];
@@ -211,17 +271,21 @@ static privates* skipCalculateTubes(double *x, double *y, size_t length)
   priv->xMinStep = ((priv->tStop - priv->tStart) + fabs(priv->tStart)) * priv->xRelEps;
   priv->countLow = length;
   priv->countHigh = length;
-  priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
+  priv->yHigh = ws->yHigh;
+  priv->yLow  = ws->yLow;
   memcpy(priv->yHigh, y, length * sizeof(double));
   memcpy(priv->yLow, y, length * sizeof(double));
-  return priv;
 }
 
-/* This method generates tubes around a given curve */
-static privates* calculateTubes(double *x, double *y, size_t length, double r)
+/* This method generates tubes around a given curve.
+ * Time points of x that are not increasing (events) are moved by xMinStep. Where a point
+ * is moved to depends on y (events without a jump are moved behind the last tube interval),
+ * so x may still have equal time points afterwards and be modified again for another
+ * variable. Once x is strictly increasing after the initial points (see
+ * isTubeTimelineSettled) it is no longer modified.
+ */
+static void calculateTubes(privates *priv, tubesWorkspace *ws, double *x, double *y, size_t length, double r)
 {
-  privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
   int i;
   /* set tStart and tStop */
   priv->length = length;
@@ -233,18 +297,18 @@ static privates* calculateTubes(double *x, double *y, size_t length, double r)
   priv->countHigh = 0;
 
   /* Initialize lists (upper tube) */
-  priv->mh  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
+  priv->mh  = ws->mh;
+  priv->i0h = ws->i0h;
+  priv->i1h = ws->i1h;
   /* Initialize lists (lower tube) */
-  priv->ml  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
+  priv->ml  = ws->ml;
+  priv->i0l = ws->i0l;
+  priv->i1l = ws->i1l;
 
-  priv->xHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->xLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
+  priv->xHigh = ws->xHigh;
+  priv->xLow  = ws->xLow;
+  priv->yHigh = ws->yHigh;
+  priv->yLow  = ws->yLow;
 
   /* calculate the tubes delta */
   priv->delta = r * (priv->tStop - priv->tStart);
@@ -352,7 +416,21 @@ static privates* calculateTubes(double *x, double *y, size_t length, double r)
   priv->xLow[priv->countLow] = priv->x2 + priv->delta;
   priv->yLow[priv->countLow] = priv->y1 + priv->currentSlope * (priv->x2 + priv->delta - priv->x1);
   priv->countLow++;
-  return priv;
+}
+
+/* Returns 1 if calculateTubes will not modify the reference time any more: all time
+ * points after the initial ones (which have identical values) are strictly increasing.
+ * This is not guaranteed after any number of calls, so it has to be checked after each one.
+ */
+static int isTubeTimelineSettled(DataField *reftime, int offsetRef)
+{
+  unsigned int i;
+  for (i = offsetRef + 1; i < reftime->n; i++) {
+    if (!(reftime->data[i] > reftime->data[i-1])) {
+      return 0;
+    }
+  }
+  return 1;
 }
 
 static inline double linearInterpolation(double x, double x0, double x1, double y0, double y1, double xabstol)
@@ -368,10 +446,9 @@ static inline double linearInterpolation(double x, double x0, double x1, double
   }
 }
 
-/* Calibrate the target time+value pair onto the source timeline */
-static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol)
+/* Calibrate the target time+value pair onto the source timeline, the values are stored in interpolatedValues (*nsource elements) */
+static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol, double *interpolatedValues)
 {
-  double* interpolatedValues;
   int j, i;
   double x0, x1, y0, y1;
   size_t n;
@@ -381,7 +458,6 @@ static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, d
   }
 
   n = *nsource;
-  interpolatedValues = (double*) omc_alloc_interface.malloc_atomic(sizeof(double)*n);
 
   j = 1;
   for (i = 0; i < n; i++) {
@@ -600,10 +676,9 @@ static void assertMonotonic(addTargetEventTimesRes series)
   }
 }
 
-/* Return NULL if there were no errors */
-static double* validate(int n, addTargetEventTimesRes ref, double *low, double *high, double *calibrated_values, double reltol, double abstol, double xabstol)
+/* Stores the errors in error (n elements); return NULL if there were no errors */
+static double* validate(int n, addTargetEventTimesRes ref, double *low, double *high, double *calibrated_values, double reltol, double abstol, double xabstol, double *error)
 {
-  double *error = omc_alloc_interface.malloc_atomic(n * sizeof(double));
   int isdifferent = 0;
   int i,lastStepError = 1;
   for (i=0; i<n; i++) {
@@ -638,7 +713,13 @@ static double* validate(int n, addTargetEventTimesRes ref, double *low, double *
   return NULL;
 }
 
-static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, DiffDataField *ddf, char **cmpdiffvars, unsigned int vardiffindx, int keepEqualResults, void **diffLst, const char *prefix, int isHtml, char **htmlOut)
+/* Compares one variable against the tubes around the reference and writes the csv or html
+ * output. Returns 1 if the variable is outside the tubes. The workspace must have room for
+ * the points of reftime (see tubesWorkspaceReserve). Only uses the given workspace and
+ * writes to its own files, so several variables can be compared concurrently once the time
+ * of the reference is settled (see isTubeTimelineSettled).
+ */
+static int cmpDataTubes(tubesWorkspace *ws, int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, int keepEqualResults, const char *prefix, int isHtml, char **htmlOut)
 {
   int withTubes = 0 == rangeDelta;
   FILE *fout = NULL;
@@ -648,7 +729,7 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   double xabstol = (reftime->data[reftime->n-1]-reftime->data[0])*(withTubes ? rangeDelta : 1e-3) / fmax(time->n,reftime->n);
   /* Calculate the tubes without additional events added */
   addTargetEventTimesRes ref,actual,actualoriginal;
-  privates *priv=NULL;
+  privates tubes, *priv=&tubes;
   size_t n,maxn,html_size=0;
   double *calibrated_values=NULL, *high=NULL, *low=NULL, *error=NULL,maxPlusTol,minMinusTol,abstol;
 
@@ -665,15 +746,19 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   /* actual = removeUneventfulPoints(actual, reltol*reltol, xabstol); */
   /* assertMonotonic(ref); */
   /* assertMonotonic(actual); */
-  priv = withTubes ? skipCalculateTubes(ref.time,ref.values,ref.size) : calculateTubes(ref.time,ref.values,ref.size,rangeDelta);
+  if (withTubes) {
+    skipCalculateTubes(priv,ws,ref.time,ref.values,ref.size);
+  } else {
+    calculateTubes(priv,ws,ref.time,ref.values,ref.size,rangeDelta);
+  }
   /* ref = mergeTimelines(ref,actual,xabstol); */
   /* assertMonotonic(ref); */
   n = ref.size;
-  calibrated_values = calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol);
+  calibrated_values = calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol,ws->calibrated);
   maxPlusTol = priv->max + fabs(priv->max) * reltol;
   minMinusTol = priv->min - fabs(priv->min) * reltol;
-  high = calibrateValues(ref.time,priv->xHigh,priv->yHigh,&n,priv->countHigh,xabstol);
-  low  = calibrateValues(ref.time,priv->xLow,priv->yLow,&n,priv->countLow,xabstol);
+  high = calibrateValues(ref.time,priv->xHigh,priv->yHigh,&n,priv->countHigh,xabstol,ws->high);
+  low  = calibrateValues(ref.time,priv->xLow,priv->yLow,&n,priv->countLow,xabstol,ws->low);
   /* If all values in the reference are ~0 (and the same)... Allow reltolDiffMaxMin^2 as tolerance
    * Maybe we should just treat it differently though
    * Like not creating a tubes and simply check that the other file also has only identical points close to this
@@ -681,7 +766,7 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   abstol = (priv->max-priv->min == 0 && priv->max < reltolDiffMaxMin*reltolDiffMaxMin) ? reltolDiffMaxMin*reltolDiffMaxMin : fabs((priv->max-priv->min)*reltolDiffMaxMin);
   addRelativeTolerance(high,ref.values,n,reltol,abstol,1);
   addRelativeTolerance(low ,ref.values,n,reltol,abstol,-1);
-  error = validate(n,ref,low,high,calibrated_values,reltol,abstol,xabstol);
+  error = validate(n,ref,low,high,calibrated_values,reltol,abstol,xabstol,ws->error);
   if ( isHtml ) {
 
 #if _XOPEN_SOURCE >= 700 || _POSIX_C_SOURCE >= 200809L
@@ -786,13 +871,6 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
     }
     fputs(isHtml ? "],\n" : "\n", fout);
   }
-  if (error) {
-    cmpdiffvars[vardiffindx] = varname;
-    vardiffindx++;
-    if (!isResultCmp) {
-      *diffLst = mmc_mk_cons(mmc_mk_scon(varname),*diffLst);
-    }
-  }
   if (fout) {
     if (isHtml) {
 fprintf(fout, "{title: '%s',\n"
@@ -846,23 +924,109 @@ fprintf(fout, "{title: '%s',\n"
     }
   }
   /* Tell the GC some variables have been free'd */
-  if (error) GC_free(error);
   if (fname) GC_free(fname);
-  GC_free(low);
-  GC_free(high);
-  if (withTubes) {
-    GC_free(priv->mh);
-    GC_free(priv->i0h);
-    GC_free(priv->i1h);
-    GC_free(priv->ml);
-    GC_free(priv->i0l);
-    GC_free(priv->i1l);
-    GC_free(priv->xHigh);
-    GC_free(priv->xLow);
+  return error != NULL;
+}
+
+/* A variable to compare with cmpDataTubes */
+typedef struct {
+  char *varname;
+  DataField data;
+  DataField refdata;
+  int isDifferent;
+} tubesJob;
+
+typedef struct {
+  pthread_mutex_t *mutex;
+  int *current;
+  int size;
+  tubesJob *jobs;
+  DataField *time;
+  DataField *reftime;
+  double reltol, rangeDelta, reltolDiffMaxMin;
+  int keepEqualResults;
+  const char *prefix;
+  tubesWorkspace ws;
+} tubesWorkerArgs;
+
+static void* tubesWorkerThread(void *argVoid)
+{
+  tubesWorkerArgs *arg = (tubesWorkerArgs*) argVoid;
+  while (1) {
+    int i;
+    pthread_mutex_lock(arg->mutex);
+    i = (*arg->current);
+    *arg->current+=1;
+    pthread_mutex_unlock(arg->mutex);
+    if (i >= arg->size) break;
+    arg->jobs[i].isDifferent = cmpDataTubes(&arg->ws,0,arg->jobs[i].varname,arg->time,arg->reftime,&arg->jobs[i].data,&arg->jobs[i].refdata,arg->reltol,arg->rangeDelta,arg->reltolDiffMaxMin,arg->keepEqualResults,arg->prefix,0,NULL);
+  }
+  return NULL;
+}
+
+/* Compares the variables of jobs with cmpDataTubes, using up to numThreads threads, adds
+ * the different ones to cmpdiffvars and diffLst in the order of jobs and frees their data.
+ * ws must have room for the points of reftime. calculateTubes may move event points of
+ * the reference time, so the jobs are compared one after the other as long as it is not
+ * settled (which may be never), and the results are the same as comparing all variables
+ * in order. The workspaces of the threads are allocated here; threads that do not get
+ * one are not started, and if none does the jobs are compared on this thread.
+ */
+static unsigned int cmpDataTubesBatch(tubesJob *jobs, int njobs, int numThreads, tubesWorkspace *ws, int *timelineSettled, int offsetRef, DataField *time, DataField *reftime, double reltol, double rangeDelta, double reltolDiffMaxMin, int keepEqualResults, const char *prefix, char **cmpdiffvars, unsigned int vardiffindx, void **diffLst)
+{
+  int i = 0;
+  for (; i < njobs && (numThreads <= 1 || !*timelineSettled); i++) {
+    jobs[i].isDifferent = cmpDataTubes(ws,0,jobs[i].varname,time,reftime,&jobs[i].data,&jobs[i].refdata,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,prefix,0,NULL);
+    if (numThreads > 1) {
+      *timelineSettled = isTubeTimelineSettled(reftime, offsetRef);
+    }
+  }
+  if (i < njobs) {
+    int t, index = i;
+    pthread_mutex_t mutex;
+    pthread_t *th;
+    tubesWorkerArgs *args;
+    if (numThreads > njobs - i) {
+      numThreads = njobs - i;
+    }
+    args = (tubesWorkerArgs*) calloc(numThreads, sizeof(tubesWorkerArgs));
+    for (t=0; args && t<numThreads; t++) {
+      tubesWorkerArgs arg = {&mutex,&index,njobs,jobs,time,reftime,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,prefix,{0}};
+      if (tubesWorkspaceReserve(&arg.ws, reftime->n)) {
+        break;
+      }
+      args[t] = arg;
+    }
+    if (t == 0) {
+      /* no memory for the threads, compare on this thread */
+      for (; i < njobs; i++) {
+        jobs[i].isDifferent = cmpDataTubes(ws,0,jobs[i].varname,time,reftime,&jobs[i].data,&jobs[i].refdata,reltol,rangeDelta,reltolDiffMaxMin,keepEqualResults,prefix,0,NULL);
+      }
+    } else {
+      numThreads = t;
+      pthread_mutex_init(&mutex,NULL);
+      th = (pthread_t*) omc_alloc_interface.malloc(sizeof(pthread_t)*numThreads);
+      for (t=0; t<numThreads; t++) {
+        GC_pthread_create(&th[t],NULL,tubesWorkerThread,&args[t]);
+      }
+      for (t=0; t<numThreads; t++) {
+        GC_pthread_join(th[t], NULL);
+      }
+      GC_free(th);
+      pthread_mutex_destroy(&mutex);
+    }
+    for (t=0; args && t<numThreads; t++) {
+      tubesWorkspaceFree(&args[t].ws);
+    }
+    free(args);
+  }
+  for (i=0; i<njobs; i++) {
+    if (jobs[i].isDifferent) {
+      cmpdiffvars[vardiffindx++] = jobs[i].varname;
+      *diffLst = mmc_mk_cons(mmc_mk_scon(jobs[i].varname),*diffLst);
+    }
+    free(jobs[i].data.data);
+    free(jobs[i].refdata.data);
   }
-  GC_free(priv->yHigh);
-  GC_free(priv->yLow);
-  GC_free(priv);
-  GC_free(calibrated_values);
   return vardiffindx;
 }
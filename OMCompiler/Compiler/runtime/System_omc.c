@@ -129,6 +129,20 @@ extern void System_realtimeClear(int ix)
   rt_clear(ix);
 }
 
+static rtclock_t monotonic_origin;
+static pthread_once_t monotonic_origin_once = PTHREAD_ONCE_INIT;
+
+static void System_initMonotonicOrigin(void)
+{
+  rt_ext_tp_tick(&monotonic_origin);
+}
+
+extern double System_realtimeSeconds(void)
+{
+  pthread_once(&monotonic_origin_once, System_initMonotonicOrigin);
+  return rt_ext_tp_tock(&monotonic_origin);
+}
+
 extern int System_realtimeNtick(int ix)
 {
   if (ix < 0 || ix >= NUM_USER_RT_CLOCKS) MMC_THROW();
@@ -614,6 +628,13 @@ extern int System_loadLibrary(const char *name, int printDebug)
   return res;
 }
 
+extern void* System_simulateInMemory(const char *libName, void *args, void *variables)
+{
+  void *res = SystemImpl__simulateInMemory(libName, args, variables);
+  if (res == NULL) MMC_THROW();
+  return res;
+}
+
 #if defined(__MINGW32__) || defined(_MSC_VER)
 void* System_subDirectories(const char *directory)
 {
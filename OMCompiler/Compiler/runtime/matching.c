@@ -1230,7 +1230,234 @@ void match_pr_fifo_fair(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids
   free(r_label);
 }
 
-void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int matching_id, int cheap_id, double relabel_period, int clear_match) {
+/*
+ * Multithreaded Pothen-Fan with fairness, see
+ *
+ *   "A. Azad, M. Halappanavar, S. Rajamanickam, E. G. Boman, A. Khan and A. Pothen.
+ *   'Multithreaded Algorithms for Maximum Matching in Bipartite Graphs'
+ *   IPDPS 2012."
+ *
+ * The unmatched columns of a phase are distributed dynamically over the threads. Every
+ * thread runs the depth first searches of its columns, rows are claimed with an atomic
+ * exchange on the visited array, hence the augmenting paths found in one phase are vertex
+ * disjoint and can be applied without further synchronization. A phase without any
+ * augmentation proves that the matching is maximum. Once the number of unmatched columns
+ * is too small to keep the threads busy the remaining work is done by match_pf_fair.
+ */
+#if !defined(_MSC_VER)
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define PPF_MIN_PARALLEL 4096
+#define PPF_CHUNK 64
+
+typedef struct {
+  int* col_ptrs;
+  int* col_ids;
+  int* match;
+  int* row_match;
+  int* visited;
+  int* lookahead;
+  int* colptrs;
+  int* unmatched;
+  int* next_unmatched;
+  int nunmatched;
+  int next;       /* next position in unmatched, accessed atomically */
+  int nnext;      /* number of entries in next_unmatched, accessed atomically */
+  int augmented;  /* set if at least one path was augmented, accessed atomically */
+  int pcount;
+  int inc;
+} ppf_phase;
+
+typedef struct {
+  ppf_phase* phase;
+  int* stack;
+} ppf_worker;
+
+static inline int ppf_claim(int* visited, int row, int pcount) {
+  return __atomic_load_n(&visited[row], __ATOMIC_RELAXED) != pcount &&
+         __atomic_exchange_n(&visited[row], pcount, __ATOMIC_ACQ_REL) != pcount;
+}
+
+static int ppf_search(ppf_phase* ph, int* stack, int root) {
+  int* col_ptrs = ph->col_ptrs;
+  int* col_ids = ph->col_ids;
+  int* colptrs = ph->colptrs;
+  int pcount = ph->pcount;
+  int inc = ph->inc;
+  int ptr, eptr, row = -1, col, temp, stack_last = 0, found;
+
+  stack[0] = root;
+  colptrs[root] = inc ? col_ptrs[root] : col_ptrs[root + 1] - 1;
+
+  while(stack_last > -1) {
+    col = stack[stack_last];
+    found = 0;
+
+    /* look ahead for a free row, every claimed row is either matched already or augmented by its claimer */
+    eptr = col_ptrs[col + 1];
+    for(ptr = ph->lookahead[col]; ptr < eptr; ptr++) {
+      row = col_ids[ptr];
+      if(__atomic_load_n(&ph->row_match[row], __ATOMIC_RELAXED) == -1 && ppf_claim(ph->visited, row, pcount)) {
+        found = 1;
+        break;
+      }
+    }
+    ph->lookahead[col] = ptr + 1;
+
+    if(!found) {
+      if(inc) {
+        for(ptr = colptrs[col]; ptr < eptr; ptr++) {
+          if(ppf_claim(ph->visited, col_ids[ptr], pcount)) break;
+        }
+        colptrs[col] = ptr + 1;
+        if(ptr == eptr) {--stack_last; continue;}
+      } else {
+        eptr = col_ptrs[col] - 1;
+        for(ptr = colptrs[col]; ptr > eptr; ptr--) {
+          if(ppf_claim(ph->visited, col_ids[ptr], pcount)) break;
+        }
+        colptrs[col] = ptr - 1;
+        if(ptr == eptr) {--stack_last; continue;}
+      }
+      row = col_ids[ptr];
+      temp = __atomic_load_n(&ph->row_match[row], __ATOMIC_RELAXED);
+      if(temp != -1) {
+        stack[++stack_last] = temp;
+        colptrs[temp] = inc ? col_ptrs[temp] : col_ptrs[temp + 1] - 1;
+        continue;
+      }
+    }
+
+    /* augment along the stack, all rows and columns on it are owned by this thread */
+    while(row != -1) {
+      col = stack[stack_last--];
+      temp = ph->match[col];
+      ph->match[col] = row;
+      __atomic_store_n(&ph->row_match[row], col, __ATOMIC_RELAXED);
+      row = temp;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+static void* ppf_worker_thread(void* arg) {
+  ppf_worker* w = (ppf_worker*)arg;
+  ppf_phase* ph = w->phase;
+  int i, start, end, col, augmented = 0;
+
+  while(1) {
+    start = __atomic_fetch_add(&ph->next, PPF_CHUNK, __ATOMIC_RELAXED);
+    if(start >= ph->nunmatched) break;
+    end = start + PPF_CHUNK < ph->nunmatched ? start + PPF_CHUNK : ph->nunmatched;
+    for(i = start; i < end; i++) {
+      col = ph->unmatched[i];
+      if(ppf_search(ph, w->stack, col)) {
+        augmented = 1;
+      } else {
+        ph->next_unmatched[__atomic_fetch_add(&ph->nnext, 1, __ATOMIC_RELAXED)] = col;
+      }
+    }
+  }
+  if(augmented) {
+    __atomic_store_n(&ph->augmented, 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+void match_ppf_fair(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int nthreads) {
+  ppf_phase ph;
+  ppf_worker* workers;
+  pthread_t* threads;
+  int* started;
+  int* temp;
+  int i, maximum = 0;
+
+  if(nthreads <= 0) {
+    nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  ph.col_ptrs = col_ptrs;
+  ph.col_ids = col_ids;
+  ph.match = match;
+  ph.row_match = row_match;
+  ph.unmatched = (int*)malloc(sizeof(int) * n);
+  ph.nunmatched = 0;
+  for(i = 0; i < n; i++) {
+    if(match[i] == -1 && col_ptrs[i] != col_ptrs[i+1]) {
+      ph.unmatched[ph.nunmatched++] = i;
+    }
+  }
+
+  if(nthreads > 1 && ph.nunmatched >= PPF_MIN_PARALLEL) {
+    ph.visited = (int*)malloc(sizeof(int) * m);
+    ph.lookahead = (int*)malloc(sizeof(int) * n);
+    ph.colptrs = (int*)malloc(sizeof(int) * n);
+    ph.next_unmatched = (int*)malloc(sizeof(int) * n);
+    workers = (ppf_worker*)malloc(sizeof(ppf_worker) * nthreads);
+    threads = (pthread_t*)malloc(sizeof(pthread_t) * nthreads);
+    started = (int*)malloc(sizeof(int) * nthreads);
+    memset(ph.visited, 0, sizeof(int) * m);
+    memcpy(ph.lookahead, col_ptrs, sizeof(int) * n);
+    for(i = 0; i < nthreads; i++) {
+      workers[i].phase = &ph;
+      workers[i].stack = (int*)malloc(sizeof(int) * n);
+    }
+    ph.pcount = 1;
+    ph.inc = 1;
+
+    while(ph.nunmatched >= PPF_MIN_PARALLEL) {
+      ph.next = 0;
+      ph.nnext = 0;
+      ph.augmented = 0;
+      /* the calling thread is worker 0, a failed thread creation only reduces the parallelism */
+      for(i = 1; i < nthreads; i++) {
+        started[i] = 0 == pthread_create(&threads[i], NULL, ppf_worker_thread, &workers[i]);
+      }
+      ppf_worker_thread(&workers[0]);
+      for(i = 1; i < nthreads; i++) {
+        if(started[i]) pthread_join(threads[i], NULL);
+      }
+
+      temp = ph.unmatched; ph.unmatched = ph.next_unmatched; ph.next_unmatched = temp;
+      ph.nunmatched = ph.nnext;
+      ph.pcount++;
+      ph.inc = !ph.inc;
+      if(!ph.augmented) {
+        maximum = 1;
+        break;
+      }
+    }
+
+    for(i = 0; i < nthreads; i++) {
+      free(workers[i].stack);
+    }
+    free(started);
+    free(threads);
+    free(workers);
+    free(ph.next_unmatched);
+    free(ph.colptrs);
+    free(ph.lookahead);
+    free(ph.visited);
+  }
+  free(ph.unmatched);
+
+  if(!maximum) {
+    match_pf_fair(col_ptrs, col_ids, match, row_match, n, m);
+  }
+}
+
+#else
+
+void match_ppf_fair(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int nthreads) {
+  match_pf_fair(col_ptrs, col_ids, match, row_match, n, m);
+}
+
+#endif
+
+void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int matching_id, int cheap_id, double relabel_period, int clear_match, int nthreads) {
   int* row_ptrs;
   int* row_ids;
   int i;
@@ -1245,7 +1472,7 @@ void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, in
     }
   }
 
-  if(matching_id >= do_hk || cheap_id > do_old_cheap) {
+  if((matching_id >= do_hk && matching_id <= do_pr_fifo_fair) || cheap_id > do_old_cheap) {
 
     row_ptrs = (int*) malloc((m+1) * sizeof(int));
     memset(row_ptrs, 0, (m+1) * sizeof(int));
@@ -1294,8 +1521,10 @@ void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, in
     match_abmp_bfs(col_ptrs, col_ids, row_ptrs, row_ids, match, row_match, n, m);
   } else if(matching_id == do_pr_fifo_fair) {
     match_pr_fifo_fair(col_ptrs, col_ids, row_ptrs, row_ids, match, row_match, n, m, relabel_period);
+  } else if(matching_id == do_ppf_fair) {
+    match_ppf_fair(col_ptrs, col_ids, match, row_match, n, m, nthreads);
   }
-  if(matching_id >= do_hk || cheap_id > do_old_cheap) {
+  if((matching_id >= do_hk && matching_id <= do_pr_fifo_fair) || cheap_id > do_old_cheap) {
     free(row_ids);
     free(row_ptrs);
   }
@@ -35,6 +35,7 @@
 #define do_abmp 8
 #define do_abmp_bfs 9
 #define do_pr_fifo_fair 10
+#define do_ppf_fair 11
 
 void old_cheap(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m);
 void sk_cheap(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
@@ -51,12 +52,13 @@ void match_hk_dw(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int*
 void match_abmp(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void match_abmp_bfs(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 void match_pr_fifo_fair(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m, double relabel_period);
+void match_ppf_fair(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int nthreads);
 
 void pr_global_relabel(int* l_label, int* r_label, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m);
 
 void cheap_matching(int* col_ptrs, int* col_ids, int* row_ptrs, int* row_ids, int* match, int* row_match, int n, int m, int cheap_id);
 
 void cheapmatching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int cheap_id, int clear_match);
-void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int match_id, int cheap_id, double relabel_period, int clear_match);
+void matching(int* col_ptrs, int* col_ids, int* match, int* row_match, int n, int m, int match_id, int cheap_id, double relabel_period, int clear_match, int nthreads);
 
 #endif /* MATCHMAKER_H_ */
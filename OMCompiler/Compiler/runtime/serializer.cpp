@@ -1,13 +1,26 @@
 
 
 #include <stack>
-//#include <unordered_map>
 #include <map>
+#include <new>
 #include <string>
 #include <vector>
 #include <fstream>
 #include "meta_modelica.h"
 #include <stdint.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#if !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
 
 extern "C"
 {
@@ -16,6 +29,8 @@ extern "C"
 /* This is used to keep track of generated record_description,
    that way we don't generate new every time something is de-serialized */
 std::map<std::string,record_description*> record_cache;
+/* Files may be de-serialized from several threads at once (parallel parsing) */
+static pthread_mutex_t record_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 
 
 static const uint8_t TAG_INT_TINY     = 0x00;
@@ -33,45 +48,257 @@ static const uint8_t TAG_SHARED_BIG   = 0xA0;
 
 /*  SERIALIZATION */
 
+/* Output buffer made of large chunks. Growing it never copies the data
+   written so far, and the chunks can be handed directly to writev. */
+class OutputBuffer {
+public:
+    OutputBuffer(size_t chunk_size = 4*1024*1024) : chunk_size(chunk_size), current(NULL), used(0), capacity(0) {}
+    ~OutputBuffer(){
+        for(size_t i = 0; i<chunks.size(); i++){
+            free(chunks[i].data);
+        }
+    }
+
+    /* Makes sure that at least n bytes can be written to the current chunk */
+    inline void ensure(size_t n){
+        if(used+n > capacity){
+            newChunk(n);
+        }
+    }
+
+    inline void put(uint8_t v0){
+        ensure(1);
+        current[used++] = v0;
+    }
+
+    /* Unchecked write; the caller has to call ensure first */
+    inline void putUnchecked(uint8_t v0){
+        current[used++] = v0;
+    }
+
+    void putBytes(const char* data, size_t size){
+        while(size>0){
+            if(used==capacity){
+                newChunk(size);
+            }
+            size_t n = capacity-used < size ? capacity-used : size;
+            memcpy(current+used,data,n);
+            used += n;
+            data += n;
+            size -= n;
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for(size_t i = 0; i<chunks.size(); i++){
+            total += chunks[i].used;
+        }
+        return total + used;
+    }
+
+    /* Copies the contents to a contiguous string */
+    void flatten(std::string& out){
+        sync();
+        out.clear();
+        out.reserve(size());
+        for(size_t i = 0; i<chunks.size(); i++){
+            out.append(chunks[i].data,chunks[i].used);
+        }
+    }
+
+    /* Writes all the chunks to the file. Returns false on failure */
+    bool writeFile(const char* filename){
+        sync();
+#if defined(_WIN32)
+        FILE* file = fopen(filename,"wb");
+        if(!file){
+            return false;
+        }
+        for(size_t i = 0; i<chunks.size(); i++){
+            if(fwrite(chunks[i].data,1,chunks[i].used,file)!=chunks[i].used){
+                fclose(file);
+                return false;
+            }
+        }
+        return 0==fclose(file);
+#else
+        int fd = open(filename,O_WRONLY|O_CREAT|O_TRUNC,0666);
+        if(fd<0){
+            return false;
+        }
+        std::vector<struct iovec> iov(chunks.size());
+        for(size_t i = 0; i<chunks.size(); i++){
+            iov[i].iov_base = chunks[i].data;
+            iov[i].iov_len  = chunks[i].used;
+        }
+        size_t first = 0;
+        while(first<iov.size()){
+            int count = iov.size()-first > IOV_MAX ? IOV_MAX : iov.size()-first;
+            ssize_t written = writev(fd,&iov[first],count);
+            if(written<0){
+                if(errno==EINTR){
+                    continue;
+                }
+                close(fd);
+                return false;
+            }
+            /* Skip the fully written chunks and adjust for partial writes */
+            while(first<iov.size() && (size_t)written>=iov[first].iov_len){
+                written -= iov[first].iov_len;
+                first++;
+            }
+            if(first<iov.size()){
+                iov[first].iov_base = (char*)iov[first].iov_base+written;
+                iov[first].iov_len -= written;
+            }
+        }
+        return 0==close(fd);
+#endif
+    }
+
+private:
+    struct Chunk {
+        char*  data;
+        size_t used;
+    };
+
+    /* Stores the used size of the current chunk */
+    void sync(){
+        if(current){
+            chunks.back().used = used;
+        }
+    }
+
+    void newChunk(size_t n){
+        sync();
+        capacity = n > chunk_size ? n : chunk_size;
+        current  = (char*)malloc(capacity);
+        if(!current){
+            throw std::bad_alloc();
+        }
+        used = 0;
+        Chunk c = {current,0};
+        chunks.push_back(c);
+    }
+
+    std::vector<Chunk> chunks;
+    size_t chunk_size;
+    char*  current;
+    size_t used;
+    size_t capacity;
+};
+
+/* Open-addressing (linear probing) hash table mapping object addresses to the index
+   they got when they were first serialized. Indices are handed out in insertion order. */
+class ObjectCache {
+public:
+    ObjectCache(size_t initial_capacity = 1<<16) : count(0) {
+        size_t capacity = 16;
+        while(capacity<initial_capacity){
+            capacity <<= 1;
+        }
+        keys.assign(capacity,(void*)NULL);
+        values.resize(capacity);
+        mask = capacity-1;
+    }
+
+    /* Inserts the pointer if not present. Returns true if it was new; index is set to the object index */
+    inline bool insert(void* ptr, uint64_t &index){
+        size_t i = hash(ptr) & mask;
+        while(keys[i]){
+            if(keys[i]==ptr){
+                index = values[i];
+                return false;
+            }
+            i = (i+1) & mask;
+        }
+        keys[i]   = ptr;
+        values[i] = index = count++;
+        if(2*count > keys.size()){ // keep the load factor below 0.5
+            grow();
+        }
+        return true;
+    }
+
+    uint64_t size() const {
+        return count;
+    }
+
+private:
+    static inline size_t hash(void* ptr){
+        /* Finalizer of MurmurHash3; the low bits of pointers are always aligned */
+        uint64_t x = (uint64_t)(uintptr_t)ptr;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return (size_t)x;
+    }
+
+    void grow(){
+        std::vector<void*> old_keys;
+        std::vector<uint64_t> old_values;
+        old_keys.swap(keys);
+        old_values.swap(values);
+        keys.assign(old_keys.size()*2,(void*)NULL);
+        values.resize(old_keys.size()*2);
+        mask = keys.size()-1;
+        for(size_t j = 0; j<old_keys.size(); j++){
+            if(old_keys[j]){
+                size_t i = hash(old_keys[j]) & mask;
+                while(keys[i]){
+                    i = (i+1) & mask;
+                }
+                keys[i]   = old_keys[j];
+                values[i] = old_values[j];
+            }
+        }
+    }
+
+    std::vector<void*>    keys;
+    std::vector<uint64_t> values;
+    size_t   mask;
+    uint64_t count;
+};
+
 /* Writes 8 bits to the buffer */
-void write8(uint8_t v0,std::string& buffer){
-    buffer.push_back(v0);
-    //printf("%02X ",v0);
+static inline void write8(uint8_t v0,OutputBuffer& buffer){
+    buffer.put(v0);
 }
 
 /* Writes 16 bits to the buffer */
-void write16(uint16_t v0,std::string& buffer){
-    uint8_t h = (v0 & 0xFF00)>>8;
-    uint8_t l = v0 & 0xFF;
-    buffer.push_back(h);
-    buffer.push_back(l);
-    //printf("%02X ",h);
-    //printf("%02X ",l);
+static inline void write16(uint16_t v0,OutputBuffer& buffer){
+    buffer.ensure(2);
+    buffer.putUnchecked((v0 & 0xFF00)>>8);
+    buffer.putUnchecked(v0 & 0xFF);
 }
 
 /* Writes 32 bits to the buffer */
-void write32(uint32_t v0,std::string& buffer){
-    write16((v0>>16) & 0xFFFF,buffer);
-    write16(v0       & 0xFFFF,buffer);
+static inline void write32(uint32_t v0,OutputBuffer& buffer){
+    buffer.ensure(4);
+    buffer.putUnchecked((v0>>24) & 0xFF);
+    buffer.putUnchecked((v0>>16) & 0xFF);
+    buffer.putUnchecked((v0>>8)  & 0xFF);
+    buffer.putUnchecked(v0       & 0xFF);
 }
 
 /* Writes 64 bits to the buffer */
-void write64(uint64_t v0,std::string& buffer){
+static inline void write64(uint64_t v0,OutputBuffer& buffer){
     write32((v0>>32) & 0xFFFFFFFF,buffer);
     write32(v0       & 0xFFFFFFFF,buffer);
 }
 
 /* Writes a tag value */
-void writeTag(uint8_t v0,std::string& buffer){
+static inline void writeTag(uint8_t v0,OutputBuffer& buffer){
     write8(v0,buffer);
 }
 
 /* Writes an integer considering the required size */
-void writeInt(mmc_sint_t value,std::string& buffer){
+void writeInt(mmc_sint_t value,OutputBuffer& buffer){
     if(value >= -8 && value <= 7){ // tiny integer
         writeTag(TAG_INT_TINY | (0x0F & value),buffer);
     }
-    else if(value >= -2147483648 && value <= 2147483647) // regular 32 signed int
+    else if(value >= -2147483648LL && value <= 2147483647LL) // regular 32 signed int
     {
         int32_t cropped = value;
         uint32_t* pv    = (uint32_t*)&cropped;
@@ -89,14 +316,15 @@ void writeInt(mmc_sint_t value,std::string& buffer){
 }
 
 /* Writes an real value always as 64 bits */
-void writeReal(double value,std::string& buffer){
+void writeReal(double value,OutputBuffer& buffer){
     writeTag(TAG_DOUBLE,buffer);    // double -> 3
-    unsigned long long* ivalue = (unsigned long long*) &value;
-    write64(*ivalue,buffer);
+    uint64_t ivalue;
+    memcpy(&ivalue,&value,sizeof(double));
+    write64(ivalue,buffer);
 }
 
 /* Writes a string considering the required size */
-void writeString(mmc_uint_t size,const char* data,std::string& buffer){
+void writeString(mmc_uint_t size,const char* data,OutputBuffer& buffer){
     if(size<256){
         writeTag(TAG_STRING_SMALL,buffer);
         write8(size,buffer);
@@ -105,14 +333,10 @@ void writeString(mmc_uint_t size,const char* data,std::string& buffer){
         writeTag(TAG_STRING_BIG,buffer);
         write64(size,buffer);
     }
-    mmc_uint_t i = 0;
-    while(i<size){
-        write8(data[i],buffer);
-        i++;
-    }
+    buffer.putBytes(data,size);
 }
 
-void writeStruct(mmc_uint_t size,mmc_uint_t ctor,std::string& buffer){
+void writeStruct(mmc_uint_t size,mmc_uint_t ctor,OutputBuffer& buffer){
     if(size<16){
         writeTag(TAG_STRUCT_SMALL|(size&0x0F),buffer);
     }
@@ -123,7 +347,7 @@ void writeStruct(mmc_uint_t size,mmc_uint_t ctor,std::string& buffer){
     write8(ctor,buffer);
 }
 
-void writeShared(mmc_uint_t index,std::string& buffer){
+void writeShared(uint64_t index,OutputBuffer& buffer){
     //printf("shared(%i) -> ",index);
     if(index<=0xFFFF){
         writeTag(TAG_SHARED_TINY,buffer);
@@ -144,11 +368,10 @@ void writeShared(mmc_uint_t index,std::string& buffer){
 
 /* Tries to insert the object to the seen-object list. If it has been found before it writes a shared object instead.
    Returns true if the object is new, false if it's shared */
-bool isNewObject(void* ptr,std::string& buffer, std::map<void*,uint64_t> &objcache){
-    std::pair<std::map<void*,uint64_t>::iterator,bool> ret;
-    ret = objcache.insert(std::pair<void*,uint64_t>(ptr,objcache.size()));
-    if(ret.second==false){
-        writeShared(ret.first->second,buffer);
+static inline bool isNewObject(void* ptr,OutputBuffer& buffer, ObjectCache &objcache){
+    uint64_t index;
+    if(!objcache.insert(ptr,index)){
+        writeShared(index,buffer);
         return false;
     }
     //printf("%i:",objcache.size()-1);
@@ -156,7 +379,7 @@ bool isNewObject(void* ptr,std::string& buffer, std::map<void*,uint64_t> &objcac
 }
 
 /* Record descriptions are serialized as [path,name,[field1,...,fieldn]] */
-void writeRecordDescription(struct record_description* desc,mmc_uint_t slots,std::string& buffer,std::map<void*,uint64_t> &objcache){
+void writeRecordDescription(struct record_description* desc,mmc_uint_t slots,OutputBuffer& buffer,ObjectCache &objcache){
     mmc_uint_t size = 0;
     //printf("ctor(%i,%i) -> ", 3,255);
     writeStruct(3,255,buffer); // Serializes the objec as an array.
@@ -193,18 +416,18 @@ void writeRecordDescription(struct record_description* desc,mmc_uint_t slots,std
     }
 }
 
-void serialize(modelica_metatype input_object,std::string& buffer){
+void serialize(modelica_metatype input_object,OutputBuffer& buffer){
 
-    std::stack<modelica_metatype> objstack;
-    std::map<void*,uint64_t> objcache;
-    buffer.reserve(1024*1024);
+    std::vector<modelica_metatype> objstack;
+    ObjectCache objcache;
     //Inserts the object to the stack
-    objstack.push(input_object);
+    objstack.reserve(1024);
+    objstack.push_back(input_object);
 
     while(!objstack.empty()){
         // Takes the next object in the stack
-        modelica_metatype object = objstack.top();
-        objstack.pop();
+        modelica_metatype object = objstack.back();
+        objstack.pop_back();
 
         /* Integer */
         if(MMC_IS_IMMEDIATE(object)){
@@ -251,7 +474,7 @@ void serialize(modelica_metatype input_object,std::string& buffer){
                 }
                 // Push the sub-objects to the stack
                 while(count>left){
-                    objstack.push(MMC_FETCH(MMC_OFFSET(ptr, count)));
+                    objstack.push_back(MMC_FETCH(MMC_OFFSET(ptr, count)));
                     count--;
                 }
             }
@@ -276,35 +499,56 @@ void readFile(char* filename,std::string& buffer){
                 std::istreambuf_iterator<char>());
 }
 
+/* Thrown by the readers below if the data is truncated or corrupt.
+   It never leaves deserialize, which turns it into a NULL result. */
+struct DeserializeError {};
+
+/* Checks that n more bytes can be read at index */
+static inline void checkAvailable(mmc_uint_t index,mmc_uint_t n,mmc_uint_t length){
+    if(index > length || n > length-index){
+        throw DeserializeError();
+    }
+}
+
+/* Returns the tag of the next object without moving the index forward */
+static inline uint8_t peekTag(mmc_uint_t index,unsigned char* data,mmc_uint_t length){
+    checkAvailable(index,1,length);
+    return data[index]&0xF0;
+}
+
 /* Reads 16 bits from the buffer and moves the index forward */
-uint16_t read16(mmc_uint_t &index,unsigned char* data){
+uint16_t read16(mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
+    checkAvailable(index,2,length);
     uint16_t value = (uint16_t)data[index]<<8 | data[index+1];
     index+=2;
     return value;
 }
 
 /* Reads 32 bits from the buffer and moves the index forward */
-uint32_t read32(mmc_uint_t &index,unsigned char* data){
+uint32_t read32(mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
+    checkAvailable(index,4,length);
     uint32_t value = (uint32_t)data[index]<<24 | (uint32_t)data[index+1]<<16 | (uint32_t)data[index+2]<<8 | (uint32_t)data[index+3];
     index+=4;
     return value;
 }
 
-/* Reads 32 bits from the buffer and moves the index forward */
-uint64_t read64(mmc_uint_t &index,unsigned char* data){
+/* Reads 64 bits from the buffer and moves the index forward */
+uint64_t read64(mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
+    checkAvailable(index,8,length);
     uint64_t value =
-            (uint64_t)data[index]<<56 | (uint64_t)data[index+1]<<48 | (uint64_t)data[index+2]<<32 | (uint64_t)data[index+3] | (uint64_t)data[index+4]<<24 | (uint64_t)data[index+5]<<16 | (uint64_t)data[index+6]<<8 | (uint64_t)data[index+7];
+            (uint64_t)data[index]<<56 | (uint64_t)data[index+1]<<48 | (uint64_t)data[index+2]<<40 | (uint64_t)data[index+3]<<32 | (uint64_t)data[index+4]<<24 | (uint64_t)data[index+5]<<16 | (uint64_t)data[index+6]<<8 | (uint64_t)data[index+7];
     index+=8;
     return value;
 }
 
-modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
     uint8_t uvalue8;
     int8_t  value8;
     int32_t value32;
     int64_t value64;
     switch(tag){
         case TAG_INT_TINY:
+            checkAvailable(index,1,length);
             uvalue8 = data[index]&0x0F;
             if(uvalue8>7)
                 value8 = uvalue8 | 0xF0;
@@ -315,44 +559,52 @@ modelica_metatype readInteger(uint8_t tag,mmc_uint_t &index,unsigned char* data)
             return mmc_mk_integer(value8);
         case TAG_INT_SMALL:
             index++;
-            value32 = read32(index,data);
+            value32 = read32(index,data,length);
             //printf("%i\n", value32);
             return mmc_mk_integer(value32);
         case TAG_INT_BIG:
             index++;
-            value64 = read64(index,data);
+            value64 = read64(index,data,length);
             //printf("%i\n", value64);
             return mmc_mk_integer(value64);
-        default: return mmc_mk_integer(0);
+        default: throw DeserializeError();
     }
 }
 
 
-modelica_metatype readReal(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+modelica_metatype readReal(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
     index++;
-    uint64_t ivalue = read64(index,data);
-    double* fvalue = (double*)(&ivalue);
-    //printf("%f\n", *fvalue);
-    return mmc_mk_real(*fvalue);
+    uint64_t ivalue = read64(index,data,length);
+    double fvalue;
+    memcpy(&fvalue,&ivalue,sizeof(double));
+    //printf("%f\n", fvalue);
+    return mmc_mk_real(fvalue);
 }
 
-
-modelica_metatype readString(uint8_t tag,mmc_uint_t &index,unsigned char* data){
+/* Reads the size of a string and checks that its characters are in the buffer */
+static uint64_t readStringSize(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
     uint64_t size = 0;
     switch(tag){
         case TAG_STRING_SMALL:
             index++;
+            checkAvailable(index,1,length);
             size = data[index];
             index++;
             break;
         case TAG_STRING_BIG:
             index++;
-            size = read64(index,data);
+            size = read64(index,data,length);
             break;
-        default: break;
+        default: throw DeserializeError();
     }
+    checkAvailable(index,size,length);
+    return size;
+}
 
-    modelica_metatype res = mmc_mk_scon_len(size+1);
+modelica_metatype readString(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
+    uint64_t size = readStringSize(tag,index,data,length);
+
+    modelica_metatype res = mmc_mk_scon_len(size);
     const char* str = (const char*)&(data[index]);
     index += size;
 
@@ -366,20 +618,8 @@ modelica_metatype readString(uint8_t tag,mmc_uint_t &index,unsigned char* data){
     return res;
 }
 
-char* readString_raw(uint8_t tag,mmc_uint_t &index,unsigned char* data){
-    uint64_t size = 0;
-    switch(tag){
-        case TAG_STRING_SMALL:
-            index++;
-            size = data[index];
-            index++;
-            break;
-        case TAG_STRING_BIG:
-            index++;
-            size = read64(index,data);
-            break;
-        default: break;
-    }
+char* readString_raw(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length){
+    uint64_t size = readStringSize(tag,index,data,length);
 
     char* res = new char[size+1];
     const char* str = (const char*)&(data[index]);
@@ -394,46 +634,47 @@ char* readString_raw(uint8_t tag,mmc_uint_t &index,unsigned char* data){
     return res;
 }
 
-modelica_metatype readShared(uint8_t tag,mmc_uint_t &index,unsigned char* data,std::vector<modelica_metatype> &shared){
-    uint64_t i64;
-    uint16_t i16;
-    uint32_t i32;
+modelica_metatype readShared(uint8_t tag,mmc_uint_t &index,unsigned char* data,mmc_uint_t length,std::vector<modelica_metatype> &shared){
+    uint64_t i;
     index++;
     switch(tag){
         case TAG_SHARED_TINY:
-            i16 = read16(index,data);
-            //printf("shared(%i)\n",i16);
-            return shared[i16];
+            i = read16(index,data,length);
             break;
         case TAG_SHARED_SMALL:
-            i32 = read32(index,data);
-            //printf("shared(%i)\n",i32);
-            return shared[i32];
+            i = read32(index,data,length);
             break;
         case TAG_SHARED_BIG:
-            i64 = read64(index,data);
-            //printf("shared(%i)\n",i64);
-            return shared[i64];
+            i = read64(index,data,length);
             break;
-        default: break;
+        default: throw DeserializeError();
     }
-    return 0;
+    //printf("shared(%i)\n",i);
+    // only objects that were read before can be referenced
+    if(i>=shared.size() || shared[i]==0){
+        throw DeserializeError();
+    }
+    return shared[i];
 }
 
-void readStruct(uint8_t tag, mmc_uint_t &index, uint8_t* data, mmc_uint_t &size, mmc_uint_t &ctor){
+void readStruct(uint8_t tag, mmc_uint_t &index, uint8_t* data, mmc_uint_t length, mmc_uint_t &size, mmc_uint_t &ctor){
     switch(tag){
         case TAG_STRUCT_SMALL:
+            checkAvailable(index,1,length);
             size = data[index] & 0x0F;
             index++;
             break;
         case TAG_STRUCT_BIG:
             index++;
-            size = read64(index,data);
+            size = read64(index,data,length);
             break;
-        default: break;
+        default: throw DeserializeError();
     }
+    checkAvailable(index,1,length);
     ctor = data[index];
     index++;
+    // every field takes at least one byte; this also bounds the allocation
+    checkAvailable(index,size,length);
 }
 
 modelica_metatype allocValue(mmc_uint_t size,mmc_uint_t ctor){
@@ -449,123 +690,141 @@ void setToNextField(modelica_metatype sub,std::stack<std::pair<modelica_metatype
 }
 
 /* This is a special case of the de-serialization to restore the record_descriptions */
-record_description* readRecordDescription(mmc_uint_t &index,unsigned char* data,std::vector<modelica_metatype> &shared){
+record_description* readRecordDescription(mmc_uint_t &index,unsigned char* data,mmc_uint_t length,std::vector<modelica_metatype> &shared){
     mmc_uint_t size,ctor;
     struct record_description* pdesc;
-    uint8_t tag = data[index]&0xF0;
+    uint8_t tag = peekTag(index,data,length);
     switch(tag){
         case TAG_SHARED_TINY:
         case TAG_SHARED_SMALL:
         case TAG_SHARED_BIG:
-            pdesc = (struct record_description*)readShared(tag,index,data,shared);
+            pdesc = (struct record_description*)readShared(tag,index,data,length,shared);
             break;
 
         case TAG_STRUCT_SMALL:
         case TAG_STRUCT_BIG:
           {
-            readStruct(tag,index,data,size,ctor); // skipping since we already know what it is
+            readStruct(tag,index,data,length,size,ctor); // skipping since we already know what it is
             // Read the path
-            char* path = readString_raw(data[index]&0xF0,index,data);
+            char* path = readString_raw(peekTag(index,data,length),index,data,length);
+            char* name = NULL;
+            char** fields = NULL;
+            mmc_uint_t numFields = 0;
             // check if we already have a description for this path
+            // the lock is held until the description is complete
+            pthread_mutex_lock(&record_cache_lock);
             std::map<std::string,record_description*>::iterator it = record_cache.find(std::string(path));
 
-            if(it==record_cache.end()){
-                pdesc = new struct record_description;
-                shared.push_back(pdesc);
-
-                shared.push_back(path);
-                // Read the name
-                char* name = readString_raw(data[index]&0xF0,index,data);
-                shared.push_back(name);
-                // Read the array
-                readStruct(data[index]&0xF0,index,data,size,ctor); // this should be an array
-                shared.push_back(0); // pushes anything since this objects are not reused
-                char** fields = new char*[size];
-                // Now read the fields
-                for(int i=0;i<size;i++){
-                    char* field = readString_raw(data[index]&0xF0,index,data);
-                    shared.push_back(field);
-                    fields[i] = field;
-                }
-                pdesc->path = path;
-                pdesc->name = name;
-                pdesc->fieldNames = (const char**) fields;
-                // Insert the record description to the global cache of descriptions
-                record_cache.insert( std::pair<std::string,record_description*>(std::string(path),pdesc));
-            }
-            else {
-                pdesc = it->second;
-                // Now we read the data but we release the memory since we are not gonna use it
-                // (This part can be optimized)
-                shared.push_back(pdesc);
-                shared.push_back(0);
-                // Read the name
-                char* name = readString_raw(data[index]&0xF0,index,data);
-                shared.push_back(0);
-                // Read the array
-                readStruct(data[index]&0xF0,index,data,size,ctor); // this should be an array
-                shared.push_back(0); // pushes anything since this objects are not reused
-                // Now read the fields
-                for(int i=0;i<size;i++){
-                    char* field = readString_raw(data[index]&0xF0,index,data);
-                    delete[] field;
-                    shared.push_back(0);
-                }
-                delete[] path;
-                delete[] name;
+            try {
+              if(it==record_cache.end()){
+                  // Read the name
+                  name = readString_raw(peekTag(index,data,length),index,data,length);
+                  // Read the array
+                  readStruct(peekTag(index,data,length),index,data,length,size,ctor); // this should be an array
+                  fields = new char*[size];
+                  // Now read the fields (the field names are not shared objects)
+                  for(numFields=0;numFields<size;numFields++){
+                      fields[numFields] = readString_raw(peekTag(index,data,length),index,data,length);
+                  }
+                  pdesc = new struct record_description;
+                  pdesc->path = path;
+                  pdesc->name = name;
+                  pdesc->fieldNames = (const char**) fields;
+                  shared.push_back(pdesc);
+                  shared.push_back(0); // the path, name and array are never referenced
+                  shared.push_back(0);
+                  shared.push_back(0);
+                  // Insert the record description to the global cache of descriptions
+                  record_cache.insert( std::pair<std::string,record_description*>(std::string(path),pdesc));
+              }
+              else {
+                  pdesc = it->second;
+                  // Now we read the data but we release the memory since we are not gonna use it
+                  // (This part can be optimized)
+                  // Read the name
+                  name = readString_raw(peekTag(index,data,length),index,data,length);
+                  // Read the array
+                  readStruct(peekTag(index,data,length),index,data,length,size,ctor); // this should be an array
+                  // Now read the fields
+                  for(mmc_uint_t i=0;i<size;i++){
+                      char* field = readString_raw(peekTag(index,data,length),index,data,length);
+                      delete[] field;
+                  }
+                  shared.push_back(pdesc);
+                  shared.push_back(0);
+                  shared.push_back(0);
+                  shared.push_back(0);
+                  delete[] path;
+                  delete[] name;
+              }
+            } catch(...) {
+              pthread_mutex_unlock(&record_cache_lock);
+              for(mmc_uint_t i=0;i<numFields;i++){
+                  delete[] fields[i];
+              }
+              delete[] fields;
+              delete[] name;
+              delete[] path;
+              throw;
             }
+            pthread_mutex_unlock(&record_cache_lock);
             break;
           }
         default:
-            pdesc = NULL;
+            throw DeserializeError();
     }
     return pdesc;
 }
 
-modelica_metatype deserialize(std::string& buffer){
+/* De-serializes length bytes of data. Returns NULL if the data is truncated or corrupt. */
+modelica_metatype deserialize(unsigned char* data,mmc_uint_t length){
     modelica_metatype  result,current;
     result = allocValue(1,0);
-    unsigned char* data = (unsigned char*) buffer.c_str();
     mmc_uint_t index = 0;
     mmc_uint_t size=0;
     mmc_uint_t ctor=0;
     std::vector<modelica_metatype> shared;
+    shared.reserve(1<<16);
     std::stack<std::pair<modelica_metatype,int> > stack;
 
     stack.push(std::make_pair(result,1));
 
+    try {
     while(!stack.empty()){
-       unsigned char tag = data[index] & 0xF0;
+       unsigned char tag = peekTag(index,data,length);
        switch(tag){ // integer
           case TAG_INT_TINY:
           case TAG_INT_SMALL:
           case TAG_INT_BIG:
-            current = readInteger(tag,index,data);
+            current = readInteger(tag,index,data,length);
             setToNextField(current,stack);
             break;
           case TAG_DOUBLE:
-            current = readReal(tag,index,data);
+            current = readReal(tag,index,data,length);
             setToNextField(current,stack);
             break;
           case TAG_STRING_SMALL:
           case TAG_STRING_BIG:
-            current = readString(tag,index,data);
+            current = readString(tag,index,data,length);
             setToNextField(current,stack);
             shared.push_back(current);
             break;
           case TAG_SHARED_TINY:
           case TAG_SHARED_SMALL:
           case TAG_SHARED_BIG:
-            current = readShared(tag,index,data,shared);
+            current = readShared(tag,index,data,length,shared);
             setToNextField(current,stack);
             break;
           case TAG_STRUCT_SMALL:
           case TAG_STRUCT_BIG:
             size = 0;
             ctor = 0;
-            readStruct(tag,index,data,size,ctor);
+            readStruct(tag,index,data,length,size,ctor);
             //printf("%i:ctor(%i,%i)\n",shared.size(),size,ctor);
             if(ctor>=3 && ctor!=255){ // not an array
+                if(size==0){ // a record always has its description
+                    throw DeserializeError();
+                }
                 current = allocValue(size,ctor);
                 shared.push_back(current);
                 setToNextField(current,stack);
@@ -573,7 +832,7 @@ modelica_metatype deserialize(std::string& buffer){
                     stack.push(std::make_pair(current,size));
                     size--;
                 }
-                modelica_metatype record_desc = readRecordDescription(index,data,shared);
+                modelica_metatype record_desc = readRecordDescription(index,data,length,shared);
                 setToNextField(record_desc,stack);
             }
             else {
@@ -586,11 +845,18 @@ modelica_metatype deserialize(std::string& buffer){
                 }
             }
             break;
-          default: break;
+          default:
+            // unknown tag, the data is corrupt
+            throw DeserializeError();
        }
     }
+    } catch(DeserializeError&) {
+        return NULL;
+    } catch(std::bad_alloc&) {
+        return NULL;
+    }
 #if 0
-    uint64_t total = read64(index,data);
+    uint64_t total = read64(index,data,length);
     printf("Sent %i :  Received %i\n",total,shared.size());
 #endif
     return MMC_FETCH(MMC_OFFSET(MMC_UNTAGPTR(result), 1));
@@ -664,18 +930,119 @@ void Serializer_showBlocks(modelica_metatype object){
 
 
 void Serializer_outputFile(modelica_metatype input_object,char* filename){
-    std::fstream fs;
-    std::string buffer;
+    OutputBuffer buffer;
     serialize(input_object,buffer);
-    fs.open (filename,std::fstream::out | std::fstream::binary);
-    fs.write(buffer.c_str(),buffer.size());
-    fs.close();
+    if(!buffer.writeFile(filename)){
+        MMC_THROW();
+    }
+}
+
+/* Files written by Serializer_outputFileWithKey start with the magic, the
+   length of the key (64 bits) and the key, followed by the object */
+static const char KEY_MAGIC[4] = {'O','M','S','K'};
+static const mmc_uint_t KEY_HEADER_SIZE = sizeof(KEY_MAGIC)+8;
+
+void Serializer_outputFileWithKey(modelica_metatype input_object,const char* key,char* filename){
+    bool ok;
+    {
+        OutputBuffer buffer;
+        size_t keyLength = strlen(key);
+        buffer.putBytes(KEY_MAGIC,sizeof(KEY_MAGIC));
+        write64(keyLength,buffer);
+        buffer.putBytes(key,keyLength);
+        serialize(input_object,buffer);
+        ok = buffer.writeFile(filename);
+    }
+    if(!ok){
+        MMC_THROW();
+    }
+}
+
+/* Returns the offset of the object if the data starts with the header for
+   the key, or 0 if it does not */
+static mmc_uint_t checkKeyHeader(unsigned char* data,mmc_uint_t length,const char* key){
+    size_t keyLength = strlen(key);
+    if(length < KEY_HEADER_SIZE || memcmp(data,KEY_MAGIC,sizeof(KEY_MAGIC))){
+        return 0;
+    }
+    mmc_uint_t index = sizeof(KEY_MAGIC);
+    if(read64(index,data,length)!=keyLength || length-index < keyLength || memcmp(data+index,key,keyLength)){
+        return 0;
+    }
+    return index+keyLength;
+}
+
+/* Deserializes the data, after checking the header if key is not NULL */
+static modelica_metatype deserializeWithKey(unsigned char* data,mmc_uint_t length,const char* key){
+    mmc_uint_t offset = 0;
+    if(key){
+        offset = checkKeyHeader(data,length,key);
+        if(offset==0){
+            return NULL;
+        }
+    }
+    return deserialize(data+offset,length-offset);
+}
+
+/* Reads back a file written by Serializer_outputFile (key==NULL) or
+   Serializer_outputFileWithKey. The file is mapped into memory instead of
+   being copied to a buffer first. */
+static modelica_metatype inputFile(char* filename,const char* key){
+    modelica_metatype out;
+#if defined(_WIN32)
+    {
+        std::string buffer;
+        readFile(filename,buffer);
+        out = buffer.empty() ? NULL : deserializeWithKey((unsigned char*) buffer.c_str(),buffer.size(),key);
+    }
+#else
+    struct stat st;
+    int fd = open(filename,O_RDONLY);
+    if(fd<0){
+        MMC_THROW();
+    }
+    if(fstat(fd,&st) || st.st_size==0){
+        close(fd);
+        MMC_THROW();
+    }
+    void* data = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(data==MAP_FAILED){
+        MMC_THROW();
+    }
+    madvise(data,st.st_size,MADV_SEQUENTIAL);
+    out = deserializeWithKey((unsigned char*) data,st.st_size,key);
+    munmap(data,st.st_size);
+#endif
+    if(out==NULL){
+        MMC_THROW();
+    }
+    return out;
+}
+
+modelica_metatype Serializer_inputFile(char* filename){
+    return inputFile(filename,NULL);
+}
+
+/* Fails without de-serializing anything if the file was written with a different key */
+modelica_metatype Serializer_inputFileWithKey(char* filename,const char* key){
+    return inputFile(filename,key);
 }
 
 modelica_metatype Serializer_bypass(modelica_metatype input_object){
-    std::string buffer;
-    serialize(input_object,buffer);
-    modelica_metatype out = deserialize(buffer);
+    modelica_metatype out;
+    {
+        std::string buffer;
+        {
+            OutputBuffer obuffer;
+            serialize(input_object,obuffer);
+            obuffer.flatten(buffer);
+        }
+        out = deserialize((unsigned char*) buffer.c_str(),buffer.size());
+    }
+    if(out==NULL){
+        MMC_THROW();
+    }
     //printf("Input object\n");
     //Serializer_showBlocks(input_object);
     //printf("Output object\n");
@@ -1603,6 +1603,151 @@ static void free_function(modelica_ptr_t func)
   /* fprintf(stderr, "FUNCTION FREE LIB index[%d]/count[%d]/handle[%ul].\n", (lib-ptr_vector),((modelica_ptr_t)(lib-ptr_vector))->cnt, lib->data.lib); fflush(stderr); */
 }
 
+#include "simulation_result_memory.h"
+
+typedef int (*simulate_in_memory_t)(int argc, char **argv, SIMULATION_MEMORY_RESULT *result);
+
+/* models loaded by SystemImpl__simulateInMemory, loaded again after they were rebuilt */
+typedef struct {
+  char *name;
+  time_t mtime;
+  ino_t inode;
+  int libIndex;
+  simulate_in_memory_t simulate;
+} loaded_model_t;
+
+static loaded_model_t *loadedModels = NULL;
+static int nLoadedModels = 0;
+/* the simulation runtime has global state, only one simulation may run at a time */
+static pthread_mutex_t simulateInMemoryMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static simulate_in_memory_t getSimulateInMemory(const char *libName)
+{
+  char libname[MAXPATHLEN];
+  const char *tokens[1] = {libname};
+  struct stat buf;
+  loaded_model_t *model = NULL;
+  int i;
+
+  snprintf(libname, MAXPATHLEN, "%s" CONFIG_DLL_EXT, libName);
+  if (stat(libname, &buf)) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Could not find the shared library %s of the model."),tokens,1);
+    return NULL;
+  }
+  for (i=0; i<nLoadedModels; i++) {
+    if (0==strcmp(loadedModels[i].name, libName)) {
+      model = loadedModels+i;
+      break;
+    }
+  }
+  if (model && model->simulate && model->mtime == buf.st_mtime && model->inode == buf.st_ino) {
+    return model->simulate;
+  }
+  if (model) {
+    /* the model was built again */
+    if (model->simulate) {
+      SystemImpl__freeLibrary(model->libIndex, 0);
+    }
+  } else {
+    loadedModels = (loaded_model_t*) realloc(loadedModels, (nLoadedModels+1)*sizeof(loaded_model_t));
+    model = loadedModels + nLoadedModels++;
+    model->name = strdup(libName);
+  }
+  model->simulate = NULL;
+  model->libIndex = SystemImpl__loadLibrary(libName, 0);
+  if (model->libIndex < 0) {
+    return NULL;
+  }
+  model->simulate = (simulate_in_memory_t) getFunctionPointerFromDLL(lookup_ptr(model->libIndex)->data.lib, "omc_simulateInMemory");
+  if (!model->simulate) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("The shared library %s was not built for simulations in memory, build the model again."),tokens,1);
+    SystemImpl__freeLibrary(model->libIndex, 0);
+    return NULL;
+  }
+  model->mtime = buf.st_mtime;
+  model->inode = buf.st_ino;
+  return model->simulate;
+}
+
+static void freeSimulationMemoryResult(SIMULATION_MEMORY_RESULT *result)
+{
+  int i;
+  for (i=0; i<result->nvars; i++) {
+    free(result->names[i]);
+  }
+  free(result->names);
+  free(result->data);
+}
+
+/* Runs one simulation of the model in the shared library libName (built by the
+ * omc_shared_library target of the generated makefile) in this process. args is the
+ * command line of the simulation. Returns the values of every variable in variables
+ * at all stored time points as list of lists, or NULL on failure.
+ */
+void* SystemImpl__simulateInMemory(const char *libName, void *args, void *variables)
+{
+  SIMULATION_MEMORY_RESULT result = {0};
+  simulate_in_memory_t simulate;
+  const char *tokens[2];
+  char buf[16];
+  char **argv;
+  int argc = listLength(args), nvars = listLength(variables), *columns;
+  int i, j, status;
+  long k;
+  void *res = mmc_mk_nil(), *lst;
+
+#if defined(__MINGW32__) || defined(_MSC_VER)
+  /* the simulation runtime reads the command line of the process on Windows */
+  c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Simulations in memory are not supported on Windows."),NULL,0);
+  return NULL;
+#endif
+
+  /* the runtime modifies some of the arguments */
+  argv = (char**) omc_alloc_interface.malloc((argc+1)*sizeof(char*));
+  for (i=0; i<argc; i++, args=MMC_CDR(args)) {
+    argv[i] = omc_alloc_interface.malloc_strdup(MMC_STRINGDATA(MMC_CAR(args)));
+  }
+  argv[argc] = NULL;
+
+  pthread_mutex_lock(&simulateInMemoryMutex);
+  simulate = getSimulateInMemory(libName);
+  status = simulate ? simulate(argc, argv, &result) : -1;
+  pthread_mutex_unlock(&simulateInMemoryMutex);
+  fflush(NULL);
+  if (!simulate) {
+    return NULL;
+  }
+  if (status) {
+    snprintf(buf, 16, "%d", status);
+    tokens[0] = libName;
+    tokens[1] = buf;
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("The simulation of %s failed with status %s."),tokens,2);
+    freeSimulationMemoryResult(&result);
+    return NULL;
+  }
+
+  columns = (int*) omc_alloc_interface.malloc_atomic(nvars*sizeof(int));
+  for (j=0; j<nvars; j++, variables=MMC_CDR(variables)) {
+    tokens[0] = MMC_STRINGDATA(MMC_CAR(variables));
+    for (i=0; i<result.nvars && strcmp(result.names[i], tokens[0]); i++);
+    if (i == result.nvars) {
+      c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Variable %s is not in the simulation result."),tokens,1);
+      freeSimulationMemoryResult(&result);
+      return NULL;
+    }
+    columns[j] = i;
+  }
+  for (j=nvars-1; j>=0; j--) {
+    lst = mmc_mk_nil();
+    for (k=result.npoints-1; k>=0; k--) {
+      lst = mmc_mk_cons(mmc_mk_rcon(result.data[k*result.nvars+columns[j]]), lst);
+    }
+    res = mmc_mk_cons(lst, res);
+  }
+  freeSimulationMemoryResult(&result);
+  return res;
+}
+
 static int SystemImpl__getVariableValue(double timeStamp, void* timeValues, void *varValues, double *returnValue)
 {
   // values to find the correct range
@@ -49,6 +49,9 @@
 
 pthread_once_t parser_once_create_key = PTHREAD_ONCE_INIT;
 pthread_key_t modelicaParserKey;
+#ifdef OMENCRYPTION
+static pthread_mutex_t lveInstanceLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 static void make_key()
 {
@@ -421,7 +424,22 @@ static void* parseFile(const char* fileName, const char* infoName, int flags, co
 
 #ifdef OMENCRYPTION
   if (len > 3 && 0==strcmp(fileName+len-4,".moc")) {
-    return parseEncryptedFile(fileName, langStd, runningTestsuite, libraryPath, lveInstance);
+    /* The library vendor executable is a single process talking over pipes;
+     * files of a library may be parsed in parallel, so serialize the requests.
+     * parseEncryptedFile may throw; the lock has to be released before rethrowing. */
+    threadData_t *threadData = (threadData_t*)pthread_getspecific(mmc_thread_data_key);
+    void * volatile res = NULL;
+    volatile int failed = 1;
+    pthread_mutex_lock(&lveInstanceLock);
+    MMC_TRY_INTERNAL(mmc_jumper)
+      res = parseEncryptedFile(fileName, langStd, runningTestsuite, libraryPath, lveInstance);
+      failed = 0;
+    MMC_CATCH_INTERNAL(mmc_jumper)
+    pthread_mutex_unlock(&lveInstanceLock);
+    if (failed) {
+      MMC_THROW_INTERNAL();
+    }
+    return res;
   }
 #else
   if (len > 3 && 0==strcmp(fileName+len-4,".moc")) {
@@ -0,0 +1,102 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * This file defines functions to evaluate an ensemble of instances of the
+ * same OpenModelica Simulation Unit (OMSU) in lockstep. Values of all
+ * instances are exchanged in structure-of-arrays layout
+ * `value[var*n_instances + instance]`, so an integrator can update the
+ * states of all instances with one loop over instances per variable.
+ */
+
+#ifndef OMSU_ENSEMBLE__H_
+#define OMSU_ENSEMBLE__H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <omsic.h>
+
+#include <omsu_getters_and_setters.h>
+#include <omsu_helper.h>
+
+
+/** \brief Ensemble of instances of the same OMSU. */
+typedef struct omsu_ensemble_t {
+    osu_t**             instances;      /**< Array of `n_instances` instances of the same model. */
+    omsi_unsigned_int   n_instances;    /**< Number of instances. */
+    omsi_unsigned_int   n_states;       /**< Number of continuous states of every instance. */
+    omsi_int*           index_buffer;   /**< Work array with resolved value references. */
+    omsi_unsigned_int   n_index_buffer; /**< Length of array `index_buffer`. */
+} omsu_ensemble_t;
+
+
+/* function prototypes */
+omsu_ensemble_t* omsu_new_ensemble(osu_t**              instances,
+                                   omsi_unsigned_int    n_instances);
+
+void omsu_free_ensemble(omsu_ensemble_t* ensemble);
+
+omsi_status omsu_ensemble_set_time(omsu_ensemble_t*     ensemble,
+                                   omsi_real            time);
+
+omsi_status omsu_ensemble_get_real(omsu_ensemble_t*         ensemble,
+                                   const omsi_unsigned_int  vr[],
+                                   omsi_unsigned_int        nvr,
+                                   omsi_real                value[]);
+
+omsi_status omsu_ensemble_set_real(omsu_ensemble_t*         ensemble,
+                                   const omsi_unsigned_int  vr[],
+                                   omsi_unsigned_int        nvr,
+                                   const omsi_real          value[]);
+
+omsi_status omsu_ensemble_set_continuous_states(omsu_ensemble_t*   ensemble,
+                                                const omsi_real    x[]);
+
+omsi_status omsu_ensemble_get_continuous_states(omsu_ensemble_t*   ensemble,
+                                                omsi_real          x[]);
+
+omsi_status omsu_ensemble_get_derivatives(omsu_ensemble_t*  ensemble,
+                                          omsi_real         derivatives[]);
+
+omsi_status omsu_ensemble_explicit_euler_step(omsu_ensemble_t*  ensemble,
+                                              omsi_real         h,
+                                              omsi_real         x[],
+                                              omsi_real         derivatives[]);
+
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,501 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/** \file omsu_ensemble.c
+ *
+ *  \brief Functions to evaluate many instances of one OMSU in lockstep.
+ *
+ * Ensemble and Monte-Carlo runs instantiate many identical OMSUs. Instead of
+ * calling the getters and setters of every instance with one value at a time,
+ * the functions of this file exchange the values of all instances at once.
+ * The values are stored structure-of-arrays, `value[var*n_instances + instance]`,
+ * so that the states of all instances are contiguous for every state and can
+ * be updated by the integrator with vectorized loops over the instances.
+ *
+ * Only the value exchange and the integrator update work on all instances at
+ * once. The generated equations are still evaluated instance by instance with
+ * the `evaluate` function of every OMSU, they are not vectorized over the
+ * instances.
+ */
+
+/** \defgroup Ensemble Ensemble Simulation
+ *  \ingroup OMSIC
+ *
+ * \brief Functions to evaluate instances of the same model in lockstep
+ */
+
+/** \addtogroup Ensemble
+  *  \{ */
+
+#include <omsu_ensemble.h>
+
+
+/*
+ * Check for an ensemble that is `NULL`.
+ */
+static omsi_bool ensembleNullPointer(omsu_ensemble_t*   ensemble,
+                                     omsi_string        function_name) {
+
+    if (!ensemble) {
+        filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                "%s: Invalid argument ensemble = NULL.", function_name);
+        return omsi_true;
+    }
+    return omsi_false;
+}
+
+
+/*
+ * Check that all instances of the ensemble are in one of the given states.
+ */
+static omsi_bool ensembleInvalidState(omsu_ensemble_t*  ensemble,
+                                      omsi_string       function_name,
+                                      omsi_int          meStates) {
+
+    /* Variables */
+    omsi_unsigned_int k;
+
+    for (k = 0; k < ensemble->n_instances; k++) {
+        if (invalidState(ensemble->instances[k], function_name, meStates, ~0)) {
+            return omsi_true;
+        }
+    }
+    return omsi_false;
+}
+
+
+/*
+ * Resolve aliases of the real value references `vr` once for all instances,
+ * returns NULL if a value reference is out of range.
+ */
+static omsi_int* ensembleResolveRealIndices(omsu_ensemble_t*            ensemble,
+                                            omsi_string                 function_name,
+                                            const omsi_unsigned_int     vr[],
+                                            omsi_unsigned_int           nvr) {
+
+    /* Variables */
+    omsi_unsigned_int i;
+    omsi_int index;
+    omsi_t* omsu = ensemble->instances[0]->osu_data;
+
+    if (nvr > ensemble->n_index_buffer) {
+        global_callback->freeMemory(ensemble->index_buffer);
+        ensemble->index_buffer = (omsi_int*) global_callback->allocateMemory(nvr, sizeof(omsi_int));
+        if (!ensemble->index_buffer) {
+            ensemble->n_index_buffer = 0;
+            filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                    "%s: Not enough memory.", function_name);
+            return NULL;
+        }
+        ensemble->n_index_buffer = nvr;
+    }
+
+    for (i = 0; i < nvr; i++) {
+        if (omsi_vr_out_of_range(omsu, function_name, vr[i], omsu->sim_data->model_vars_and_params->n_reals)) {
+            return NULL;
+        }
+        index = omsi_get_negated_index(&omsu->model_data->model_vars_info[vr[i]], vr[i]);
+        if (index < 0) {
+            index = -index;
+        }
+        if (omsi_vr_out_of_range(omsu, function_name, index, omsu->sim_data->model_vars_and_params->n_reals)) {
+            return NULL;
+        }
+        ensemble->index_buffer[i] = index;
+    }
+    return ensemble->index_buffer;
+}
+
+
+/**
+ * \brief Create an ensemble of instances of the same model.
+ *
+ * All instances must be instantiated from the same OMSU, i.e. have the same
+ * GUID. The ensemble does not take ownership of the instances.
+ *
+ * \param [in]  instances       Array of `n_instances` instances.
+ * \param [in]  n_instances     Length of array `instances`.
+ * \return                      Pointer to new ensemble or `NULL` if something went wrong.
+ */
+omsu_ensemble_t* omsu_new_ensemble(osu_t**              instances,
+                                   omsi_unsigned_int    n_instances) {
+
+    /* Variables */
+    omsu_ensemble_t* ensemble;
+    omsi_unsigned_int k;
+
+    if (n_instances == 0 || instances == NULL) {
+        filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                "omsu_new_ensemble: Invalid argument instances[] = NULL.");
+        return NULL;
+    }
+
+    for (k = 0; k < n_instances; k++) {
+        if (!instances[k] || !instances[k]->osu_data) {
+            filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                    "omsu_new_ensemble: Invalid argument instances[%u] = NULL.", k);
+            return NULL;
+        }
+    }
+
+    for (k = 1; k < n_instances; k++) {
+        if (strcmp(instances[k]->GUID, instances[0]->GUID) != 0
+            || instances[k]->osu_data->model_data->n_states != instances[0]->osu_data->model_data->n_states
+            || instances[k]->osu_data->sim_data->model_vars_and_params->n_reals != instances[0]->osu_data->sim_data->model_vars_and_params->n_reals) {
+            filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                    "omsu_new_ensemble: Instance %u is not an instance of the same model.", k);
+            return NULL;
+        }
+    }
+
+    ensemble = (omsu_ensemble_t*) global_callback->allocateMemory(1, sizeof(omsu_ensemble_t));
+    if (!ensemble) {
+        filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                "omsu_new_ensemble: Not enough memory.");
+        return NULL;
+    }
+    ensemble->instances = instances;
+    ensemble->n_instances = n_instances;
+    ensemble->n_states = instances[0]->osu_data->model_data->n_states;
+    ensemble->index_buffer = NULL;
+    ensemble->n_index_buffer = 0;
+
+    return ensemble;
+}
+
+
+/**
+ * \brief Free an ensemble, the instances themselves are not freed.
+ *
+ * \param [in,out]  ensemble    Ensemble to free.
+ */
+void omsu_free_ensemble(omsu_ensemble_t* ensemble) {
+
+    if (!ensemble) {
+        return;
+    }
+    global_callback->freeMemory(ensemble->index_buffer);
+    global_callback->freeMemory(ensemble);
+}
+
+
+/**
+ * \brief Set the time of all instances.
+ *
+ * \param [in,out]  ensemble        Ensemble of OMSU instances.
+ * \param [in]      time            New time.
+ * \return          omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_set_time(omsu_ensemble_t*     ensemble,
+                                   omsi_real            time) {
+
+    /* Variables */
+    omsi_unsigned_int k;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_set_time")) {
+        return omsi_error;
+    }
+
+    for (k = 0; k < ensemble->n_instances; k++) {
+        if (omsi_set_time(ensemble->instances[k], time) != omsi_ok) {
+            return omsi_error;
+        }
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Get real variables of all instances.
+ *
+ * \param [in]  ensemble        Ensemble of OMSU instances.
+ * \param [in]  vr              Array of value references for real variables to get.
+ * \param [in]  nvr             Length of array `vr`.
+ * \param [out] value           Array of length `nvr*n_instances`, contains the value of
+ *                              `vr[i]` of instance `k` at `value[i*n_instances + k]`.
+ * \return      omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_get_real(omsu_ensemble_t*         ensemble,
+                                   const omsi_unsigned_int  vr[],
+                                   omsi_unsigned_int        nvr,
+                                   omsi_real                value[]) {
+
+    /* Variables */
+    omsi_unsigned_int i, k, n;
+    omsi_int* index;
+    omsi_real* reals;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_get_real")) {
+        return omsi_error;
+    }
+    if (nvr == 0) {
+        return omsi_ok;
+    }
+    if (ensembleInvalidState(ensemble, "omsu_ensemble_get_real", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError)) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_get_real", "vr[]", vr)
+        || nullPointer(ensemble->instances[0], "omsu_ensemble_get_real", "value[]", value)) {
+        return omsi_error;
+    }
+    index = ensembleResolveRealIndices(ensemble, "omsu_ensemble_get_real", vr, nvr);
+    if (!index) {
+        return omsi_error;
+    }
+
+    n = ensemble->n_instances;
+    for (k = 0; k < n; k++) {
+        reals = ensemble->instances[k]->osu_data->sim_data->model_vars_and_params->reals;
+        for (i = 0; i < nvr; i++) {
+            value[i*n + k] = reals[index[i]];
+        }
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Set real variables of all instances.
+ *
+ * \param [in,out]  ensemble        Ensemble of OMSU instances.
+ * \param [in]      vr              Array of value references for real variables to set.
+ * \param [in]      nvr             Length of array `vr`.
+ * \param [in]      value           Array of length `nvr*n_instances`, contains the value of
+ *                                  `vr[i]` of instance `k` at `value[i*n_instances + k]`.
+ * \return          omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_set_real(omsu_ensemble_t*         ensemble,
+                                   const omsi_unsigned_int  vr[],
+                                   omsi_unsigned_int        nvr,
+                                   const omsi_real          value[]) {
+
+    /* Variables */
+    omsi_unsigned_int i, k, n;
+    omsi_int* index;
+    omsi_real* reals;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_set_real")) {
+        return omsi_error;
+    }
+    if (nvr == 0) {
+        return omsi_ok;
+    }
+    if (ensembleInvalidState(ensemble, "omsu_ensemble_set_real", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode)) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_set_real", "vr[]", vr)
+        || nullPointer(ensemble->instances[0], "omsu_ensemble_set_real", "value[]", value)) {
+        return omsi_error;
+    }
+    index = ensembleResolveRealIndices(ensemble, "omsu_ensemble_set_real", vr, nvr);
+    if (!index) {
+        return omsi_error;
+    }
+
+    n = ensemble->n_instances;
+    for (k = 0; k < n; k++) {
+        reals = ensemble->instances[k]->osu_data->sim_data->model_vars_and_params->reals;
+        for (i = 0; i < nvr; i++) {
+            reals[index[i]] = value[i*n + k];
+        }
+        ensemble->instances[k]->_need_update = omsi_true;
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Set the continuous states of all instances.
+ *
+ * \param [in,out]  ensemble        Ensemble of OMSU instances.
+ * \param [in]      x               Array of length `n_states*n_instances`, contains state `i`
+ *                                  of instance `k` at `x[i*n_instances + k]`.
+ * \return          omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_set_continuous_states(omsu_ensemble_t*   ensemble,
+                                                const omsi_real    x[]) {
+
+    /* Variables */
+    omsi_unsigned_int i, k, n;
+    osu_t* OSU;
+    omsi_real* reals;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_set_continuous_states")) {
+        return omsi_error;
+    }
+    if (ensembleInvalidState(ensemble, "omsu_ensemble_set_continuous_states", modelInstantiated|modelInitializationMode|modelEventMode|modelContinuousTimeMode)) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_set_continuous_states", "x[]", x)) {
+        return omsi_error;
+    }
+
+    n = ensemble->n_instances;
+    for (k = 0; k < n; k++) {
+        OSU = ensemble->instances[k];
+        reals = OSU->osu_data->sim_data->model_vars_and_params->reals;
+        for (i = 0; i < ensemble->n_states; i++) {
+            reals[OSU->vrStates[i]] = x[i*n + k];
+        }
+        OSU->_need_update = omsi_true;
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Get the continuous states of all instances.
+ *
+ * \param [in]  ensemble        Ensemble of OMSU instances.
+ * \param [out] x               Array of length `n_states*n_instances`, contains state `i`
+ *                              of instance `k` at `x[i*n_instances + k]`.
+ * \return      omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_get_continuous_states(omsu_ensemble_t*   ensemble,
+                                                omsi_real          x[]) {
+
+    /* Variables */
+    omsi_unsigned_int i, k, n;
+    osu_t* OSU;
+    omsi_real* reals;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_get_continuous_states")) {
+        return omsi_error;
+    }
+    if (ensembleInvalidState(ensemble, "omsu_ensemble_get_continuous_states", modelInitializationMode|modelEventMode|modelContinuousTimeMode|modelTerminated|modelError)) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_get_continuous_states", "x[]", x)) {
+        return omsi_error;
+    }
+
+    n = ensemble->n_instances;
+    for (k = 0; k < n; k++) {
+        OSU = ensemble->instances[k];
+        reals = OSU->osu_data->sim_data->model_vars_and_params->reals;
+        for (i = 0; i < ensemble->n_states; i++) {
+            x[i*n + k] = reals[OSU->vrStates[i]];
+        }
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Evaluate all instances that need an update and get their state derivatives.
+ *
+ * \param [in,out]  ensemble        Ensemble of OMSU instances.
+ * \param [out]     derivatives     Array of length `n_states*n_instances`, contains derivative `i`
+ *                                  of instance `k` at `derivatives[i*n_instances + k]`.
+ * \return          omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_get_derivatives(omsu_ensemble_t*  ensemble,
+                                          omsi_real         derivatives[]) {
+
+    /* Variables */
+    omsi_unsigned_int i, k, n, nx;
+    osu_t* OSU;
+    omsi_real* reals;
+
+    if (ensembleNullPointer(ensemble, "omsu_ensemble_get_derivatives")) {
+        return omsi_error;
+    }
+    if (ensembleInvalidState(ensemble, "omsu_ensemble_get_derivatives", modelEventMode|modelContinuousTimeMode|modelTerminated|modelError)) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_get_derivatives", "derivatives[]", derivatives)) {
+        return omsi_error;
+    }
+
+    n = ensemble->n_instances;
+    nx = ensemble->n_states;
+    for (k = 0; k < n; k++) {
+        OSU = ensemble->instances[k];
+        if (OSU->_need_update) {
+            if (OSU->osu_data->sim_data->simulation->evaluate(OSU->osu_data->sim_data->simulation,
+                    OSU->osu_data->sim_data->model_vars_and_params, NULL) != omsi_ok) {
+                filtered_base_logger(global_logCategories, log_statuserror, omsi_error,
+                        "omsu_ensemble_get_derivatives: Evaluation of instance %u failed.", k);
+                return omsi_error;
+            }
+            OSU->_need_update = omsi_false;
+        }
+        /* derivatives follow the states, see omsi_get_derivatives */
+        reals = OSU->osu_data->sim_data->model_vars_and_params->reals;
+        for (i = 0; i < nx; i++) {
+            derivatives[i*n + k] = reals[nx + i];
+        }
+    }
+    return omsi_ok;
+}
+
+
+/**
+ * \brief Perform one explicit Euler step for all instances in lockstep.
+ *
+ * Evaluates the derivatives of all instances at the current states, updates
+ * the states with one loop over all instances per state and advances the time
+ * of all instances by `h`.
+ *
+ * \param [in,out]  ensemble        Ensemble of OMSU instances.
+ * \param [in]      h               Step size.
+ * \param [in,out]  x               Current states of all instances, see `omsu_ensemble_get_continuous_states`.
+ * \param [out]     derivatives     Work array of length `n_states*n_instances`.
+ * \return          omsi_status     Exit status of function.
+ */
+omsi_status omsu_ensemble_explicit_euler_step(omsu_ensemble_t*  ensemble,
+                                              omsi_real         h,
+                                              omsi_real         x[],
+                                              omsi_real         derivatives[]) {
+
+    /* Variables */
+    omsi_unsigned_int j, length;
+    omsi_real time;
+
+    if (omsu_ensemble_get_derivatives(ensemble, derivatives) != omsi_ok) {
+        return omsi_error;
+    }
+    if (nullPointer(ensemble->instances[0], "omsu_ensemble_explicit_euler_step", "x[]", x)) {
+        return omsi_error;
+    }
+
+    length = ensemble->n_states * ensemble->n_instances;
+    for (j = 0; j < length; j++) {
+        x[j] += h * derivatives[j];
+    }
+
+    time = ensemble->instances[0]->osu_data->sim_data->model_vars_and_params->time_value;
+    if (omsu_ensemble_set_time(ensemble, time + h) != omsi_ok) {
+        return omsi_error;
+    }
+    return omsu_ensemble_set_continuous_states(ensemble, x);
+}
+
+/** \} */
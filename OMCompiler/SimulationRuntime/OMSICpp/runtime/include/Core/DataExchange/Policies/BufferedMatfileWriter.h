@@ -0,0 +1,243 @@
+#pragma once
+/** @addtogroup dataexchangePolicies
+ *
+ *  @{
+ */
+
+/*=={info}======================================================================================*/
+/*!
+ * \title      BufferedMatfileWriter
+ *
+ * \content    Policy class to write simulation results in a MATLAB file. The rows of the
+ *             "data_2" matrix are staged in large buffers on the solver thread and written
+ *             by a dedicated I/O thread (if USE_THREAD is defined). The header of "data_2"
+ *             is only updated after a whole buffer was written and when the file is closed.
+ */
+/*========================================================================================{end}==*/
+#include <Core/DataExchange/Policies/MatfileWriter.h>
+
+/** size of one staging buffer in bytes */
+#define MAT_WRITER_BUFFER_SIZE (1 << 20)
+
+class BufferedMatFileWriter : public MatFileWriter
+{
+public:
+    BufferedMatFileWriter(unsigned long size, string output_path, string file_name)
+        : MatFileWriter(size, output_path, file_name),
+          _fillBuffer(),
+          _writeBuffer(),
+          _uiVarCount(0),
+          _uiRowsPerBuffer(0),
+          _uiFillRows(0),
+          _uiWriteRows(0),
+          _uiRowsWritten(0),
+          _writeError(false)
+#if defined(USE_THREAD)
+          , _writerThread()
+          , _bufferMutex()
+          , _bufferCondition()
+          , _writePending(false)
+          , _stopWriter(false)
+#endif
+    {
+    }
+
+    virtual ~BufferedMatFileWriter()
+    {
+        try
+        {
+            finalize();
+        }
+        catch (std::exception& ex)
+        {
+            cerr << ex.what() << endl;
+        }
+    }
+
+    /**
+     * Initialize a new result file, a previously opened file is finalized first.
+     */
+    void init(std::string output_path, std::string file_name, size_t dim)
+    {
+        finalize();
+        MatFileWriter::init(output_path, file_name, dim);
+        _uiVarCount = 0;
+        _uiRowsPerBuffer = 0;
+        _uiFillRows = 0;
+        _uiWriteRows = 0;
+        _uiRowsWritten = 0;
+        _writeError = false;
+    }
+
+    // parameters, names and descriptions are written directly
+    using MatFileWriter::write;
+
+    /**
+     * Stage the variables of one time point in the fill buffer. The values have to be copied
+     * on the calling thread because v_list only holds pointers to the simulation variables.
+     * A full buffer is handed over to the I/O thread.
+     */
+    virtual void write(const all_vars_time_t& v_list, const neg_all_vars_t& neg_v_list)
+    {
+        unsigned int uiVarCount = get < 0 > (v_list).size() + get < 1 > (v_list).size() + get < 2 > (v_list).size() + 1;
+
+        if (_uiRowsPerBuffer == 0)
+        {
+            // first time point: write the header of "data_2" and allocate the staging buffers
+            _uiVarCount = uiVarCount;
+            _uiRowsPerBuffer = max(1u, (unsigned int)(MAT_WRITER_BUFFER_SIZE / (sizeof(double) * uiVarCount)));
+            _fillBuffer.assign(_uiRowsPerBuffer * uiVarCount, 0.0);
+            _writeBuffer.assign(_uiRowsPerBuffer * uiVarCount, 0.0);
+            writeMatVer4MatrixHeader("data_2", uiVarCount, 0, sizeof(double));
+            startWriter();
+        }
+        else if (uiVarCount != _uiVarCount)
+            throw ModelicaSimulationError(DATASTORAGE, "Number of output variables changed during simulation");
+
+        double* doubleHelpMatrix = &_fillBuffer[_uiFillRows * uiVarCount];
+
+        // first time is written to "data_2" matrix...
+        *doubleHelpMatrix = get < 3 > (v_list);
+        doubleHelpMatrix++;
+
+        // ...followed by real, int and bool variable values
+        std::transform(get < 0 > (v_list).begin(), get < 0 > (v_list).end(), get < 0 > (neg_v_list).begin(),
+                       doubleHelpMatrix, WriteOutputVar<double>());
+        size_t nReal = get < 0 > (v_list).size();
+        std::transform(get < 1 > (v_list).begin(), get < 1 > (v_list).end(), get < 1 > (neg_v_list).begin(),
+                       doubleHelpMatrix + nReal, WriteOutputVar<int>());
+        size_t nInt = get < 1 > (v_list).size();
+        std::transform(get < 2 > (v_list).begin(), get < 2 > (v_list).end(), get < 2 > (neg_v_list).begin(),
+                       doubleHelpMatrix + nReal + nInt, WriteOutputVar<bool>());
+
+        _uiValueCount++;
+        if (++_uiFillRows == _uiRowsPerBuffer)
+        {
+            flushBuffer();
+            checkWriteError();
+        }
+    }
+
+protected:
+    /**
+     * Write the staged rows of the write buffer to the file and update the header of "data_2"
+     * with the number of rows written so far. Only called by the I/O thread (or by the solver
+     * thread if threads are not available).
+     */
+    void writeBuffer()
+    {
+        if (_uiWriteRows == 0)
+            return;
+        _output_stream.write((const char*)&_writeBuffer[0], sizeof(double) * _uiVarCount * _uiWriteRows);
+        _uiRowsWritten += _uiWriteRows;
+        _uiWriteRows = 0;
+        writeMatVer4MatrixHeader("data_2", _uiVarCount, _uiRowsWritten, sizeof(double));
+        if (_output_stream.fail())
+            _writeError = true;
+    }
+
+    /**
+     * Hand the fill buffer over to the I/O thread, waits while the previous buffer is written.
+     */
+    void flushBuffer()
+    {
+#if defined(USE_THREAD)
+        unique_lock<mutex> lock(_bufferMutex);
+        while (_writePending)
+            _bufferCondition.wait(lock);
+        _fillBuffer.swap(_writeBuffer);
+        _uiWriteRows = _uiFillRows;
+        _uiFillRows = 0;
+        _writePending = true;
+        _bufferCondition.notify_all();
+#else
+        _fillBuffer.swap(_writeBuffer);
+        _uiWriteRows = _uiFillRows;
+        _uiFillRows = 0;
+        writeBuffer();
+#endif
+    }
+
+    /**
+     * Write all staged rows, stop the I/O thread and finalize the header of "data_2".
+     */
+    void finalize()
+    {
+        if (_uiRowsPerBuffer == 0)
+            return;
+        if (_uiFillRows > 0)
+            flushBuffer();
+#if defined(USE_THREAD)
+        {
+            unique_lock<mutex> lock(_bufferMutex);
+            _stopWriter = true;
+            _bufferCondition.notify_all();
+        }
+        if (_writerThread.joinable())
+            _writerThread.join();
+        _stopWriter = false;
+#endif
+        _uiRowsPerBuffer = 0;
+        _output_stream.flush();
+        checkWriteError();
+    }
+
+    void checkWriteError()
+    {
+        if (_writeError)
+            throw ModelicaSimulationError(DATASTORAGE, string("Failed to write results file ") + _file_name);
+    }
+
+#if defined(USE_THREAD)
+    void startWriter()
+    {
+        _stopWriter = false;
+        _writePending = false;
+        _writerThread = thread(&BufferedMatFileWriter::writerThread, this);
+    }
+
+    /**
+     * I/O thread, writes every buffer handed over by flushBuffer until finalize stops it.
+     */
+    void writerThread()
+    {
+        unique_lock<mutex> lock(_bufferMutex);
+        while (true)
+        {
+            while (!_writePending && !_stopWriter)
+                _bufferCondition.wait(lock);
+            if (!_writePending)
+                break;
+            lock.unlock();
+            writeBuffer();
+            lock.lock();
+            _writePending = false;
+            _bufferCondition.notify_all();
+        }
+    }
+#else
+    void startWriter()
+    {
+    }
+#endif
+
+    vector<double> _fillBuffer;
+    vector<double> _writeBuffer;
+    unsigned int _uiVarCount;
+    unsigned int _uiRowsPerBuffer;
+    unsigned int _uiFillRows;
+    unsigned int _uiWriteRows;
+    unsigned int _uiRowsWritten;
+#if defined(USE_THREAD)
+    atomic<bool> _writeError;  // set by the I/O thread, checked by the solver thread
+    thread _writerThread;
+    mutex _bufferMutex;
+    condition_variable _bufferCondition;
+    bool _writePending;
+    bool _stopWriter;
+#else
+    bool _writeError;
+#endif
+};
+
+/** @} */ // end of dataexchangePolicies
@@ -9,6 +9,8 @@
 Copyright (c) 2008, OSMC
 *****************************************************************************/
 
+class INonLinearAlgLoop;
+
 class BOOST_EXTENSION_SOLVER_DECL AlgLoopSolverDefaultImplementation
 {
   public:
@@ -20,11 +22,25 @@ class BOOST_EXTENSION_SOLVER_DECL AlgLoopSolverDefaultImplementation
   virtual bool* getConditions2WorkArray();
   virtual double* getVariableWorkArray();
 protected:
+  /// Group structurally orthogonal columns of the Jacobian of the algebraic loop and create
+  /// copies of the loop for numThreads > 1 (if supported by the loop)
+  void initializeColoredJacobian(INonLinearAlgLoop* algLoop, int numThreads);
+  /// Finite difference approximation of the Jacobian (Fortran format) at y with residuals f,
+  /// all columns of one color are perturbed at once with the given step sizes
+  void calcColoredJacobian(INonLinearAlgLoop* algLoop, const double* y, const double* f,
+                           const double* stepsize, double* jac);
+
   long int _dimZeroFunc;
   long int _dimSys;              ///< Number of unknowns (=dimension of system of equations)
   long int _max_dimSys;
   long int _max_dimZeroFunc;
   bool _single_instance;
+  vector<int> _jacColPtr;        ///< Sparsity pattern of the Jacobian (compressed sparse column)
+  vector<int> _jacRowIndex;
+  vector<vector<int> > _jacColorCols;    ///< Columns of the Jacobian grouped by color
+  vector<shared_ptr<INonLinearAlgLoop> > _jacLoopCopies; ///< Copies of the loop for additional threads
+  vector<vector<double> > _jacWork;      ///< Perturbed variables and residuals per thread
+  int _jacNumThreads;
 private:
  double* _algloopVars;
  bool* _conditions0;
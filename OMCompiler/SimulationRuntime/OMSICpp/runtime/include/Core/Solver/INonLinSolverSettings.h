@@ -29,6 +29,8 @@ public:
     virtual void load(string) = 0;
     virtual void setContinueOnError(bool) = 0;
     virtual bool getContinueOnError() = 0;
+    virtual void setThreads(int) = 0;
+    virtual int getThreads() = 0;
 };
 
 /** @} */ // end of coreSolver
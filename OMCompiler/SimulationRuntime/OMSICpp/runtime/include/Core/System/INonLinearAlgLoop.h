@@ -76,6 +76,25 @@ public:
     virtual void setUseSparseFormat(bool value) = 0;
     virtual float queryDensity() = 0;
 
+    /// Provide the sparsity pattern of the Jacobian in compressed sparse column format
+    /// (colPtr has getDimReal()+1 entries), returns false if no pattern is available
+    virtual bool getSparsityPattern(vector<int>& colPtr, vector<int>& rowIndex) const
+    {
+        return false;
+    }
+
+    /// Create a copy of the algebraic loop that works on its own copy of the system and can be
+    /// evaluated concurrently to this loop, returns an empty pointer if copies are not supported
+    virtual shared_ptr<INonLinearAlgLoop> createCopy()
+    {
+        return shared_ptr<INonLinearAlgLoop>();
+    }
+
+    /// Transfer the current state of the system to a copy created with createCopy()
+    virtual void updateCopy(INonLinearAlgLoop* copy)
+    {
+    }
+
     /*/// Fügt das übergebene Objekt als Across-Kante hinzu
     void addAcrossEdge(IObject& new_obj);
 
@@ -73,6 +73,8 @@ public:
     /*Methods for pre- variables*/
     virtual void savePreVariables() = 0;
     virtual void initPreVariables() = 0;
+    /*Copies all variables and pre-variables of another instance with the same dimensions*/
+    virtual void copyVariables(ISimVars* instance) = 0;
     /*access methods for pre-variable*/
     virtual double& getPreVar(const double& var) =0;
     virtual int& getPreVar(const int& var) =0;
@@ -124,6 +124,7 @@ ISimVars
     virtual void initStringAliasArray(std::vector<int> indices, string* ref_data[]);
     virtual void savePreVariables();
     virtual void initPreVariables();
+    virtual void copyVariables(ISimVars* instance);
     virtual double& getPreVar(const double& var);
     virtual int& getPreVar(const int& var);
     virtual bool& getPreVar(const bool& var);
@@ -26,6 +26,9 @@ public:
 
     virtual void setContinueOnError(bool);
     virtual bool getContinueOnError();
+    /*Anzahl der Threads für die Jacobi-Matrix (default: 1)*/
+    virtual void setThreads(int);
+    virtual int getThreads();
 private:
     long int _iNewt_max; ///< max. Anzahl an Newtonititerationen pro Schritt (default: 25)
 
@@ -33,6 +36,7 @@ private:
     double _dAtol; ///< Absolute Toleranz für die Newtoniteration (default: 1e-6)
     double _dDelta; ///< Dämpfungsfaktor (default: 0.9)
     bool _continueOnError;
+    int _numThreads; ///< Anzahl der Threads für die Jacobi-Matrix (default: 1)
 };
 
 /** @} */ // end of solverHybrj
@@ -35,8 +35,8 @@ public:
 
     /*will be used with new sundials version
      int kin_JacSparse(N_Vector u, N_Vector fu,SlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
-    int kin_JacDense(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
     */
+    int kin_JacDense(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
 private:
     /// Encapsulation of determination of residuals to given unknowns
     void calcFunction(const double* y, double* residual);
@@ -46,6 +46,8 @@ private:
 
     void solveNLS();
     void check4EventRetry(double* y);
+    /// Set the relative error of the residuals, it also scales the increments of the Jacobian
+    void setRelErrFunc(double relfunc);
 
     // Member variables
     //---------------------------------------------------------------
@@ -77,7 +79,8 @@ private:
         *_y_new;
     double
         _fnormtol,
-        _scsteptol;
+        _scsteptol,
+        _sqrtRelFunc; ///< Square root of the relative error of the residuals set in Kinsol
 
     N_Vector
         _Kin_y, ///< Temp   - Initial values in the Sundials Format
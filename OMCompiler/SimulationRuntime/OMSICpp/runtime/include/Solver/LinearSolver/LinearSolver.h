@@ -80,6 +80,9 @@ private:
   int* _Ap;
   double* _Ax;
   int _nonzeros;
+  long int _nAnalyze,   ///< number of symbolic analyses
+           _nFactor,    ///< number of full numerical factorizations
+           _nRefactor;  ///< number of refactorizations reusing the pivoting
 #endif
 };
 
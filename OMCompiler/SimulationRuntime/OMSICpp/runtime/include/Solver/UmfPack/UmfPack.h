@@ -33,6 +33,9 @@ public:
     virtual bool* getConditions2WorkArray();
     virtual double* getVariableWorkArray();
 private:
+    /// Checks whether the given CSC pattern equals the one of the current symbolic analysis
+    bool hasSparsityPattern(int dimSys, int nonzeros, int const* Ap, int const* Ai);
+
     ITERATIONSTATUS _iterationStatus;
     ILinSolverSettings* _umfpackSettings;
     shared_ptr<ILinearAlgLoop> _algLoop;
@@ -43,4 +46,13 @@ private:
            *_x_old,
            *_x_new;
     bool _firstuse;
+
+    void* _symbolic;  ///< UMFPACK symbolic analysis, reused while the sparsity pattern is unchanged
+    void* _numeric;   ///< UMFPACK numeric factorization of the last solve
+    int* _Ap;         ///< column pointers of the analyzed pattern
+    int* _Ai;         ///< row indices of the analyzed pattern
+    int _nonzeros;
+    long int _nSymbolic,
+             _nNumeric,
+             _nSolve;
 };
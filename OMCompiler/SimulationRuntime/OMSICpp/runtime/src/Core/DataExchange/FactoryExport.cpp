@@ -8,12 +8,13 @@
 #include <Core/DataExchange/Writer.h>
 #include <Core/DataExchange/Policies/TextfileWriter.h>
 #include <Core/DataExchange/Policies/MatfileWriter.h>
+#include <Core/DataExchange/Policies/BufferedMatfileWriter.h>
 #include <Core/DataExchange/Policies/BufferReaderWriter.h>
 #include <Core/DataExchange/Policies/DefaultWriter.h>
 #include <Core/DataExchange/HistoryImpl.h>
 shared_ptr<IHistory> createMatFileWriterFactory(shared_ptr<IGlobalSettings> globalSettings,size_t dim)
 {
-    shared_ptr<IHistory> writer= shared_ptr<IHistory>(new HistoryImpl<MatFileWriter >(globalSettings,dim)  );
+    shared_ptr<IHistory> writer= shared_ptr<IHistory>(new HistoryImpl<BufferedMatFileWriter >(globalSettings,dim)  );
     return writer;
 }
 shared_ptr<IHistory> createTextFileWriterFactory(shared_ptr<IGlobalSettings> globalSettings,size_t dim)
@@ -38,6 +39,7 @@ shared_ptr<IHistory> createDefaultWriterFactory(shared_ptr<IGlobalSettings> glob
 #include <Core/DataExchange/Writer.h>
 #include <Core/DataExchange/Policies/TextfileWriter.h>
 #include <Core/DataExchange/Policies/MatfileWriter.h>
+#include <Core/DataExchange/Policies/BufferedMatfileWriter.h>
 #include <Core/DataExchange/Policies/BufferReaderWriter.h>
 #include <Core/DataExchange/Policies/DefaultWriter.h>
 #include <Core/DataExchange/HistoryImpl.h>
@@ -45,7 +47,7 @@ shared_ptr<IHistory> createDefaultWriterFactory(shared_ptr<IGlobalSettings> glob
     types.get<map<string, boost::extensions::factory<ISimData > > >()
       ["SimData"].set<SimData>();
    types.get<map<string, boost::extensions::factory<IHistory,shared_ptr<IGlobalSettings>,size_t > > >()
-      ["MatFileWriter"].set<HistoryImpl<MatFileWriter > >();
+      ["MatFileWriter"].set<HistoryImpl<BufferedMatFileWriter > >();
   types.get<map<string, boost::extensions::factory<IHistory,shared_ptr<IGlobalSettings>,size_t > > >()
       ["TextFileWriter"].set<HistoryImpl<TextFileWriter > >();
   types.get<map<string, boost::extensions::factory<IHistory,shared_ptr<IGlobalSettings>,size_t > > >()
@@ -63,12 +65,13 @@ shared_ptr<IHistory> createDefaultWriterFactory(shared_ptr<IGlobalSettings> glob
 #include <Core/DataExchange/Writer.h>
 #include <Core/DataExchange/Policies/TextfileWriter.h>
 #include <Core/DataExchange/Policies/MatfileWriter.h>
+#include <Core/DataExchange/Policies/BufferedMatfileWriter.h>
 #include <Core/DataExchange/Policies/BufferReaderWriter.h>
 #include <Core/DataExchange/Policies/DefaultWriter.h>
 #include <Core/DataExchange/HistoryImpl.h>
 shared_ptr<IHistory> createMatFileWriterFactory(shared_ptr<IGlobalSettings> globalSettings,size_t dim)
 {
-    shared_ptr<IHistory> writer= shared_ptr<IHistory>(new HistoryImpl<MatFileWriter >(globalSettings,dim)  );
+    shared_ptr<IHistory> writer= shared_ptr<IHistory>(new HistoryImpl<BufferedMatFileWriter >(globalSettings,dim)  );
     return writer;
 }
 shared_ptr<IHistory> createTextFileWriterFactory(shared_ptr<IGlobalSettings> globalSettings,size_t dim)
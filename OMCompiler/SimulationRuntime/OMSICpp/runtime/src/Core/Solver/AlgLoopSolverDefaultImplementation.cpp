@@ -6,6 +6,11 @@
 #include <Core/Modelica.h>
 #include <Core/Solver/FactoryExport.h>
 #include <Core/Solver/AlgLoopSolverDefaultImplementation.h>
+#include <Core/System/INonLinearAlgLoop.h>
+
+#if defined(USE_OPENMP)
+#include "omp.h"
+#endif
 
 
 AlgLoopSolverDefaultImplementation::AlgLoopSolverDefaultImplementation()
@@ -14,6 +19,7 @@ AlgLoopSolverDefaultImplementation::AlgLoopSolverDefaultImplementation()
       , _algloopVars(NULL)
       , _conditions0(NULL)
       , _conditions1(NULL)
+      , _jacNumThreads(1)
 {
 }
 
@@ -68,4 +74,139 @@ void AlgLoopSolverDefaultImplementation::initialize(int dimZeroFunc, int dimSys)
     memset(_algloopVars, 0, _dimSys * sizeof(double));
 }
 
+void AlgLoopSolverDefaultImplementation::initializeColoredJacobian(INonLinearAlgLoop* algLoop, int numThreads)
+{
+    int dim = algLoop->getDimReal();
+    _jacColorCols.clear();
+    _jacLoopCopies.clear();
+
+    if (!algLoop->getSparsityPattern(_jacColPtr, _jacRowIndex) || _jacColPtr.size() != (size_t)dim + 1)
+    {
+        // without pattern every column is perturbed on its own
+        _jacColPtr.clear();
+        _jacRowIndex.clear();
+        _jacColorCols.resize(dim);
+        for (int j = 0; j < dim; j++)
+            _jacColorCols[j].push_back(j);
+    }
+    else
+    {
+        // greedy coloring, columns sharing a row must not get the same color
+        vector<int> rowPtr(dim + 1, 0);
+        vector<int> rowCols(_jacRowIndex.size());
+        for (size_t k = 0; k < _jacRowIndex.size(); k++)
+            rowPtr[_jacRowIndex[k] + 1]++;
+        for (int i = 0; i < dim; i++)
+            rowPtr[i + 1] += rowPtr[i];
+        vector<int> rowPos(rowPtr.begin(), rowPtr.end() - 1);
+        for (int j = 0; j < dim; j++)
+            for (int k = _jacColPtr[j]; k < _jacColPtr[j + 1]; k++)
+                rowCols[rowPos[_jacRowIndex[k]]++] = j;
+
+        vector<int> color(dim, -1);
+        vector<int> usedBy(dim, -1);
+        for (int j = 0; j < dim; j++)
+        {
+            for (int k = _jacColPtr[j]; k < _jacColPtr[j + 1]; k++)
+            {
+                int i = _jacRowIndex[k];
+                for (int l = rowPtr[i]; l < rowPtr[i + 1]; l++)
+                    if (color[rowCols[l]] >= 0)
+                        usedBy[color[rowCols[l]]] = j;
+            }
+            int c = 0;
+            while (usedBy[c] == j)
+                c++;
+            color[j] = c;
+            if ((size_t)c == _jacColorCols.size())
+                _jacColorCols.push_back(vector<int>());
+            _jacColorCols[c].push_back(j);
+        }
+    }
+
+    // every additional thread evaluates its own copy of the algebraic loop
+    _jacNumThreads = 1;
+#if defined(USE_OPENMP)
+    numThreads = min(numThreads, (int)_jacColorCols.size());
+    for (int t = 1; t < numThreads; t++)
+    {
+        shared_ptr<INonLinearAlgLoop> copy = algLoop->createCopy();
+        if (!copy)
+            break;
+        _jacLoopCopies.push_back(copy);
+    }
+    _jacNumThreads = _jacLoopCopies.size() + 1;
+#endif
+    _jacWork.assign(_jacNumThreads, vector<double>(2 * dim));
+}
+
+void AlgLoopSolverDefaultImplementation::calcColoredJacobian(INonLinearAlgLoop* algLoop, const double* y,
+                                                             const double* f, const double* stepsize, double* jac)
+{
+    int dim = algLoop->getDimReal();
+    int numColors = _jacColorCols.size();
+    bool failed = false;
+    string error;
+    if (dim == 0)
+        return;
+
+    if (_jacColPtr.size() > 0)
+        std::fill(jac, jac + dim * dim, 0.0);
+    for (size_t t = 0; t < _jacLoopCopies.size(); t++)
+        algLoop->updateCopy(_jacLoopCopies[t].get());
+
+#if defined(USE_OPENMP)
+#pragma omp parallel for num_threads(_jacNumThreads) schedule(dynamic)
+#endif
+    for (int c = 0; c < numColors; c++)
+    {
+#if defined(USE_OPENMP)
+        int t = omp_get_thread_num();
+#else
+        int t = 0;
+#endif
+        INonLinearAlgLoop* loop = t == 0 ? algLoop : _jacLoopCopies[t - 1].get();
+        double* yHelp = &_jacWork[t][0];
+        double* fHelp = yHelp + dim;
+        const vector<int>& cols = _jacColorCols[c];
+
+        std::copy(y, y + dim, yHelp);
+        for (size_t l = 0; l < cols.size(); l++)
+            yHelp[cols[l]] += stepsize[cols[l]];
+        try
+        {
+            loop->setReal(yHelp);
+            loop->evaluate();
+            loop->getRHS(fHelp);
+        }
+        catch (std::exception& ex)
+        {
+#if defined(USE_OPENMP)
+#pragma omp critical (coloredJacobianError)
+#endif
+            {
+                failed = true;
+                error = ex.what();
+            }
+            continue;
+        }
+
+        // build Jacobian in Fortran format, with pattern only the structural non-zeros of every column
+        for (size_t l = 0; l < cols.size(); l++)
+        {
+            int j = cols[l];
+            double* col = jac + j * dim;
+            if (_jacColPtr.size() > 0)
+                for (int k = _jacColPtr[j]; k < _jacColPtr[j + 1]; k++)
+                    col[_jacRowIndex[k]] = (fHelp[_jacRowIndex[k]] - f[_jacRowIndex[k]]) / stepsize[j];
+            else
+                for (int i = 0; i < dim; i++)
+                    col[i] = (fHelp[i] - f[i]) / stepsize[j];
+        }
+    }
+
+    if (failed)
+        throw ModelicaSimulationError(ALGLOOP_SOLVER, "error evaluating Jacobian of algebraic loop: " + error);
+}
+
 /** @} */ // end of coreSolver
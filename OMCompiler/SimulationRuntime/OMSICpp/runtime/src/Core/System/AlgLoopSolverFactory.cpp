@@ -48,6 +48,7 @@ shared_ptr<INonLinearAlgLoopSolver> AlgLoopSolverFactory::createNonLinearAlgLoop
         string nonlinsolver_name = _global_settings->getSelectedNonLinSolver();
         shared_ptr<INonLinSolverSettings> algsolversetting = createNonLinSolverSettings(nonlinsolver_name);
         algsolversetting->setContinueOnError(_global_settings->getNonLinearSolverContinueOnError());
+        algsolversetting->setThreads(_global_settings->getSolverThreads());
         _algsolversettings.push_back(algsolversetting);
 
         shared_ptr<INonLinearAlgLoopSolver> algsolver =
@@ -683,6 +683,40 @@ void SimVars::initPreVariables()
     // nothing needs to be done, exploiting contiguous vars storage
 }
 
+/**
+*  \brief Copies all real,int,bool,string variables and their pre-variables of another instance
+*  \param [in] instance simvars with the same dimensions, e.g. of a copy of the same system
+*  \details Details
+*/
+void SimVars::copyVariables(ISimVars* instance)
+{
+    SimVars* simVars = dynamic_cast<SimVars*>(instance);
+    if (!simVars || _use_omsu || simVars->_use_omsu || simVars->_dim_real != _dim_real
+        || simVars->_dim_int != _dim_int || simVars->_dim_bool != _dim_bool || simVars->_dim_string != _dim_string)
+        throw ModelicaSimulationError(MODEL_EQ_SYSTEM, "simvars can not be copied");
+
+    if (_dim_real > 0)
+    {
+        std::copy(simVars->_real_vars, simVars->_real_vars + _dim_real, _real_vars);
+        std::copy(simVars->_pre_real_vars, simVars->_pre_real_vars + _dim_real, _pre_real_vars);
+    }
+    if (_dim_int > 0)
+    {
+        std::copy(simVars->_int_vars, simVars->_int_vars + _dim_int, _int_vars);
+        std::copy(simVars->_pre_int_vars, simVars->_pre_int_vars + _dim_int, _pre_int_vars);
+    }
+    if (_dim_bool > 0)
+    {
+        std::copy(simVars->_bool_vars, simVars->_bool_vars + _dim_bool, _bool_vars);
+        std::copy(simVars->_pre_bool_vars, simVars->_pre_bool_vars + _dim_bool, _pre_bool_vars);
+    }
+    if (_dim_string > 0)
+    {
+        std::copy(simVars->_string_vars, simVars->_string_vars + _dim_string, _string_vars);
+        std::copy(simVars->_pre_string_vars, simVars->_pre_string_vars + _dim_string, _pre_string_vars);
+    }
+}
+
 double& SimVars::getPreVar(const double& var)
 {
     size_t i = &var - _real_vars;
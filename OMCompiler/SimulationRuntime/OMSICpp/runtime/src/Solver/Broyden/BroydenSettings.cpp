@@ -14,6 +14,7 @@ BroydenSettings::BroydenSettings()
       , _dAtol(1e-6)
       , _dDelta(1)
       , _continueOnError(false)
+      , _numThreads(1)
 {
 };
 
@@ -79,4 +80,14 @@ bool BroydenSettings::getContinueOnError()
     return _continueOnError;
 }
 
+void BroydenSettings::setThreads(int value)
+{
+    _numThreads = value;
+}
+
+int BroydenSettings::getThreads()
+{
+    return _numThreads;
+}
+
 /** @} */ // end of solverBroyden
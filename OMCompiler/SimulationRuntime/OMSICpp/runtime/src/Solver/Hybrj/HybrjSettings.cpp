@@ -14,6 +14,7 @@ HybrjSettings::HybrjSettings()
       , _dAtol(1.0)
       , _dDelta(0.9)
       , _continueOnError(false)
+      , _numThreads(1)
 {
 };
 /*max. Anzahl an Newtonititerationen pro Schritt (default: 25)*/
@@ -74,4 +75,14 @@ bool HybrjSettings::getContinueOnError()
     return _continueOnError;
 }
 
+void HybrjSettings::setThreads(int value)
+{
+    _numThreads = value;
+}
+
+int HybrjSettings::getThreads()
+{
+    return _numThreads;
+}
+
 /** @} */ // end of solverHybrj
@@ -52,8 +52,8 @@ int kin_fCallback(N_Vector y, N_Vector fval, void* user_data);
 
 /*will be used with new sundials version
 int kin_SlsSparseJacFn(N_Vector u, N_Vector fu,SlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
-int kin_DlsDenseJacFn(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
 */
+int kin_DlsDenseJacFn(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2);
 
 
 /**\Callback function for Kinsol to calculate right hand side, calls internal Kinsol member function
@@ -96,13 +96,11 @@ int kin_SlsSparseJacFn(N_Vector u, N_Vector fu,SlsMat J, void *user_data,N_Vecto
  *  \return Return_Description
  *  \details Details
  */
-/*will be used with new sundials version
 int kin_DlsDenseJacFn(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2)
 {
     Kinsol* myKinsol =  (Kinsol*)(user_data);
     return  myKinsol->kin_JacDense(N,u,fu,J,user_data,tmp1,tmp2);
 }
-*/
 
 Kinsol::Kinsol(INonLinSolverSettings* settings, shared_ptr<INonLinearAlgLoop> algLoop)
     : AlgLoopSolverDefaultImplementation()
@@ -264,6 +262,7 @@ void Kinsol::initialize()
         else
             _yScale[i] = 1;
 
+    initializeColoredJacobian(_algLoop.get(), _kinsolSettings->getThreads());
 
     if (_Kin_y)
 
@@ -326,6 +325,11 @@ void Kinsol::initialize()
 
     KINDense(_kinMem, _dimSys);
 
+    // colored finite differences instead of the internal difference quotients
+    idid = KINDlsSetDenseJacFn(_kinMem, kin_DlsDenseJacFn);
+    if (check_flag(&idid, (char *)"KINDlsSetDenseJacFn", 1))
+        throw ModelicaSimulationError(ALGLOOP_SOLVER, "Kinsol::initialize()");
+
     /*will be used with new sundials version
     if(_algLoop->isLinearTearing())
     {
@@ -357,7 +361,7 @@ void Kinsol::initialize()
 
     idid = KINSetFuncNormTol(_kinMem, _fnormtol);
     idid = KINSetScaledStepTol(_kinMem, _scsteptol);
-    idid = KINSetRelErrFunc(_kinMem, 1e-14);
+    setRelErrFunc(1e-14);
 
     _counter = 0;
 
@@ -417,6 +421,11 @@ void Kinsol::solve()
     if (_usedCompletePivoting || _usedIterativeSolver)
     {
         KINDense(_kinMem, _dimSys);
+
+        // colored finite differences instead of the internal difference quotients
+        idid = KINDlsSetDenseJacFn(_kinMem, kin_DlsDenseJacFn);
+        if (check_flag(&idid, (char *)"KINDlsSetDenseJacFn", 1))
+            throw ModelicaSimulationError(ALGLOOP_SOLVER, "Kinsol::solve()");
         _usedCompletePivoting = false;
         _usedIterativeSolver = false;
     }
@@ -677,21 +686,35 @@ int Kinsol::kin_JacSparse(N_Vector u, N_Vector fu,SlsMat J, void *user_data,N_Ve
  *  \return status value
  *  \details Details
  */
-/*will be used with new sundials version
 int Kinsol::kin_JacDense(long int N, N_Vector u, N_Vector fu,DlsMat J, void *user_data,N_Vector tmp1, N_Vector tmp2)
 {
-    const matrix_t& A = _algLoop->getSystemMatrix();
-
-    for(size_t i = 0; i < A.size1(); ++i)
-    {
+    double* y = NV_DATA_S(u);
 
-        const ublas::matrix_column<const  matrix_t > col (A, i);
-        std::copy(col.begin(), col.end(), J->cols[i]);
+    // same increments as the internal difference quotients of Kinsol, they follow the
+    // relative error of the residuals, which is lowered when the line search fails
+    for (int j = 0; j < _dimSys; j++)
+        _yHelp[j] = _sqrtRelFunc * std::max(std::abs(y[j]), 1.0 / _yScale[j]);
 
+    try
+    {
+        calcColoredJacobian(_algLoop.get(), y, NV_DATA_S(fu), _yHelp, _jac);
     }
+    catch (std::exception&)
+    {
+        return 1;
+    }
+
+    for (int j = 0; j < _dimSys; j++)
+        std::copy(_jac + j * _dimSys, _jac + (j + 1) * _dimSys, DENSE_COL(J, j));
     return 0;
 }
-*/
+
+void Kinsol::setRelErrFunc(double relfunc)
+{
+    KINSetRelErrFunc(_kinMem, relfunc);
+    _sqrtRelFunc = std::sqrt(relfunc);
+}
+
 void Kinsol::stepCompleted(double time)
 {
     memcpy(_y0, _y, _dimSys * sizeof(double));
@@ -878,7 +901,7 @@ void Kinsol::solveNLS()
                 else
                 {
                     delta /= 1e2;
-                    idid = KINSetRelErrFunc(_kinMem, delta);
+                    setRelErrFunc(delta);
                 }
             }
             break;
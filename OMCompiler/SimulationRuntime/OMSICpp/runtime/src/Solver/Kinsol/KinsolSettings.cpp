@@ -13,6 +13,7 @@ KinsolSettings::KinsolSettings()
       , _dAtol(1.0)
       , _dDelta(0.9)
       , _continueOnError(false)
+      , _numThreads(1)
 {
 };
 /*max. Anzahl an Newtonititerationen pro Schritt (default: 25)*/
@@ -73,4 +74,14 @@ bool KinsolSettings::getContinueOnError()
     return _continueOnError;
 }
 
+void KinsolSettings::setThreads(int value)
+{
+    _numThreads = value;
+}
+
+int KinsolSettings::getThreads()
+{
+    return _numThreads;
+}
+
 /** @} */ // end of solverKinsol
@@ -37,6 +37,10 @@ LinearSolver::LinearSolver(ILinSolverSettings* settings, shared_ptr<ILinearAlgLo
   , _Ai                 (NULL)
   , _Ap                 (NULL)
   , _Ax                 (NULL)
+  , _nonzeros           (0)
+  , _nAnalyze           (0)
+  , _nFactor            (0)
+  , _nRefactor          (0)
 #endif
 
       , _iterationStatus(CONTINUE)
@@ -80,6 +84,10 @@ LinearSolver::~LinearSolver()
 
 #if defined(klu)
   if (_sparse == true) {
+    if (_nAnalyze > 0)
+      LOGGER_WRITE("LinearSolver: KLU symbolic analyses = " + to_string(_nAnalyze) +
+                   ", factorizations = " + to_string(_nFactor) +
+                   ", refactorizations = " + to_string(_nRefactor), LC_LS, LL_INFO);
     if (_kluCommon) {
       if (_kluSymbolic)
         klu_free_symbolic(&_kluSymbolic, _kluCommon);
@@ -175,9 +183,10 @@ void LinearSolver::initialize()
         memcpy(_Ai,Tj, sizeof(int)*(_nonzeros));
 
         _kluSymbolic = klu_analyze(_dimSys, _Ap, _Ai, _kluCommon);
-        _kluNumeric = klu_factor(_Ap, _Ai, _Ax, _kluSymbolic, _kluCommon);
-        if (_kluNumeric == NULL)
-          throw ModelicaSimulationError(ALGLOOP_SOLVER, "error during numerical factorization with Sparse Solver KLU");
+        if (_kluSymbolic == NULL)
+          throw ModelicaSimulationError(ALGLOOP_SOLVER, "error during symbolic analysis with Sparse Solver KLU");
+        _nAnalyze++;
+        // the numerical factorization is done with the first solve
       }
 #endif
     }
@@ -368,20 +377,48 @@ void LinearSolver::solve()
       std::cout << std::endl;
     }
 
-    int ok = klu_refactor(_Ap, _Ai, _Ax, _kluSymbolic, _kluNumeric, _kluCommon) ;
+    //redo the symbolic analysis if the sparsity pattern has changed
+    int const* Ti = boost::numeric::bindings::begin_compressed_index_major(A);
+    int const* Tj = boost::numeric::bindings::begin_index_minor(A);
+    if (Ti[_dimSys] != _nonzeros
+        || memcmp(_Ap, Ti, sizeof(int)*(_dimSys + 1)) != 0
+        || memcmp(_Ai, Tj, sizeof(int)*_nonzeros) != 0) {
+      if (_kluNumeric)
+        klu_free_numeric(&_kluNumeric, _kluCommon);
+      klu_free_symbolic(&_kluSymbolic, _kluCommon);
+      delete [] _Ai;
+      _nonzeros = Ti[_dimSys];
+      _Ai = new int[_nonzeros];
+      memcpy(_Ap, Ti, sizeof(int)*(_dimSys + 1));
+      memcpy(_Ai, Tj, sizeof(int)*_nonzeros);
+      _kluSymbolic = klu_analyze(_dimSys, _Ap, _Ai, _kluCommon);
+      if (_kluSymbolic == NULL)
+        throw ModelicaSimulationError(ALGLOOP_SOLVER, "error during symbolic analysis with Sparse Solver KLU");
+      _nAnalyze++;
+    }
 
-    //checking for accuracy of refactorization
-    ok = klu_rgrowth(_Ap, _Ai, _Ax, _kluSymbolic, _kluNumeric, _kluCommon);
-    if (ok != 1)
-      throw ModelicaSimulationError(ALGLOOP_SOLVER,"Sparse Solver KLU: error checking accuracy of refactorization by computing reciprocal pivot growth");
-    if (_kluCommon->rgrowth < 1e-3) {
-      klu_free_numeric(&_kluNumeric, _kluCommon);
+    //refactor with the pivoting of the last factorization and fall back
+    //to a full factorization if that fails or is inaccurate
+    bool refactored = false;
+    if (_kluNumeric) {
+      int ok = klu_refactor(_Ap, _Ai, _Ax, _kluSymbolic, _kluNumeric, _kluCommon);
+      //checking for accuracy of refactorization
+      if (ok == 1)
+        ok = klu_rgrowth(_Ap, _Ai, _Ax, _kluSymbolic, _kluNumeric, _kluCommon);
+      refactored = ok == 1 && _kluCommon->rgrowth >= 1e-3;
+      if (refactored)
+        _nRefactor++;
+      else
+        klu_free_numeric(&_kluNumeric, _kluCommon);
+    }
+    if (!refactored) {
       _kluNumeric = klu_factor(_Ap, _Ai, _Ax, _kluSymbolic, _kluCommon);
       if (_kluNumeric == NULL)
         throw ModelicaSimulationError(ALGLOOP_SOLVER,"error during numerical factorization with Sparse Solver KLU");
+      _nFactor++;
     }
 
-    ok = klu_solve(_kluSymbolic, _kluNumeric, _dimSys, 1, _b, _kluCommon) ;
+    int ok = klu_solve(_kluSymbolic, _kluNumeric, _dimSys, 1, _b, _kluCommon) ;
     if (ok != 1)
       throw ModelicaSimulationError(ALGLOOP_SOLVER,"error solving Sparse Solver KLU");
     _iterationStatus = DONE;
@@ -110,6 +110,8 @@ void Newton::initialize()
         _algLoop->getNominalReal(_yNominal);
         _algLoop->getMinReal(_yMin);
         _algLoop->getMaxReal(_yMax);
+
+        initializeColoredJacobian(_algLoop.get(), _newtonSettings->getThreads());
     }
 
 
@@ -358,26 +360,15 @@ void Newton::calcJacobian(double* jac, double* fNominal)
     // Alternatively apply finite differences
     if (Adata == NULL)
     {
+        // Step sizes, structurally orthogonal columns are perturbed at once
         for (int j = 0; j < _dimSys; j++)
-        {
-            // Reset variables for every column
-            std::copy(_y, _y + _dimSys, _yHelp);
-            double stepsize = 1e2 * _newtonSettings->getRtol() * _yNominal[j];
+            _yHelp[j] = 1e2 * _newtonSettings->getRtol() * _yNominal[j];
 
-            // Finite differences
-            _yHelp[j] += stepsize;
+        calcColoredJacobian(_algLoop.get(), _y, _f, _yHelp, jac);
 
-            calcFunction(_yHelp, _fHelp);
-
-            // Build Jacobian in Fortran format
-            for (int i = 0, idx = j * _dimSys; i < _dimSys; i++, idx++)
-            {
-                jac[idx] = (_fHelp[i] - _f[i]) / stepsize;
+        for (int j = 0, idx = 0; j < _dimSys; j++)
+            for (int i = 0; i < _dimSys; i++, idx++)
                 fNominal[i] = std::max(std::abs(jac[idx]) /** _yNominal[j]*/, fNominal[i]);
-            }
-
-            _yHelp[j] -= stepsize;
-        }
     }
 
     // Scale Jacobian
@@ -14,6 +14,7 @@ NewtonSettings::NewtonSettings()
       , _dAtol(1e-8)
       , _dDelta(1)
       , _continueOnError(false)
+      , _numThreads(1)
 {
 }
 
@@ -79,4 +80,14 @@ bool NewtonSettings::getContinueOnError()
     return _continueOnError;
 }
 
+void NewtonSettings::setThreads(int value)
+{
+    _numThreads = value;
+}
+
+int NewtonSettings::getThreads()
+{
+    return _numThreads;
+}
+
 /** @} */ // end of solverNewton
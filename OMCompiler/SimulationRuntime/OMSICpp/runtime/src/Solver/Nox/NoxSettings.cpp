@@ -15,6 +15,7 @@ NoxSettings::NoxSettings()
       , _dAtol(1.0e-13)
       , _dDelta(0.9)
       , _continueOnError(false)
+      , _numThreads(1)
 {
 };
 /*max. Anzahl an Newtonititerationen pro Schritt (default: 25)*/
@@ -79,4 +80,14 @@ bool NoxSettings::getContinueOnError()
     return _continueOnError;
 }
 
+void NoxSettings::setThreads(int value)
+{
+    _numThreads = value;
+}
+
+int NoxSettings::getThreads()
+{
+    return _numThreads;
+}
+
 /** @} */ // end of solverNox
@@ -89,7 +89,8 @@ void Peer::initialize()
     IContinuous *continuous_system = dynamic_cast<IContinuous*>(_system);
     ITime *time_system =  dynamic_cast<ITime*>(_system);
     IGlobalSettings* global_settings = dynamic_cast<ISolverSettings*>(_peersettings)->getGlobalSettings();
-    _numThreads=_peersettings->getGlobalSettings()->getSolverThreads();
+    // one thread per stage at most, the threads are kept alive for the whole solve() call
+    _numThreads=std::max(1, std::min(_peersettings->getGlobalSettings()->getSolverThreads(), 5));
     _hOut = global_settings->gethOutput();
 #ifdef MPIPEER
     MPI_Comm_size(MPI_COMM_WORLD, &_size);
@@ -109,12 +110,22 @@ void Peer::initialize()
     _time_system[0] = time_system;
     _continuous_system[0] = continuous_system;
 
-    for(int i = 1; i < 5; i++)
+    // The stages are distributed statically over the threads, so every stage is computed by
+    // the same thread in all steps. Its system copy is created by this thread to place it in
+    // the thread's local memory (first touch).
+#pragma omp parallel for num_threads(_numThreads) schedule(static)
+    for(int i = 0; i < 5; i++)
     {
-        IMixedSystem* clonedSystem = _system->clone();
+        if(i == 0)
+            continue;
+        IMixedSystem* clonedSystem;
+#pragma omp critical (PeerCloneSystem)
+        {
+            clonedSystem = _system->clone();
+            dynamic_cast<ISystemInitialization*>(clonedSystem)->initialize();
+        }
         _continuous_system[i] = dynamic_cast<IContinuous*>(clonedSystem);
         _time_system[i] = dynamic_cast<ITime*>(clonedSystem);
-        dynamic_cast<ISystemInitialization*>(clonedSystem)->initialize();
     }
 #endif //MPIPEER
     SolverDefaultImplementation::initialize();
@@ -212,6 +223,17 @@ void Peer::initialize()
     _Y1=new double[_dimSys*_rstages];
     _Y2=new double[_dimSys*_rstages];
     _Y3=new double[_dimSys*_rstages];
+
+    // first touch of the work arrays of every stage by the thread computing it
+#pragma omp parallel for num_threads(_numThreads) schedule(static)
+    for(int rank=0; rank<5; ++rank) {
+        std::fill(&_F[rank*_dimSys], &_F[(rank+1)*_dimSys], 0.);
+        std::fill(&_T[rank*_dimSys*_dimSys], &_T[(rank+1)*_dimSys*_dimSys], 0.);
+        std::fill(&_P[rank*_dimSys], &_P[(rank+1)*_dimSys], 0);
+        std::fill(&_Y1[rank*_dimSys], &_Y1[(rank+1)*_dimSys], 0.);
+        std::fill(&_Y2[rank*_dimSys], &_Y2[(rank+1)*_dimSys], 0.);
+        std::fill(&_Y3[rank*_dimSys], &_Y3[(rank+1)*_dimSys], 0.);
+    }
 #endif
 
     _continuous_system[0]->evaluateAll(IContinuous::ALL);
@@ -327,27 +349,6 @@ void Peer::solve(const SOLVERCALL action)
         MPI_Gather(_Y1,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
     }
     t+=_h;
-#else
-#pragma omp parallel for num_threads(_numThreads)
-    for(int _rank=0; _rank<5; ++_rank) {
-        std::copy(_y,_y+_dimSys,&_Y1[_rank*_dimSys]);
-        if (abs(_c[_rank]+1.)>1e-12)
-        {
-            ros2(&_Y1[_rank*_dimSys],_tCurrent,_tCurrent+_h*(_c[_rank]+1.), _continuous_system[_rank], _time_system[_rank]);
-            t=_tCurrent;
-        }
-    }
-    t+=_h;
-    _time_system[0]->setTime(t);
-    _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
-    if(writeOutput) {
-        if(t>=twrite) {
-            _continuous_system[0]->evaluateAll(IContinuous::ALL);
-            SolverDefaultImplementation::writeToFile(0, t, _h);
-            twrite+=_hOut;
-        }
-    }
-#endif
 
 
 //    std::cerr << "Finished init at rank  " << _rank<<std::endl;
@@ -358,7 +359,6 @@ void Peer::solve(const SOLVERCALL action)
     int count=0;
     while(std::abs(t-_tEnd)>1e-8)
     {
-#ifdef MPIPEER
         if(_rank==0)
         {
             for(int i=0; i<_rstages; ++i)
@@ -439,74 +439,148 @@ void Peer::solve(const SOLVERCALL action)
             SolverDefaultImplementation::writeToFile(0, t, _h);
         }
         t+=_h;
+    }
+#else
+    char trans='N';
+    long int dim=1;
+    int count=0;
+    bool failed=false;
+    string error;
+
+    // All steps are computed by one persistent team of threads, bound to distinct cores. The
+    // threads wait at the barriers between the phases of a step instead of being forked and
+    // joined in every step (the OpenMP runtime spins for a while before it parks them).
+#if _OPENMP >= 201307
+#pragma omp parallel num_threads(_numThreads) proc_bind(spread)
 #else
-        for(int i=0; i<_rstages; ++i)
+#pragma omp parallel num_threads(_numThreads)
+#endif
+    {
+#pragma omp for schedule(static)
+        for(int rank=0; rank<5; ++rank) {
+            try {
+                std::copy(_y,_y+_dimSys,&_Y1[rank*_dimSys]);
+                if (abs(_c[rank]+1.)>1e-12)
+                    ros2(&_Y1[rank*_dimSys],_tCurrent,_tCurrent+_h*(_c[rank]+1.), _continuous_system[rank], _time_system[rank]);
+            }
+            catch(std::exception& ex) {
+#pragma omp critical (PeerError)
+                {
+                    failed=true;
+                    error=ex.what();
+                }
+            }
+        }
+
+#pragma omp single
+        {
+            try {
+                if(!failed) {
+                    t+=_h;
+                    _time_system[0]->setTime(t);
+                    _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
+                    if(writeOutput) {
+                        if(t>=twrite) {
+                            _continuous_system[0]->evaluateAll(IContinuous::ALL);
+                            SolverDefaultImplementation::writeToFile(0, t, _h);
+                            twrite+=_hOut;
+                        }
+                    }
+                    t+=_h;
+                }
+            }
+            catch(std::exception& ex) {
+                failed=true;
+                error=ex.what();
+            }
+        }
+
+// Solution phase
+        while(!failed && std::abs(t-_tEnd)>1e-8)
         {
+            // predictors of the stages, the states are distributed over the threads
+#pragma omp for schedule(static)
             for(int j=0; j<_dimSys; ++j) {
-                _Y2[i*_dimSys+j]=0.;
+                for(int i=0; i<_rstages; ++i) {
+                    _Y2[i*_dimSys+j]=0.;
                     for(int k=0; k<_rstages;++k) {
                         _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
                     }
                 }
- //               Y2.vector(i)=Y1*mtl::vector::trans(Theta[i][iall]);
-            }
-            for(int i=0; i<_rstages; i++)
-            {
-                 for(int j=0; j<_dimSys; ++j) {
+                for(int i=0; i<_rstages; ++i) {
                     _Y3[i*_dimSys+j]=0.;
                     for(int k=0; k<_rstages;++k) {
                         _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
                     }
                 }
-//                Y3.vector(i)=Y2*mtl::vector::trans(E[i][iall]);
             }
 
-#pragma omp parallel for num_threads(_numThreads)
-        for(int _rank=0; _rank<5; ++_rank) {
-            long int info;
-            evalF(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_F[_rank*_dimSys],_continuous_system[_rank], _time_system[_rank]);
-            if(!(count%_reuseJacobi)) {
-               evalJ(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_T[_rank*_dimSys*_dimSys], _continuous_system[_rank], _time_system[_rank]);
-                for(int i=0; i<_dimSys; ++i) {
-                    for(int j=0; j<_dimSys; ++j) {
-                        _T[_rank*_dimSys*_dimSys+i*_dimSys+j]*=-_h*_G[_rank];
+            // stages, every stage is computed by the thread owning its system copy
+#pragma omp for schedule(static)
+            for(int rank=0; rank<5; ++rank) {
+                try {
+                    long int info;
+                    evalF(t+_c[rank]*_h,&_Y2[rank*_dimSys],&_F[rank*_dimSys],_continuous_system[rank], _time_system[rank]);
+                    if(!(count%_reuseJacobi)) {
+                        evalJ(t+_c[rank]*_h,&_Y2[rank*_dimSys],&_T[rank*_dimSys*_dimSys], _continuous_system[rank], _time_system[rank]);
+                        for(int i=0; i<_dimSys; ++i) {
+                            for(int j=0; j<_dimSys; ++j) {
+                                _T[rank*_dimSys*_dimSys+i*_dimSys+j]*=-_h*_G[rank];
+                            }
+                            _T[rank*_dimSys*_dimSys+i*_dimSys+i]+=1.;
+                        }
+
+                        dgetrf_(&_dimSys, &_dimSys, &_T[rank*_dimSys*_dimSys], &_dimSys, &_P[rank*_dimSys], &info);
                     }
-                    _T[_rank*_dimSys*_dimSys+i*_dimSys+i]+=1.;
-                }
-
-                dgetrf_(&_dimSys, &_dimSys, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &info);
-            }
-
-
-    //        std::cerr << "Finished iteration matrix calculation step at rank  " << _rank<<std::endl;
 
-            for(int i=0; i<_dimSys; ++i) {
-                _F[_rank*_dimSys+i]*=_h;
-                _F[_rank*_dimSys+i]-=_Y3[_rank*_dimSys+i];
-                _F[_rank*_dimSys+i]*=_G[_rank];
-            }
-            dgetrs_(&trans, &_dimSys, &dim, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &_F[_rank*_dimSys], &_dimSys, &info);
-            for(int i=0; i<_dimSys; ++i) {
-                _Y1[_rank*_dimSys+i]=_F[_rank*_dimSys+i]+_Y2[_rank*_dimSys+i];
+                    for(int i=0; i<_dimSys; ++i) {
+                        _F[rank*_dimSys+i]*=_h;
+                        _F[rank*_dimSys+i]-=_Y3[rank*_dimSys+i];
+                        _F[rank*_dimSys+i]*=_G[rank];
+                    }
+                    dgetrs_(&trans, &_dimSys, &dim, &_T[rank*_dimSys*_dimSys], &_dimSys, &_P[rank*_dimSys], &_F[rank*_dimSys], &_dimSys, &info);
+                    for(int i=0; i<_dimSys; ++i) {
+                        _Y1[rank*_dimSys+i]=_F[rank*_dimSys+i]+_Y2[rank*_dimSys+i];
+                    }
+                }
+                catch(std::exception& ex) {
+#pragma omp critical (PeerError)
+                    {
+                        failed=true;
+                        error=ex.what();
+                    }
+                }
             }
-        }
 
-        count++;
-        if(t+_h>_tEnd) _h=_tEnd-t;
-        _time_system[0]->setTime(t);
-        _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
-
-        if(writeOutput) {
-            if(t>=twrite) {
-                _continuous_system[0]->evaluateAll(IContinuous::ALL);
-                SolverDefaultImplementation::writeToFile(0, t, _h);
-                twrite+=_hOut;
+#pragma omp single
+            {
+                try {
+                    if(!failed) {
+                        count++;
+                        if(t+_h>_tEnd) _h=_tEnd-t;
+                        _time_system[0]->setTime(t);
+                        _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
+
+                        if(writeOutput) {
+                            if(t>=twrite) {
+                                _continuous_system[0]->evaluateAll(IContinuous::ALL);
+                                SolverDefaultImplementation::writeToFile(0, t, _h);
+                                twrite+=_hOut;
+                            }
+                        }
+                        t+=_h;
+                    }
+                }
+                catch(std::exception& ex) {
+                    failed=true;
+                    error=ex.what();
+                }
             }
         }
-        t+=_h;
-#endif
-
     }
+    if(failed)
+        throw ModelicaSimulationError(SOLVER, "Peer: " + error);
+#endif
 #ifdef MPIPEER
     MPI_Barrier(MPI_COMM_WORLD);
     if(_rank==0)
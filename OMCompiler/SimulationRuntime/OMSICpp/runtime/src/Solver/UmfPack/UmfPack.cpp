@@ -5,11 +5,7 @@
 
 #ifdef USE_UMFPACK
 #include "umfpack.h"
-#include <Core/Utils/numeric/bindings/umfpack/umfpack.hpp>
-#include <Core/Utils/numeric/bindings/ublas/vector.hpp>
 #include <Core/Utils/numeric/bindings/ublas.hpp>
-#include <boost/numeric/ublas/io.hpp>
-namespace umf = boost::numeric::bindings::umfpack;
 #endif
 UmfPack::UmfPack(ILinSolverSettings* settings, shared_ptr<ILinearAlgLoop> algLoop)
     : AlgLoopSolverDefaultImplementation()
@@ -19,7 +15,15 @@ UmfPack::UmfPack(ILinSolverSettings* settings, shared_ptr<ILinearAlgLoop> algLoo
       _rhs(NULL),
       _x(NULL),
       _firstuse(true),
-      _jacd(NULL)
+      _jacd(NULL),
+      _symbolic(NULL),
+      _numeric(NULL),
+      _Ap(NULL),
+      _Ai(NULL),
+      _nonzeros(0),
+      _nSymbolic(0),
+      _nNumeric(0),
+      _nSolve(0)
 {
     if (_algLoop)
     {
@@ -36,6 +40,17 @@ UmfPack::~UmfPack()
     if (_jacd) delete [] _jacd;
     if (_rhs) delete [] _rhs;
     if (_x) delete [] _x;
+#ifdef USE_UMFPACK
+    if (_nSolve > 0)
+        LOGGER_WRITE("UmfPack: eq" + to_string(_algLoop->getEquationIndex()) +
+                     ": symbolic analyses = " + to_string(_nSymbolic) +
+                     ", numeric factorizations = " + to_string(_nNumeric) +
+                     ", solves = " + to_string(_nSolve), LC_LS, LL_INFO);
+    if (_numeric) umfpack_di_free_numeric(&_numeric);
+    if (_symbolic) umfpack_di_free_symbolic(&_symbolic);
+#endif
+    if (_Ap) delete [] _Ap;
+    if (_Ai) delete [] _Ai;
 }
 
 void UmfPack::initialize()
@@ -121,36 +136,50 @@ void UmfPack::solve()
     {
 
 
-         int status;
-        // get the default control parameters
-        umf::control_type<> Control;
-        // change the default print level
-        Control [UMFPACK_PRL] = 6;
+        int status;
+        double control[UMFPACK_CONTROL];
+        umfpack_di_defaults(control);
 
-         _algLoop->evaluate();
+        _algLoop->evaluate();
         _algLoop->getb(_rhs);
-         long int dimSys = _algLoop->getDimReal();
-        const sparsematrix_t& A = _algLoop->getSparseAMatrix();
-
-        adaptor_t rhs_adaptor(dimSys,_rhs);
-        shared_vector_t b(dimSys,rhs_adaptor);
-
-        adaptor_t x_adaptor(dimSys,_x);
-        shared_vector_t x(dimSys,x_adaptor);
-
-
-        umf::symbolic_type<double> Symbolic;
-        umf::numeric_type<double> Numeric;
-        status = umf::symbolic(A, Symbolic);
-        if(status<0)
-            //umf::report_status (Control, status)
-            throw ModelicaSimulationError(ALGLOOP_SOLVER,"Error in umfpack symbolic function");
-        status = umf::numeric (A, Symbolic, Numeric);
+        int dimSys = _algLoop->getDimReal();
+        sparsematrix_t& A = _algLoop->getSparseAMatrix();
+
+        int const* Ap = boost::numeric::bindings::begin_compressed_index_major(A);
+        int const* Ai = boost::numeric::bindings::begin_index_minor(A);
+        double const* Ax = boost::numeric::bindings::begin_value(A);
+        int nonzeros = Ap[dimSys];
+
+        // the symbolic analysis (column ordering) only depends on the sparsity
+        // pattern, so it is redone only if the pattern of A has changed
+        if (!_symbolic || !hasSparsityPattern(dimSys, nonzeros, Ap, Ai))
+        {
+            if (_numeric) umfpack_di_free_numeric(&_numeric);
+            if (_symbolic) umfpack_di_free_symbolic(&_symbolic);
+            if (_Ap) delete [] _Ap;
+            if (_Ai) delete [] _Ai;
+            _nonzeros = nonzeros;
+            _Ap = new int[dimSys + 1];
+            _Ai = new int[nonzeros];
+            memcpy(_Ap, Ap, sizeof(int) * (dimSys + 1));
+            memcpy(_Ai, Ai, sizeof(int) * nonzeros);
+
+            status = umfpack_di_symbolic(dimSys, dimSys, _Ap, _Ai, Ax, &_symbolic, control, NULL);
+            if(status<0)
+                throw ModelicaSimulationError(ALGLOOP_SOLVER,"Error in umfpack symbolic function");
+            _nSymbolic++;
+        }
+
+        if (_numeric) umfpack_di_free_numeric(&_numeric);
+        status = umfpack_di_numeric(_Ap, _Ai, Ax, _symbolic, &_numeric, control, NULL);
         if(status<0)
             throw ModelicaSimulationError(ALGLOOP_SOLVER,"Error in umfpack numeric function");
-        status = umf::solve (A, x, b, Numeric);
+        _nNumeric++;
+
+        status = umfpack_di_solve(UMFPACK_A, _Ap, _Ai, Ax, _x, _rhs, _numeric, control, NULL);
         if(status<0)
             throw ModelicaSimulationError(ALGLOOP_SOLVER,"Error in umfpack solve function");
+        _nSolve++;
         _algLoop->setReal(_x);
 
 
@@ -159,6 +188,13 @@ void UmfPack::solve()
 #endif
 }
 
+bool UmfPack::hasSparsityPattern(int dimSys, int nonzeros, int const* Ap, int const* Ai)
+{
+    return nonzeros == _nonzeros
+        && memcmp(Ap, _Ap, sizeof(int) * (dimSys + 1)) == 0
+        && memcmp(Ai, _Ai, sizeof(int) * nonzeros) == 0;
+}
+
 ILinearAlgLoopSolver::ITERATIONSTATUS UmfPack::getIterationStatus()
 {
     return _iterationStatus;
@@ -39,6 +39,7 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <map>
 #include <algorithm>
 #include <iomanip>
 #include <stdlib.h>
@@ -47,6 +48,9 @@
 #include "omc_config.h"
 #include <cmath>
 #include "dataReconciliation.h"
+#ifdef WITH_UMFPACK
+#include "suitesparse/Include/amd.h"
+#endif
 
 extern "C"
 {
@@ -494,136 +498,437 @@ matrixData solveMatrixAddition(matrixData A, matrixData B, ofstream & logfile)
 }
 
 /*
- * Function which Calculates the Matrix Multiplication
- * of (Sx*Ft)*Fstar
+ * Sparse matrix in compressed column format,
+ * colptr holds column+1 entries and rowind and values
+ * hold the row index and the value of each nonzero
  */
-matrixData Calculate_Sx_Ft_Fstar(matrixData Sx, matrixData Ft, matrixData Fstar, ofstream & logfile)
+struct sparseMatrix {
+	int rows;
+	int column;
+	vector<int> colptr;
+	vector<int> rowind;
+	vector<double> values;
+};
+
+/*
+ * Sparse LDL^T factorization of the symmetric positive definite
+ * matrix (F*Sx*Ft) with the fill reducing permutation P,
+ * the elimination tree and the pattern of L are computed once
+ * and reused for every numeric factorization with the same pattern
+ */
+struct sparseLDL {
+	int n;
+	bool analysed;
+	bool factorized;
+	vector<int> P;
+	vector<int> Pinv;
+	vector<int> parent;
+	vector<int> Lp;
+	vector<int> Lnz;
+	vector<int> Li;
+	vector<double> Lx;
+	vector<double> D;
+	vector<int> colptr; // pattern of the analysed matrix
+	vector<int> rowind;
+};
+
+/*
+ * State of the reconciliation solver which is kept over the
+ * convergence iterations and the measurement sets of a batch
+ */
+struct reconciliationSolver {
+	sparseMatrix Sx;  // covariance matrix Sx
+	sparseMatrix F;   // jacobian matrix F
+	sparseMatrix Ft;  // transpose of F
+	sparseMatrix FSx; // F*Sx
+	sparseMatrix M;   // F*Sx*Ft
+	sparseLDL ldl;    // factorization of F*Sx*Ft
+	int factorizations;
+	int reusedFactorizations;
+};
+
+/*
+ * Function which converts the sparse matrix
+ * into a dense matrix in column major,
+ * mostly used to print the matrices
+ */
+double * sparseToDenseMatrix(const sparseMatrix & A)
 {
-	// Sx*Ft
-	double* tmpMatrixA = (double*)calloc(Sx.rows*Ft.column,sizeof(double));
-	solveMatrixMultiplication(Sx.data,Ft.data,Sx.rows,Sx.column,Ft.rows,Ft.column,tmpMatrixA,logfile);
-	//printMatrix1(tmpMatrixA,Sx.rows,Ft.column,"Reconciled-(Sx*Ft)");
-	//printMatrix1(Fstar.data,Fstar.rows,Fstar.column,"REconciled-FStar");
-
-	//(Sx*Ft)*Fstar
-	double* tmpMatrixB = (double*)calloc(Sx.rows*Fstar.column,sizeof(double));
-	solveMatrixMultiplication(tmpMatrixA,Fstar.data,Sx.rows,Ft.column,Fstar.rows,Fstar.column,tmpMatrixB,logfile);
-	matrixData rhsdata= {Sx.rows,Fstar.column,tmpMatrixB};
-
-	free(tmpMatrixA);
-	free(tmpMatrixB);
-	return rhsdata;
+	double * dense = (double*)calloc(A.rows*A.column,sizeof(double));
+	for (int j=0; j < A.column; j++)
+	{
+		for (int p=A.colptr[j]; p < A.colptr[j+1]; p++)
+		{
+			dense[A.rowind[p]+j*A.rows] = A.values[p];
+		}
+	}
+	return dense;
 }
 
 /*
- * Solves the system
- * recon_x = x - (Sx*Ft*fstar)
+ * Function to Print the sparse matrix in row based format
  */
-matrixData solveReconciledX(matrixData x, matrixData Sx, matrixData Ft, matrixData Fstar, ofstream& logfile)
+void printSparseMatrix(const sparseMatrix & A, string name, ofstream & logfile)
 {
-	// Sx*Ft
-	double* tmpMatrixAf = (double*)calloc(Sx.rows*Ft.column,sizeof(double));
-	solveMatrixMultiplication(Sx.data,Ft.data,Sx.rows,Sx.column,Ft.rows,Ft.column,tmpMatrixAf,logfile);
-	//printMatrix(tmpMatrixAf,Sx.rows,Ft.column,"Sx*Ft");
-	//(Sx*Ft)*fstar
-	double* tmpMatrixBf = (double*)calloc(Sx.rows*Fstar.column,sizeof(double));
-	solveMatrixMultiplication(tmpMatrixAf,Fstar.data,Sx.rows,Ft.column,Fstar.rows,Fstar.column,tmpMatrixBf,logfile);
-	//printMatrix(tmpMatrixBf,Sx.rows,Fstar.column,"(Sx*Ft*fstar)");
-
-	matrixData rhs= {Sx.rows,Fstar.column,tmpMatrixBf};
-	//matrixData rhs = Calculate_Sx_Ft_Fstar(Sx,Ft,Fstar);
-
-	double* reconciledX = (double*)calloc(x.rows*x.column,sizeof(double));
-	solveMatrixSubtraction(x,rhs,reconciledX,logfile);
-	//printMatrix(reconciledX,x.rows,x.column,"reconciled X^cap ===> (x - (Sx*Ft*fstar))");
-	if(ACTIVE_STREAM(LOG_JAC))
+	double * dense = sparseToDenseMatrix(A);
+	printMatrix(dense,A.rows,A.column,name,logfile);
+	free(dense);
+}
+
+/*
+ * Function to Print the sparse matrix in row based format with headers
+ */
+void printSparseMatrixWithHeaders(const sparseMatrix & A, vector<string> headers, string name, ofstream & logfile)
+{
+	double * dense = sparseToDenseMatrix(A);
+	printMatrixWithHeaders(dense,A.rows,A.column,headers,name,logfile);
+	free(dense);
+}
+
+/*
+ * Function Which gets the diagonal elements of the sparse matrix
+ */
+vector<double> getSparseDiagonalElements(const sparseMatrix & A)
+{
+	vector<double> result(min(A.rows,A.column),0.0);
+	for (unsigned int j=0; j < result.size(); j++)
 	{
-		logfile << "Calculations of Reconciled_x ==> (x - (Sx*Ft*f*))" << "\n";
-		logfile << "====================================================";
-		printMatrix(tmpMatrixAf,Sx.rows,Ft.column,"Sx*Ft",logfile);
-		printMatrix(tmpMatrixBf,Sx.rows,Fstar.column,"(Sx*Ft*f*)",logfile);
-		printMatrix(reconciledX,x.rows,x.column,"x - (Sx*Ft*f*))",logfile);
-		logfile << "***** Completed ****** \n\n";
+		for (int p=A.colptr[j]; p < A.colptr[j+1]; p++)
+		{
+			if(A.rowind[p] == (int)j)
+			{
+				result[j] = A.values[p];
+			}
+		}
 	}
-	matrixData recon_x = {x.rows,x.column,reconciledX};
-	//free(reconciledX);
-	free(tmpMatrixAf);
-	free(tmpMatrixBf);
-	return recon_x;
+	return result;
 }
 
 /*
- * Solves the system
- * recon_Sx = Sx - (Sx*Ft*Fstar)
+ * Function to transpose the sparse Matrix,
+ * the row indices of the result are sorted
  */
-matrixData solveReconciledSx(matrixData Sx, matrixData Ft, matrixData Fstar, ofstream& logfile)
+sparseMatrix transposeSparseMatrix(const sparseMatrix & A)
 {
-	// Sx*Ft
-	double* tmpMatrixA = (double*)calloc(Sx.rows*Ft.column,sizeof(double));
-	solveMatrixMultiplication(Sx.data,Ft.data,Sx.rows,Sx.column,Ft.rows,Ft.column,tmpMatrixA, logfile);
-	//printMatrix(tmpMatrixA,Sx.rows,Ft.column,"Reconciled-(Sx*Ft)");
-	//printMatrix(Fstar.data,Fstar.rows,Fstar.column,"REconciled-FStar");
-
-	//(Sx*Ft)*Fstar
-	double* tmpMatrixB = (double*)calloc(Sx.rows*Fstar.column,sizeof(double));
-	solveMatrixMultiplication(tmpMatrixA,Fstar.data,Sx.rows,Ft.column,Fstar.rows,Fstar.column,tmpMatrixB, logfile);
-	//printMatrix(tmpMatrixB,Sx.rows,Fstar.column,"Reconciled-(Sx*Ft*Fstar)");
-
-	matrixData rhs= {Sx.rows,Fstar.column,tmpMatrixB};
-
-	//matrixData rhs = Calculate_Sx_Ft_Fstar(Sx,Ft,Fstar);
-	double* reconciledSx = (double*)calloc(Sx.rows*Sx.column,sizeof(double));
-	solveMatrixSubtraction(Sx,rhs,reconciledSx, logfile);
-	//printMatrix(reconciledSx,Sx.rows,Sx.column,"reconciled Sx ===> (Sx - (Sx*Ft*Fstar))");
-	if(ACTIVE_STREAM(LOG_JAC))
+	sparseMatrix At;
+	At.rows = A.column;
+	At.column = A.rows;
+	At.colptr.assign(A.rows+1,0);
+	At.rowind.resize(A.rowind.size());
+	At.values.resize(A.values.size());
+	for (unsigned int p=0; p < A.rowind.size(); p++)
 	{
-		logfile << "Calculations of Reconciled_Sx ===> (Sx - (Sx*Ft*F*))" << "\n";
-		logfile << "============================================";
-		printMatrix(tmpMatrixA,Sx.rows,Ft.column,"(Sx*Ft)",logfile);
-		printMatrix(tmpMatrixB,Sx.rows,Fstar.column,"(Sx*Ft*F*)",logfile);
-		printMatrix(reconciledSx,Sx.rows,Sx.column,"Sx - (Sx*Ft*F*))",logfile);
-		logfile << "***** Completed ****** \n\n";
+		At.colptr[A.rowind[p]+1]++;
+	}
+	for (int i=0; i < A.rows; i++)
+	{
+		At.colptr[i+1] += At.colptr[i];
+	}
+	vector<int> next(At.colptr.begin(), At.colptr.end()-1);
+	for (int j=0; j < A.column; j++)
+	{
+		for (int p=A.colptr[j]; p < A.colptr[j+1]; p++)
+		{
+			int q = next[A.rowind[p]]++;
+			At.rowind[q] = j;
+			At.values[q] = A.values[p];
+		}
 	}
-	matrixData recon_sx ={Sx.rows,Sx.column,reconciledSx};
-	//free(reconciledSx);
-	free(tmpMatrixA);
-	free(tmpMatrixB);
-	return recon_sx;
+	return At;
 }
 
 /*
- * Function Which Computes the
- * Jacobian Matrix F
+ * Sparse Matrix Multiplication C=A*B computed column by column,
+ * the row indices of each column of C are sorted
  */
-matrixData getJacobianMatrixF(DATA* data, threadData_t *threadData, ofstream & logfile)
+sparseMatrix multiplySparseMatrix(const sparseMatrix & A, const sparseMatrix & B, ofstream & logfile)
+{
+	if(A.column != B.rows)
+	{
+		logfile << "|  error   |   " << "multiplySparseMatrix() Failed!, Column of First Matrix not equal to Rows of Second Matrix " << A.column << " != "<< B.rows <<  "\n";
+		logfile.close();
+		exit(1);
+	}
+	sparseMatrix C;
+	C.rows = A.rows;
+	C.column = B.column;
+	C.colptr.assign(B.column+1,0);
+	vector<double> work(A.rows,0.0);
+	vector<int> marker(A.rows,-1);
+	for (int j=0; j < B.column; j++)
+	{
+		int start = C.rowind.size();
+		for (int p=B.colptr[j]; p < B.colptr[j+1]; p++)
+		{
+			int k = B.rowind[p];
+			double bkj = B.values[p];
+			for (int q=A.colptr[k]; q < A.colptr[k+1]; q++)
+			{
+				int i = A.rowind[q];
+				if(marker[i] != j)
+				{
+					marker[i] = j;
+					work[i] = 0.0;
+					C.rowind.push_back(i);
+				}
+				work[i] += A.values[q]*bkj;
+			}
+		}
+		std::sort(C.rowind.begin()+start, C.rowind.end());
+		for (unsigned int q=start; q < C.rowind.size(); q++)
+		{
+			C.values.push_back(work[C.rowind[q]]);
+		}
+		C.colptr[j+1] = C.rowind.size();
+	}
+	return C;
+}
+
+/*
+ * Symbolic analysis of the sparse LDL^T factorization of M,
+ * computes the fill reducing ordering (AMD if available),
+ * the elimination tree and the number of nonzeros of each column of L
+ */
+void analyseSparseLDL(sparseLDL & ldl, const sparseMatrix & M)
+{
+	int n = M.column;
+	ldl.n = n;
+	ldl.P.resize(n);
+	ldl.Pinv.resize(n);
+	ldl.parent.resize(n);
+	ldl.Lnz.resize(n);
+	ldl.Lp.resize(n+1);
+	ldl.D.resize(n);
+	vector<int> flag(n);
+
+	bool ordered = false;
+#ifdef WITH_UMFPACK
+	ordered = n > 0 && amd_order(n, &M.colptr[0], &M.rowind[0], &ldl.P[0], NULL, NULL) >= AMD_OK;
+#endif
+	if(!ordered)
+	{
+		for (int k=0; k < n; k++)
+		{
+			ldl.P[k] = k;
+		}
+	}
+	for (int k=0; k < n; k++)
+	{
+		ldl.Pinv[ldl.P[k]] = k;
+	}
+
+	/* compute the elimination tree and the column counts of L */
+	for (int k=0; k < n; k++)
+	{
+		ldl.parent[k] = -1;
+		ldl.Lnz[k] = 0;
+		flag[k] = k;
+		int kk = ldl.P[k];
+		for (int p=M.colptr[kk]; p < M.colptr[kk+1]; p++)
+		{
+			int i = ldl.Pinv[M.rowind[p]];
+			if(i < k)
+			{
+				for (; flag[i] != k; i = ldl.parent[i])
+				{
+					if(ldl.parent[i] == -1)
+					{
+						ldl.parent[i] = k;
+					}
+					ldl.Lnz[i]++;
+					flag[i] = k;
+				}
+			}
+		}
+	}
+	ldl.Lp[0] = 0;
+	for (int k=0; k < n; k++)
+	{
+		ldl.Lp[k+1] = ldl.Lp[k] + ldl.Lnz[k];
+	}
+	ldl.Li.resize(ldl.Lp[n]);
+	ldl.Lx.resize(ldl.Lp[n]);
+	ldl.colptr = M.colptr;
+	ldl.rowind = M.rowind;
+	ldl.analysed = true;
+	ldl.factorized = false;
+}
+
+/*
+ * Numeric LDL^T factorization of M based on the symbolic analysis,
+ * returns false if M is singular
+ */
+bool factorSparseLDL(sparseLDL & ldl, const sparseMatrix & M)
+{
+	int n = ldl.n;
+	vector<double> Y(n,0.0);
+	vector<int> pattern(n);
+	vector<int> flag(n);
+	ldl.factorized = false;
+	for (int k=0; k < n; k++)
+	{
+		/* compute the nonzero pattern of row k of L */
+		int top = n;
+		flag[k] = k;
+		ldl.Lnz[k] = 0;
+		int kk = ldl.P[k];
+		for (int p=M.colptr[kk]; p < M.colptr[kk+1]; p++)
+		{
+			int i = ldl.Pinv[M.rowind[p]];
+			if(i <= k)
+			{
+				Y[i] += M.values[p];
+				int len;
+				for (len=0; flag[i] != k; i = ldl.parent[i])
+				{
+					pattern[len++] = i;
+					flag[i] = k;
+				}
+				while(len > 0)
+				{
+					pattern[--top] = pattern[--len];
+				}
+			}
+		}
+		/* compute row k of L and the diagonal element D(k) */
+		ldl.D[k] = Y[k];
+		Y[k] = 0.0;
+		for (; top < n; top++)
+		{
+			int i = pattern[top];
+			double yi = Y[i];
+			Y[i] = 0.0;
+			int p2 = ldl.Lp[i] + ldl.Lnz[i];
+			for (int p=ldl.Lp[i]; p < p2; p++)
+			{
+				Y[ldl.Li[p]] -= ldl.Lx[p]*yi;
+			}
+			double l_ki = yi/ldl.D[i];
+			ldl.D[k] -= l_ki*yi;
+			ldl.Li[p2] = k;
+			ldl.Lx[p2] = l_ki;
+			ldl.Lnz[i]++;
+		}
+		if(ldl.D[k] == 0.0)
+		{
+			return false;
+		}
+	}
+	ldl.factorized = true;
+	return true;
+}
+
+/*
+ * Solve the Linear System M*x=b using the sparse LDL^T factorization,
+ * b will be overridden with the solution x
+ */
+void solveSparseLDL(const sparseLDL & ldl, double * b, vector<double> & work)
+{
+	int n = ldl.n;
+	work.resize(n);
+	for (int k=0; k < n; k++)
+	{
+		work[k] = b[ldl.P[k]];
+	}
+	for (int j=0; j < n; j++)
+	{
+		for (int p=ldl.Lp[j]; p < ldl.Lp[j+1]; p++)
+		{
+			work[ldl.Li[p]] -= ldl.Lx[p]*work[j];
+		}
+	}
+	for (int j=0; j < n; j++)
+	{
+		work[j] /= ldl.D[j];
+	}
+	for (int j=n-1; j >= 0; j--)
+	{
+		for (int p=ldl.Lp[j]; p < ldl.Lp[j+1]; p++)
+		{
+			work[j] -= ldl.Lx[p]*work[ldl.Li[p]];
+		}
+	}
+	for (int k=0; k < n; k++)
+	{
+		b[ldl.P[k]] = work[k];
+	}
+}
+
+/*
+ * Function Which Computes the sparse
+ * Jacobian Matrix F, all columns of one color are
+ * evaluated with a single call if the jacobian has
+ * a colored sparse pattern, otherwise the dense columns
+ * are evaluated and the zeros are dropped
+ */
+void getSparseJacobianMatrixF(DATA* data, threadData_t *threadData, sparseMatrix & F, ofstream & logfile)
 {
-	// initialize the jacobian call
 	const int index = data->callback->INDEX_JAC_F;
 	ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
-	data->callback->initialAnalyticJacobianF(data, threadData, jacobian);
+	SPARSE_PATTERN* sparsePattern = jacobian->sparsePattern;
 	int cols = jacobian->sizeCols;
 	int rows = jacobian->sizeRows;
 	if(cols == 0) {
-		//errorStreamPrint(LOG_STDOUT, 0, "Cannot Compute Jacobian Matrix F");
 		logfile << "|  error   |   " << "Cannot Compute Jacobian Matrix F" << "\n";
 		logfile.close();
 		exit(1);
 	}
-	double* jacF = (double*)calloc(rows*cols,sizeof(double)); // allocate for Matrix F
-	int k=0;
-	for (int x=0; x < cols ; x++)
+	F.rows = rows;
+	F.column = cols;
+
+	if(sparsePattern != NULL && sparsePattern->maxColors > 0)
 	{
-		jacobian->seedVars[x] = 1.0;
-		data->callback->functionJacF_column(data, threadData, jacobian, NULL);
-		//cout << "Calculate one column\n:";
-		for (int y=0; y < rows ; y++)
+		/* the pattern is fixed, copy it only once */
+		if((int)F.colptr.size() != cols+1)
 		{
-			jacF[k++]=jacobian->resultVars[y];
+			F.colptr.assign(sparsePattern->leadindex, sparsePattern->leadindex+cols+1);
+			F.rowind.assign(sparsePattern->index, sparsePattern->index+sparsePattern->leadindex[cols]);
+			F.values.assign(sparsePattern->leadindex[cols],0.0);
+		}
+		for (unsigned int color=0; color < sparsePattern->maxColors; color++)
+		{
+			for (int x=0; x < cols; x++)
+			{
+				if(sparsePattern->colorCols[x]-1 == color)
+				{
+					jacobian->seedVars[x] = 1.0;
+				}
+			}
+			data->callback->functionJacF_column(data, threadData, jacobian, NULL);
+			for (int x=0; x < cols; x++)
+			{
+				if(sparsePattern->colorCols[x]-1 == color)
+				{
+					for (int p=F.colptr[x]; p < F.colptr[x+1]; p++)
+					{
+						F.values[p] = jacobian->resultVars[F.rowind[p]];
+					}
+					jacobian->seedVars[x] = 0.0;
+				}
+			}
+		}
+	}
+	else
+	{
+		F.colptr.assign(cols+1,0);
+		F.rowind.clear();
+		F.values.clear();
+		for (int x=0; x < cols; x++)
+		{
+			jacobian->seedVars[x] = 1.0;
+			data->callback->functionJacF_column(data, threadData, jacobian, NULL);
+			for (int y=0; y < rows; y++)
+			{
+				if(jacobian->resultVars[y] != 0.0)
+				{
+					F.rowind.push_back(y);
+					F.values.push_back(jacobian->resultVars[y]);
+				}
+			}
+			jacobian->seedVars[x] = 0.0;
+			F.colptr[x+1] = F.rowind.size();
 		}
-		jacobian->seedVars[x] = 0.0;
 	}
-	matrixData Fdata ={rows,cols,jacF};
-	return Fdata;
 }
 
 /*
@@ -688,34 +993,17 @@ matrixData getCovarianceMatrixSx(csvData Sx_result, DATA* data, threadData_t *th
  * covariance matrix Sx based on
  * Half width confidence interval provided by user
  * Sx=(Wxi/1.96)^2
+ * the matrix is stored sparse with the diagonal and
+ * the correlated entries rx_ik*sqrt(Sx_i)*sqrt(Sx_k)
  */
-
-matrixData computeCovarianceMatrixSx(csvData Sx_result, DATA* data, threadData_t *threadData, ofstream & logfile)
+sparseMatrix computeCovarianceMatrixSx(csvData Sx_result, DATA* data, threadData_t *threadData, ofstream & logfile)
 {
-	double* tempSx = (double*)calloc(Sx_result.sxdata.size()*Sx_result.sxdata.size(),sizeof(double));
-	vector<double> tmpdata;
-	int k=0;
-	for (unsigned int i=0;i<Sx_result.sxdata.size(); i++)
+	int n = Sx_result.sxdata.size();
+	vector< map<int,double> > columns(n);
+	for (int i=0; i < n; i++)
 	{
-		double data = pow(Sx_result.sxdata[k]/1.96,2);
-		for (unsigned int j=0;j<Sx_result.sxdata.size();j++)
-		{
-			if(i==j)
-			{
-				//tmpdata.push_back(pow(Sx_result.sxdata[k]/1.96,2));
-				//k++;
-				tmpdata.push_back(data);
-			}
-			else
-			{
-				tmpdata.push_back(0);
-			}
-			// logfile << " data " << count << "=="<< tmpdata[count++] << "\n";
-		}
-		k++;
+		columns[i][i] = pow(Sx_result.sxdata[i]/1.96,2);
 	}
-	//logfile << "tmpdatasize" << tmpdata.size() << "\n";
-	//logfile << "Size of vector :" << Sx_result.rx.size() << "\n";
 
 	/* check for corelation coefficient matrix and insert the elements in correct position*/
 	for (unsigned int l=0; l < Sx_result.rx.size();l++)
@@ -723,40 +1011,43 @@ matrixData computeCovarianceMatrixSx(csvData Sx_result, DATA* data, threadData_t
 		int pos1;
 		int pos2;
 		double xi;
-		double xk ;
+		double xk;
 		for(unsigned int m=0; m<Sx_result.rx[l].size();m++)
 		{
 			if(m==0)
 			{
 				pos1 = getVariableIndex(Sx_result.headers,Sx_result.rx[l][m],logfile);
-				xi   =  tmpdata[(Sx_result.rowcount*pos1)+pos1];
-				//logfile << "xi =>"<< pos1 << "= "<< xi << "\n";
+				xi   = columns[pos1][pos1];
 			}
-
 			if(m==1)
 			{
 				pos2 = getVariableIndex(Sx_result.headers,Sx_result.rx[l][m],logfile);
-				xk   = tmpdata[(Sx_result.rowcount*pos2)+pos2];
-				//logfile << "xk =>"<< pos2 << "= "<< xk << "\n";
+				xk   = columns[pos2][pos2];
 			}
 			if(m==2)
 			{
-				//logfile << "position:" << pos1 << ": " << pos2 << "\n";
-				//logfile << "rx_ik" << Sx_result.rx[l][m] << "*" << xi << "*" << xk << "\n";
-				//logfile << atof((Sx_result.rx[l][m]).c_str())*sqrt(xi)*sqrt(xk) << "\n";
 				double tmprx = atof((Sx_result.rx[l][m]).c_str())*sqrt(xi)*sqrt(xk);
-				// find the symmetric position and insert the elements
-				//logfile << "final position :" << (Sx_result.rowcount*pos1)+pos2 << "value is: "<< tmprx << "\n";
-				//logfile << "final position :" << (Sx_result.rowcount*pos2)+pos1 << "value is: "<< tmprx << "\n";
-				tmpdata[(Sx_result.rowcount*pos1)+pos2]=tmprx;
-				tmpdata[(Sx_result.rowcount*pos2)+pos1]=tmprx;
+				// insert the elements at the symmetric position
+				columns[pos1][pos2]=tmprx;
+				columns[pos2][pos1]=tmprx;
 			}
 		}
-		//logfile << "\n";
 	}
-	initColumnMatrix(tmpdata , Sx_result.rowcount, Sx_result.rowcount, tempSx);
-	matrixData Sx_data = {Sx_result.rowcount,Sx_result.rowcount,tempSx};
-	return Sx_data;
+
+	sparseMatrix Sx;
+	Sx.rows = n;
+	Sx.column = n;
+	Sx.colptr.assign(n+1,0);
+	for (int j=0; j < n; j++)
+	{
+		for (map<int,double>::iterator it=columns[j].begin(); it != columns[j].end(); ++it)
+		{
+			Sx.rowind.push_back(it->first);
+			Sx.values.push_back(it->second);
+		}
+		Sx.colptr[j+1] = Sx.rowind.size();
+	}
+	return Sx;
 }
 
 /*
@@ -847,113 +1138,6 @@ void calculateSquareRoot(double * data, int length)
 	}
 }
 
-/*
- * Function which calculates
- * J*=(recon_x-x)T*(Sx^-1)*(recon_x-x)+2.[f+F*(recon_x-x)]T*fstar
- * where T= transpose of matrix
- * and returns the converged value
- */
-
-double solveConvergence(DATA* data, matrixData conv_recon_x, matrixData conv_recon_sx, inputData conv_x, matrixData conv_sx, matrixData conv_jacF, matrixData conv_vector_c, matrixData conv_fstar, ofstream & logfile)
-{
-
-	//printMatrix(conv_vector_c.data,conv_vector_c.rows,conv_vector_c.column,"Convergence_C(x,y)");
-	//printMatrix(conv_fstar.data,conv_fstar.rows,conv_fstar.column,"Convergence_f*");
-	//printMatrix(conv_recon_x.data,conv_recon_x.rows,conv_recon_x.column,"check_recon_x*");
-
-	// calculate(recon_x-x)
-	double* conv_data1 = (double*)calloc(conv_x.rows*conv_x.column,sizeof(double));
-	matrixData conv_inputs = {conv_x.rows,conv_x.column,conv_x.data};
-	solveMatrixSubtraction(conv_recon_x,conv_inputs,conv_data1,logfile);
-	matrixData conv_data1result={conv_x.rows,conv_x.column,conv_data1};
-	matrixData copy_reconx_x = copyMatrix(conv_data1result);
-
-	//printMatrix(conv_inputs.data,conv_inputs.rows,conv_inputs.column,"check_inputs");
-	//printMatrix(conv_data1result.data,conv_data1result.rows,conv_data1result.column,"(recon_X - X)");
-
-	// calculate Transpose_(recon_x-x)
-	matrixData conv_data1Transpose = getTransposeMatrix(conv_data1result);
-	//printMatrix(conv_data1Transpose.data,conv_data1Transpose.rows,conv_data1Transpose.column,"Transpose(recon_X - X)");
-
-	/* solves (Sx^-1)*(recon_x-x)
-	 * Solve the inverse of matrix Sx using linear form
-	 * Ax=b
-	 * where A=Sx and b= (recon_x-x) to avoid inversion of Sx which is
-	 * expensive
-	 */
-	solveSystemFstar(conv_sx.rows,1,conv_sx.data,conv_data1result.data,logfile);
-	//printMatrix(conv_data1result.data,conv_sx.rows,conv_data1result.column,"inverse multiplication_without inverse");
-
-	double *conv_tmpmatrixlhs = (double*)calloc(conv_data1Transpose.rows*conv_data1result.column,sizeof(double));
-	/*
-	 * Solve (recon_x-x)T*(Sx^-1)*(recon_x-x)
-	 */
-	solveMatrixMultiplication(conv_data1Transpose.data,conv_data1result.data,conv_data1Transpose.rows,conv_data1Transpose.column,conv_data1result.rows,conv_data1result.column,conv_tmpmatrixlhs,logfile);
-	//printMatrix(conv_tmpmatrixlhs,conv_data1Transpose.rows,conv_data1result.column,"(recon_x-x)T*(Sx^-1)*(recon_x-x)");
-	matrixData struct_conv_tmpmatrixlhs = {conv_data1Transpose.rows,conv_data1result.column,conv_tmpmatrixlhs};
-
-	/*
-	 * Solve rhs = 2.[f+F*(recon_x-x)]T*fstar
-	 *
-	 */
-	// Calculate F*(recon_x-x)
-	double * tmp_F_recon_x_x = (double*)calloc(conv_jacF.rows*copy_reconx_x.column,sizeof(double));
-	solveMatrixMultiplication(conv_jacF.data, copy_reconx_x.data, conv_jacF.rows, conv_jacF.column, copy_reconx_x.rows, copy_reconx_x.column,tmp_F_recon_x_x, logfile);
-	//printMatrix(tmp_F_recon_x_x,conv_jacF.rows,copy_reconx_x.column,"F*(recon_x-x)");
-	matrixData mult_F_recon_x_x = {conv_jacF.rows,copy_reconx_x.column,tmp_F_recon_x_x};
-
-	// Calculate f + F*(recon_x-x)
-	matrixData add_f_F_recon_x_x = solveMatrixAddition(conv_vector_c, mult_F_recon_x_x, logfile);
-	//printMatrix(add_f_F_recon_x_x.data,add_f_F_recon_x_x.rows,add_f_F_recon_x_x.column,"f + F*(recon_x-x)");
-
-	matrixData transpose_add_f_F_recon_x_x = getTransposeMatrix(add_f_F_recon_x_x);
-	//printMatrix(transpose_add_f_F_recon_x_x.data,transpose_add_f_F_recon_x_x.rows,transpose_add_f_F_recon_x_x.column,"transpose-[f + F*(recon_x-x)]");
-
-	// calculate [f + F*(recon_x-x)]T*fstar
-	double *conv_tmpmatrixrhs = (double*)calloc(transpose_add_f_F_recon_x_x.rows*conv_fstar.column,sizeof(double));
-	solveMatrixMultiplication(transpose_add_f_F_recon_x_x.data, conv_fstar.data, transpose_add_f_F_recon_x_x.rows, transpose_add_f_F_recon_x_x.column, conv_fstar.rows, conv_fstar.column, conv_tmpmatrixrhs, logfile);
-	//printMatrix(conv_tmpmatrixrhs, transpose_add_f_F_recon_x_x.rows, conv_fstar.column,"[f + F*(recon_x-x)]*fstar");
-
-	// scale the matrix with 2*[f + F*(recon_x-x)]T*fstar
-	scaleVector(transpose_add_f_F_recon_x_x.rows , conv_fstar.column, 2.0, conv_tmpmatrixrhs);
-	//printMatrix(conv_tmpmatrixrhs, transpose_add_f_F_recon_x_x.rows, conv_fstar.column,"2*[f + F*(recon_x-x)]*fstar");
-	matrixData struct_conv_tmpmatrixrhs= {transpose_add_f_F_recon_x_x.rows, conv_fstar.column,conv_tmpmatrixrhs};
-
-	/*
-	 * solve the final J*=J*=(recon_x-x)T*(Sx^-1)*(recon_x-x)+2.[f+F*(recon_x-x)]T*fstar
-	 * J*=_struct_conv_tmpmatrixlhs + struct_conv_tmpmatrixrhs
-	 */
-	matrixData struct_Jstar= solveMatrixAddition(struct_conv_tmpmatrixlhs,struct_conv_tmpmatrixrhs, logfile);
-	//printMatrix(struct_Jstar.data,struct_Jstar.rows,struct_Jstar.column,"J*",logfile);
-
-	int r=data->modelData->nSetcVars; // number of setc equations
-	double val=1.0/r;
-
-	/*
-	 * calculate J/r < epselon
-	 */
-	scaleVector(struct_Jstar.rows,struct_Jstar.column,val,struct_Jstar.data);
-	//printMatrix(struct_Jstar.data,struct_Jstar.rows,struct_Jstar.column,"J*/r ");
-	double convergedvalue=struct_Jstar.data[0];
-
-	//  free(struct_Jstar.data);
-	//  free(struct_conv_tmpmatrixrhs.data);
-	//  free(conv_tmpmatrixrhs);
-	//  free(transpose_add_f_F_recon_x_x.data);
-	//  free(add_f_F_recon_x_x.data);
-	//  free(transpose_add_f_F_recon_x_x.data);
-	//  free(mult_F_recon_x_x.data);
-	//  free(tmp_F_recon_x_x);
-	//  free(struct_conv_tmpmatrixlhs.data);
-	//  free(conv_tmpmatrixlhs);
-	//  free(conv_data1Transpose.data);
-	//  free(copy_reconx_x.data);
-	//  free(conv_data1result.data);
-	//  free(conv_data1);
-
-	return convergedvalue;
-}
-
 /*
  * Example Function which performs matrix inverse
  * using dgetri_ and dgetrf_ LAPACK routine
@@ -995,128 +1179,185 @@ void checkInExpensiveMatrixInverse(ofstream & logfile)
 	//printMatrix(checksx,3,1,"InExpensive_Matrix_Inverse");
 }
 
-int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixData Sx, matrixData tmpjacF, matrixData tmpjacFt, double eps, int iterationcount, csvData csvinputs, matrixData xdiag, matrixData sxdiag, ofstream& logfile)
+/*
+ * Function which updates F*Sx and F*Sx*Ft for the current Jacobian F
+ * and factorizes F*Sx*Ft, the factorization is reused as long as F
+ * does not change (e.g. linear constraints) and the symbolic analysis
+ * is reused as long as the pattern of F*Sx*Ft does not change
+ */
+void updateReconciliationSolver(DATA* data, threadData_t *threadData, reconciliationSolver & solver, ofstream & logfile)
 {
-	// set the inputs first
-    /*
-	for (int i=0; i< x.rows*x.column; i++)
+	sparseMatrix previousF = solver.F;
+	getSparseJacobianMatrixF(data, threadData, solver.F, logfile);
+	if(solver.ldl.factorized && previousF.colptr == solver.F.colptr && previousF.rowind == solver.F.rowind && previousF.values == solver.F.values)
 	{
-		data->simulationInfo->inputVars[x.index[i]]=x.data[i];
-		//logfile << "input data:" << x.data[i]<<"\n";
-	}*/
+		solver.reusedFactorizations++;
+		return;
+	}
 
-	for (int i=0; i< x.rows*x.column; i++)
+	solver.Ft = transposeSparseMatrix(solver.F);
+	solver.FSx = multiplySparseMatrix(solver.F, solver.Sx, logfile);
+	solver.M = multiplySparseMatrix(solver.FSx, solver.Ft, logfile);
+	if(!solver.ldl.analysed || solver.ldl.colptr != solver.M.colptr || solver.ldl.rowind != solver.M.rowind)
+	{
+		analyseSparseLDL(solver.ldl, solver.M);
+	}
+	if(!factorSparseLDL(solver.ldl, solver.M))
 	{
-		data->simulationInfo->datainputVars[i]=x.data[i];
-		//logfile << "input data:" << x.data[i]<<"\n";
+		logfile << "|  error   |   " << "factorSparseLDL() Failed !, The Matrix (F*Sx*Ft) is singular, The solution could not be computed" << "\n";
+		logfile.close();
+		exit(1);
 	}
+	solver.factorizations++;
+}
 
-    /* set the inputs via this special function generated for dataReconciliation
-     * which also sets inputs for models not involving top level inputs
-     */
-    data->callback->data_function(data, threadData);
-	//data->callback->input_function(data, threadData);
+/*
+ * Function which performs one reconciliation step for the measured values x
+ * f* = (F*Sx*Ft)^-1 * c(x,y)
+ * recon_x = x - (Sx*Ft*f*)
+ * and returns the converged value J* scaled with 1/r
+ * J*=(recon_x-x)T*(Sx^-1)*(recon_x-x)+2.[f+F*(recon_x-x)]T*fstar
+ * since (Sx^-1)*(recon_x-x) = -Ft*f* no system with Sx has to be solved
+ */
+double solveReconciliationStep(DATA* data, threadData_t *threadData, reconciliationSolver & solver, const vector<double> & x, vector<double> & reconciledX, ofstream & logfile)
+{
+	int n = x.size();
+	int r = data->modelData->nSetcVars; // number of setc equations
+	vector<double> work;
+
+	for (int i=0; i < n; i++)
+	{
+		data->simulationInfo->datainputVars[i]=x[i];
+	}
+	/* set the inputs via this special function generated for dataReconciliation
+	 * which also sets inputs for models not involving top level inputs
+	 */
+	data->callback->data_function(data, threadData);
 	data->callback->functionDAE(data,threadData);
-	//data->callback->functionODE(data,threadData);
 	data->callback->setc_function(data, threadData);
 
-	matrixData jacF = getJacobianMatrixF(data,threadData,logfile);
-	matrixData jacFt = getTransposeMatrix(jacF);
-
-	printMatrix(jacF.data,jacF.rows,jacF.column,"F",logfile);
-	printMatrix(jacFt.data,jacFt.rows,jacFt.column,"Ft",logfile);
-
-
-	double* setc = (double*)calloc(data->modelData->nSetcVars,sizeof(double)); // allocate data for setc array
-	// store the setc data to compute for convergence as setc will be overriddeen with new values
-	double* tmpsetc = (double*)calloc(data->modelData->nSetcVars,sizeof(double));
-
 	/* loop to store the data C(x,y) rhs side, get the elements in reverse order */
-	int t=0;
-	for (int i=data->modelData->nSetcVars; i > 0; i--)
-	{
-		setc[t]=data->simulationInfo->setcVars[i-1];
-		tmpsetc[t]=data->simulationInfo->setcVars[i-1];
-		t++;
-		//cout << "array_setc_vars:=>" << t << ":" << data->simulationInfo->setcVars[i-1] << "\n";
-	}
-
-	int nsetcvars= data->modelData->nSetcVars;
-	matrixData vector_c = {nsetcvars,1,tmpsetc};
-	//allocate data for matrix multiplication F*Sx
-	double * tmpmatrixC = (double*)calloc(jacF.rows*Sx.column,sizeof(double));
-	solveMatrixMultiplication(jacF.data,Sx.data,jacF.rows,jacF.column,Sx.rows,Sx.column,tmpmatrixC,logfile);
-	//printMatrix(tmpmatrixC,jacF.rows,Sx.column,"F*Sx");
-
-	//allocate data for matrix multiplication (F*Sx)*Ftranspose
-	double * tmpmatrixD = (double*)calloc(jacF.rows*jacFt.column,sizeof(double));
-	solveMatrixMultiplication(tmpmatrixC,jacFt.data,jacF.rows,Sx.column,jacFt.rows,jacFt.column,tmpmatrixD,logfile);
-	//printMatrix(tmpmatrixD,jacF.rows,jacFt.column,"F*Sx*Ft");
-	//printMatrix(setc,nsetcvars,1,"c(x,y)");
-	/*
-	 * Copy tmpmatrixC and tmpmatrixD to avoid loss of data
-	 * when calculating F*
-	 */
-	matrixData cpytmpmatrixC = {jacF.rows,Sx.column,tmpmatrixC};
-	matrixData cpytmpmatrixD = {jacF.rows,jacFt.column,tmpmatrixD};
-	matrixData tmpmatrixC1 = copyMatrix(cpytmpmatrixC);
-	matrixData tmpmatrixD1 = copyMatrix(cpytmpmatrixD);
+	vector<double> c(r);
+	for (int i=0; i < r; i++)
+	{
+		c[i]=data->simulationInfo->setcVars[r-1-i];
+	}
 
+	updateReconciliationSolver(data, threadData, solver, logfile);
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
+		printSparseMatrix(solver.F,"F",logfile);
+		printSparseMatrix(solver.Ft,"Ft",logfile);
 		logfile << "Calculations of Matrix (F*Sx*Ft) f* = c(x,y) " << "\n";
 		logfile << "============================================\n";
-		printMatrix(tmpmatrixC,jacF.rows,Sx.column,"F*Sx",logfile);
-		printMatrix(tmpmatrixD,jacF.rows,jacFt.column,"F*Sx*Ft",logfile);
-		printMatrix(setc,nsetcvars,1,"c(x,y)",logfile);
+		printSparseMatrix(solver.FSx,"F*Sx",logfile);
+		printSparseMatrix(solver.M,"F*Sx*Ft",logfile);
+		printMatrix(&c[0],r,1,"c(x,y)",logfile);
 	}
-	/*
-	 * calculate f* for covariance matrix (F*Sx*Ftranspose).F*= c(x,y)
-	 * matrix setc will be overridden with new values which is the output
-	 * for the calculation A *x =B
-	 * A = tmpmatrixD
-	 * B = setc
-	 */
-	solveSystemFstar(jacF.rows,1,tmpmatrixD,setc,logfile);
-	//printMatrix(setc,jacF.rows,1,"f*");
-	if(ACTIVE_STREAM(LOG_JAC))
+
+	// f* = (F*Sx*Ft)^-1 * c(x,y)
+	vector<double> fstar(c);
+	solveSparseLDL(solver.ldl, &fstar[0], work);
+
+	// recon_x = x - (Sx*Ft*f*) = x - (F*Sx)T*f*
+	vector<double> Sx_Ft_fstar(n,0.0);
+	reconciledX.resize(n);
+	for (int j=0; j < n; j++)
 	{
-		printMatrix(setc,jacF.rows,1,"f*",logfile);
-		logfile << "***** Completed ****** \n\n";
+		for (int p=solver.FSx.colptr[j]; p < solver.FSx.colptr[j+1]; p++)
+		{
+			Sx_Ft_fstar[j] += solver.FSx.values[p]*fstar[solver.FSx.rowind[p]];
+		}
+		reconciledX[j] = x[j]-Sx_Ft_fstar[j];
 	}
-	matrixData tmpxcap ={x.rows,1,x.data};
-	matrixData tmpfstar = {jacF.rows,1,setc};
-	matrixData reconciled_X = solveReconciledX(tmpxcap,Sx,jacFt,tmpfstar,logfile);
-	//printMatrix(reconciled_X.data,reconciled_X.rows,reconciled_X.column,"reconciled_X ===> (x - (Sx*Ft*fstar))");
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
-		logfile << "Calculations of Matrix (F*Sx*Ft) F* = F*Sx " << "\n";
-		logfile << "===============================================\n";
-		//printMatrix(tmpmatrixC,jacF.rows,Sx.column,"F*Sx");
-		//printMatrix(tmpmatrixD,jacF.rows,jacFt.column,"F*Sx*Ft");
-		printMatrix(tmpmatrixC1.data,tmpmatrixC1.rows,tmpmatrixC1.column,"F*Sx",logfile);
-		printMatrix(tmpmatrixD1.data,tmpmatrixD1.rows,tmpmatrixD1.column,"F*Sx*Ft",logfile);
+		printMatrix(&fstar[0],r,1,"f*",logfile);
+		logfile << "***** Completed ****** \n\n";
+		logfile << "Calculations of Reconciled_x ==> (x - (Sx*Ft*f*))" << "\n";
+		logfile << "====================================================";
+		printMatrix(&Sx_Ft_fstar[0],n,1,"(Sx*Ft*f*)",logfile);
+		printMatrix(&reconciledX[0],n,1,"x - (Sx*Ft*f*))",logfile);
+		logfile << "***** Completed ****** \n\n";
 	}
+
 	/*
-	 * calculate F* for covariance matrix (F*Sx*Ftranspose).F*= (F*Sx)
-	 * tmpmatrixC1 will be overridden with new values which is the output
-	 * for the calculation A *x =B
-	 * A = tmpmatrixD
-	 * B = tmpmatrixC
+	 * J* = (recon_x-x)T*(Sx^-1)*(recon_x-x)+2.[f+F*(recon_x-x)]T*fstar
+	 * with (recon_x-x)T*(Sx^-1)*(recon_x-x) = -(recon_x-x)T*Ft*fstar
 	 */
-	solveSystemFstar(jacF.rows,Sx.column,tmpmatrixD1.data,tmpmatrixC1.data,logfile);
-	//printMatrix(tmpmatrixC,jacF.rows,Sx.column,"Sx_F*");
-	if(ACTIVE_STREAM(LOG_JAC))
+	vector<double> F_recon_x_x(r,0.0);
+	double lhs = 0.0;
+	for (int j=0; j < n; j++)
 	{
-		printMatrix(tmpmatrixC1.data,jacF.rows,Sx.column,"F*",logfile);
-		logfile << "***** Completed ****** \n\n";
+		double d = reconciledX[j]-x[j];
+		double Ft_fstar = 0.0;
+		for (int p=solver.F.colptr[j]; p < solver.F.colptr[j+1]; p++)
+		{
+			F_recon_x_x[solver.F.rowind[p]] += solver.F.values[p]*d;
+			Ft_fstar += solver.F.values[p]*fstar[solver.F.rowind[p]];
+		}
+		lhs -= d*Ft_fstar;
 	}
+	double rhs = 0.0;
+	for (int i=0; i < r; i++)
+	{
+		rhs += (c[i]+F_recon_x_x[i])*fstar[i];
+	}
+	return (lhs+2.0*rhs)/r;
+}
+
+/*
+ * Function which computes the diagonal of the reconciled covariance matrix
+ * recon_Sx = Sx - (Sx*Ft*F*) with F* = (F*Sx*Ft)^-1*(F*Sx)
+ * every column of F* is solved with the factorization of (F*Sx*Ft),
+ * the full matrix recon_Sx is only assembled if reconciledSx is not NULL
+ */
+vector<double> getReconciledSxDiagonal(reconciliationSolver & solver, double * reconciledSx)
+{
+	int n = solver.Sx.column;
+	int r = solver.M.rows;
+	vector<double> Sx_diag = getSparseDiagonalElements(solver.Sx);
+	vector<double> reconciledSx_diag(n);
+	vector<double> Fstar(r);
+	vector<double> work;
+	for (int j=0; j < n; j++)
+	{
+		std::fill(Fstar.begin(), Fstar.end(), 0.0);
+		for (int p=solver.FSx.colptr[j]; p < solver.FSx.colptr[j+1]; p++)
+		{
+			Fstar[solver.FSx.rowind[p]] = solver.FSx.values[p];
+		}
+		solveSparseLDL(solver.ldl, &Fstar[0], work);
+		double Sx_Ft_Fstar = 0.0;
+		for (int p=solver.FSx.colptr[j]; p < solver.FSx.colptr[j+1]; p++)
+		{
+			Sx_Ft_Fstar += solver.FSx.values[p]*Fstar[solver.FSx.rowind[p]];
+		}
+		reconciledSx_diag[j] = Sx_diag[j]-Sx_Ft_Fstar;
 
-	matrixData tmpFstar = {jacF.rows,Sx.column,tmpmatrixC1.data};
-	matrixData reconciled_Sx = solveReconciledSx(Sx,jacFt,tmpFstar,logfile);
-	//printMatrix(reconciled_Sx.data,reconciled_Sx.rows,reconciled_Sx.column,"reconciled Sx ===> (Sx - (Sx*Ft*Fstar))");
+		if(reconciledSx)
+		{
+			for (int p=solver.Sx.colptr[j]; p < solver.Sx.colptr[j+1]; p++)
+			{
+				reconciledSx[solver.Sx.rowind[p]+j*n] = solver.Sx.values[p];
+			}
+			for (int i=0; i < n; i++)
+			{
+				for (int p=solver.FSx.colptr[i]; p < solver.FSx.colptr[i+1]; p++)
+				{
+					reconciledSx[i+j*n] -= solver.FSx.values[p]*Fstar[solver.FSx.rowind[p]];
+				}
+			}
+		}
+	}
+	return reconciledSx_diag;
+}
 
-	double value = solveConvergence(data,reconciled_X,reconciled_Sx,x,Sx,jacF,vector_c,tmpfstar,logfile);
+int RunReconciliation(DATA* data, threadData_t *threadData, reconciliationSolver & solver, vector<double> x, double eps, int iterationcount, csvData csvinputs, vector<double> xdiag, vector<double> sxdiag, ofstream& logfile)
+{
+	int n = x.size();
+	vector<double> reconciledX;
+	double value = solveReconciliationStep(data, threadData, solver, x, reconciledX, logfile);
 	if(value > eps )
 	{
 		logfile << "J*/r" << "(" << value << ")"  << " > " << eps << ", Value not Converged \n";
@@ -1126,19 +1367,9 @@ int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixD
 	{
 		logfile << "Running Convergence iteration: " << iterationcount << " with the following reconciled values:" << "\n";
 		logfile << "========================================================================" << "\n";
-		//cout << "J*/r :=" << value << "\n";
-		//printMatrix(jacF.data,jacF.rows,jacF.column,"F");
-		//printMatrix(jacFt.data,jacFt.rows,jacFt.column,"Ft");
-		//printMatrix(setc,jacF.rows,1,"f*");
-		//printMatrix(tmpmatrixC,jacF.rows,Sx.column,"F*");
-		printMatrixWithHeaders(reconciled_X.data,reconciled_X.rows,reconciled_X.column,csvinputs.headers,"reconciled_X ===> (x - (Sx*Ft*fstar))",logfile);
-		printMatrixWithHeaders(reconciled_Sx.data,reconciled_Sx.rows,reconciled_Sx.column,csvinputs.headers,"reconciled_Sx ===> (Sx - (Sx*Ft*Fstar))",logfile);
-		//free(x.data);
-		//free(Sx.data);
-		x.data=reconciled_X.data;
-		//Sx.data=reconciled_Sx.data;
+		printVectorMatrixWithHeaders(reconciledX,n,1,csvinputs.headers,"reconciled_X ===> (x - (Sx*Ft*fstar))",logfile);
 		iterationcount++;
-		return RunReconciliation(data, threadData, x, Sx, jacF, jacFt,eps,iterationcount,csvinputs,xdiag,sxdiag,logfile);
+		return RunReconciliation(data, threadData, solver, reconciledX, eps, iterationcount, csvinputs, xdiag, sxdiag, logfile);
 	}
 	if(value < eps && iterationcount==1)
 	{
@@ -1148,13 +1379,30 @@ int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixD
 	{
 		logfile << "***** Value Converged, Convergence Completed******* \n\n";
 	}
+
+	/*
+	 * the full reconciled covariance matrix is only
+	 * assembled for debugging, otherwise its diagonal is enough
+	 */
+	double * reconciledSx = NULL;
+	if(ACTIVE_STREAM(LOG_JAC))
+	{
+		reconciledSx = (double*)calloc(n*n,sizeof(double));
+	}
+	vector<double> reconSx_diag = getReconciledSxDiagonal(solver, reconciledSx);
+
 	logfile << "Final Results:\n";
 	logfile << "=============\n";
 	logfile << "Total Iteration to Converge : " << iterationcount << "\n";
 	logfile << "Final Converged Value(J*/r) : " << value << "\n";
 	logfile << "Epsilon                     : " << eps << "\n";
-	printMatrixWithHeaders(reconciled_X.data,reconciled_X.rows,reconciled_X.column,csvinputs.headers,"reconciled_X ===> (x - (Sx*Ft*fstar))",logfile);
-	printMatrixWithHeaders(reconciled_Sx.data,reconciled_Sx.rows,reconciled_Sx.column,csvinputs.headers,"reconciled_Sx ===> (Sx - (Sx*Ft*Fstar))",logfile);
+	printVectorMatrixWithHeaders(reconciledX,n,1,csvinputs.headers,"reconciled_X ===> (x - (Sx*Ft*fstar))",logfile);
+	if(reconciledSx)
+	{
+		printMatrixWithHeaders(reconciledSx,n,n,csvinputs.headers,"reconciled_Sx ===> (Sx - (Sx*Ft*Fstar))",logfile);
+		free(reconciledSx);
+	}
+	printVectorMatrixWithHeaders(reconSx_diag,n,1,csvinputs.headers,"reconciled_Sx_Diagonal ===> diag(Sx - (Sx*Ft*Fstar))",logfile);
 
 	/*
 	 * Calculate half width Confidence interval
@@ -1162,64 +1410,57 @@ int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixD
 	 * where lamba = 1.96 and
 	 * Sx - diagonal elements of reconciled_Sx
 	 */
-	double* reconSx_diag = (double*)calloc(reconciled_Sx.rows*1,sizeof(double));
-	getDiagonalElements(reconciled_Sx.data,reconciled_Sx.rows,reconciled_Sx.column,reconSx_diag);
-
-	matrixData copyreconSx_diag = {reconciled_Sx.rows,1,reconSx_diag};
-	matrixData tmpcopyreconSx_diag = copyMatrix(copyreconSx_diag);
+	vector<double> copyreconSx_diag(reconSx_diag);
+	calculateSquareRoot(&copyreconSx_diag[0],n);
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
 		logfile << "Calculations of HalfWidth Confidence Interval " << "\n";
 		logfile << "===============================================\n";
-		printMatrix(copyreconSx_diag.data,reconciled_Sx.rows,1,"reconciled-Sx_Diagonal",logfile);
-	}
-	calculateSquareRoot(copyreconSx_diag.data,reconciled_Sx.rows);
-	if(ACTIVE_STREAM(LOG_JAC))
-	{
-		printMatrix(copyreconSx_diag.data,reconciled_Sx.rows,1,"reconciled-Sx_SquareRoot",logfile);
+		printMatrix(&copyreconSx_diag[0],n,1,"reconciled-Sx_SquareRoot",logfile);
 		logfile << "*****Completed***********\n";
 	}
-	scaleVector(reconciled_Sx.rows,1,1.96,copyreconSx_diag.data);
-	printMatrixWithHeaders(copyreconSx_diag.data,reconciled_Sx.rows,1,csvinputs.headers,"Wx-HalfWidth-Interval-(1.96)*sqrt(Sx_diagonal)",logfile);
-
+	scaleVector(n,1,1.96,&copyreconSx_diag[0]);
+	printVectorMatrixWithHeaders(copyreconSx_diag,n,1,csvinputs.headers,"Wx-HalfWidth-Interval-(1.96)*sqrt(Sx_diagonal)",logfile);
 
 	/*
 	 * Calculate individual tests
 	 * (recon_x - x)/sqrt(Sx-recon_Sx)
 	 */
-	double* newSx_diag = (double*)calloc(reconciled_Sx.rows*1,sizeof(double));
-	solveMatrixSubtraction(sxdiag,tmpcopyreconSx_diag,newSx_diag,logfile);
+	vector<double> newSx_diag(n);
+	for (int i=0; i < n; i++)
+	{
+		newSx_diag[i] = sxdiag[i]-reconSx_diag[i];
+	}
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
 		logfile << "Calculations of Individual Tests " << "\n";
 		logfile << "===============================================\n";
-		printMatrix(newSx_diag,sxdiag.rows,sxdiag.column,"Sx-recon_Sx",logfile);
+		printMatrix(&newSx_diag[0],n,1,"Sx-recon_Sx",logfile);
 	}
-	calculateSquareRoot(newSx_diag,reconciled_Sx.rows);
+	calculateSquareRoot(&newSx_diag[0],n);
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
-		printMatrix(newSx_diag,sxdiag.rows,sxdiag.column,"squareroot-newSx",logfile);
+		printMatrix(&newSx_diag[0],n,1,"squareroot-newSx",logfile);
 	}
 
-	double *newX = (double*)calloc(xdiag.rows*1,sizeof(double));
-	solveMatrixSubtraction(reconciled_X,xdiag,newX,logfile);
 	// calculate absolute value for this numeric analysis
-	for (unsigned int a=0; a < sizeof(newX); a++)
+	vector<double> newX(n);
+	for (int a=0; a < n; a++)
 	{
-		newX[a] = fabs(newX[a]);
+		newX[a] = fabs(reconciledX[a]-xdiag[a]);
 	}
 	if(ACTIVE_STREAM(LOG_JAC))
 	{
-		printMatrix(newX,xdiag.rows,xdiag.column,"recon_X - X",logfile);
+		printMatrix(&newX[0],n,1,"recon_X - X",logfile);
 		logfile << "*********Completed***********\n";
 	}
 
-	for (int val=0; val < xdiag.rows; val++)
+	for (int val=0; val < n; val++)
 	{
-		newX[val]=newX[val]/max(newSx_diag[val],sqrt(sxdiag.data[val]/10));
+		newX[val]=newX[val]/max(newSx_diag[val],sqrt(sxdiag[val]/10));
 	}
 
-	printMatrixWithHeaders(newX,xdiag.rows,xdiag.column,csvinputs.headers,"IndividualTests_Value- (recon_x-x)/sqrt(Sx_diag)",logfile);
+	printVectorMatrixWithHeaders(newX,n,1,csvinputs.headers,"IndividualTests_Value- (recon_x-x)/sqrt(Sx_diag)",logfile);
 
 	/*
 	 * create HTML Report
@@ -1296,16 +1537,16 @@ int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixD
 		myfile << "<tr>\n";
 		myfile << "<td>" << csvinputs.headers[r] << "</td>\n";
 		csvfile << csvinputs.headers[r] << ",";
-		myfile << "<td>" << xdiag.data[r] << "</td>\n";
-		csvfile << xdiag.data[r] << ",";
-		myfile << "<td>" << reconciled_X.data[r] << "</td>\n";
-		csvfile << reconciled_X.data[r] << ",";
+		myfile << "<td>" << xdiag[r] << "</td>\n";
+		csvfile << xdiag[r] << ",";
+		myfile << "<td>" << reconciledX[r] << "</td>\n";
+		csvfile << reconciledX[r] << ",";
 
 		myfile << "<td>" << csvinputs.sxdata[r] << "</td>\n";
 		csvfile << csvinputs.sxdata[r] << ",";
 
-		myfile << "<td>" << copyreconSx_diag.data[r] << "</td>\n";
-		csvfile << copyreconSx_diag.data[r] << ",";
+		myfile << "<td>" << copyreconSx_diag[r] << "</td>\n";
+		csvfile << copyreconSx_diag[r] << ",";
 
 		if(newX[r] < 1.96)
 		{
@@ -1331,25 +1572,145 @@ int RunReconciliation(DATA* data, threadData_t *threadData, inputData x, matrixD
 	myfile << "</body>\n</html>";
 	myfile.close();
 
-	free(tmpFstar.data);
-	free(tmpfstar.data);
-	//free(tmpmatrixC);
-	//free(tmpmatrixD);
-	//free(setc);
-	free(reconciled_Sx.data);
-	free(reconciled_X.data);
-	free(copyreconSx_diag.data);
-	free(tmpcopyreconSx_diag.data);
-	free(newSx_diag);
-	free(newX);
-	//free(jacF.data);
-	//free(jacFt.data);
-	//free(x.data);
-	//free(Sx.data);
 	return 0;
 }
 
 
+
+/*
+ * Function which reads the csv file of the batch mode,
+ * the first line holds the names of the variables to be reconciled
+ * and every further line one set of measured values, the values are
+ * returned in the order of the variables of the Sx csv file
+ */
+vector< vector<double> > readBatchMeasurements(const char * filename, vector<string> headers, ofstream & logfile)
+{
+	ifstream ip(filename);
+	string line;
+	vector<int> pos;
+	vector< vector<double> > sets;
+	int linecount=1;
+	if(!ip.good())
+	{
+		logfile << "|  error   |   " << "file name not found " << filename << "\n";
+		logfile.close();
+		exit(1);
+	}
+	while(ip.good())
+	{
+		getline(ip,line);
+		if(!line.empty())
+		{
+			std::replace(line.begin(), line.end(), ';', ' ');
+			std::replace(line.begin(), line.end(), ',', ' ');
+			stringstream ss(line);
+			string temp;
+			if(linecount==1)
+			{
+				while(ss >> temp)
+				{
+					int index = std::find(headers.begin(), headers.end(), temp) - headers.begin();
+					if(index == (int)headers.size())
+					{
+						logfile << "|  error   |   " << "Batch Variable Name not Matched:  " << temp << " ,readBatchMeasurements() failed!"<< "\n";
+						logfile.close();
+						exit(1);
+					}
+					pos.push_back(index);
+				}
+				if(pos.size() != headers.size())
+				{
+					logfile << "|  error   |   " << filename << "|  expected " << headers.size() << " variables but found " << pos.size() << ", readBatchMeasurements() failed!\n";
+					logfile.close();
+					exit(1);
+				}
+			}
+			else
+			{
+				vector<double> x(headers.size(),0.0);
+				unsigned int k=0;
+				while(ss >> temp)
+				{
+					if(k < pos.size())
+					{
+						x[pos[k]] = atof(temp.c_str());
+					}
+					k++;
+				}
+				if(k != pos.size())
+				{
+					logfile << "|  error   |   " << filename << "|  line " << linecount << " has " << k << " values instead of " << pos.size() << ", readBatchMeasurements() failed!\n";
+					logfile.close();
+					exit(1);
+				}
+				sets.push_back(x);
+			}
+			linecount++;
+		}
+	}
+	return sets;
+}
+
+/*
+ * Function which reconciles all measurement sets of the csv file
+ * given with -reconcileBatch and writes the results to <model>_Batch.csv,
+ * all sets share the covariance matrix Sx and the factorization of
+ * (F*Sx*Ft), which is only recomputed when the Jacobian F changes
+ */
+void RunBatchReconciliation(DATA* data, threadData_t *threadData, reconciliationSolver & solver, double eps, csvData csvinputs, ofstream& logfile)
+{
+	const int maxIterations = 100;
+	vector< vector<double> > sets = readBatchMeasurements(omc_flagValue[FLAG_DATA_RECONCILE_BATCH], csvinputs.headers, logfile);
+	int factorizations = solver.factorizations;
+	int reusedFactorizations = solver.reusedFactorizations;
+
+	ofstream csvfile;
+	std::stringstream csv_file;
+	if (omc_flag[FLAG_OUTPUT_PATH])
+	{
+		csv_file << string(omc_flagValue[FLAG_OUTPUT_PATH]) << "/" << data->modelData->modelName << "_Batch.csv";
+	}
+	else
+	{
+		csv_file << data->modelData->modelName << "_Batch.csv";
+	}
+	string tmpcsv= csv_file.str();
+	csvfile.open(tmpcsv.c_str());
+	csvfile << "Measurement Set ," << "Number of Iteration ," << "Converged Value(J*/r) ";
+	for (unsigned int i=0; i < csvinputs.headers.size(); i++)
+	{
+		csvfile << "," << csvinputs.headers[i];
+	}
+	csvfile << "\n";
+
+	logfile << "\n\nBatch Reconciliation \n" << "=====================\n";
+	for (unsigned int s=0; s < sets.size(); s++)
+	{
+		vector<double> reconciledX;
+		int iterationcount = 1;
+		double value = solveReconciliationStep(data, threadData, solver, sets[s], reconciledX, logfile);
+		while(value > eps && iterationcount < maxIterations)
+		{
+			iterationcount++;
+			vector<double> x(reconciledX);
+			value = solveReconciliationStep(data, threadData, solver, x, reconciledX, logfile);
+		}
+		if(value > eps)
+		{
+			logfile << "|  warning |   " << "Measurement set " << s+1 << " not converged after " << iterationcount << " iterations, J*/r(" << value << ") > " << eps << "\n";
+		}
+		csvfile << (s+1) << "," << iterationcount << "," << value;
+		for (unsigned int i=0; i < reconciledX.size(); i++)
+		{
+			csvfile << "," << reconciledX[i];
+		}
+		csvfile << "\n";
+	}
+	csvfile.close();
+	logfile << "|  info    |   " << "Reconciled " << sets.size() << " measurement sets with " << (solver.factorizations-factorizations) << " factorizations of (F*Sx*Ft), " << (solver.reusedFactorizations-reusedFactorizations) << " reused\n";
+}
+
+
 int dataReconciliation(DATA* data, threadData_t *threadData)
 {
 	TRACE_PUSH
@@ -1382,39 +1743,42 @@ int dataReconciliation(DATA* data, threadData_t *threadData)
 		exit(1);
 	}
 	csvData Sx_data = readCovarianceMatrixSx(data, threadData,logfile);
-	//matrixData Sx = getCovarianceMatrixSx(Sx_data, data, threadData); // Prepare the data from csv file *
-	matrixData Sx = computeCovarianceMatrixSx(Sx_data,data,threadData,logfile); // Compute the covariance matrix from csv inputs
+	reconciliationSolver solver;
+	solver.Sx = computeCovarianceMatrixSx(Sx_data,data,threadData,logfile); // Compute the sparse covariance matrix from csv inputs
+	solver.ldl.analysed = false;
+	solver.ldl.factorized = false;
+	solver.factorizations = 0;
+	solver.reusedFactorizations = 0;
 	inputData x = getInputDataFromStartAttribute(Sx_data, data, threadData, logfile);  // Read the inputs from the start attribute of the modelica model
-	matrixData jacF = getJacobianMatrixF(data, threadData, logfile); // Compute the Jacobian Matrix F
-	matrixData jacFt = getTransposeMatrix(jacF); // Compute the Transpose of jacobian Matrix F
 
-	double* Sx_diag = (double*)calloc(Sx.rows*1,sizeof(double));
-	getDiagonalElements(Sx.data,Sx.rows,Sx.column,Sx_diag);
-	matrixData tmpSx_diag={Sx.rows,1,Sx_diag};
+	// initialize the jacobian call
+	const int index = data->callback->INDEX_JAC_F;
+	data->callback->initialAnalyticJacobianF(data, threadData, &(data->simulationInfo->analyticJacobians[index]));
 
-	matrixData tmp_x={x.rows,x.column,x.data};
-	matrixData x_diag=copyMatrix(tmp_x);
+	vector<double> x_diag(x.data, x.data+x.rows);
+	vector<double> Sx_diag = getSparseDiagonalElements(solver.Sx);
 
 	// Print the initial information
 	logfile << "\n\nInitial Data \n" << "=============\n";
 	printMatrixWithHeaders(x.data,x.rows,x.column,Sx_data.headers,"X",logfile);
 	printVectorMatrixWithHeaders(Sx_data.sxdata,Sx_data.rowcount,1,Sx_data.headers,"Half-WidthConfidenceInterval",logfile);
-	printMatrixWithHeaders(Sx.data,Sx.rows,Sx.column,Sx_data.headers,"Sx",logfile);
-	//printMatrix(Sx_diag,Sx.rows,1,"Sx-Diagonal elements",logfile);
+	if(ACTIVE_STREAM(LOG_JAC))
+	{
+		printSparseMatrixWithHeaders(solver.Sx,Sx_data.headers,"Sx",logfile);
+	}
+	printVectorMatrixWithHeaders(Sx_diag,Sx_data.rowcount,1,Sx_data.headers,"Sx-Diagonal",logfile);
 
-	//printMatrix(jacF.data,jacF.rows,jacF.column,"F",logfile);
-	//printMatrix(jacFt.data,jacFt.rows,jacFt.column,"Ft",logfile);
 	// Start the Algorithm
-	RunReconciliation(data,threadData,x,Sx,jacF,jacFt,atof(epselon),1,Sx_data,x_diag,tmpSx_diag,logfile);
+	RunReconciliation(data,threadData,solver,x_diag,atof(epselon),1,Sx_data,x_diag,Sx_diag,logfile);
+	logfile << "|  info    |   " << "Factorizations of (F*Sx*Ft): " << solver.factorizations << ", reused: " << solver.reusedFactorizations << "\n";
+	if(omc_flag[FLAG_DATA_RECONCILE_BATCH])
+	{
+		RunBatchReconciliation(data,threadData,solver,atof(epselon),Sx_data,logfile);
+	}
 	logfile << "|  info    |   " << "DataReconciliation Completed! \n";
 	logfile.flush();
 	logfile.close();
-	free(Sx.data);
 	free(x.data);
-	free(jacF.data);
-	free(jacFt.data);
-	free(tmpSx_diag.data);
-	free(x_diag.data);
 	TRACE_POP
 	return 0;
 }
@@ -28,20 +28,69 @@
  *
  */
 
+#ifdef USE_PARJAC
+  #define GC_THREADS
+  #include <gc/omc_gc.h>
+#endif
+
 #include "util/omc_error.h"
 #include "util/omc_file.h"
+#include "util/parallel_helper.h"
+#include "util/write_matlab4.h"
 #include "simulation_data.h"
 #include "openmodelica_func.h"
 #include "simulation/solver/external_input.h"
 #include "simulation/options.h"
 #include "simulation/solver/model_help.h"
 #include "linearize.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string.h>
 
 using namespace std;
 
+/* One matrix of the linear model. Matrices from a symbolic Jacobian with
+ * sparse pattern hold only the nonzeros in the order of sparsePattern->index,
+ * all other matrices are dense in column-major order.
+ */
+typedef struct LIN_MATRIX
+{
+  unsigned int rows;
+  unsigned int cols;
+  SPARSE_PATTERN* sparsePattern;  /* NULL for dense matrices */
+  double* values;
+} LIN_MATRIX;
+
+static void initLinMatrix(LIN_MATRIX* matrix, unsigned int rows, unsigned int cols, int allocDense)
+{
+  matrix->rows = rows;
+  matrix->cols = cols;
+  matrix->sparsePattern = NULL;
+  matrix->values = allocDense ? (double*)calloc(rows*cols, sizeof(double)) : NULL;
+}
+
+/* returns the dense values of the matrix, to be freed by the caller */
+static double* denseLinMatrix(const LIN_MATRIX* matrix)
+{
+  double* dense = (double*)calloc(matrix->rows*matrix->cols + 1, sizeof(double));
+  unsigned int i, k;
+
+  if(!matrix->sparsePattern) {
+    if(matrix->values) {
+      memcpy(dense, matrix->values, matrix->rows*matrix->cols*sizeof(double));
+    }
+    return dense;
+  }
+  for(i = 0; i < matrix->cols; i++) {
+    for(k = matrix->sparsePattern->leadindex[i]; k < matrix->sparsePattern->leadindex[i+1]; k++) {
+      dense[i*matrix->rows + matrix->sparsePattern->index[k]] = matrix->values[k];
+    }
+  }
+  return dense;
+}
+
 static string array2string(double* array, int row, int col)
 {
   int i=0;
@@ -68,6 +117,55 @@ static string array2string(double* array, int row, int col)
   return retVal.str();
 }
 
+static string matrix2string(const LIN_MATRIX* matrix)
+{
+  double* dense = denseLinMatrix(matrix);
+  string retVal = array2string(dense, matrix->rows, matrix->cols);
+  free(dense);
+  return retVal;
+}
+
+static int writeLinMatrix(FILE* fout, const char* name, const LIN_MATRIX* matrix)
+{
+  double* dense;
+  int ret;
+
+  if(matrix->sparsePattern) {
+    return writeMatVer4SparseMatrix(fout, name, matrix->rows, matrix->cols, matrix->sparsePattern->leadindex, matrix->sparsePattern->index, matrix->values);
+  }
+  if(matrix->values) {
+    return writeMatVer4Matrix(fout, name, matrix->rows, matrix->cols, matrix->values, sizeof(double));
+  }
+  /* matrix could not be determined */
+  dense = denseLinMatrix(matrix);
+  ret = writeMatVer4Matrix(fout, name, matrix->rows, matrix->cols, dense, sizeof(double));
+  free(dense);
+  return ret;
+}
+
+/* writes the names as char matrix with one name per row */
+static int writeNames(FILE* fout, const char* name, char** names, int n)
+{
+  size_t maxlen = 1, len;
+  int i, ret;
+  size_t j;
+  char* buffer;
+
+  for(i = 0; i < n; i++) {
+    maxlen = std::max(maxlen, strlen(names[i]));
+  }
+  buffer = (char*)calloc(n*maxlen + 1, sizeof(char));
+  for(i = 0; i < n; i++) {
+    len = strlen(names[i]);
+    for(j = 0; j < len; j++) {
+      buffer[j*n + i] = names[i][j];
+    }
+  }
+  ret = writeMatVer4Matrix(fout, name, n, maxlen, buffer, sizeof(char));
+  free(buffer);
+  return ret;
+}
+
 extern "C" {
 
 int functionODE_residual(DATA* data, threadData_t *threadData, double *dx, double *dy, double *dz)
@@ -286,15 +384,11 @@ int functionJacBD_num(DATA* data, threadData_t *threadData, double *matrixB, dou
 
 
 /*  Calculate the jacobian matrix by analytical finite difference */
-int functionJacA(DATA* data, threadData_t *threadData, double* jac){
-
-  const int index = data->callback->INDEX_JAC_A;
-  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
+static void functionJacDense(DATA* data, threadData_t *threadData, ANALYTIC_JACOBIAN* jacobian,
+                             int (*jacColumn)(void*, threadData_t*, ANALYTIC_JACOBIAN*, ANALYTIC_JACOBIAN*), double* jac)
+{
   unsigned int i,j,k;
   k = 0;
-  if (jacobian->constantEqns != NULL) {
-    jacobian->constantEqns(data, threadData, jacobian, NULL);
-  }
 
   for(i=0; i < jacobian->sizeCols; i++)
   {
@@ -308,7 +402,7 @@ int functionJacA(DATA* data, threadData_t *threadData, double* jac){
       }
     }
 
-    data->callback->functionJacA_column(data, threadData, jacobian, NULL);
+    jacColumn(data, threadData, jacobian, NULL);
 
     for(j = 0; j < jacobian->sizeRows; j++)
     {
@@ -324,206 +418,194 @@ int functionJacA(DATA* data, threadData_t *threadData, double* jac){
     for(i=0;  i < jacobian->sizeRows;i++)
     {
       for(j=0;  j < jacobian->sizeCols;j++) {
-        printf("% .5e ",jac[i+j*jacobian->sizeCols]);
+        printf("% .5e ",jac[i+j*jacobian->sizeRows]);
       }
       printf("\n");
     }
   }
-
-  return 0;
 }
-int functionJacB(DATA* data, threadData_t *threadData, double* jac){
 
-  const int index = data->callback->INDEX_JAC_B;
-  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
+/*  Calculate the jacobian matrix with one directional derivative per color of
+ *  the sparse pattern. The nonzeros are stored in the order of
+ *  sparsePattern->index, i.e. compressed by columns. With USE_PARJAC the
+ *  colors are distributed over the OpenMP threads. */
+static void functionJacColored(DATA* data, threadData_t *threadData, ANALYTIC_JACOBIAN* jacobian,
+                               int (*jacColumn)(void*, threadData_t*, ANALYTIC_JACOBIAN*, ANALYTIC_JACOBIAN*), double* values)
+{
+  SPARSE_PATTERN* sp = jacobian->sparsePattern;
+  int color;
 
-  unsigned int i,j,k;
-  k = 0;
-  if (jacobian->constantEqns != NULL) {
-    jacobian->constantEqns(data, threadData, jacobian, NULL);
+#ifdef USE_PARJAC
+  GC_allow_register_threads();
+#pragma omp parallel default(none) shared(data, threadData, jacobian, jacColumn, values, sp, color)
+#endif
+{
+#ifdef USE_PARJAC
+  /* Register omp-thread in GC */
+  if(!GC_thread_is_registered()) {
+     struct GC_stack_base sb;
+     memset (&sb, 0, sizeof(sb));
+     GC_get_stack_base(&sb);
+     GC_register_my_thread (&sb);
   }
+  /* thread local seed and result vectors, the temporaries start from the
+   * values computed by the constant equations */
+  ANALYTIC_JACOBIAN localJacobian = *jacobian;
+  ANALYTIC_JACOBIAN* t_jac = &localJacobian;
+  t_jac->seedVars = (double*) calloc(jacobian->sizeCols, sizeof(double));
+  t_jac->resultVars = (double*) calloc(jacobian->sizeRows, sizeof(double));
+  t_jac->tmpVars = (double*) malloc(jacobian->sizeTmpVars*sizeof(double));
+  memcpy(t_jac->tmpVars, jacobian->tmpVars, jacobian->sizeTmpVars*sizeof(double));
+#else
+  ANALYTIC_JACOBIAN* t_jac = jacobian;
+#endif
+  unsigned int i, k;
 
-  for(i=0; i < jacobian->sizeCols; i++)
+#ifdef USE_PARJAC
+#pragma omp for schedule(runtime)
+#endif
+  for(color = 0; color < (int)sp->maxColors; color++)
   {
-    jacobian->seedVars[i] = 1.0;
-    if(ACTIVE_STREAM(LOG_JAC))
+    for(i = 0; i < t_jac->sizeCols; i++)
     {
-      printf("Caluculate one col:\n");
-      for(j=0;  j < jacobian->sizeCols;j++)
-      {
-        infoStreamPrint(LOG_JAC,0,"seed: jacobian->seedVars[%d]= %f",j,jacobian->seedVars[j]);
-      }
+      if(sp->colorCols[i]-1 == (unsigned int)color)
+        t_jac->seedVars[i] = 1.0;
     }
 
-    data->callback->functionJacB_column(data, threadData, jacobian, NULL);
-
-    for(j = 0; j < jacobian->sizeRows; j++)
-    {
-      jac[k++] = jacobian->resultVars[j];
-      infoStreamPrint(LOG_JAC,0,"write in jac[%d]-[%d,%d]=%g from row[%d]=%g",k-1,i,j,jac[k-1],i,jacobian->resultVars[j]);
-    }
+    jacColumn(data, threadData, t_jac, NULL);
 
-    jacobian->seedVars[i] = 0.0;
-  }
-  if(ACTIVE_STREAM(LOG_JAC))
-  {
-    infoStreamPrint(LOG_JAC, 0, "Print jac:");
-    for(i=0;  i < jacobian->sizeRows;i++)
+    for(i = 0; i < t_jac->sizeCols; i++)
     {
-      for(j=0;  j < jacobian->sizeCols;j++)
-        printf("% .5e ",jac[i+j*jacobian->sizeCols]);
-      printf("\n");
+      if(sp->colorCols[i]-1 == (unsigned int)color)
+      {
+        for(k = sp->leadindex[i]; k < sp->leadindex[i+1]; k++)
+          values[k] = t_jac->resultVars[sp->index[k]];
+        t_jac->seedVars[i] = 0.0;
+      }
     }
   }
 
-  return 0;
-}
-int functionJacC(DATA* data, threadData_t *threadData, double* jac){
-
-  const int index = data->callback->INDEX_JAC_C;
-  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
-  unsigned int i,j,k;
-  k = 0;
-  if (jacobian->constantEqns != NULL) {
-    jacobian->constantEqns(data, threadData, jacobian, NULL);
-  }
-
-  for(i=0; i < jacobian->sizeCols; i++)
-  {
-    jacobian->seedVars[i] = 1.0;
-    if(ACTIVE_STREAM(LOG_JAC))
-    {
-      printf("Caluculate one col:\n");
-      for(j=0;  j < jacobian->sizeCols;j++)
-        infoStreamPrint(LOG_JAC,0,"seed: jacobian->seedVars[%d]= %f",j,jacobian->seedVars[j]);
-    }
-
-    data->callback->functionJacC_column(data, threadData, jacobian, NULL);
-
-    for(j = 0; j < jacobian->sizeRows; j++)
-    {
-      jac[k++] = jacobian->resultVars[j];
-      infoStreamPrint(LOG_JAC,0,"write in jac[%d]-[%d,%d]=%g from row[%d]=%g",k-1,i,j,jac[k-1],i,jacobian->resultVars[j]);
-    }
+#ifdef USE_PARJAC
+  free(t_jac->seedVars);
+  free(t_jac->resultVars);
+  free(t_jac->tmpVars);
+#endif
+} // omp parallel
 
-    jacobian->seedVars[i] = 0.0;
-  }
   if(ACTIVE_STREAM(LOG_JAC))
   {
-    infoStreamPrint(LOG_JAC, 0, "Print jac:");
-    for(i=0;  i < jacobian->sizeRows;i++)
-    {
-      for(j=0;  j < jacobian->sizeCols;j++)
-        printf("% .5e ",jac[i+j*jacobian->sizeCols]);
-      printf("\n");
-    }
+    unsigned int i, k;
+    infoStreamPrint(LOG_JAC, 1, "Print jac (%d nonzeros, %d colors):", sp->numberOfNoneZeros, sp->maxColors);
+    for(i = 0; i < jacobian->sizeCols; i++)
+      for(k = sp->leadindex[i]; k < sp->leadindex[i+1]; k++)
+        infoStreamPrint(LOG_JAC, 0, "jac[%d,%d] = % .5e", sp->index[k], i, values[k]);
+    messageClose(LOG_JAC);
   }
-
-  return 0;
 }
-int functionJacD(DATA* data, threadData_t *threadData, double* jac){
 
-  const int index = data->callback->INDEX_JAC_D;
-  ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[index]);
-  unsigned int i,j,k;
-  k = 0;
+/*  Calculate one of the matrices A, B, C, D from its symbolic Jacobian. If the
+ *  Jacobian has a sparse pattern the matrix is stored sparse and the dense
+ *  values are released. Returns 0 on success. */
+static int functionJacSymbolic(DATA* data, threadData_t *threadData, ANALYTIC_JACOBIAN* jacobian,
+                               int (*jacColumn)(void*, threadData_t*, ANALYTIC_JACOBIAN*, ANALYTIC_JACOBIAN*), LIN_MATRIX* matrix)
+{
+  SPARSE_PATTERN* sp = jacobian->sparsePattern;
+
   if (jacobian->constantEqns != NULL) {
     jacobian->constantEqns(data, threadData, jacobian, NULL);
   }
 
-  for(i=0; i < jacobian->sizeCols; i++)
+  if(sp && sp->maxColors > 0 && jacobian->sizeCols > 0)
   {
-    jacobian->seedVars[i] = 1.0;
-    if(ACTIVE_STREAM(LOG_JAC))
-    {
-      printf("Caluculate one col:\n");
-      for(j=0;  j < jacobian->sizeCols;j++) {
-        infoStreamPrint(LOG_JAC,0,"seed: jacobian->seedVars[%d]= %f",j,jacobian->seedVars[j]);
-      }
-    }
-
-    data->callback->functionJacD_column(data, threadData, jacobian, NULL);
-
-    for(j = 0; j < jacobian->sizeRows; j++)
-    {
-      jac[k++] = jacobian->resultVars[j];
-      infoStreamPrint(LOG_JAC,0, "write in jac[%d]-[%d,%d]=%g from row[%d]=%g",k-1,i,j,jac[k-1],i,jacobian->resultVars[j]);
-    }
-
-    jacobian->seedVars[i] = 0.0;
+    double* values = (double*)calloc(sp->leadindex[jacobian->sizeCols] + 1, sizeof(double));
+    if(!values) {
+      return 1;
+    }
+    functionJacColored(data, threadData, jacobian, jacColumn, values);
+    free(matrix->values);
+    matrix->values = values;
+    matrix->sparsePattern = sp;
   }
-  if(ACTIVE_STREAM(LOG_JAC))
+  else
   {
-    infoStreamPrint(LOG_JAC, 0, "Print jac:");
-    for(i=0;  i < jacobian->sizeRows;i++)
-    {
-      for(j=0;  j < jacobian->sizeCols;j++)
-        printf("% .5e ",jac[i+j*jacobian->sizeCols]);
-      printf("\n");
+    if(!matrix->values && !(matrix->values = (double*)calloc(matrix->rows*matrix->cols, sizeof(double)))) {
+      return 1;
     }
+    functionJacDense(data, threadData, jacobian, jacColumn, matrix->values);
   }
-
   return 0;
 }
 
-
-
 int linearize(DATA* data, threadData_t *threadData)
 {
     TRACE_PUSH
     /* Check if data recovery is requested */
     int do_data_recovery = omc_flag[FLAG_L_DATA_RECOVERY] ? 1 : 0;
+    /* Check if the linear model is written as MAT-file instead of a Modelica model */
+    int mat_format = omc_flag[FLAG_L_FORMAT] && 0 == strcmp(omc_flagValue[FLAG_L_FORMAT], "mat");
+    int do_numeric = 0;
 
     /* init linearization sizes */
     int size_A = data->modelData->nStates;
     int size_Inputs = data->modelData->nInputVars;
     int size_Outputs = data->modelData->nOutputVars;
     int size_z = data->modelData->nVariablesReal - 2*data->modelData->nStates;
-    double* matrixA = (double*)calloc(size_A*size_A,sizeof(double));
-    double* matrixB = (double*)calloc(size_A*size_Inputs,sizeof(double));
-    double* matrixC = (double*)calloc(size_Outputs*size_A,sizeof(double));
-    double* matrixD = (double*)calloc(size_Outputs*size_Inputs,sizeof(double));
-    double* matrixCz = 0;
-    double* matrixDz = 0;
+    LIN_MATRIX matrixA, matrixB, matrixC, matrixD, matrixCz, matrixDz;
+    double* z0 = 0;
     string strA, strB, strC, strD, strCz, strDz, strX, strU, strZ0, filename;
 	std::size_t pos, pos1, pos2;
 
-    assertStreamPrint(threadData,0!=matrixA,"calloc failed");
-    assertStreamPrint(threadData,0!=matrixB,"calloc failed");
-    assertStreamPrint(threadData,0!=matrixC,"calloc failed");
-    assertStreamPrint(threadData,0!=matrixD,"calloc failed");
+    if(omc_flag[FLAG_L_FORMAT] && !mat_format && 0 != strcmp(omc_flagValue[FLAG_L_FORMAT], "mo")) {
+        throwStreamPrint(threadData, "unknown linear model format -l_format=%s, expected mo or mat", omc_flagValue[FLAG_L_FORMAT]);
+    }
+
+    /* Can currently only extract data recovery matrices Cz and Dz numerically, so we do this first if necessary */
+    do_numeric = do_data_recovery > 0 || data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sizeTmpVars == 0;
+
+    initLinMatrix(&matrixA, size_A, size_A, do_numeric);
+    initLinMatrix(&matrixB, size_A, size_Inputs, do_numeric);
+    initLinMatrix(&matrixC, size_Outputs, size_A, do_numeric);
+    initLinMatrix(&matrixD, size_Outputs, size_Inputs, do_numeric);
+    initLinMatrix(&matrixCz, size_z, size_A, do_data_recovery);
+    initLinMatrix(&matrixDz, size_z, size_Inputs, do_data_recovery);
+
+    if(do_numeric){
+        assertStreamPrint(threadData,0!=matrixA.values,"calloc failed");
+        assertStreamPrint(threadData,0!=matrixB.values,"calloc failed");
+        assertStreamPrint(threadData,0!=matrixC.values,"calloc failed");
+        assertStreamPrint(threadData,0!=matrixD.values,"calloc failed");
+    }
 
     if(do_data_recovery > 0){
-        matrixCz = (double*)calloc(size_z*size_A,sizeof(double));
-        matrixDz = (double*)calloc(size_z*size_Inputs,sizeof(double));
-        assertStreamPrint(threadData,0!=matrixCz,"calloc failed");
-        assertStreamPrint(threadData,0!=matrixDz,"calloc failed");
+        assertStreamPrint(threadData,0!=matrixCz.values,"calloc failed");
+        assertStreamPrint(threadData,0!=matrixDz.values,"calloc failed");
     }
 
     /* Need to do this before changing anything so that we get a proper z0 */
     if(do_data_recovery > 0){
-        if(size_z){
-            strZ0 = "{" + array2string(&data->localData[0]->realVars[2*size_A],1,size_z) + "}";
-        }else{
-            strZ0 = "zeros(0)";
-        }
+        z0 = (double*)calloc(size_z+1,sizeof(double));
+        assertStreamPrint(threadData,0!=z0,"calloc failed");
+        memcpy(z0, &data->localData[0]->realVars[2*size_A], size_z*sizeof(double));
     }
 
-    /* Can currently only extract data recovery matrices Cz and Dz numerically, so we do this first if necessary */
-    if(do_data_recovery > 0 || data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sizeTmpVars == 0){
+    if(do_numeric){
         /* Calculate numeric Jacobian */
-        if(functionJacAC_num(data, threadData, matrixA, matrixC, matrixCz))
+        if(functionJacAC_num(data, threadData, matrixA.values, matrixC.values, matrixCz.values))
         {
             throwStreamPrint(threadData, "Error, can not get Matrix A or C ");
             TRACE_POP
             return 1;
         }
-        if(functionJacBD_num(data, threadData, matrixB, matrixD, matrixDz))
+        if(functionJacBD_num(data, threadData, matrixB.values, matrixD.values, matrixDz.values))
         {
             throwStreamPrint(threadData, "Error, can not get Matrix B or D ");
             TRACE_POP
             return 1;
         }
+        /* the finite differences leave the model at the last perturbation, restore the operating point */
+        data->callback->functionODE(data, threadData);
+        data->callback->functionAlgebraics(data, threadData);
+        data->callback->output_function(data, threadData);
     }
 
     /* Check if symbolic Jacobian available, if it is then use it (overwriting A,B,C,D if also doing data recovery) */
@@ -532,59 +614,28 @@ int linearize(DATA* data, threadData_t *threadData)
         /* Determine Matrix A */
         ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
         if(!data->callback->initialAnalyticJacobianA(data, threadData, jacobian)){
-            assertStreamPrint(threadData,0==functionJacA(data, threadData, matrixA),"Error, can not get Matrix A ");
+            assertStreamPrint(threadData,0==functionJacSymbolic(data, threadData, jacobian, data->callback->functionJacA_column, &matrixA),"Error, can not get Matrix A ");
         }
 
         /* Determine Matrix B */
         jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_B]);
         if(!data->callback->initialAnalyticJacobianB(data, threadData, jacobian)){
-            assertStreamPrint(threadData,0==functionJacB(data, threadData, matrixB),"Error, can not get Matrix B ");
+            assertStreamPrint(threadData,0==functionJacSymbolic(data, threadData, jacobian, data->callback->functionJacB_column, &matrixB),"Error, can not get Matrix B ");
         }
 
         /* Determine Matrix C */
         jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_C]);
         if(!data->callback->initialAnalyticJacobianC(data, threadData, jacobian)){
-            assertStreamPrint(threadData,0==functionJacC(data, threadData, matrixC),"Error, can not get Matrix C ");
+            assertStreamPrint(threadData,0==functionJacSymbolic(data, threadData, jacobian, data->callback->functionJacC_column, &matrixC),"Error, can not get Matrix C ");
         }
 
         /* Determine Matrix D */
         jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_D]);
         if(!data->callback->initialAnalyticJacobianD(data, threadData, jacobian)){
-            assertStreamPrint(threadData,0==functionJacD(data, threadData, matrixD),"Error, can not get Matrix D ");
+            assertStreamPrint(threadData,0==functionJacSymbolic(data, threadData, jacobian, data->callback->functionJacD_column, &matrixD),"Error, can not get Matrix D ");
         }
     }
 
-    strA = array2string(matrixA,size_A,size_A);
-    strB = array2string(matrixB,size_A,size_Inputs);
-    strC = array2string(matrixC,size_Outputs,size_A);
-    strD = array2string(matrixD,size_Outputs,size_Inputs);
-    if(do_data_recovery > 0){
-        strCz = array2string(matrixCz,size_z,size_A);
-        strDz = array2string(matrixDz,size_z,size_Inputs);
-    }
-
-    // The empty array {} is not valid modelica, so we need to put something
-    //   inside the curly braces for x0 and u0. {for i in in 1:0} will create an
-    //   empty array if needed.
-    if(size_A)
-      strX = "{" + array2string(data->localData[0]->realVars, 1, size_A) + "}";
-    else
-      strX = "zeros(0)";
-
-    if(size_Inputs)
-      strU = "{" + array2string(data->simulationInfo->inputVars, 1, size_Inputs) + "}";
-    else
-      strU = "zeros(0)";
-
-    free(matrixA);
-    free(matrixB);
-    free(matrixC);
-    free(matrixD);
-    if(do_data_recovery > 0){
-        free(matrixCz);
-        free(matrixDz);
-    }
-
     /* Use the result file name rather than the model name so that the linear file name can be changed with the -r flag, however strip _res.mat from the filename */
     filename = string(data->modelData->resultFileName) + ".mo";
 	pos = filename.rfind("_res.mat");
@@ -621,19 +672,93 @@ int linearize(DATA* data, threadData_t *threadData)
     }
 #endif
 
+    /* number the linear models of a batch linearization (-l=t1,t2,...) */
+    if(data->simulationInfo->nLinearizationTimes > 1) {
+      ostringstream suffix(ostringstream::out);
+      suffix << "_" << (data->simulationInfo->nextLinearization + 1);
+      filename.insert(filename.length() - 3, suffix.str());
+    }
+    if(mat_format) {
+      filename.replace(filename.length() - 3, 3, ".mat");
+    }
+
     FILE *fout = omc_fopen(filename.c_str(),"wb");
     assertStreamPrint(threadData,0!=fout,"Cannot open File %s",filename.c_str());
-    if(do_data_recovery > 0){
-        fprintf(fout, data->callback->linear_model_datarecovery_frame(), strX.c_str(), strU.c_str(), strZ0.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str(), strCz.c_str(), strDz.c_str());
+    if(mat_format){
+        double time = data->localData[0]->timeValue;
+        char** names = (char**)malloc((std::max(size_A, size_Inputs) + 1)*sizeof(char*));
+        int i, err = 0;
+
+        err = err || writeMatVer4Matrix(fout, "time", 1, 1, &time, sizeof(double));
+        err = err || writeLinMatrix(fout, "A", &matrixA);
+        err = err || writeLinMatrix(fout, "B", &matrixB);
+        err = err || writeLinMatrix(fout, "C", &matrixC);
+        err = err || writeLinMatrix(fout, "D", &matrixD);
+        err = err || writeMatVer4Matrix(fout, "x0", size_A, 1, data->localData[0]->realVars, sizeof(double));
+        err = err || writeMatVer4Matrix(fout, "u0", size_Inputs, 1, data->simulationInfo->inputVars, sizeof(double));
+        if(do_data_recovery > 0){
+            err = err || writeLinMatrix(fout, "Cz", &matrixCz);
+            err = err || writeLinMatrix(fout, "Dz", &matrixDz);
+            err = err || writeMatVer4Matrix(fout, "z0", size_z, 1, z0, sizeof(double));
+        }
+        for(i = 0; i < size_A; i++) {
+            names[i] = (char*) data->modelData->realVarsData[i].info.name;
+        }
+        err = err || writeNames(fout, "xNames", names, size_A);
+        data->callback->inputNames(data, names);
+        err = err || writeNames(fout, "uNames", names, size_Inputs);
+        free(names);
+        assertStreamPrint(threadData,0==err,"Cannot write File %s",filename.c_str());
     }else{
-        fprintf(fout, data->callback->linear_model_frame(), strX.c_str(), strU.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str());
-    }
-    if(ACTIVE_STREAM(LOG_STATS)) {
-      infoStreamPrint(LOG_STATS, 0, data->callback->linear_model_frame(), strX.c_str(), strU.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str());
+        strA = matrix2string(&matrixA);
+        strB = matrix2string(&matrixB);
+        strC = matrix2string(&matrixC);
+        strD = matrix2string(&matrixD);
+
+        // The empty array {} is not valid modelica, so we need to put something
+        //   inside the curly braces for x0 and u0. {for i in in 1:0} will create an
+        //   empty array if needed.
+        if(size_A)
+          strX = "{" + array2string(data->localData[0]->realVars, 1, size_A) + "}";
+        else
+          strX = "zeros(0)";
+
+        if(size_Inputs)
+          strU = "{" + array2string(data->simulationInfo->inputVars, 1, size_Inputs) + "}";
+        else
+          strU = "zeros(0)";
+
+        if(do_data_recovery > 0){
+            strCz = matrix2string(&matrixCz);
+            strDz = matrix2string(&matrixDz);
+            if(size_z){
+                strZ0 = "{" + array2string(z0,1,size_z) + "}";
+            }else{
+                strZ0 = "zeros(0)";
+            }
+            fprintf(fout, data->callback->linear_model_datarecovery_frame(), strX.c_str(), strU.c_str(), strZ0.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str(), strCz.c_str(), strDz.c_str());
+        }else{
+            fprintf(fout, data->callback->linear_model_frame(), strX.c_str(), strU.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str());
+        }
+        if(ACTIVE_STREAM(LOG_STATS)) {
+          infoStreamPrint(LOG_STATS, 0, data->callback->linear_model_frame(), strX.c_str(), strU.c_str(), strA.c_str(), strB.c_str(), strC.c_str(), strD.c_str());
+        }
     }
     fflush(fout);
     fclose(fout);
 
+    free(matrixA.values);
+    free(matrixB.values);
+    free(matrixC.values);
+    free(matrixD.values);
+    if(do_data_recovery > 0){
+        free(matrixCz.values);
+        free(matrixDz.values);
+        free(z0);
+    }
+
+    infoStreamPrint(LOG_SOLVER, 0, "Linear model %s is created at time %g", filename.c_str(), data->localData[0]->timeValue);
+
     TRACE_POP
     return 0;
 }
@@ -49,7 +49,7 @@ int helpFlagSet(int argc, char** argv)
 }
 
 #if !defined(OMC_MINIMAL_RUNTIME)
-int setLogFormat(int argc, char** argv)
+int setLogFormat(int argc, char** argv, const char *modelFilePrefix)
 {
   const char* value = getOption(FLAG_NAME[FLAG_LOG_FORMAT], argc, argv);
   if (NULL == value) {
@@ -63,8 +63,17 @@ int setLogFormat(int argc, char** argv)
       setStreamPrintXML(2);
     } else if (0 == strcmp(value, "text")) {
       setStreamPrintXML(0);
+    } else if (0 == strcmp(value, "binary")) {
+      const char* outputPath = getOption(FLAG_NAME[FLAG_OUTPUT_PATH], argc, argv);
+      if (NULL == outputPath) {
+        outputPath = getFlagValue(FLAG_NAME[FLAG_OUTPUT_PATH], argc, argv);
+      }
+      if (setStreamPrintBinary(outputPath, modelFilePrefix)) {
+        warningStreamPrint(LOG_STDOUT, 0, "could not open the binary log file for -logFormat=binary");
+        return 1;
+      }
     } else {
-      warningStreamPrint(LOG_STDOUT, 0, "invalid command line option: -logFormat=%s, expected text, xml, or xmltcp", value);
+      warningStreamPrint(LOG_STDOUT, 0, "invalid command line option: -logFormat=%s, expected text, xml, xmltcp, or binary", value);
       return 1;
     }
   }
@@ -41,24 +41,167 @@
 #include "util/omc_error.h"
 #include "util/omc_file.h"
 #include "simulation_result_csv.h"
+#include "simulation/options.h"
 #include "util/rtclock.h"
 
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <vector>
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus >= 201703L
+#include <charconv>
+#endif
+#endif
+
+/* std::to_chars with precision 16 gives the same text as printf("%.16g") but is much faster */
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define CSV_HAVE_TO_CHARS 1
+#endif
+
+/* enough for any value printed with %.16g or %i */
+#define CSV_MAX_VALUE_LENGTH 32
+/* size of the stdio buffer of the result file */
+#define CSV_FILE_BUFFER_SIZE (1<<20)
+/* number of values collected before they are passed to the background thread (-csvThread) */
+#define CSV_CHUNK_VALUES (1<<16)
 
 extern "C" {
 
+/* The source of a column of the result file, computed once in omc_csv_init */
+typedef enum {
+  CSV_TIME,
+  CSV_CPU_TIME,
+  CSV_REAL,
+  CSV_INTEGER,
+  CSV_BOOLEAN
+} csv_source;
+
+typedef struct csv_column {
+  csv_source source;
+  int index;
+  int negate;
+} csv_column;
+
+/* value of a column of one output point, copied for the background thread */
+typedef union csv_value {
+  double real;
+  int integer;
+} csv_value;
+
+typedef struct csv_data {
+  FILE *fout;
+  char *fileBuffer;
+  std::vector<csv_column> columns;
+  std::vector<char> line;
+
+  /* only used with -csvThread */
+  int threaded;
+  std::vector<csv_value> pending;   /* values of the output points collected by omc_csv_emit */
+  std::vector<csv_value> writing;   /* values of the output points formatted by the thread */
+  int hasWork, finished;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} csv_data;
+
+static inline int isRealColumn(const csv_column *column)
+{
+  return column->source == CSV_TIME || column->source == CSV_CPU_TIME || column->source == CSV_REAL;
+}
+
+static inline char* formatReal(char *p, double value)
+{
+#if defined(CSV_HAVE_TO_CHARS)
+  return std::to_chars(p, p + CSV_MAX_VALUE_LENGTH, value, std::chars_format::general, 16).ptr;
+#else
+  return p + snprintf(p, CSV_MAX_VALUE_LENGTH, "%.16g", value);
+#endif
+}
+
+static inline char* formatInteger(char *p, int value)
+{
+  char digits[12];
+  int n = 0;
+  unsigned int u = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+  if (value < 0) {
+    *p++ = '-';
+  }
+  do {
+    digits[n++] = '0' + u % 10;
+    u /= 10;
+  } while (u);
+  while (n) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+/* Formats one output point (one value per column) into csvData->line and writes it */
+static void writeLine(csv_data *csvData, const csv_value *values)
+{
+  size_t i, n = csvData->columns.size();
+  char *begin = csvData->line.data(), *p = begin;
+  for (i = 0; i < n; i++) {
+    if (i) {
+      *p++ = ',';
+    }
+    if (isRealColumn(&csvData->columns[i])) {
+      p = formatReal(p, values[i].real);
+    } else {
+      p = formatInteger(p, values[i].integer);
+    }
+  }
+  *p++ = '\n';
+  fwrite(begin, 1, p - begin, csvData->fout);
+}
+
+static void* writerThread(void *arg)
+{
+  csv_data *csvData = (csv_data*) arg;
+  size_t i, ncolumns = csvData->columns.size();
+  pthread_mutex_lock(&csvData->mutex);
+  while (1) {
+    while (!csvData->hasWork && !csvData->finished) {
+      pthread_cond_wait(&csvData->cond, &csvData->mutex);
+    }
+    if (!csvData->hasWork) {
+      break;
+    }
+    pthread_mutex_unlock(&csvData->mutex);
+    for (i = 0; i < csvData->writing.size(); i += ncolumns) {
+      writeLine(csvData, csvData->writing.data() + i);
+    }
+    pthread_mutex_lock(&csvData->mutex);
+    csvData->writing.clear();
+    csvData->hasWork = 0;
+    pthread_cond_broadcast(&csvData->cond);
+  }
+  pthread_mutex_unlock(&csvData->mutex);
+  return NULL;
+}
+
+/* Passes the collected output points to the background thread, waits until it has finished the previous ones */
+static void passPending(csv_data *csvData)
+{
+  pthread_mutex_lock(&csvData->mutex);
+  while (csvData->hasWork) {
+    pthread_cond_wait(&csvData->cond, &csvData->mutex);
+  }
+  csvData->writing.swap(csvData->pending);
+  csvData->hasWork = 1;
+  pthread_cond_broadcast(&csvData->cond);
+  pthread_mutex_unlock(&csvData->mutex);
+}
+
 void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
 {
-  FILE *fout = (FILE*) self->storage;
-  const char* format = ",%.16g";
-  const char* formatint = ",%i";
-  const char* formatbool = ",%i";
-  const char* formatstring = ",\"%s\"";
-  int i;
-  modelica_real value = 0;
+  csv_data *csvData = (csv_data*) self->storage;
+  const SIMULATION_DATA *sData = data->localData[0];
+  size_t i, n = csvData->columns.size(), offset;
+  csv_value *values;
   double cpuTimeValue = 0;
   rt_tick(SIM_TIMER_OUTPUT);
 
@@ -66,91 +209,141 @@ void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
   cpuTimeValue = rt_accumulated(SIM_TIMER_TOTAL);
   rt_tick(SIM_TIMER_TOTAL);
 
-  fprintf(fout, "%.16g", data->localData[0]->timeValue);
-  if(self->cpuTime)
-    fprintf(fout, format, cpuTimeValue);
-  for(i = 0; i < data->modelData->nVariablesReal; i++) if(!data->modelData->realVarsData[i].filterOutput)
-    fprintf(fout, format, (data->localData[0])->realVars[i]);
-  for(i = 0; i < data->modelData->nVariablesInteger; i++) if(!data->modelData->integerVarsData[i].filterOutput)
-    fprintf(fout, formatint, (data->localData[0])->integerVars[i]);
-  for(i = 0; i < data->modelData->nVariablesBoolean; i++) if(!data->modelData->booleanVarsData[i].filterOutput)
-    fprintf(fout, formatbool, (data->localData[0])->booleanVars[i]);
-  //for(i = 0; i < data->modelData->nVariablesString; i++) if(!data->modelData->stringVarsData[i].filterOutput)
-  //  fprintf(fout, formatstring, MMC_STRINGDATA((data->localData[0])->stringVars[i]));
-
-  for(i = 0; i < data->modelData->nAliasReal; i++) if(!data->modelData->realAlias[i].filterOutput && data->modelData->realAlias[i].aliasType != 1) {
-    if (data->modelData->realAlias[i].aliasType == 2) {
-      value = (data->localData[0])->timeValue;
-    } else {
-      value = (data->localData[0])->realVars[data->modelData->realAlias[i].nameID];
-    }
-    if (data->modelData->realAlias[i].negate) {
-      fprintf(fout, format, -value);
-    } else {
-      fprintf(fout, format, value);
+  offset = csvData->pending.size();
+  csvData->pending.resize(offset + n);
+  values = csvData->pending.data() + offset;
+  for (i = 0; i < n; i++) {
+    const csv_column *column = &csvData->columns[i];
+    switch (column->source) {
+    case CSV_TIME:
+      values[i].real = column->negate ? -sData->timeValue : sData->timeValue;
+      break;
+    case CSV_CPU_TIME:
+      values[i].real = cpuTimeValue;
+      break;
+    case CSV_REAL:
+      values[i].real = column->negate ? -sData->realVars[column->index] : sData->realVars[column->index];
+      break;
+    case CSV_INTEGER:
+      values[i].integer = (int) (column->negate ? -sData->integerVars[column->index] : sData->integerVars[column->index]);
+      break;
+    case CSV_BOOLEAN:
+      values[i].integer = column->negate ? (sData->booleanVars[column->index]==1?0:1) : sData->booleanVars[column->index];
+      break;
     }
   }
-  for(i = 0; i < data->modelData->nAliasInteger; i++) if(!data->modelData->integerAlias[i].filterOutput && data->modelData->integerAlias[i].aliasType != 1) {
-    if (data->modelData->integerAlias[i].negate) {
-      fprintf(fout, formatint, -(data->localData[0])->integerVars[data->modelData->integerAlias[i].nameID]);
-    } else {
-      fprintf(fout, formatint, (data->localData[0])->integerVars[data->modelData->integerAlias[i].nameID]);
-    }
-  }
-  for(i = 0; i < data->modelData->nAliasBoolean; i++) if(!data->modelData->booleanAlias[i].filterOutput && data->modelData->booleanAlias[i].aliasType != 1) {
-    if (data->modelData->booleanAlias[i].negate) {
-      fprintf(fout, formatbool, (data->localData[0])->booleanVars[data->modelData->booleanAlias[i].nameID]==1?0:1);
-    } else {
-      fprintf(fout, formatbool, (data->localData[0])->booleanVars[data->modelData->booleanAlias[i].nameID]);
-    }
+
+  if (!csvData->threaded) {
+    writeLine(csvData, values);
+    csvData->pending.clear();
+  } else if (csvData->pending.size() >= CSV_CHUNK_VALUES) {
+    passPending(csvData);
   }
-  //for(i = 0; i < data->modelData->nAliasString; i++) if(!data->modelData->stringAlias[i].filterOutput && data->modelData->stringAlias[i].aliasType != 1) {
-  //  /* there would no negation of a string happen */
-  //  fprintf(fout, formatstring, MMC_STRINGDATA((data->localData[0])->stringVars[data->modelData->stringAlias[i].nameID]));
-  //}
-  fprintf(fout, "\n");
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
 
+static void addColumn(csv_data *csvData, csv_source source, int index, int negate)
+{
+  csv_column column = {source, index, negate};
+  csvData->columns.push_back(column);
+}
+
 void omc_csv_init(simulation_result *self, DATA *data, threadData_t *threadData)
 {
   int i;
   const MODEL_DATA *mData = data->modelData;
+  csv_data *csvData;
 
   const char* format = ",\"%s\"";
   FILE *fout = omc_fopen(self->filename, "w");
 
   assertStreamPrint(threadData, 0!=fout, "Error, couldn't create output file: [%s] because of %s", self->filename, strerror(errno));
 
+  csvData = new csv_data();
+  csvData->fout = fout;
+  csvData->fileBuffer = (char*) malloc(CSV_FILE_BUFFER_SIZE);
+  if (csvData->fileBuffer) {
+    setvbuf(fout, csvData->fileBuffer, _IOFBF, CSV_FILE_BUFFER_SIZE);
+  }
+
   fprintf(fout, "\"time\"");
-  if(self->cpuTime)
+  addColumn(csvData, CSV_TIME, 0, 0);
+  if(self->cpuTime) {
     fprintf(fout, format, "$cpuTime");
-  for(i = 0; i < mData->nVariablesReal; i++) if(!mData->realVarsData[i].filterOutput)
+    addColumn(csvData, CSV_CPU_TIME, 0, 0);
+  }
+  for(i = 0; i < mData->nVariablesReal; i++) if(!mData->realVarsData[i].filterOutput) {
     fprintf(fout, format, mData->realVarsData[i].info.name);
-  for(i = 0; i < mData->nVariablesInteger; i++) if(!mData->integerVarsData[i].filterOutput)
+    addColumn(csvData, CSV_REAL, i, 0);
+  }
+  for(i = 0; i < mData->nVariablesInteger; i++) if(!mData->integerVarsData[i].filterOutput) {
     fprintf(fout, format, mData->integerVarsData[i].info.name);
-  for(i = 0; i < mData->nVariablesBoolean; i++) if(!mData->booleanVarsData[i].filterOutput)
+    addColumn(csvData, CSV_INTEGER, i, 0);
+  }
+  for(i = 0; i < mData->nVariablesBoolean; i++) if(!mData->booleanVarsData[i].filterOutput) {
     fprintf(fout, format, mData->booleanVarsData[i].info.name);
+    addColumn(csvData, CSV_BOOLEAN, i, 0);
+  }
   //for(i = 0; i < mData->nVariablesString; i++) if(!mData->stringVarsData[i].filterOutput)
   //  fprintf(fout, format, mData->stringVarsData[i].info.name);
 
-  for(i = 0; i < mData->nAliasReal; i++) if(!mData->realAlias[i].filterOutput && data->modelData->realAlias[i].aliasType != 1)
+  for(i = 0; i < mData->nAliasReal; i++) if(!mData->realAlias[i].filterOutput && data->modelData->realAlias[i].aliasType != 1) {
     fprintf(fout, format, mData->realAlias[i].info.name);
-  for(i = 0; i < mData->nAliasInteger; i++) if(!mData->integerAlias[i].filterOutput && data->modelData->integerAlias[i].aliasType != 1)
+    if (mData->realAlias[i].aliasType == 2) {
+      addColumn(csvData, CSV_TIME, 0, mData->realAlias[i].negate);
+    } else {
+      addColumn(csvData, CSV_REAL, mData->realAlias[i].nameID, mData->realAlias[i].negate);
+    }
+  }
+  for(i = 0; i < mData->nAliasInteger; i++) if(!mData->integerAlias[i].filterOutput && data->modelData->integerAlias[i].aliasType != 1) {
     fprintf(fout, format, mData->integerAlias[i].info.name);
-  for(i = 0; i < mData->nAliasBoolean; i++) if(!mData->booleanAlias[i].filterOutput && data->modelData->booleanAlias[i].aliasType != 1)
+    addColumn(csvData, CSV_INTEGER, mData->integerAlias[i].nameID, mData->integerAlias[i].negate);
+  }
+  for(i = 0; i < mData->nAliasBoolean; i++) if(!mData->booleanAlias[i].filterOutput && data->modelData->booleanAlias[i].aliasType != 1) {
     fprintf(fout, format, mData->booleanAlias[i].info.name);
+    addColumn(csvData, CSV_BOOLEAN, mData->booleanAlias[i].nameID, mData->booleanAlias[i].negate);
+  }
   //for(i = 0; i < mData->nAliasString; i++) if(!mData->stringAlias[i].filterOutput && data->modelData->stringAlias[i].aliasType != 1)
   //  fprintf(fout, format, mData->stringAlias[i].info.name);
   fprintf(fout, "\n");
-  self->storage = fout;
+
+  csvData->line.resize(csvData->columns.size() * (CSV_MAX_VALUE_LENGTH + 1) + 1);
+  csvData->threaded = omc_flag[FLAG_CSV_THREAD];
+  if (csvData->threaded) {
+    csvData->pending.reserve(CSV_CHUNK_VALUES + csvData->columns.size());
+    csvData->writing.reserve(CSV_CHUNK_VALUES + csvData->columns.size());
+    pthread_mutex_init(&csvData->mutex, NULL);
+    pthread_cond_init(&csvData->cond, NULL);
+    if (pthread_create(&csvData->thread, NULL, writerThread, csvData)) {
+      warningStreamPrint(LOG_STDOUT, 0, "Could not start the thread for writing the result file, writing it directly.");
+      pthread_cond_destroy(&csvData->cond);
+      pthread_mutex_destroy(&csvData->mutex);
+      csvData->threaded = 0;
+    }
+  }
+  self->storage = csvData;
 }
 
 void omc_csv_free(simulation_result *self, DATA *data, threadData_t *threadData)
 {
-  FILE *fout = (FILE*) self->storage;
+  csv_data *csvData = (csv_data*) self->storage;
   rt_tick(SIM_TIMER_OUTPUT);
-  fclose(fout);
+  if (csvData->threaded) {
+    if (!csvData->pending.empty()) {
+      passPending(csvData);
+    }
+    pthread_mutex_lock(&csvData->mutex);
+    csvData->finished = 1;
+    pthread_cond_broadcast(&csvData->cond);
+    pthread_mutex_unlock(&csvData->mutex);
+    pthread_join(csvData->thread, NULL);
+    pthread_cond_destroy(&csvData->cond);
+    pthread_mutex_destroy(&csvData->mutex);
+  }
+  fclose(csvData->fout);
+  free(csvData->fileBuffer);
+  delete csvData;
+  self->storage = NULL;
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
 
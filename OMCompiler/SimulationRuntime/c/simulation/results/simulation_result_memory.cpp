@@ -0,0 +1,145 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Stores the result of a simulation in sim_memory_result instead of a file. Used when the
+ * model is loaded into the process that simulates it (omc, see simulateInMemory), which
+ * reads the variables directly from memory afterwards.
+ *
+ * The same variables as for the csv format are stored.
+ */
+
+#include "util/omc_error.h"
+#include "simulation_result_memory.h"
+#include "util/rtclock.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+extern "C" {
+
+SIMULATION_MEMORY_RESULT *sim_memory_result = NULL;
+
+static void addName(SIMULATION_MEMORY_RESULT *res, const char *name, threadData_t *threadData)
+{
+  res->names[res->nvars] = strdup(name);
+  assertStreamPrint(threadData, 0 != res->names[res->nvars], "Not enough memory to store the simulation result");
+  res->nvars++;
+}
+
+void omc_memory_init(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  SIMULATION_MEMORY_RESULT *res = sim_memory_result;
+  const MODEL_DATA *mData = data->modelData;
+  int i, maxVars;
+
+  if (!res) {
+    return;
+  }
+  maxVars = 1 + mData->nVariablesReal + mData->nVariablesInteger + mData->nVariablesBoolean + mData->nAliasReal + mData->nAliasInteger + mData->nAliasBoolean;
+  res->nvars = 0;
+  res->names = (char**) malloc(maxVars*sizeof(char*));
+  assertStreamPrint(threadData, 0 != res->names, "Not enough memory to store the simulation result");
+
+  addName(res, "time", threadData);
+  for(i = 0; i < mData->nVariablesReal; i++) if(!mData->realVarsData[i].filterOutput)
+    addName(res, mData->realVarsData[i].info.name, threadData);
+  for(i = 0; i < mData->nVariablesInteger; i++) if(!mData->integerVarsData[i].filterOutput)
+    addName(res, mData->integerVarsData[i].info.name, threadData);
+  for(i = 0; i < mData->nVariablesBoolean; i++) if(!mData->booleanVarsData[i].filterOutput)
+    addName(res, mData->booleanVarsData[i].info.name, threadData);
+  for(i = 0; i < mData->nAliasReal; i++) if(!mData->realAlias[i].filterOutput && mData->realAlias[i].aliasType != 1)
+    addName(res, mData->realAlias[i].info.name, threadData);
+  for(i = 0; i < mData->nAliasInteger; i++) if(!mData->integerAlias[i].filterOutput && mData->integerAlias[i].aliasType != 1)
+    addName(res, mData->integerAlias[i].info.name, threadData);
+  for(i = 0; i < mData->nAliasBoolean; i++) if(!mData->booleanAlias[i].filterOutput && mData->booleanAlias[i].aliasType != 1)
+    addName(res, mData->booleanAlias[i].info.name, threadData);
+
+  /* room for the output points without events, grows if needed */
+  res->npoints = 0;
+  res->capacity = data->simulationInfo->numSteps + 2;
+  res->data = (double*) malloc(res->capacity*res->nvars*sizeof(double));
+  assertStreamPrint(threadData, 0 != res->data, "Not enough memory to store the simulation result");
+}
+
+void omc_memory_emit(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  SIMULATION_MEMORY_RESULT *res = sim_memory_result;
+  const MODEL_DATA *mData = data->modelData;
+  const SIMULATION_DATA *sData = data->localData[0];
+  double *row, value;
+  int i;
+
+  if (!res || !res->data) {
+    return;
+  }
+  rt_tick(SIM_TIMER_OUTPUT);
+  if (res->npoints == res->capacity) {
+    double *tmp = (double*) realloc(res->data, 2*res->capacity*res->nvars*sizeof(double));
+    assertStreamPrint(threadData, 0 != tmp, "Not enough memory to store the simulation result");
+    res->data = tmp;
+    res->capacity *= 2;
+  }
+  row = res->data + res->npoints*res->nvars;
+
+  *row++ = sData->timeValue;
+  for(i = 0; i < mData->nVariablesReal; i++) if(!mData->realVarsData[i].filterOutput)
+    *row++ = sData->realVars[i];
+  for(i = 0; i < mData->nVariablesInteger; i++) if(!mData->integerVarsData[i].filterOutput)
+    *row++ = sData->integerVars[i];
+  for(i = 0; i < mData->nVariablesBoolean; i++) if(!mData->booleanVarsData[i].filterOutput)
+    *row++ = sData->booleanVars[i];
+  for(i = 0; i < mData->nAliasReal; i++) if(!mData->realAlias[i].filterOutput && mData->realAlias[i].aliasType != 1) {
+    value = mData->realAlias[i].aliasType == 2 ? sData->timeValue : sData->realVars[mData->realAlias[i].nameID];
+    *row++ = mData->realAlias[i].negate ? -value : value;
+  }
+  for(i = 0; i < mData->nAliasInteger; i++) if(!mData->integerAlias[i].filterOutput && mData->integerAlias[i].aliasType != 1) {
+    value = sData->integerVars[mData->integerAlias[i].nameID];
+    *row++ = mData->integerAlias[i].negate ? -value : value;
+  }
+  for(i = 0; i < mData->nAliasBoolean; i++) if(!mData->booleanAlias[i].filterOutput && mData->booleanAlias[i].aliasType != 1) {
+    value = sData->booleanVars[mData->booleanAlias[i].nameID];
+    *row++ = mData->booleanAlias[i].negate ? 1-value : value;
+  }
+  res->npoints++;
+  rt_accumulate(SIM_TIMER_OUTPUT);
+}
+
+void omc_memory_writeParameterData(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  /* parameters are not stored */
+}
+
+void omc_memory_free(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  /* the result is owned by the caller of the simulation */
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "simulation_data.h"
+#include "simulation_result.h"
+
+#ifndef _SIMULATION_RESULT_MEMORY_H
+#define _SIMULATION_RESULT_MEMORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* cplusplus */
+
+/* Result of a simulation running in the process that called the model (omc_simulateInMemory in the
+ * generated code). Everything is allocated with malloc and owned by the caller after the simulation.
+ */
+typedef struct SIMULATION_MEMORY_RESULT
+{
+  int nvars;       /* number of stored variables, the first one is time */
+  char **names;    /* names of the stored variables */
+  long npoints;    /* number of stored time points */
+  long capacity;   /* number of time points data has room for */
+  double *data;    /* npoints x nvars values, one time point after the other */
+} SIMULATION_MEMORY_RESULT;
+
+/* result of the running simulation, NULL if the results are written to a file */
+extern SIMULATION_MEMORY_RESULT *sim_memory_result;
+
+void omc_memory_init(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_memory_emit(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_memory_writeParameterData(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_memory_free(simulation_result *self,DATA *data, threadData_t *threadData);
+
+#ifdef __cplusplus
+}
+#endif /* cplusplus */
+
+#endif
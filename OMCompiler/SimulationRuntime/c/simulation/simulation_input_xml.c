@@ -593,7 +593,7 @@ void read_input_xml(MODEL_DATA* modelData,
       messageClose(LOG_SIMULATION);
     }
     XML_ParserFree(parser);
-    EXIT(-1);
+    throwStreamPrint(NULL, "simulation_input_xml.c: Error: input data file does not match model.");
   }
 
   /* read all static data from File for every variable */
@@ -60,6 +60,7 @@
 
 #include "util/omc_error.h"
 #include "util/omc_file.h"
+#include "util/omc_binlog.h"
 #include "simulation_data.h"
 #include "openmodelica_func.h"
 #include "meta/meta_modelica.h"
@@ -73,6 +74,7 @@
 #include "simulation/results/simulation_result_mat4.h"
 #include "simulation/results/simulation_result_wall.h"
 #include "simulation/results/simulation_result_ia.h"
+#include "simulation/results/simulation_result_memory.h"
 #include "simulation/solver/solver_main.h"
 #include "simulation_info_json.h"
 #include "modelinfo.h"
@@ -104,6 +106,9 @@ extern "C" {
 
 int sim_noemit = 0;           /* Flag for not emitting data */
 
+/* a simulation in memory (see simulation_result_memory.h) runs in the calling omc process and must not exit it */
+#define EXIT_SIMULATION(code) do { if(sim_memory_result) return 1; EXIT(code); } while(0)
+
 const std::string *init_method = NULL; /* method for  initialization. */
 
 static int callSolver(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
@@ -481,10 +486,31 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
   {
     if(lintime == NULL) {
       data->simulationInfo->stopTime = data->simulationInfo->startTime;
-    } else {
+    } else if(strchr(lintime, ',') == NULL) {
       data->simulationInfo->stopTime = atof(lintime);
+    } else {
+      /* batch linearization: the solver stops at every time point, the last one ends the simulation */
+      int n = 1;
+      const char *c;
+      char *endptr;
+      for(c = lintime; *c; c++) {
+        n += (*c == ',');
+      }
+      data->simulationInfo->linearizationTimes = (double*) malloc(n*sizeof(double));
+      data->simulationInfo->nLinearizationTimes = n;
+      data->simulationInfo->nextLinearization = 0;
+      for(c = lintime, n = 0; n < data->simulationInfo->nLinearizationTimes; n++, c = endptr+1) {
+        data->simulationInfo->linearizationTimes[n] = strtod(c, &endptr);
+        if(endptr == c || (*endptr != ',' && *endptr != '\0') || (n > 0 && data->simulationInfo->linearizationTimes[n] <= data->simulationInfo->linearizationTimes[n-1])) {
+          throwStreamPrint(threadData, "-l expects a time or a comma separated list of increasing times (got '%s')", lintime);
+        }
+      }
+      data->simulationInfo->stopTime = data->simulationInfo->linearizationTimes[data->simulationInfo->nLinearizationTimes-1];
+      infoStreamPrint(LOG_STDOUT, 0, "Linearization will performed at %d points of time from %f to %f", data->simulationInfo->nLinearizationTimes, data->simulationInfo->linearizationTimes[0], data->simulationInfo->stopTime);
+    }
+    if(data->simulationInfo->nLinearizationTimes == 0) {
+      infoStreamPrint(LOG_STDOUT, 0, "Linearization will performed at point of time: %f", data->simulationInfo->stopTime);
     }
-    infoStreamPrint(LOG_STDOUT, 0, "Linearization will performed at point of time: %f", data->simulationInfo->stopTime);
   }
 
   /* set delta x for linearization */
@@ -594,6 +620,8 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
   }
 
   if(0 == retVal && create_linearmodel) {
+    /* the last point of a batch linearization is the stop time */
+    data->simulationInfo->nextLinearization = data->simulationInfo->nLinearizationTimes - 1;
     rt_tick(SIM_TIMER_JACOBIAN);
     retVal = linearize(data, threadData);
     rt_accumulate(SIM_TIMER_JACOBIAN);
@@ -641,6 +669,12 @@ int initializeResultData(DATA* simData, threadData_t *threadData, int cpuTime)
   sim_result.cpuTime = cpuTime;
   if (sim_noemit || 0 == strcmp("empty", simData->simulationInfo->outputFormat)) {
     /* Default is set to noemit */
+  } else if(sim_memory_result) {
+    /* the caller of the simulation reads the result from memory */
+    sim_result.init = omc_memory_init;
+    sim_result.emit = omc_memory_emit;
+    sim_result.writeParameterData = omc_memory_writeParameterData;
+    sim_result.free = omc_memory_free;
   } else if(0 == strcmp("csv", simData->simulationInfo->outputFormat)) {
     sim_result.init = omc_csv_init;
     sim_result.emit = omc_csv_emit;
@@ -777,7 +811,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
   int i;
   initDumpSystem();
 
-  if(setLogFormat(argc, argv) || helpFlagSet(argc, argv) || checkCommandLineArguments(argc, argv))
+  if(setLogFormat(argc, argv, data->modelData->modelFilePrefix) || helpFlagSet(argc, argv) || checkCommandLineArguments(argc, argv))
   {
     infoStreamPrint(LOG_STDOUT, 1, "usage: %s", argv[0]);
 
@@ -793,7 +827,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
     }
 
     messageClose(LOG_STDOUT);
-    EXIT(0);
+    EXIT_SIMULATION(0);
   }
 
   if(omc_flag[FLAG_HELP]) {
@@ -877,13 +911,13 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
         }
         messageClose(LOG_STDOUT);
 
-        EXIT(0);
+        EXIT_SIMULATION(0);
       }
     }
 
     warningStreamPrint(LOG_STDOUT, 0, "invalid command line option: -help=%s", option.c_str());
     warningStreamPrint(LOG_STDOUT, 0, "use %s -help for a list of all command-line flags", argv[0]);
-    EXIT(0);
+    EXIT_SIMULATION(0);
   }
 
   setGlobalVerboseLevel(argc, argv);
@@ -892,7 +926,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
   if(!data)
   {
     std::cerr << "Error: Could not initialize the global data structure file" << std::endl;
-    EXIT(1);
+    EXIT_SIMULATION(1);
   }
 
   readFlag(&data->simulationInfo->nlsMethod, NLS_MAX, omc_flagValue[FLAG_NLS], "-nls", NLS_NAME, NLS_DESC);
@@ -1047,6 +1081,11 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
   sim_noemit = omc_flag[FLAG_NOEMIT];
 
 #ifndef NO_INTERACTIVE_DEPENDENCY
+  if(omc_flag[FLAG_PORT] && sim_memory_result) {
+    /* the socket code exits the process on errors */
+    errorStreamPrint(LOG_STDOUT, 0, "-port is not supported for simulations in memory");
+    EXIT_SIMULATION(1);
+  }
   if(omc_flag[FLAG_PORT]) {
     std::istringstream stream(omc_flagValue[FLAG_PORT]);
     int port;
@@ -1062,7 +1101,7 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
 
   if (isXMLTCP && !sim_communication_port_open) {
     errorStreamPrint(LOG_STDOUT, 0, "xmltcp log format requires a TCP-port to be passed (and successfully open)");
-    EXIT(1);
+    EXIT_SIMULATION(1);
   }
 #endif
   // ppriv - NO_INTERACTIVE_DEPENDENCY - for simpler debugging in Visual Studio
@@ -1112,6 +1151,14 @@ void communicateMsg(char id, unsigned int size, const char *data)
  * -r res.plt write result to file.
  */
 
+/* Closes the log of the finished run, so the next simulation in the same
+ * process (simulateInMemory) starts with its own log and output format. */
+static void resetRuntimeState()
+{
+  omc_binlog_close();
+  setStreamPrintText();
+}
+
 int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *threadData)
 {
 #if defined(__MINGW32__) || defined(_MSC_VER)
@@ -1129,8 +1176,10 @@ int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *thre
 
   int retVal = -1;
   MMC_TRY_INTERNAL(globalJumpBuffer)
-  if (initRuntimeAndSimulation(argc, argv, data, threadData)) //initRuntimeAndSimulation returns 1 if an error occurs
+  if (initRuntimeAndSimulation(argc, argv, data, threadData)) { //initRuntimeAndSimulation returns 1 if an error occurs
+    resetRuntimeState();
     return 1;
+  }
 
   /* sighandler_t oldhandler = different type on all platforms... */
 #ifdef SIGUSR1
@@ -1156,6 +1205,7 @@ int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *thre
   }
 #endif
 
+  resetRuntimeState();
   return retVal;
 }
 
@@ -1318,6 +1368,23 @@ void setStreamPrintXML(int isXML)
   }
 }
 
+/* -logFormat=binary: messages are written unformatted to <prefix>_log.bin,
+ * decode the file with omc_binlog_decode */
+int setStreamPrintBinary(const char *outputPath, const char *modelFilePrefix)
+{
+  std::string fileName = std::string(modelFilePrefix) + "_log.bin";
+  if (outputPath) {
+    fileName = std::string(outputPath) + "/" + fileName;
+  }
+  if (omc_binlog_open(fileName.c_str())) {
+    return 1;
+  }
+  messageDeferred = omc_binlog_message;
+  messageClose = omc_binlog_messageClose;
+  messageCloseWarning = omc_binlog_messageCloseWarning;
+  return 0;
+}
+
 void communicateStatus(const char *phase, double completionPercent /*0.0 to 1.0*/, double currentTime, double currentStepSize)
 {
 #ifndef NO_INTERACTIVE_DEPENDENCY
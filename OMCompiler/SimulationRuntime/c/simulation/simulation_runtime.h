@@ -86,6 +86,7 @@ const char* prettyPrintNanoSec(int64_t ns, int *v);
 #endif
 
 void setStreamPrintXML(int isXML);
+int setStreamPrintBinary(const char *outputPath, const char *modelFilePrefix);
 
 #ifdef __cplusplus
 }
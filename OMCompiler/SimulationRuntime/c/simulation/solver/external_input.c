@@ -108,8 +108,7 @@ void externalInputallocate2(DATA* data, char *filename){
   const int nnu = modelica_integer_min(nu, res ? res->numvars - 1 : 0);
 
   if (NULL == res) {
-    fprintf(stderr, "Failed to read CSV-file %s", filename);
-    EXIT(1);
+    throwStreamPrint(NULL, "Failed to read CSV-file %s", filename);
   }
 
   data->modelData->nInputVars = nu;
@@ -170,8 +169,9 @@ static inline void externalInputallocate1(DATA* data, FILE * pFile){
   // check if csv file is empty!
   if (n == 0)
   {
-    fprintf(stderr, "External input file: externalInput.csv is empty!\n"); fflush(NULL);
-    EXIT(1);
+    fclose(pFile);
+    data->simulationInfo->external_input.active = 0;
+    throwStreamPrint(NULL, "External input file: externalInput.csv is empty!");
   }
 
   --n;
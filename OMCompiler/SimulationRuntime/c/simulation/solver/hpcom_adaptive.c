@@ -0,0 +1,422 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file hpcom_adaptive.c
+ */
+
+#include "hpcom_adaptive.h"
+#include "../../util/omc_error.h"
+#include "../options.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static const int HPCOM_ADAPT_DEFAULT_STEPS = 100;
+
+/*! \fn hpcom_adaptive_init
+ *
+ *  Initializes the adaptive schedule for the given task graph and computes the
+ *  initial list schedule from the estimated costs. The tasks have to be
+ *  topologically sorted, i.e. every parent has a lower index than its child.
+ *  The arrays parentIdx and eqIdx passed by the generated code are not copied.
+ *
+ *  \param [out] [schedule]
+ *  \param [in]  [data]
+ *  \param [in]  [nTasks]
+ *  \param [in]  [nThreads]
+ *  \param [in]  [taskFunctions]  one function per task
+ *  \param [in]  [nParents]       number of parents of every task
+ *  \param [in]  [parentIdx]      parents of all tasks
+ *  \param [in]  [nEqs]           number of simulation equations of every task
+ *  \param [in]  [eqIdx]          indices of the simulation equations of all tasks
+ *  \param [in]  [estimatedCosts] compile-time costs of the tasks
+ */
+void hpcom_adaptive_init(HPCOM_ADAPTIVE_SCHEDULE *schedule, DATA *data, int nTasks, int nThreads,
+                         const HPCOM_TASK_FUNCTION *taskFunctions, const int *nParents, const int *parentIdx,
+                         const int *nEqs, const int *eqIdx, const double *estimatedCosts)
+{
+  int i, j;
+
+  schedule->parentPtr = (int*) calloc(nTasks+1, sizeof(int));
+  schedule->eqPtr = (int*) calloc(nTasks+1, sizeof(int));
+  assertStreamPrint(NULL, 0 != schedule->parentPtr && 0 != schedule->eqPtr, "out of memory");
+  for(i=0; i<nTasks; i++) {
+    schedule->parentPtr[i+1] = schedule->parentPtr[i] + nParents[i];
+    schedule->eqPtr[i+1] = schedule->eqPtr[i] + nEqs[i];
+  }
+
+  for(i=0; i<nTasks; i++) {
+    for(j=schedule->parentPtr[i]; j<schedule->parentPtr[i+1]; j++) {
+      assertStreamPrint(NULL, parentIdx[j] >= 0 && parentIdx[j] < i, "hpcom: task %d depends on task %d, the tasks are not topologically sorted", i, parentIdx[j]);
+    }
+  }
+
+  schedule->nTasks = nTasks;
+  schedule->nThreads = nThreads > 0 ? nThreads : 1;
+  schedule->taskFunctions = taskFunctions;
+  schedule->parentIdx = parentIdx;
+  schedule->eqIdx = eqIdx;
+
+  for(i=0; i<2; i++) {
+    schedule->threadTaskPtr[i] = (int*) calloc(schedule->nThreads+1, sizeof(int));
+    schedule->threadTasks[i] = (int*) calloc(nTasks > 0 ? nTasks : 1, sizeof(int));
+    assertStreamPrint(NULL, 0 != schedule->threadTaskPtr[i] && 0 != schedule->threadTasks[i], "out of memory");
+  }
+  schedule->taskDone = (long*) calloc(nTasks > 0 ? nTasks : 1, sizeof(long));
+  schedule->costs = (double*) calloc(nTasks > 0 ? nTasks : 1, sizeof(double));
+  schedule->taskTime = (double*) calloc(nTasks > 0 ? nTasks : 1, sizeof(double));
+  assertStreamPrint(NULL, 0 != schedule->taskDone && 0 != schedule->costs && 0 != schedule->taskTime, "out of memory");
+  schedule->evaluation = 0;
+  schedule->failed = 0;
+
+  /* tasks without estimate are considered cheap */
+  for(i=0; i<nTasks; i++) {
+    schedule->costs[i] = estimatedCosts[i] > 0.0 ? estimatedCosts[i] : 0.0;
+  }
+  schedule->active = 0;
+  schedule->makespan[0] = hpcom_adaptive_list_schedule(schedule, schedule->costs, schedule->threadTaskPtr[0], schedule->threadTasks[0]);
+  schedule->makespan[1] = 0.0;
+
+  schedule->nMeasured = 0;
+  schedule->nMeasureSteps = omc_flag[FLAG_HPCOM_ADAPT_STEPS] ? atoi(omc_flagValue[FLAG_HPCOM_ADAPT_STEPS]) : HPCOM_ADAPT_DEFAULT_STEPS;
+  if(schedule->nMeasureSteps < 0) {
+    schedule->nMeasureSteps = 0;
+  }
+
+  /* the measured times replace the profiling of the model only on request */
+  schedule->profileFile = omc_flag[FLAG_HPCOM_ADAPT_PROFILE] ? omc_flagValue[FLAG_HPCOM_ADAPT_PROFILE] : NULL;
+
+  infoStreamPrint(LOG_SOLVER, 0, "hpcom: adaptive schedule with %d tasks on %d threads, rescheduling after %d evaluations", nTasks, schedule->nThreads, schedule->nMeasureSteps);
+}
+
+void hpcom_adaptive_free(HPCOM_ADAPTIVE_SCHEDULE *schedule)
+{
+  int i;
+
+  for(i=0; i<2; i++) {
+    free(schedule->threadTaskPtr[i]);
+    free(schedule->threadTasks[i]);
+  }
+  free(schedule->parentPtr);
+  free(schedule->eqPtr);
+  free(schedule->taskDone);
+  free(schedule->costs);
+  free(schedule->taskTime);
+}
+
+/*! \fn hpcom_adaptive_list_schedule
+ *
+ *  List scheduling of the task graph with the given costs: the ready task with
+ *  the longest path to the end of the graph (bottom level) is assigned to the
+ *  thread on which it can start first. The tasks of every thread are stored in
+ *  assignment order, which is a topological order.
+ *
+ *  \param [in]  [schedule]      task graph
+ *  \param [in]  [costs]         costs of the tasks
+ *  \param [out] [threadTaskPtr] nThreads+1 offsets into threadTasks
+ *  \param [out] [threadTasks]   tasks of all threads
+ *  \return predicted time for one evaluation
+ */
+double hpcom_adaptive_list_schedule(const HPCOM_ADAPTIVE_SCHEDULE *schedule, const double *costs,
+                                    int *threadTaskPtr, int *threadTasks)
+{
+  int nTasks = schedule->nTasks;
+  int nThreads = schedule->nThreads;
+  double *bottomLevel = (double*) calloc(nTasks > 0 ? nTasks : 1, sizeof(double));
+  double *finishTime = (double*) calloc(nTasks > 0 ? nTasks : 1, sizeof(double));
+  double *threadReady = (double*) calloc(nThreads, sizeof(double));
+  int *nOpenParents = (int*) calloc(nTasks > 0 ? nTasks : 1, sizeof(int));
+  int *ready = (int*) calloc(nTasks > 0 ? nTasks : 1, sizeof(int));
+  int *assignedThread = (int*) calloc(nTasks > 0 ? nTasks : 1, sizeof(int));
+  int *order = (int*) calloc(nTasks > 0 ? nTasks : 1, sizeof(int));
+  int nEdges = schedule->parentPtr[nTasks];
+  int *childPtr = (int*) calloc(nTasks+1, sizeof(int));
+  int *childIdx = (int*) calloc(nEdges > 0 ? nEdges : 1, sizeof(int));
+  int nReady = 0, nScheduled, i, j, k, best, thread;
+  double start, dataReady, makespan = 0.0;
+
+  assertStreamPrint(NULL, 0 != bottomLevel && 0 != finishTime && 0 != threadReady && 0 != nOpenParents && 0 != ready && 0 != assignedThread && 0 != order && 0 != childPtr && 0 != childIdx, "out of memory");
+
+  /* children of all tasks from the parents */
+  for(j=0; j<nEdges; j++) {
+    childPtr[schedule->parentIdx[j]+1]++;
+  }
+  for(i=0; i<nTasks; i++) {
+    childPtr[i+1] += childPtr[i];
+  }
+  for(i=0; i<nTasks; i++) {
+    for(j=schedule->parentPtr[i]; j<schedule->parentPtr[i+1]; j++) {
+      childIdx[childPtr[schedule->parentIdx[j]] + nOpenParents[schedule->parentIdx[j]]++] = i;
+    }
+  }
+
+  /* bottom levels, the children of a task have higher indices */
+  for(i=nTasks-1; i>=0; i--) {
+    bottomLevel[i] += costs[i];
+    for(j=schedule->parentPtr[i]; j<schedule->parentPtr[i+1]; j++) {
+      if(bottomLevel[i] > bottomLevel[schedule->parentIdx[j]]) {
+        bottomLevel[schedule->parentIdx[j]] = bottomLevel[i];
+      }
+    }
+  }
+
+  for(i=0; i<nTasks; i++) {
+    nOpenParents[i] = schedule->parentPtr[i+1] - schedule->parentPtr[i];
+    if(0 == nOpenParents[i]) {
+      ready[nReady++] = i;
+    }
+  }
+
+  for(nScheduled=0; nScheduled<nTasks; nScheduled++) {
+    assertStreamPrint(NULL, nReady > 0, "hpcom: the task graph contains a cycle");
+
+    /* ready task with the highest bottom level */
+    best = 0;
+    for(k=1; k<nReady; k++) {
+      if(bottomLevel[ready[k]] > bottomLevel[ready[best]]) {
+        best = k;
+      }
+    }
+    i = ready[best];
+    ready[best] = ready[--nReady];
+
+    /* thread with the earliest start time */
+    dataReady = 0.0;
+    for(j=schedule->parentPtr[i]; j<schedule->parentPtr[i+1]; j++) {
+      if(finishTime[schedule->parentIdx[j]] > dataReady) {
+        dataReady = finishTime[schedule->parentIdx[j]];
+      }
+    }
+    thread = 0;
+    for(k=1; k<nThreads; k++) {
+      if(fmax(threadReady[k], dataReady) < fmax(threadReady[thread], dataReady)) {
+        thread = k;
+      }
+    }
+    start = fmax(threadReady[thread], dataReady);
+    finishTime[i] = start + costs[i];
+    threadReady[thread] = finishTime[i];
+    if(finishTime[i] > makespan) {
+      makespan = finishTime[i];
+    }
+    assignedThread[i] = thread;
+    order[nScheduled] = i;
+
+    /* release the children */
+    for(j=childPtr[i]; j<childPtr[i+1]; j++) {
+      if(0 == --nOpenParents[childIdx[j]]) {
+        ready[nReady++] = childIdx[j];
+      }
+    }
+  }
+
+  /* store the tasks of every thread in assignment order */
+  memset(threadTaskPtr, 0, (nThreads+1)*sizeof(int));
+  for(i=0; i<nTasks; i++) {
+    threadTaskPtr[assignedThread[i]+1]++;
+  }
+  for(k=0; k<nThreads; k++) {
+    threadTaskPtr[k+1] += threadTaskPtr[k];
+    threadReady[k] = 0.0;
+  }
+  for(nScheduled=0; nScheduled<nTasks; nScheduled++) {
+    i = order[nScheduled];
+    thread = assignedThread[i];
+    threadTasks[threadTaskPtr[thread] + (int)threadReady[thread]] = i;
+    threadReady[thread] += 1.0;
+  }
+
+  free(bottomLevel);
+  free(finishTime);
+  free(threadReady);
+  free(nOpenParents);
+  free(ready);
+  free(assignedThread);
+  free(order);
+  free(childPtr);
+  free(childIdx);
+
+  return makespan;
+}
+
+/*! \fn hpcom_adaptive_makespan
+ *
+ *  Predicts the time for one evaluation of an existing schedule with the given
+ *  costs.
+ */
+static double hpcom_adaptive_makespan(const HPCOM_ADAPTIVE_SCHEDULE *schedule, const double *costs,
+                                      const int *threadTaskPtr, const int *threadTasks)
+{
+  int nThreads = schedule->nThreads;
+  double *finishTime = (double*) calloc(schedule->nTasks > 0 ? schedule->nTasks : 1, sizeof(double));
+  double *threadReady = (double*) calloc(nThreads, sizeof(double));
+  int *next = (int*) calloc(nThreads, sizeof(int));
+  char *done = (char*) calloc(schedule->nTasks > 0 ? schedule->nTasks : 1, sizeof(char));
+  int nDone = 0, progress = 1, thread, i, j;
+  double start, makespan = 0.0;
+
+  assertStreamPrint(NULL, 0 != finishTime && 0 != threadReady && 0 != next && 0 != done, "out of memory");
+
+  for(thread=0; thread<nThreads; thread++) {
+    next[thread] = threadTaskPtr[thread];
+  }
+
+  while(nDone < schedule->nTasks && progress) {
+    progress = 0;
+    for(thread=0; thread<nThreads; thread++) {
+      while(next[thread] < threadTaskPtr[thread+1]) {
+        i = threadTasks[next[thread]];
+        start = threadReady[thread];
+        for(j=schedule->parentPtr[i]; j<schedule->parentPtr[i+1]; j++) {
+          if(!done[schedule->parentIdx[j]]) {
+            break;
+          }
+          start = fmax(start, finishTime[schedule->parentIdx[j]]);
+        }
+        if(j < schedule->parentPtr[i+1]) {
+          break;
+        }
+        finishTime[i] = start + costs[i];
+        threadReady[thread] = finishTime[i];
+        makespan = fmax(makespan, finishTime[i]);
+        done[i] = 1;
+        next[thread]++;
+        nDone++;
+        progress = 1;
+      }
+    }
+  }
+
+  free(finishTime);
+  free(threadReady);
+  free(next);
+  free(done);
+
+  return progress ? makespan : HUGE_VAL;
+}
+
+/*! \fn hpcom_adaptive_begin_evaluation
+ *
+ *  Has to be called by the generated code before the parallel region.
+ */
+void hpcom_adaptive_begin_evaluation(HPCOM_ADAPTIVE_SCHEDULE *schedule)
+{
+  schedule->evaluation++;
+  schedule->failed = 0;
+}
+
+/*! \fn hpcom_adaptive_end_evaluation
+ *
+ *  Has to be called by the generated code after the parallel region. Once
+ *  enough evaluations are measured, the tasks are rescheduled with the mean
+ *  measured times. The new schedule is used if it is predicted to be faster
+ *  than the current one. The measured times are written to the file given
+ *  with -hpcomAdaptProfile.
+ */
+void hpcom_adaptive_end_evaluation(HPCOM_ADAPTIVE_SCHEDULE *schedule)
+{
+  int i, inactive;
+  double oldMakespan, newMakespan;
+
+  if(!HPCOM_ADAPTIVE_MEASURING(schedule)) {
+    return;
+  }
+  if(++schedule->nMeasured < schedule->nMeasureSteps) {
+    return;
+  }
+
+  for(i=0; i<schedule->nTasks; i++) {
+    schedule->costs[i] = schedule->taskTime[i] / schedule->nMeasured;
+  }
+
+  inactive = 1 - schedule->active;
+  oldMakespan = hpcom_adaptive_makespan(schedule, schedule->costs, schedule->threadTaskPtr[schedule->active], schedule->threadTasks[schedule->active]);
+  newMakespan = hpcom_adaptive_list_schedule(schedule, schedule->costs, schedule->threadTaskPtr[inactive], schedule->threadTasks[inactive]);
+  schedule->makespan[schedule->active] = oldMakespan;
+  schedule->makespan[inactive] = newMakespan;
+
+  if(newMakespan < oldMakespan) {
+    schedule->active = inactive;
+    infoStreamPrint(LOG_SOLVER, 0, "hpcom: rescheduled after %d evaluations, predicted time per evaluation %g s instead of %g s", schedule->nMeasured, newMakespan, oldMakespan);
+  } else {
+    infoStreamPrint(LOG_SOLVER, 0, "hpcom: keeping the schedule after %d evaluations, predicted time per evaluation %g s", schedule->nMeasured, oldMakespan);
+  }
+
+  hpcom_adaptive_write_profile(schedule);
+}
+
+/*! \fn hpcom_adaptive_write_profile
+ *
+ *  Writes the measured task times in the format of the equation profiling
+ *  (see printJSONProfileBlocks), the time of a task is split evenly over its
+ *  equations.
+ */
+void hpcom_adaptive_write_profile(const HPCOM_ADAPTIVE_SCHEDULE *schedule)
+{
+  FILE *fout;
+  int i, j, first = 1;
+  double time;
+
+  if(schedule->nMeasured == 0 || schedule->profileFile == NULL) {
+    return;
+  }
+
+  fout = fopen(schedule->profileFile, "wb");
+  if(fout == NULL) {
+    warningStreamPrint(LOG_STDOUT, 0, "hpcom: failed to open %s for writing", schedule->profileFile);
+    return;
+  }
+
+  fputs("{\n\"profileBlocks\":[\n", fout);
+  for(i=0; i<schedule->nTasks; i++) {
+    if(schedule->eqPtr[i+1] == schedule->eqPtr[i]) {
+      continue;
+    }
+    time = schedule->taskTime[i] / (schedule->eqPtr[i+1] - schedule->eqPtr[i]);
+    for(j=schedule->eqPtr[i]; j<schedule->eqPtr[i+1]; j++) {
+      fprintf(fout, "%s{\"id\":%d,\"ncall\":%d,\"time\":%.9f}", first ? "" : ",\n", schedule->eqIdx[j], schedule->nMeasured, time);
+      first = 0;
+    }
+  }
+  fputs("\n]\n}\n", fout);
+  fclose(fout);
+
+  infoStreamPrint(LOG_STATS, 0, "hpcom: measured task times written to %s", schedule->profileFile);
+}
+
+#ifdef __cplusplus
+}
+#endif
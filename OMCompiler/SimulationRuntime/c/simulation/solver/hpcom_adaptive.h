@@ -0,0 +1,100 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file hpcom_adaptive.h
+ *
+ * Adaptive list schedule for hpcom-generated parallel code (+hpcomScheduler=adapt).
+ *
+ * The generated code passes the task graph of the ODE system (one function per
+ * task and the parents of every task) and compile-time cost estimates. An
+ * initial list schedule is computed from the estimates; during the first
+ * evaluations the generated code measures the execution time of every task.
+ * Afterwards the list schedule is recomputed from the measured times and
+ * replaces the initial schedule between two evaluations.
+ */
+
+#ifndef _HPCOM_ADAPTIVE_H_
+#define _HPCOM_ADAPTIVE_H_
+
+#include "../../simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*HPCOM_TASK_FUNCTION)(DATA *data, threadData_t *threadData);
+
+typedef struct HPCOM_ADAPTIVE_SCHEDULE
+{
+  int nTasks;
+  int nThreads;
+  const HPCOM_TASK_FUNCTION *taskFunctions;
+  int *parentPtr;                 /* parents of task i: parentIdx[parentPtr[i]] ... parentIdx[parentPtr[i+1]-1] */
+  const int *parentIdx;
+  int *eqPtr;                     /* simulation equations of task i: eqIdx[eqPtr[i]] ... eqIdx[eqPtr[i+1]-1] */
+  const int *eqIdx;
+
+  /* two schedules, the active one is used by the evaluations and the other one is recomputed */
+  int *threadTaskPtr[2];          /* tasks of thread t: threadTasks[.][threadTaskPtr[.][t]] ... threadTasks[.][threadTaskPtr[.][t+1]-1] */
+  int *threadTasks[2];
+  double makespan[2];             /* predicted time for one evaluation */
+  int active;
+
+  /* synchronization of one evaluation */
+  long *taskDone;                 /* evaluation in which the task has been finished */
+  long evaluation;
+  int failed;
+
+  /* measurement */
+  double *costs;                  /* costs used for the active schedule */
+  double *taskTime;               /* accumulated measured time of every task */
+  int nMeasured;
+  int nMeasureSteps;
+  const char *profileFile;        /* -hpcomAdaptProfile, NULL if the measured times are not written */
+} HPCOM_ADAPTIVE_SCHEDULE;
+
+void hpcom_adaptive_init(HPCOM_ADAPTIVE_SCHEDULE *schedule, DATA *data, int nTasks, int nThreads,
+                         const HPCOM_TASK_FUNCTION *taskFunctions, const int *nParents, const int *parentIdx,
+                         const int *nEqs, const int *eqIdx, const double *estimatedCosts);
+void hpcom_adaptive_free(HPCOM_ADAPTIVE_SCHEDULE *schedule);
+void hpcom_adaptive_begin_evaluation(HPCOM_ADAPTIVE_SCHEDULE *schedule);
+void hpcom_adaptive_end_evaluation(HPCOM_ADAPTIVE_SCHEDULE *schedule);
+double hpcom_adaptive_list_schedule(const HPCOM_ADAPTIVE_SCHEDULE *schedule, const double *costs,
+                                    int *threadTaskPtr, int *threadTasks);
+void hpcom_adaptive_write_profile(const HPCOM_ADAPTIVE_SCHEDULE *schedule);
+
+/* true if the task times of the current evaluation are measured */
+#define HPCOM_ADAPTIVE_MEASURING(schedule) ((schedule)->nMeasured < (schedule)->nMeasureSteps)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -516,13 +516,11 @@ void overwriteOldSimulationData(DATA *data)
   TRACE_PUSH
   long i;
 
+  /* integer, boolean and string variables are shared by all slots, see initializeDataStruc */
   for(i=1; i<ringBufferLength(data->simulationData); ++i)
   {
     data->localData[i]->timeValue = data->localData[i-1]->timeValue;
     memcpy(data->localData[i]->realVars, data->localData[i-1]->realVars, sizeof(modelica_real)*data->modelData->nVariablesReal);
-    memcpy(data->localData[i]->integerVars, data->localData[i-1]->integerVars, sizeof(modelica_integer)*data->modelData->nVariablesInteger);
-    memcpy(data->localData[i]->booleanVars, data->localData[i-1]->booleanVars, sizeof(modelica_boolean)*data->modelData->nVariablesBoolean);
-    memcpy(data->localData[i]->stringVars, data->localData[i-1]->stringVars, sizeof(modelica_string)*data->modelData->nVariablesString);
   }
 
   TRACE_POP
@@ -552,14 +550,18 @@ void copyRingBufferSimulationData(DATA *data, threadData_t *threadData, SIMULATI
   {
     destData[i]->timeValue = data->localData[i]->timeValue;
     memcpy(destData[i]->realVars, data->localData[i]->realVars, sizeof(modelica_real)*data->modelData->nVariablesReal);
-    memcpy(destData[i]->integerVars, data->localData[i]->integerVars, sizeof(modelica_integer)*data->modelData->nVariablesInteger);
-    memcpy(destData[i]->booleanVars, data->localData[i]->booleanVars, sizeof(modelica_boolean)*data->modelData->nVariablesBoolean);
+  }
+
+  /* integer, boolean and string variables are shared by all slots, see initializeDataStruc */
+  if(destData[0]->integerVars != data->localData[0]->integerVars)
+  {
+    memcpy(destData[0]->integerVars, data->localData[0]->integerVars, sizeof(modelica_integer)*data->modelData->nVariablesInteger);
+    memcpy(destData[0]->booleanVars, data->localData[0]->booleanVars, sizeof(modelica_boolean)*data->modelData->nVariablesBoolean);
 #if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
-    memcpy(destData[i]->stringVars, data->localData[i]->stringVars, sizeof(modelica_string)*data->modelData->nVariablesString);
+    memcpy(destData[0]->stringVars, data->localData[0]->stringVars, sizeof(modelica_string)*data->modelData->nVariablesString);
 #endif
   }
 
-
   TRACE_POP
 }
 
@@ -580,15 +582,11 @@ void restoreExtrapolationDataOld(DATA *data)
   TRACE_PUSH
   long i;
 
+  /* integer, boolean and string variables are shared by all slots, see initializeDataStruc */
   for(i=1; i<ringBufferLength(data->simulationData); ++i)
   {
     data->localData[i-1]->timeValue = data->localData[i]->timeValue;
     memcpy(data->localData[i-1]->realVars, data->localData[i]->realVars, sizeof(modelica_real)*data->modelData->nVariablesReal);
-    memcpy(data->localData[i-1]->integerVars, data->localData[i]->integerVars, sizeof(modelica_integer)*data->modelData->nVariablesInteger);
-    memcpy(data->localData[i-1]->booleanVars, data->localData[i]->booleanVars, sizeof(modelica_boolean)*data->modelData->nVariablesBoolean);
-#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
-    memcpy(data->localData[i-1]->stringVars, data->localData[i]->stringVars, sizeof(modelica_string)*data->modelData->nVariablesString);
-#endif
   }
 
   TRACE_POP
@@ -892,22 +890,30 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
     throwStreamPrint(threadData, "Your memory is not strong enough for our ringbuffer!");
   }
 
-  /* prepare RingBuffer */
+  /* prepare RingBuffer
+   * Integer, boolean and string variables only change at events, after which
+   * all ring slots are synchronized by overwriteOldSimulationData. Hence all
+   * slots share one buffer for them and only the real variables are stored
+   * per slot; rotating the ring buffer stays a pointer rotation and the
+   * synchronization only copies the real variables.
+   * The real variables stay one array per slot: generated code indexes
+   * realVars directly, so the algebraic variables cannot be moved to a
+   * buffer shared by all slots without changing the code generator. */
+  tmpSimData.integerVars = (modelica_integer*) calloc(data->modelData->nVariablesInteger, sizeof(modelica_integer));
+  assertStreamPrint(threadData, 0 == data->modelData->nVariablesInteger || 0 != tmpSimData.integerVars, "out of memory");
+  tmpSimData.booleanVars = (modelica_boolean*) calloc(data->modelData->nVariablesBoolean, sizeof(modelica_boolean));
+  assertStreamPrint(threadData, 0 == data->modelData->nVariablesBoolean || 0 != tmpSimData.booleanVars, "out of memory");
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+  tmpSimData.stringVars = (modelica_string*) omc_alloc_interface.malloc_uncollectable(data->modelData->nVariablesString * sizeof(modelica_string));
+  assertStreamPrint(threadData, 0 == data->modelData->nVariablesString || 0 != tmpSimData.stringVars, "out of memory");
+#endif
   for(i=0; i<SIZERINGBUFFER; i++)
   {
     /* set time value */
     tmpSimData.timeValue = 0;
-    /* buffer for all variable values */
+    /* buffer for all real variable values */
     tmpSimData.realVars = (modelica_real*) calloc(data->modelData->nVariablesReal, sizeof(modelica_real));
     assertStreamPrint(threadData, 0 == data->modelData->nVariablesReal || 0 != tmpSimData.realVars, "out of memory");
-    tmpSimData.integerVars = (modelica_integer*) calloc(data->modelData->nVariablesInteger, sizeof(modelica_integer));
-    assertStreamPrint(threadData, 0 == data->modelData->nVariablesInteger || 0 != tmpSimData.integerVars, "out of memory");
-    tmpSimData.booleanVars = (modelica_boolean*) calloc(data->modelData->nVariablesBoolean, sizeof(modelica_boolean));
-    assertStreamPrint(threadData, 0 == data->modelData->nVariablesBoolean || 0 != tmpSimData.booleanVars, "out of memory");
-#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
-    tmpSimData.stringVars = (modelica_string*) omc_alloc_interface.malloc_uncollectable(data->modelData->nVariablesString * sizeof(modelica_string));
-    assertStreamPrint(threadData, 0 == data->modelData->nVariablesString || 0 != tmpSimData.stringVars, "out of memory");
-#endif
     appendRingData(data->simulationData, &tmpSimData);
   }
   data->localData = (SIMULATION_DATA**) omc_alloc_interface.malloc_uncollectable(SIZERINGBUFFER * sizeof(SIMULATION_DATA));
@@ -935,6 +941,9 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   data->simulationInfo->nextSampleEvent = data->simulationInfo->startTime;
   data->simulationInfo->nextSampleTimes = (double*) calloc(data->modelData->nSamples, sizeof(double));
   data->simulationInfo->samples = (modelica_boolean*) calloc(data->modelData->nSamples, sizeof(modelica_boolean));
+  data->simulationInfo->linearizationTimes = NULL;
+  data->simulationInfo->nLinearizationTimes = 0;
+  data->simulationInfo->nextLinearization = 0;
 
   data->modelData->clocksInfo = (CLOCK_INFO*) omc_alloc_interface.malloc_uncollectable(data->modelData->nClocks * sizeof(CLOCK_INFO));
   data->modelData->subClocksInfo = (SUBCLOCK_INFO*) omc_alloc_interface.malloc_uncollectable(data->modelData->nSubClocks * sizeof(SUBCLOCK_INFO));
@@ -1130,12 +1139,13 @@ void deInitializeDataStruc(DATA *data)
   for(i=0; i<SIZERINGBUFFER; i++)
   {
     SIMULATION_DATA* tmpSimData = (SIMULATION_DATA*) data->localData[i];
-    /* free buffer for all variable values */
+    /* free buffer for all real variable values */
     free(tmpSimData->realVars);
-    free(tmpSimData->integerVars);
-    free(tmpSimData->booleanVars);
-    omc_alloc_interface.free_uncollectable(tmpSimData->stringVars);
   }
+  /* the buffers for discrete variables are shared by all slots */
+  free(data->localData[0]->integerVars);
+  free(data->localData[0]->booleanVars);
+  omc_alloc_interface.free_uncollectable(data->localData[0]->stringVars);
   omc_alloc_interface.free_uncollectable(data->localData);
   freeRingBuffer(data->simulationData);
 
@@ -1165,6 +1175,7 @@ void deInitializeDataStruc(DATA *data)
   omc_alloc_interface.free_uncollectable(data->modelData->samplesInfo);
   free(data->simulationInfo->nextSampleTimes);
   free(data->simulationInfo->samples);
+  free(data->simulationInfo->linearizationTimes);
 
   omc_alloc_interface.free_uncollectable(data->modelData->clocksInfo);
   omc_alloc_interface.free_uncollectable(data->modelData->subClocksInfo);
@@ -648,6 +648,10 @@ typedef struct SIMULATION_INFO
   double *nextSampleTimes;             /* array of next sample time */
   modelica_boolean *samples;           /* array of the current value for all sample-calls */
 
+  double *linearizationTimes;          /* ascending time points of a batch linearization (-l=t1,t2,...) */
+  int nLinearizationTimes;             /* number of linearizationTimes, 0 if the model is linearized at most once */
+  int nextLinearization;               /* index of the next entry of linearizationTimes */
+
   LIST* intvlTimers;
   CLOCK_DATA *clocksData;
 
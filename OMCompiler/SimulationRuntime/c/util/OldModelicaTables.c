@@ -51,6 +51,7 @@ typedef struct InterpolationTable
   char *filename;
   char *tablename;
   char own_data;
+  char shared_data; /* data read from a file, shared with other tables, see TableData_open */
   double* data;
   size_t rows;
   size_t cols;
@@ -58,6 +59,8 @@ typedef struct InterpolationTable
   int ipoType;
   int expoType;
   double startTime;
+  int refs;
+  size_t lastIdx; /* interval of the last lookup; only a hint, shared by all blocks using the table */
 } InterpolationTable;
 
 typedef struct InterpolationTable2D
@@ -65,6 +68,7 @@ typedef struct InterpolationTable2D
   char *filename;
   char *tablename;
   char own_data;
+  char shared_data; /* data read from a file, shared with other tables, see TableData_open */
   double *data;
   size_t rows;
   size_t cols;
@@ -72,12 +76,28 @@ typedef struct InterpolationTable2D
   char colWise;
   int ipoType;
   int expoType;
+  int refs;
+  size_t lastRow; /* indexes of the last lookup; only hints, shared by all blocks using the table */
+  size_t lastCol;
 } InterpolationTable2D;
 
+/* table data read from a file */
+typedef struct TableData
+{
+  char *filename;
+  char *tablename;
+  double *data;
+  size_t rows;
+  size_t cols;
+  int refs;
+} TableData;
+
 static InterpolationTable** interpolationTables=NULL;
 static int ninterpolationTables=0;
 static InterpolationTable2D** interpolationTables2D=NULL;
 static int ninterpolationTables2D=0;
+static TableData** tableData=NULL;
+static int ntableData=0;
 
 static InterpolationTable *InterpolationTable_init(double time,double startTime, int ipoType, int expoType,
          const char* tableName, const char* fileName,
@@ -88,7 +108,9 @@ static void InterpolationTable_deinit(InterpolationTable *tpl);
 static double InterpolationTable_interpolate(InterpolationTable *tpl, double time, size_t col);
 static double InterpolationTable_maxTime(InterpolationTable *tpl);
 static double InterpolationTable_minTime(InterpolationTable *tpl);
-static char InterpolationTable_compare(InterpolationTable *tpl, const char* fname, const char* tname, const double* table);
+static char InterpolationTable_compare(InterpolationTable *tpl, double startTime, int ipoType, int expoType,
+         const char* fname, const char* tname, const double* table, int tableDim1, int tableDim2);
+static size_t InterpolationTable_findInterval(InterpolationTable *tpl, double time, size_t lastIdx);
 
 static double InterpolationTable_extrapolate(InterpolationTable *tpl, double time, size_t col, char beforeData);
 static inline double InterpolationTable_interpolateLin(InterpolationTable *tpl, double time, size_t i, size_t j);
@@ -102,11 +124,16 @@ static InterpolationTable2D *InterpolationTable2D_init(int ipoType, const char*
            int tableDim1, int tableDim2, int colWise);
 static void InterpolationTable2D_deinit(InterpolationTable2D *table);
 static double InterpolationTable2D_interpolate(InterpolationTable2D *tpl, double x1, double x2);
-static char InterpolationTable2D_compare(InterpolationTable2D *tpl, const char* fname, const char* tname, const double* table);
+static char InterpolationTable2D_compare(InterpolationTable2D *tpl, int ipoType, const char* fname, const char* tname,
+           const double* table, int tableDim1, int tableDim2);
+static size_t InterpolationTable2D_findIndex(InterpolationTable2D *tpl, char row, double x, size_t end, size_t *last);
 static double InterpolationTable2D_linInterpolate(double x, double x_1, double x_2, double f_1, double f_2);
 static const double InterpolationTable2D_getElt(InterpolationTable2D *tpl, size_t row, size_t col);
 static void InterpolationTable2D_checkValidityOfData(InterpolationTable2D *tpl);
 
+static double* TableData_open(const char* fileName, const char* tableName, size_t *rows, size_t *cols);
+static void TableData_release(double *data);
+
 
 
 /* Initialize table.
@@ -137,13 +164,14 @@ int omcTableTimeIni(double timeIn, double startTime,int ipoType,int expoType,
 #ifdef INFOS
   INFO10("Init Table \n timeIn %f \n startTime %f \n ipoType %d \n expoType %d \n tableName %s \n fileName %s \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", timeIn, startTime, ipoType, expoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
-  /* if table is already initialized, find it */
+  /* if table is already initialized, find it; the blocks then share its lookup cache */
   for(i = 0; i < ninterpolationTables; ++i)
-    if(InterpolationTable_compare(interpolationTables[i],fileName,tableName,table))
+    if(interpolationTables[i] && InterpolationTable_compare(interpolationTables[i],startTime,ipoType,expoType,fileName,tableName,table,tableDim1,tableDim2))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
 #endif
+      interpolationTables[i]->refs++;
       return i;
     }
 #ifdef INFOS
@@ -161,6 +189,8 @@ int omcTableTimeIni(double timeIn, double startTime,int ipoType,int expoType,
   free(interpolationTables);
   interpolationTables = tmp;
   ninterpolationTables++;
+  /* stays NULL if reading the table raises an error */
+  interpolationTables[ninterpolationTables-1] = NULL;
   /* otherwise initialize new table */
   interpolationTables[ninterpolationTables-1] = InterpolationTable_init(timeIn,startTime,
                    ipoType,expoType,
@@ -176,14 +206,23 @@ void omcTableTimeIpoClose(int tableID)
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables && interpolationTables[tableID])
   {
-    InterpolationTable_deinit(interpolationTables[tableID]);
-    interpolationTables[tableID] = NULL;
-    ninterpolationTables--;
+    /* the table may be shared by several blocks, see omcTableTimeIni */
+    if(--interpolationTables[tableID]->refs == 0)
+    {
+      InterpolationTable_deinit(interpolationTables[tableID]);
+      interpolationTables[tableID] = NULL;
+    }
   }
-  if(ninterpolationTables <=0)
+  /* table ids stay valid until all tables are closed */
+  while(ninterpolationTables > 0 && !interpolationTables[ninterpolationTables-1])
+    ninterpolationTables--;
+  if(ninterpolationTables <= 0)
+  {
     free(interpolationTables);
+    interpolationTables = NULL;
+  }
 }
 
 
@@ -192,7 +231,7 @@ double omcTableTimeIpo(int tableID, int icol, double timeIn)
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,icol,timeIn);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables && interpolationTables[tableID])
   {
     return InterpolationTable_interpolate(interpolationTables[tableID],timeIn,icol-1);
   }
@@ -206,7 +245,7 @@ double omcTableTimeTmax(int tableID)
 #ifdef INFOS
   infoStreamPrint("Time max from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables && interpolationTables[tableID])
     return InterpolationTable_maxTime(interpolationTables[tableID]);
   else
     return 0.0;
@@ -218,7 +257,7 @@ double omcTableTimeTmin(int tableID)
 #ifdef INFOS
   infoStreamPrint("Time min from Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables && interpolationTables[tableID])
     return InterpolationTable_minTime(interpolationTables[tableID]);
   else
     return 0.0;
@@ -233,13 +272,14 @@ int omcTable2DIni(int ipoType, const char *tableName, const char* fileName,
 #ifdef INFOS
   infoStreamPrint("Init Table \n ipoType %f \n tableName %f \n fileName %d \n table %p \n tableDim1 %d \n tableDim2 %d \n colWise %d", ipoType, tableName, fileName, table, tableDim1, tableDim2, colWise);
 #endif
-  /* if table is already initialized, find it */
+  /* if table is already initialized, find it; the blocks then share its lookup cache */
   for(i = 0; i < ninterpolationTables2D; ++i)
-    if(InterpolationTable2D_compare(interpolationTables2D[i],fileName,tableName,table))
+    if(interpolationTables2D[i] && InterpolationTable2D_compare(interpolationTables2D[i],ipoType,fileName,tableName,table,tableDim1,tableDim2))
     {
 #ifdef INFOS
       infoStreamPrint("Table id = %d",i);
 #endif
+      interpolationTables2D[i]->refs++;
       return i;
     }
 #ifdef INFOS
@@ -257,6 +297,8 @@ int omcTable2DIni(int ipoType, const char *tableName, const char* fileName,
   free(interpolationTables2D);
   interpolationTables2D = tmp;
   ninterpolationTables2D++;
+  /* stays NULL if reading the table raises an error */
+  interpolationTables2D[ninterpolationTables2D-1] = NULL;
   /* otherwise initialize new table */
   interpolationTables2D[ninterpolationTables2D-1] = InterpolationTable2D_init(ipoType,tableName,
                       fileName,table,tableDim1,tableDim2,colWise);
@@ -269,14 +311,23 @@ void omcTable2DIpoClose(int tableID)
 #ifdef INFOS
   infoStreamPrint("Close Table[%d]",tableID);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables2D && interpolationTables2D[tableID])
   {
-    InterpolationTable2D_deinit(interpolationTables2D[tableID]);
-    interpolationTables2D[tableID] = NULL;
-    ninterpolationTables2D--;
+    /* the table may be shared by several blocks, see omcTable2DIni */
+    if(--interpolationTables2D[tableID]->refs == 0)
+    {
+      InterpolationTable2D_deinit(interpolationTables2D[tableID]);
+      interpolationTables2D[tableID] = NULL;
+    }
   }
-  if(ninterpolationTables2D <=0)
+  /* table ids stay valid until all tables are closed */
+  while(ninterpolationTables2D > 0 && !interpolationTables2D[ninterpolationTables2D-1])
+    ninterpolationTables2D--;
+  if(ninterpolationTables2D <= 0)
+  {
     free(interpolationTables2D);
+    interpolationTables2D = NULL;
+  }
 }
 
 
@@ -285,7 +336,7 @@ double omcTable2DIpo(int tableID,double u1_, double u2_)
 #ifdef INFOS
   infoStreamPrint("Interpolate Table[%d][%d] add Time %f",tableID,u1_,u2_);
 #endif
-  if(tableID >= 0 && tableID < (int)ninterpolationTables2D)
+  if(tableID >= 0 && tableID < (int)ninterpolationTables2D && interpolationTables2D[tableID])
     return InterpolationTable2D_interpolate(interpolationTables2D[tableID], u1_, u2_);
   else
     return 0.0;
@@ -1029,6 +1080,74 @@ static char *copyTableNameFile(const char *name)
   return dst;
 }
 
+/*
+  tables read from files, shared by all InterpolationTables using the same table of the same file
+*/
+
+static double* TableData_open(const char* fileName, const char* tableName, size_t *rows, size_t *cols)
+{
+  int i;
+  double *data = NULL;
+  TableData *td, **tmp;
+  for(i = 0; i < ntableData; ++i)
+  {
+    td = tableData[i];
+    if(!strcmp(td->filename,fileName) && !strcmp(td->tablename,tableName))
+    {
+      td->refs++;
+      *rows = td->rows;
+      *cols = td->cols;
+      return td->data;
+    }
+  }
+  tmp = (TableData**)realloc(tableData,(ntableData+1)*sizeof(TableData*));
+  if (!tmp) {
+    ModelicaFormatError("Not enough memory for Table: %s",tableName);
+  }
+  tableData = tmp;
+  /* openFile raises an error if the table can not be read, so nothing is allocated before */
+  openFile(fileName,tableName,rows,cols,&data);
+  td = (TableData*)calloc(1,sizeof(TableData));
+  if (!td) {
+    free(data);
+    ModelicaFormatError("Not enough memory for Table: %s",tableName);
+  }
+  td->data = data;
+  td->rows = *rows;
+  td->cols = *cols;
+  td->filename = copyTableNameFile(fileName);
+  td->tablename = copyTableNameFile(tableName);
+  td->refs = 1;
+  tableData[ntableData++] = td;
+  return td->data;
+}
+
+static void TableData_release(double *data)
+{
+  int i;
+  for(i = 0; i < ntableData; ++i)
+  {
+    TableData *td = tableData[i];
+    if(td->data == data)
+    {
+      if(--td->refs == 0)
+      {
+        free(td->data);
+        free(td->filename);
+        free(td->tablename);
+        free(td);
+        tableData[i] = tableData[--ntableData];
+        if(ntableData == 0)
+        {
+          free(tableData);
+          tableData = NULL;
+        }
+      }
+      return;
+    }
+  }
+}
+
 static InterpolationTable* InterpolationTable_init(double time, double startTime,
                int ipoType, int expoType,
                const char* tableName, const char* fileName,
@@ -1049,14 +1168,15 @@ static InterpolationTable* InterpolationTable_init(double time, double startTime
     tpl->ipoType = ipoType;
     tpl->expoType = expoType;
     tpl->startTime = startTime;
+    tpl->refs = 1;
 
     tpl->tablename = copyTableNameFile(tableName);
     tpl->filename = copyTableNameFile(fileName);
 
     if(fileName && strncmp("NoName",fileName,6) != 0)
     {
-      openFile(fileName,tableName,&(tpl->rows),&(tpl->cols),&(tpl->data));
-      tpl->own_data = 1;
+      tpl->data = TableData_open(fileName,tableName,&(tpl->rows),&(tpl->cols));
+      tpl->shared_data = 1;
     } else
     {
 #ifndef COPY_ARRAYS
@@ -1089,8 +1209,12 @@ static void InterpolationTable_deinit(InterpolationTable *tpl)
 {
   if(tpl)
   {
-    if(tpl->own_data)
+    if(tpl->shared_data)
+      TableData_release(tpl->data);
+    else if(tpl->own_data)
       free(tpl->data);
+    free(tpl->filename);
+    free(tpl->tablename);
     free(tpl);
   }
 }
@@ -1112,14 +1236,12 @@ static double InterpolationTable_interpolate(InterpolationTable *tpl, double tim
   if(time < InterpolationTable_minTime(tpl))
     return InterpolationTable_extrapolate(tpl,time,col,time <= InterpolationTable_minTime(tpl));
 
-  for(i = 0; i < lastIdx; ++i) {
-    if(InterpolationTable_getElt(tpl,i,0) > time) {
-      if(tpl->ipoType == 1 || lastIdx==2)
-        return InterpolationTable_interpolateLin(tpl,time, i-1,col);
-      else if(tpl->ipoType == 2){
-        return InterpolationTable_interpolateSpline(tpl,time, i-1,col);
-      }
-    }
+  i = InterpolationTable_findInterval(tpl,time,lastIdx);
+  if(i+1 < lastIdx) {
+    if(tpl->ipoType == 1 || lastIdx==2)
+      return InterpolationTable_interpolateLin(tpl,time,i,col);
+    else if(tpl->ipoType == 2)
+      return InterpolationTable_interpolateSpline(tpl,time,i,col);
   }
   return InterpolationTable_extrapolate(tpl,time,col,time <= InterpolationTable_minTime(tpl));
 }
@@ -1133,19 +1255,53 @@ static double InterpolationTable_minTime(InterpolationTable *tpl)
   return (tpl->data?tpl->data[0]:0.0);
 }
 
-static char InterpolationTable_compare(InterpolationTable *tpl, const char* fname, const char* tname,
-         const double* table)
+/*
+  Returns the index i of the last row with t_i <= time, i.e. the interval [t_i,t_i+1) containing
+  time, or lastIdx-1 if time is after the last row. Expects time >= t_0.
+  The interval of the previous call and the following one are checked first, so the usual
+  monotonic queries (every column at the same time, time advancing) do not search the table.
+  Blocks with equal tables get the same table id from omcTableTimeIni and share this cache.
+  If they look up different times in turn, every lookup falls back to the binary search;
+  the result is the same, only slower.
+*/
+static size_t InterpolationTable_findInterval(InterpolationTable *tpl, double time, size_t lastIdx)
 {
-  if( (fname == NULL || tname == NULL) || ((strncmp("NoName",fname,6) == 0 && strncmp("NoName",tname,6) == 0)) )
+  size_t lo = tpl->lastIdx, hi, mid;
+
+  if(lo+1 < lastIdx && InterpolationTable_getElt(tpl,lo,0) <= time)
   {
-    /* table passed as memory location */
-    return (tpl->data == table);
+    if(time < InterpolationTable_getElt(tpl,lo+1,0))
+      return lo;
+    if(lo+2 < lastIdx && time < InterpolationTable_getElt(tpl,lo+2,0))
+      return (tpl->lastIdx = lo+1);
+  }
+  /* binary search for the first row with t > time */
+  lo = 0;
+  hi = lastIdx;
+  while(hi - lo > 1)
+  {
+    mid = lo + (hi - lo)/2;
+    if(InterpolationTable_getElt(tpl,mid,0) > time)
+      hi = mid;
+    else
+      lo = mid;
   }
-  else
+  return (tpl->lastIdx = lo);
+}
+
+static char InterpolationTable_compare(InterpolationTable *tpl, double startTime, int ipoType, int expoType,
+         const char* fname, const char* tname, const double* table, int tableDim1, int tableDim2)
+{
+  if(tpl->startTime != startTime || tpl->ipoType != ipoType || tpl->expoType != expoType)
+    return 0;
+  if(fname && strncmp("NoName",fname,6) != 0)
   {
     /* table loaded from file */
-    return ((!strncmp(tpl->filename,fname,6)) && (!strncmp(tpl->tablename,tname,6)));
+    return tpl->shared_data && !strcmp(tpl->filename,fname) && !strcmp(tpl->tablename,tname);
   }
+  /* table passed as memory location, compare the contents as the data is copied */
+  return !tpl->shared_data && tpl->rows == (size_t)tableDim1 && tpl->cols == (size_t)tableDim2 &&
+         (tpl->data == table || !memcmp(tpl->data,table,tpl->rows*tpl->cols*sizeof(double)));
 }
 
 static double InterpolationTable_extrapolate(InterpolationTable *tpl, double time, size_t col,
@@ -1318,14 +1474,15 @@ static InterpolationTable2D* InterpolationTable2D_init(int ipoType, const char*
     tpl->cols = tableDim2;
     tpl->colWise = colWise;
     tpl->ipoType = ipoType;
+    tpl->refs = 1;
 
     tpl->tablename = copyTableNameFile(tableName);
     tpl->filename = copyTableNameFile(fileName);
 
     if(fileName && strncmp("NoName",fileName,6) != 0)
     {
-      openFile(fileName,tableName,&(tpl->rows),&(tpl->cols),&(tpl->data));
-      tpl->own_data = 1;
+      tpl->data = TableData_open(fileName,tableName,&(tpl->rows),&(tpl->cols));
+      tpl->shared_data = 1;
     } else {
 #ifndef COPY_ARRAYS
       if (!table) {
@@ -1356,8 +1513,12 @@ static void InterpolationTable2D_deinit(InterpolationTable2D *table)
 {
   if(table)
   {
-    if(table->own_data)
+    if(table->shared_data)
+      TableData_release(table->data);
+    else if(table->own_data)
       free(table->data);
+    free(table->filename);
+    free(table->tablename);
     free(table);
   }
 }
@@ -1539,8 +1700,7 @@ static double InterpolationTable2D_interpolate(InterpolationTable2D *table, doub
       return InterpolationTable2D_getElt(table,1,1);
     }
     /* find interval corresponding x1 */
-    for(i = 2; i < table->rows; ++i)
-      if(InterpolationTable2D_getElt(table,i,0) >= x1) break;
+    i = InterpolationTable2D_findIndex(table,1,x1,table->rows,&table->lastRow);
     if((table->ipoType == 2) && (table->rows > 3))
     {
       /* smooth interpolation with Akima Splines such that der(y) is continuous */
@@ -1564,8 +1724,7 @@ static double InterpolationTable2D_interpolate(InterpolationTable2D *table, doub
   if(table->rows == 2)
   {
     /* find interval corresponding x2 */
-    for(j = 2; j < table->cols; ++j)
-      if(InterpolationTable2D_getElt(table,0,j) >= x2) break;
+    j = InterpolationTable2D_findIndex(table,0,x2,table->cols,&table->lastCol);
 
     if((table->ipoType == 2) && (table->cols > 3))
     {
@@ -1588,10 +1747,8 @@ static double InterpolationTable2D_interpolate(InterpolationTable2D *table, doub
   }
 
   /* find intervals corresponding x1 and x2 */
-  for(i = 2; i < table->rows-1; ++i)
-    if(InterpolationTable2D_getElt(table,i,0) >= x1) break;
-  for(j = 2; j < table->cols-1; ++j)
-    if(InterpolationTable2D_getElt(table,0,j) >= x2) break;
+  i = InterpolationTable2D_findIndex(table,1,x1,table->rows-1,&table->lastRow);
+  j = InterpolationTable2D_findIndex(table,0,x2,table->cols-1,&table->lastCol);
 
   if((table->ipoType == 2) && (table->rows != 3) && (table->cols != 3)  )
   {
@@ -1641,19 +1798,44 @@ static double InterpolationTable2D_interpolate(InterpolationTable2D *table, doub
   return InterpolationTable2D_linInterpolate(x2,InterpolationTable2D_getElt(table,0,j-1),InterpolationTable2D_getElt(table,0,j),f_1,f_2);
 }
 
-static char InterpolationTable2D_compare(InterpolationTable2D *tpl, const char* fname, const char* tname, const double* table)
+/*
+  Returns the first index k in [2,end) with x <= row (or column) k of the first column (row),
+  or end if there is none. Starts at the index of the previous call, see
+  InterpolationTable_findInterval.
+*/
+static size_t InterpolationTable2D_findIndex(InterpolationTable2D *tpl, char row, double x, size_t end, size_t *last)
 {
-  if( (fname == NULL || tname == NULL) || ((strncmp("NoName",fname,6) == 0 && strncmp("NoName",tname,6) == 0)) )
+  size_t lo = *last, hi, mid;
+
+  if(lo >= 2 && lo < end && x <= (row ? InterpolationTable2D_getElt(tpl,lo,0) : InterpolationTable2D_getElt(tpl,0,lo)) &&
+     (lo == 2 || x > (row ? InterpolationTable2D_getElt(tpl,lo-1,0) : InterpolationTable2D_getElt(tpl,0,lo-1))))
+    return lo;
+  lo = 2;
+  hi = end;
+  while(lo < hi)
   {
-    /* table passed as memory location */
-    return (tpl->data == table);
+    mid = lo + (hi - lo)/2;
+    if(x <= (row ? InterpolationTable2D_getElt(tpl,mid,0) : InterpolationTable2D_getElt(tpl,0,mid)))
+      hi = mid;
+    else
+      lo = mid + 1;
   }
-  else
+  return (*last = lo);
+}
+
+static char InterpolationTable2D_compare(InterpolationTable2D *tpl, int ipoType, const char* fname, const char* tname,
+           const double* table, int tableDim1, int tableDim2)
+{
+  if(tpl->ipoType != ipoType)
+    return 0;
+  if(fname && strncmp("NoName",fname,6) != 0)
   {
     /* table loaded from file */
-    return ((!strncmp(tpl->filename,fname,6)) && (!strncmp(tpl->tablename,tname,6)));
+    return tpl->shared_data && !strcmp(tpl->filename,fname) && !strcmp(tpl->tablename,tname);
   }
-  return 0;
+  /* table passed as memory location, compare the contents as the data is copied */
+  return !tpl->shared_data && tpl->rows == (size_t)tableDim1 && tpl->cols == (size_t)tableDim2 &&
+         (tpl->data == table || !memcmp(tpl->data,table,tpl->rows*tpl->cols*sizeof(double)));
 }
 
 static double InterpolationTable2D_linInterpolate(double x, double x_1, double x_2, double f_1, double f_2)
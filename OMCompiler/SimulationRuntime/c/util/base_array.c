@@ -307,32 +307,32 @@ size_t calc_base_index(int ndims, const _index_t *idx_vec, const base_array_t *a
 
 size_t calc_base_index_dims_subs(int ndims,...)
 {
-
     int i;
-    size_t index;
-
-    _index_t *dims = (_index_t*)omc_alloc_interface.malloc(sizeof(_index_t)*ndims);
-    _index_t *subs = (_index_t*)omc_alloc_interface.malloc(sizeof(_index_t)*ndims);
-
-    va_list ap;
-    va_start(ap,ndims);
-    for(i = 0; i < ndims; ++i) {
-        dims[i] = va_arg(ap, _index_t);
-    }
+    size_t index = 0;
+    _index_t dim, sub;
+    va_list dims, subs;
+
+    /* The dimensions are followed by the subscripts; walk both lists in
+     * parallel so that no temporary arrays are needed. This is called for
+     * every element access with variable subscripts in generated code. */
+    va_start(dims, ndims);
+    va_copy(subs, dims);
     for(i = 0; i < ndims; ++i) {
-        subs[i] = va_arg(ap, _index_t) - 1;
+        (void) va_arg(subs, _index_t);
     }
-    va_end(ap);
-
-    index = 0;
     for(i = 0; i < ndims; ++i) {
-        if (subs[i] < 0 || subs[i] >= dims[i]) {
+        dim = va_arg(dims, _index_t);
+        sub = va_arg(subs, _index_t) - 1;
+        if (sub < 0 || sub >= dim) {
           FILE_INFO info = omc_dummyFileInfo;
-          omc_assert(NULL, info, "Dimension %d has bounds 1..%d, got array subscript %d", i+1, dims[i], subs[i]+1);
+          va_end(subs);
+          va_end(dims);
+          omc_assert(NULL, info, "Dimension %d has bounds 1..%ld, got array subscript %ld", i+1, (long) dim, (long) sub+1);
         }
-        index = (index * dims[i]) + subs[i];
+        index = (index * dim) + sub;
     }
-
+    va_end(subs);
+    va_end(dims);
 
     return index;
 }
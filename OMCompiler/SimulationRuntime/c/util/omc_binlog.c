@@ -0,0 +1,683 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "omc_binlog.h"
+#include "omc_error.h"
+#include "rtclock.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BINLOG_BUFFER_SIZE   65536  /* per-thread buffer, flushed as one chunk */
+#define BINLOG_MAX_ARGS      32     /* formats with more arguments are formatted eagerly */
+#define BINLOG_MAX_STRING    4095   /* longer string arguments are truncated */
+#define BINLOG_CACHE_SIZE    256    /* per-thread format lookup cache */
+#define BINLOG_HASH_BITS     12     /* size of the match table of the chunk compression */
+
+typedef struct BINLOG_FORMAT
+{
+  const char *format;
+  unsigned long id;
+  int nArgs;                        /* -1 if the format can't be deferred */
+  unsigned char args[BINLOG_MAX_ARGS];
+  unsigned char isUnsigned[BINLOG_MAX_ARGS];
+} BINLOG_FORMAT;
+
+/* The buffer of a thread is filled by its owner and written by the owner or by
+ * omc_binlog_close, both under the lock of the thread. Whoever needs both locks
+ * takes binlogLock first. */
+typedef struct BINLOG_THREAD
+{
+  pthread_mutex_t lock;
+  int open;                         /* 0 if the log was closed since the thread registered */
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+  unsigned char *packed;            /* compressed chunk */
+  size_t packedCapacity;
+  unsigned long id;
+  uint64_t lastTime;                /* timestamps are stored as delta to the previous record */
+  const char *cacheKey[BINLOG_CACHE_SIZE];
+  BINLOG_FORMAT *cacheValue[BINLOG_CACHE_SIZE];
+  struct BINLOG_THREAD *next;
+} BINLOG_THREAD;
+
+static pthread_mutex_t binlogLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t binlogOnce = PTHREAD_ONCE_INIT;
+
+/* everything but the key is reset when the log is closed */
+static struct {
+  FILE *file;
+  pthread_key_t key;
+  rtclock_t origin;
+  BINLOG_THREAD *threads;
+  unsigned long nThreads;
+  BINLOG_FORMAT **formats;          /* open addressing hash table on the format pointer */
+  size_t formatsSize;
+  unsigned long nFormats;
+} binlog;
+
+static inline size_t hashPointer(const void *p)
+{
+  uint64_t h = (uint64_t)(uintptr_t)p;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (size_t)h;
+}
+
+static inline unsigned char* putVarint(unsigned char *p, uint64_t v)
+{
+  while (v >= 0x80) {
+    *p++ = (unsigned char)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (unsigned char)v;
+  return p;
+}
+
+static inline unsigned char* putSigned(unsigned char *p, int64_t v)
+{
+  return putVarint(p, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+static inline unsigned char* putDouble(unsigned char *p, double d)
+{
+  uint64_t bits;
+  int i;
+  memcpy(&bits, &d, sizeof(bits));
+  for (i = 0; i < 8; i++) {
+    *p++ = (unsigned char)(bits >> (8*i));
+  }
+  return p;
+}
+
+static inline unsigned char* putLength(unsigned char *p, size_t len)
+{
+  for (; len >= 255; len -= 255) {
+    *p++ = 255;
+  }
+  *p++ = (unsigned char) len;
+  return p;
+}
+
+static unsigned char* putSequence(unsigned char *p, const unsigned char *literals, size_t nLiterals, size_t offset, size_t matchLength)
+{
+  unsigned char *token = p++;
+  *token = (unsigned char) ((nLiterals < 15 ? nLiterals : 15) << 4);
+  if (nLiterals >= 15) {
+    p = putLength(p, nLiterals - 15);
+  }
+  memcpy(p, literals, nLiterals);
+  p += nLiterals;
+  if (matchLength) {
+    matchLength -= OMC_BINLOG_MIN_MATCH;
+    *token |= (unsigned char) (matchLength < 15 ? matchLength : 15);
+    *p++ = (unsigned char) offset;
+    *p++ = (unsigned char) (offset >> 8);
+    if (matchLength >= 15) {
+      p = putLength(p, matchLength - 15);
+    }
+  }
+  return p;
+}
+
+/* Compresses n bytes of src into dst (see OMC_BINLOG_TAG_PACKED), which needs
+ * room for n + n/255 + 16 bytes. Returns the compressed size. */
+static size_t compress(const unsigned char *src, size_t n, unsigned char *dst)
+{
+  uint32_t table[1 << BINLOG_HASH_BITS] = {0}; /* last position+1 of every hashed 4-byte sequence */
+  size_t ip = 0, anchor = 0;
+  unsigned char *p = dst;
+
+  while (ip + OMC_BINLOG_MIN_MATCH <= n) {
+    uint32_t v, h;
+    size_t ref;
+    memcpy(&v, src + ip, sizeof(v));
+    h = (v * 2654435761U) >> (32 - BINLOG_HASH_BITS);
+    ref = table[h];
+    table[h] = (uint32_t) (ip + 1);
+    if (ref && ip + 1 - ref <= 65535 && 0 == memcmp(src + ref - 1, src + ip, OMC_BINLOG_MIN_MATCH)) {
+      size_t len = OMC_BINLOG_MIN_MATCH;
+      ref--;
+      while (ip + len < n && src[ref + len] == src[ip + len]) {
+        len++;
+      }
+      p = putSequence(p, src + anchor, ip - anchor, ip - ref, len);
+      ip += len;
+      anchor = ip;
+    } else {
+      ip++;
+    }
+  }
+  /* the last sequence only has literals */
+  p = putSequence(p, src + anchor, n - anchor, 0, 0);
+  return p - dst;
+}
+
+/* requires binlogLock and thread->lock */
+static void writeChunk(BINLOG_THREAD *thread)
+{
+  unsigned char header[32], *p = header;
+  size_t needed = thread->size + thread->size/255 + 16, packedSize = 0;
+  if (thread->size == 0) {
+    return;
+  }
+  if (needed > thread->packedCapacity) {
+    free(thread->packed);
+    thread->packed = (unsigned char*) malloc(needed);
+    thread->packedCapacity = thread->packed ? needed : 0;
+  }
+  if (thread->packed) {
+    packedSize = compress(thread->data, thread->size, thread->packed);
+  }
+  if (packedSize && packedSize < thread->size) {
+    *p++ = OMC_BINLOG_TAG_PACKED;
+    p = putVarint(p, thread->id);
+    p = putVarint(p, thread->size);
+    p = putVarint(p, packedSize);
+    fwrite(header, 1, p - header, binlog.file);
+    fwrite(thread->packed, 1, packedSize, binlog.file);
+  } else {
+    *p++ = OMC_BINLOG_TAG_CHUNK;
+    p = putVarint(p, thread->id);
+    p = putVarint(p, thread->size);
+    fwrite(header, 1, p - header, binlog.file);
+    fwrite(thread->data, 1, thread->size, binlog.file);
+  }
+  thread->size = 0;
+}
+
+static void threadExit(void *ptr)
+{
+  BINLOG_THREAD *thread = (BINLOG_THREAD*) ptr, **it;
+  pthread_mutex_lock(&binlogLock);
+  pthread_mutex_lock(&thread->lock);
+  if (thread->open) {
+    writeChunk(thread);
+    for (it = &binlog.threads; *it; it = &(*it)->next) {
+      if (*it == thread) {
+        *it = thread->next;
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&thread->lock);
+  pthread_mutex_unlock(&binlogLock);
+  pthread_mutex_destroy(&thread->lock);
+  free(thread->data);
+  free(thread->packed);
+  free(thread);
+}
+
+static void createKey(void)
+{
+  pthread_key_create(&binlog.key, threadExit);
+}
+
+/* Returns the buffer of the calling thread with its lock held, or NULL if the log
+ * is closed. A thread that logged to a previous (closed) log starts over. */
+static BINLOG_THREAD* lockThread(void)
+{
+  BINLOG_THREAD *thread = (BINLOG_THREAD*) pthread_getspecific(binlog.key);
+  if (thread) {
+    pthread_mutex_lock(&thread->lock);
+    if (thread->open) {
+      return thread;
+    }
+    pthread_mutex_unlock(&thread->lock);
+  }
+
+  pthread_mutex_lock(&binlogLock);
+  if (!binlog.file) {
+    pthread_mutex_unlock(&binlogLock);
+    return NULL;
+  }
+  if (!thread) {
+    thread = (BINLOG_THREAD*) calloc(1, sizeof(BINLOG_THREAD));
+    pthread_mutex_init(&thread->lock, NULL);
+    thread->capacity = BINLOG_BUFFER_SIZE;
+    thread->data = (unsigned char*) malloc(thread->capacity);
+    pthread_setspecific(binlog.key, thread);
+  }
+  pthread_mutex_lock(&thread->lock);
+  thread->open = 1;
+  thread->size = 0;
+  thread->lastTime = 0;
+  memset(thread->cacheKey, 0, sizeof(thread->cacheKey));
+  thread->id = binlog.nThreads++;
+  thread->next = binlog.threads;
+  binlog.threads = thread;
+  pthread_mutex_unlock(&binlogLock);
+  return thread;
+}
+
+/* Takes binlogLock while keeping the lock order; returns 0 (with only the
+ * thread lock held) if the log was closed in between. */
+static int lockLog(BINLOG_THREAD *thread)
+{
+  pthread_mutex_unlock(&thread->lock);
+  pthread_mutex_lock(&binlogLock);
+  pthread_mutex_lock(&thread->lock);
+  if (!thread->open) {
+    pthread_mutex_unlock(&binlogLock);
+    return 0;
+  }
+  return 1;
+}
+
+/* Makes sure the thread buffer has room for n more bytes; returns 0 if the log was
+ * closed meanwhile. Requires thread->lock, which is still held afterwards. */
+static inline int reserve(BINLOG_THREAD *thread, size_t n)
+{
+  if (thread->size + n <= thread->capacity) {
+    return 1;
+  }
+  if (!lockLog(thread)) {
+    return 0;
+  }
+  writeChunk(thread);
+  pthread_mutex_unlock(&binlogLock);
+  if (n > thread->capacity) {
+    thread->capacity = n;
+    thread->data = (unsigned char*) realloc(thread->data, thread->capacity);
+  }
+  return 1;
+}
+
+/* The arguments of a format are analyzed once, when it is registered */
+static BINLOG_FORMAT* compileFormat(const char *format)
+{
+  BINLOG_FORMAT *entry = (BINLOG_FORMAT*) calloc(1, sizeof(BINLOG_FORMAT));
+  OMC_BINLOG_SPEC spec;
+  const char *p = format;
+
+  entry->format = format;
+  while ((p = omc_binlog_nextSpec(p, &spec)) != NULL && entry->nArgs >= 0) {
+    int needed = spec.widthStar + spec.precisionStar + (spec.arg != OMC_BINLOG_ARG_NONE);
+    if (spec.arg == OMC_BINLOG_ARG_INVALID || entry->nArgs + needed > BINLOG_MAX_ARGS) {
+      entry->nArgs = -1;
+      break;
+    }
+    if (spec.widthStar) {
+      entry->args[entry->nArgs++] = OMC_BINLOG_ARG_INT;
+    }
+    if (spec.precisionStar) {
+      entry->args[entry->nArgs++] = OMC_BINLOG_ARG_INT;
+    }
+    if (spec.arg != OMC_BINLOG_ARG_NONE) {
+      entry->isUnsigned[entry->nArgs] = (unsigned char) spec.isUnsigned;
+      entry->args[entry->nArgs++] = (unsigned char) spec.arg;
+    }
+  }
+  return entry;
+}
+
+/* requires binlogLock */
+static void insertFormat(BINLOG_FORMAT *entry)
+{
+  size_t i;
+  if (2*(binlog.nFormats + 1) > binlog.formatsSize) {
+    BINLOG_FORMAT **old = binlog.formats;
+    size_t oldSize = binlog.formatsSize;
+    binlog.formatsSize = oldSize ? 2*oldSize : 1024;
+    binlog.formats = (BINLOG_FORMAT**) calloc(binlog.formatsSize, sizeof(BINLOG_FORMAT*));
+    for (i = 0; i < oldSize; i++) {
+      if (old[i]) {
+        size_t j = hashPointer(old[i]->format) & (binlog.formatsSize - 1);
+        while (binlog.formats[j]) j = (j + 1) & (binlog.formatsSize - 1);
+        binlog.formats[j] = old[i];
+      }
+    }
+    free(old);
+  }
+  i = hashPointer(entry->format) & (binlog.formatsSize - 1);
+  while (binlog.formats[i]) i = (i + 1) & (binlog.formatsSize - 1);
+  binlog.formats[i] = entry;
+  binlog.nFormats++;
+}
+
+/* Format strings are identified by their address. Only string literals are
+ * looked up here, the text behind their address never changes. Every new
+ * format is written to the file before any chunk that uses it.
+ * Requires thread->lock; returns NULL if the log was closed meanwhile. */
+static BINLOG_FORMAT* lookupFormat(BINLOG_THREAD *thread, const char *format)
+{
+  size_t slot = hashPointer(format) & (BINLOG_CACHE_SIZE - 1), i;
+  BINLOG_FORMAT *entry = NULL;
+
+  if (thread->cacheKey[slot] == format) {
+    return thread->cacheValue[slot];
+  }
+
+  if (!lockLog(thread)) {
+    return NULL;
+  }
+  if (binlog.formatsSize) {
+    for (i = hashPointer(format) & (binlog.formatsSize - 1); binlog.formats[i]; i = (i + 1) & (binlog.formatsSize - 1)) {
+      if (binlog.formats[i]->format == format) {
+        entry = binlog.formats[i];
+        break;
+      }
+    }
+  }
+  if (!entry) {
+    unsigned char header[32], *p = header;
+    size_t len = strlen(format);
+    entry = compileFormat(format);
+    entry->id = binlog.nFormats;
+    insertFormat(entry);
+    *p++ = OMC_BINLOG_TAG_FORMAT;
+    p = putVarint(p, entry->id);
+    p = putVarint(p, len);
+    fwrite(header, 1, p - header, binlog.file);
+    fwrite(format, 1, len, binlog.file);
+  }
+  pthread_mutex_unlock(&binlogLock);
+
+  thread->cacheKey[slot] = format;
+  thread->cacheValue[slot] = entry;
+  return entry;
+}
+
+static inline unsigned char* putHeader(BINLOG_THREAD *thread, unsigned char *p, int tag)
+{
+  uint64_t now = (uint64_t) (rt_ext_tp_tock(&binlog.origin) * 1e9);
+  /* the clock might not be monotonic on all platforms */
+  if (now < thread->lastTime) {
+    now = thread->lastTime;
+  }
+  *p++ = (unsigned char) tag;
+  p = putVarint(p, now - thread->lastTime);
+  thread->lastTime = now;
+  return p;
+}
+
+static inline unsigned char* putIndexes(unsigned char *p, const int *indexes)
+{
+  int i;
+  if (!indexes) {
+    return putVarint(p, 0);
+  }
+  p = putVarint(p, indexes[0]);
+  for (i = 1; i <= indexes[0]; i++) {
+    p = putSigned(p, indexes[i]);
+  }
+  return p;
+}
+
+void omc_binlog_message(int type, int stream, int indentNext, const int *indexes, int isLiteral, const char *format, va_list args)
+{
+  BINLOG_THREAD *thread;
+  BINLOG_FORMAT *entry;
+  const char *strings[BINLOG_MAX_ARGS];
+  size_t lengths[BINLOG_MAX_ARGS];
+  size_t needed = 64 + (indexes ? 10*indexes[0] : 0);
+  unsigned char *p;
+  va_list copy;
+  int i;
+
+  if (type == LOG_TYPE_ERROR || type == LOG_TYPE_ASSERT) {
+    /* errors stay visible on the console */
+    va_copy(copy, args);
+    fprintf(stderr, "%-17s | %-7s | ", LOG_STREAM_NAME[stream], LOG_TYPE_DESC[type]);
+    vfprintf(stderr, format, copy);
+    fputc('\n', stderr);
+    va_end(copy);
+  }
+
+  thread = lockThread();
+  if (!thread) {
+    return;
+  }
+  /* a format that is not a literal (a buffer) may change behind its address */
+  entry = isLiteral ? lookupFormat(thread, format) : NULL;
+  if (isLiteral && !entry) {
+    pthread_mutex_unlock(&thread->lock);
+    return;
+  }
+
+  if (!entry || entry->nArgs < 0) {
+    int len;
+    va_copy(copy, args);
+    len = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if (len < 0) {
+      len = 0;
+    }
+    /* the message is formatted directly into the buffer, with room for the terminating 0 */
+    if (reserve(thread, needed + len + 1)) {
+      p = putHeader(thread, thread->data + thread->size, OMC_BINLOG_REC_TEXT);
+      *p++ = (unsigned char) type;
+      p = putVarint(p, stream);
+      *p++ = (unsigned char) indentNext;
+      p = putIndexes(p, indexes);
+      p = putVarint(p, len);
+      if (len) {
+        vsnprintf((char*) p, len + 1, format, args);
+      }
+      thread->size = p + len - thread->data;
+    }
+    pthread_mutex_unlock(&thread->lock);
+    return;
+  }
+
+  /* the strings have to be measured before reserving space */
+  va_copy(copy, args);
+  for (i = 0; i < entry->nArgs; i++) {
+    strings[i] = NULL;
+    switch (entry->args[i]) {
+    case OMC_BINLOG_ARG_INT: (void) va_arg(copy, int); break;
+    case OMC_BINLOG_ARG_LONG: (void) va_arg(copy, long); break;
+    case OMC_BINLOG_ARG_LLONG: (void) va_arg(copy, long long); break;
+    case OMC_BINLOG_ARG_SIZE: (void) va_arg(copy, size_t); break;
+    case OMC_BINLOG_ARG_INTMAX: (void) va_arg(copy, intmax_t); break;
+    case OMC_BINLOG_ARG_PTRDIFF: (void) va_arg(copy, ptrdiff_t); break;
+    case OMC_BINLOG_ARG_DOUBLE: (void) va_arg(copy, double); break;
+    case OMC_BINLOG_ARG_LDOUBLE: (void) va_arg(copy, long double); break;
+    case OMC_BINLOG_ARG_POINTER: (void) va_arg(copy, void*); break;
+    case OMC_BINLOG_ARG_STRING:
+      strings[i] = va_arg(copy, const char*);
+      lengths[i] = strings[i] ? strlen(strings[i]) : 0;
+      if (lengths[i] > BINLOG_MAX_STRING) {
+        lengths[i] = BINLOG_MAX_STRING;
+      }
+      needed += lengths[i];
+      break;
+    }
+    needed += 10;
+  }
+  va_end(copy);
+
+  if (!reserve(thread, needed)) {
+    pthread_mutex_unlock(&thread->lock);
+    return;
+  }
+  p = putHeader(thread, thread->data + thread->size, OMC_BINLOG_REC_MESSAGE);
+  *p++ = (unsigned char) type;
+  p = putVarint(p, stream);
+  *p++ = (unsigned char) indentNext;
+  p = putIndexes(p, indexes);
+  p = putVarint(p, entry->id);
+
+  for (i = 0; i < entry->nArgs; i++) {
+    int u = entry->isUnsigned[i];
+    switch (entry->args[i]) {
+    case OMC_BINLOG_ARG_INT:
+      p = u ? putVarint(p, va_arg(args, unsigned int)) : putSigned(p, va_arg(args, int));
+      break;
+    case OMC_BINLOG_ARG_LONG:
+      p = u ? putVarint(p, va_arg(args, unsigned long)) : putSigned(p, va_arg(args, long));
+      break;
+    case OMC_BINLOG_ARG_LLONG:
+      p = u ? putVarint(p, va_arg(args, unsigned long long)) : putSigned(p, va_arg(args, long long));
+      break;
+    case OMC_BINLOG_ARG_SIZE:
+      p = putVarint(p, va_arg(args, size_t));
+      break;
+    case OMC_BINLOG_ARG_INTMAX:
+      p = u ? putVarint(p, va_arg(args, uintmax_t)) : putSigned(p, va_arg(args, intmax_t));
+      break;
+    case OMC_BINLOG_ARG_PTRDIFF:
+      p = putSigned(p, va_arg(args, ptrdiff_t));
+      break;
+    case OMC_BINLOG_ARG_DOUBLE:
+      p = putDouble(p, va_arg(args, double));
+      break;
+    case OMC_BINLOG_ARG_LDOUBLE:
+      p = putDouble(p, (double) va_arg(args, long double));
+      break;
+    case OMC_BINLOG_ARG_POINTER:
+      p = putVarint(p, (uintptr_t) va_arg(args, void*));
+      break;
+    case OMC_BINLOG_ARG_STRING:
+      (void) va_arg(args, const char*);
+      /* 0 encodes a NULL pointer */
+      p = putVarint(p, strings[i] ? lengths[i] + 1 : 0);
+      if (strings[i]) {
+        memcpy(p, strings[i], lengths[i]);
+        p += lengths[i];
+      }
+      break;
+    }
+  }
+  thread->size = p - thread->data;
+  pthread_mutex_unlock(&thread->lock);
+}
+
+static void recordClose(int stream, int warning)
+{
+  BINLOG_THREAD *thread = lockThread();
+  unsigned char *p;
+  if (!thread) {
+    return;
+  }
+  if (reserve(thread, 32)) {
+    p = putHeader(thread, thread->data + thread->size, OMC_BINLOG_REC_CLOSE);
+    p = putVarint(p, stream);
+    *p++ = (unsigned char) warning;
+    thread->size = p - thread->data;
+  }
+  pthread_mutex_unlock(&thread->lock);
+}
+
+void omc_binlog_messageClose(int stream)
+{
+  if (ACTIVE_STREAM(stream)) {
+    recordClose(stream, 0);
+  }
+}
+
+void omc_binlog_messageCloseWarning(int stream)
+{
+  if (ACTIVE_WARNING_STREAM(stream)) {
+    recordClose(stream, 1);
+  }
+}
+
+/* Opens the log file and writes the header with the names of all streams and
+ * message types, so the decoder does not depend on the runtime version.
+ * Returns 0 on success. */
+int omc_binlog_open(const char *fileName)
+{
+  static int registeredAtExit = 0;
+  unsigned char buf[32], *p;
+  int i;
+
+  pthread_once(&binlogOnce, createKey);
+  pthread_mutex_lock(&binlogLock);
+  if (binlog.file) {
+    pthread_mutex_unlock(&binlogLock);
+    return 1;
+  }
+  binlog.file = fopen(fileName, "wb");
+  if (!binlog.file) {
+    pthread_mutex_unlock(&binlogLock);
+    return 1;
+  }
+  rt_ext_tp_tick(&binlog.origin);
+
+  fwrite(OMC_BINLOG_MAGIC, 1, strlen(OMC_BINLOG_MAGIC), binlog.file);
+  p = putVarint(buf, SIM_LOG_MAX);
+  fwrite(buf, 1, p - buf, binlog.file);
+  for (i = 0; i < SIM_LOG_MAX; i++) {
+    size_t len = strlen(LOG_STREAM_NAME[i]);
+    p = putVarint(buf, len);
+    fwrite(buf, 1, p - buf, binlog.file);
+    fwrite(LOG_STREAM_NAME[i], 1, len, binlog.file);
+  }
+  p = putVarint(buf, LOG_TYPE_MAX);
+  fwrite(buf, 1, p - buf, binlog.file);
+  for (i = 0; i < LOG_TYPE_MAX; i++) {
+    size_t len = strlen(LOG_TYPE_DESC[i]);
+    p = putVarint(buf, len);
+    fwrite(buf, 1, p - buf, binlog.file);
+    fwrite(LOG_TYPE_DESC[i], 1, len, binlog.file);
+  }
+  if (!registeredAtExit) {
+    registeredAtExit = 1;
+    atexit(omc_binlog_close);
+  }
+  pthread_mutex_unlock(&binlogLock);
+  return 0;
+}
+
+/* Writes the pending records of all threads and closes the file. Messages
+ * logged after this are dropped until the log is opened again, e.g. by the
+ * next simulation in the same process; the thread ids and format ids of that
+ * log start from 0 again. */
+void omc_binlog_close(void)
+{
+  BINLOG_THREAD *thread;
+  size_t i;
+  pthread_mutex_lock(&binlogLock);
+  if (binlog.file) {
+    for (thread = binlog.threads; thread; thread = thread->next) {
+      pthread_mutex_lock(&thread->lock);
+      writeChunk(thread);
+      thread->open = 0;
+      pthread_mutex_unlock(&thread->lock);
+    }
+    fclose(binlog.file);
+    for (i = 0; i < binlog.formatsSize; i++) {
+      free(binlog.formats[i]);
+    }
+    free(binlog.formats);
+    binlog.file = NULL;
+    binlog.threads = NULL;
+    binlog.nThreads = 0;
+    binlog.formats = NULL;
+    binlog.formatsSize = 0;
+    binlog.nFormats = 0;
+  }
+  pthread_mutex_unlock(&binlogLock);
+}
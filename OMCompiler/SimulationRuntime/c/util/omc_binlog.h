@@ -0,0 +1,199 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Binary, deferred-format sink for the runtime stream printers.
+ *
+ * With -logFormat=binary the info/warning/error stream printers do not call
+ * vsnprintf. Each message is stored as a record holding the id of its format
+ * string and the raw printf arguments, together with a timestamp and the
+ * stream/type/indentation information needed to restore the text output.
+ * Records are collected in a per-thread buffer and appended to the log file
+ * in chunks when the buffer is full or the log is closed. Integers and
+ * timestamps are stored as variable-length (delta) encoded numbers and every
+ * format string is written only once. Chunks are compressed with a simple
+ * LZ77 scheme (see OMC_BINLOG_TAG_PACKED) when that makes them smaller.
+ *
+ * Only string literals are deferred, since a format is identified by its
+ * address; messages with other formats (e.g. from ModelicaMessage or
+ * assert) are formatted eagerly and stored as text.
+ *
+ * The file is decoded offline with omc_binlog_decode (see
+ * omc_binlog_decode.c), which can also filter by stream, message type,
+ * thread and time.
+ */
+
+#ifndef OMC_BINLOG_H
+#define OMC_BINLOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMC_BINLOG_MAGIC "OMCBLOG1"
+
+/* record tags */
+#define OMC_BINLOG_TAG_FORMAT  'F'  /* format string definition */
+#define OMC_BINLOG_TAG_CHUNK   'C'  /* block of records of one thread */
+#define OMC_BINLOG_TAG_PACKED  'Z'  /* compressed chunk: thread, size, packed size, data */
+
+/* A packed chunk is a sequence of (token, literals, offset, match length):
+ * the high nibble of the token is the number of literals, the low nibble the
+ * match length minus OMC_BINLOG_MIN_MATCH; the value 15 is continued by bytes
+ * that are added as long as they are 255. The 2-byte little-endian offset
+ * counts back from the current position of the unpacked data. The last
+ * sequence has only literals. */
+#define OMC_BINLOG_MIN_MATCH   4
+
+/* record tags inside a chunk */
+#define OMC_BINLOG_REC_MESSAGE 'M'  /* message with deferred format */
+#define OMC_BINLOG_REC_TEXT    'T'  /* message formatted eagerly (unsupported format) */
+#define OMC_BINLOG_REC_CLOSE   'X'  /* messageClose of a stream */
+
+int omc_binlog_open(const char *fileName);
+void omc_binlog_close(void);
+void omc_binlog_message(int type, int stream, int indentNext, const int *indexes, int isLiteral, const char *format, va_list args);
+void omc_binlog_messageClose(int stream);
+void omc_binlog_messageCloseWarning(int stream);
+
+/* Arguments of a printf conversion specification, as stored in the log */
+typedef enum OMC_BINLOG_ARG
+{
+  OMC_BINLOG_ARG_NONE = 0,  /* %% */
+  OMC_BINLOG_ARG_INT,       /* also char and short, which are promoted to int */
+  OMC_BINLOG_ARG_LONG,
+  OMC_BINLOG_ARG_LLONG,
+  OMC_BINLOG_ARG_SIZE,
+  OMC_BINLOG_ARG_INTMAX,
+  OMC_BINLOG_ARG_PTRDIFF,
+  OMC_BINLOG_ARG_DOUBLE,
+  OMC_BINLOG_ARG_LDOUBLE,
+  OMC_BINLOG_ARG_STRING,
+  OMC_BINLOG_ARG_POINTER,
+  OMC_BINLOG_ARG_INVALID    /* %n, positional arguments, wide strings, ... */
+} OMC_BINLOG_ARG;
+
+typedef struct OMC_BINLOG_SPEC
+{
+  const char *start;        /* first character of the specification ('%') */
+  const char *end;          /* one past the conversion character */
+  int widthStar;            /* width is given as an int argument */
+  int precisionStar;        /* precision is given as an int argument */
+  int isUnsigned;
+  OMC_BINLOG_ARG arg;
+} OMC_BINLOG_SPEC;
+
+/* Parses the next conversion specification of a printf format.
+ * Returns the position after it, or NULL if there is none left.
+ * Shared by the writer and the offline decoder so both agree on the layout
+ * of the stored arguments. */
+static inline const char* omc_binlog_nextSpec(const char *format, OMC_BINLOG_SPEC *spec)
+{
+  const char *p = format;
+  int length = 0; /* 'H' hh, 'h', 'l', 'q' ll, 'L', 'z', 'j', 't' */
+
+  while (*p && *p != '%') p++;
+  if (!*p) {
+    return NULL;
+  }
+  spec->start = p++;
+  spec->widthStar = 0;
+  spec->precisionStar = 0;
+  spec->isUnsigned = 0;
+  spec->arg = OMC_BINLOG_ARG_INVALID;
+
+  while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') p++;
+  if (*p == '*') {
+    spec->widthStar = 1;
+    p++;
+  } else {
+    while (*p >= '0' && *p <= '9') p++;
+  }
+  if (*p == '.') {
+    p++;
+    if (*p == '*') {
+      spec->precisionStar = 1;
+      p++;
+    } else {
+      while (*p >= '0' && *p <= '9') p++;
+    }
+  }
+  switch (*p) {
+  case 'h': length = 'h'; p++; if (*p == 'h') {length = 'H'; p++;} break;
+  case 'l': length = 'l'; p++; if (*p == 'l') {length = 'q'; p++;} break;
+  case 'L': case 'z': case 'j': case 't': case 'q': length = *p; p++; break;
+  default: break;
+  }
+
+  switch (*p) {
+  case '%':
+    spec->arg = (p == spec->start + 1) ? OMC_BINLOG_ARG_NONE : OMC_BINLOG_ARG_INVALID;
+    break;
+  case 'u': case 'o': case 'x': case 'X':
+    spec->isUnsigned = 1;
+    /* fall through */
+  case 'd': case 'i':
+    switch (length) {
+    case 0: case 'h': case 'H': spec->arg = OMC_BINLOG_ARG_INT; break;
+    case 'l': spec->arg = OMC_BINLOG_ARG_LONG; break;
+    case 'q': spec->arg = OMC_BINLOG_ARG_LLONG; break;
+    case 'z': spec->arg = OMC_BINLOG_ARG_SIZE; break;
+    case 'j': spec->arg = OMC_BINLOG_ARG_INTMAX; break;
+    case 't': spec->arg = OMC_BINLOG_ARG_PTRDIFF; break;
+    default: break;
+    }
+    break;
+  case 'c':
+    spec->arg = length ? OMC_BINLOG_ARG_INVALID : OMC_BINLOG_ARG_INT;
+    break;
+  case 's':
+    spec->arg = length ? OMC_BINLOG_ARG_INVALID : OMC_BINLOG_ARG_STRING;
+    break;
+  case 'p':
+    spec->arg = OMC_BINLOG_ARG_POINTER;
+    break;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+    spec->arg = length == 'L' ? OMC_BINLOG_ARG_LDOUBLE : (length == 0 || length == 'l') ? OMC_BINLOG_ARG_DOUBLE : OMC_BINLOG_ARG_INVALID;
+    break;
+  default:
+    break;
+  }
+  spec->end = *p ? p + 1 : p;
+  return spec->end;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,676 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Offline decoder for logs written with -logFormat=binary (see omc_binlog.h).
+ * Prints the messages in the same layout as -logFormat=text.
+ *
+ * This is a standalone program that only depends on the C library:
+ *   cc -O2 -o omc_binlog_decode omc_binlog_decode.c
+ *
+ * Usage: omc_binlog_decode [options] model_log.bin
+ *   -lv=LOG_NLS,LOG_EVENTS  only print these streams
+ *   -type=warning,error     only print these message types
+ *   -thread=N               only print the messages of thread N
+ *   -start=T -stop=T        only print messages logged in this interval
+ *                           (wall clock seconds since the log was opened)
+ *   -time                   prefix every message with its timestamp and thread
+ */
+
+#include "omc_binlog.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  unsigned char *data;
+  size_t size;
+  size_t pos;
+  int error;
+} READER;
+
+typedef struct {
+  int *level;         /* indentation per stream */
+  int *lastType;
+  int lastStream;
+  uint64_t time;
+} THREAD_STATE;
+
+typedef struct {
+  const char **streams;     /* names of the streams to print; NULL for all */
+  int typeMask;             /* bit (1<<type) for every type to print; 0 for all */
+  long thread;              /* -1 for all threads */
+  double startTime;
+  double stopTime;
+  int printTime;
+} FILTER;
+
+static char **streamNames;
+static int nStreams;
+static char **typeNames;
+static int nTypes;
+static char **formats;
+static size_t nFormats;
+static int *streamEnabled;
+
+/* All lengths and counts read from the file are checked against the data
+ * that is left, so a corrupt file cannot make the decoder read past the end
+ * of a chunk or allocate huge amounts of memory. */
+static int available(READER *r, uint64_t n)
+{
+  if (r->error || r->pos > r->size || n > r->size - r->pos) {
+    r->error = 1;
+    return 0;
+  }
+  return 1;
+}
+
+static int getByte(READER *r)
+{
+  return available(r, 1) ? r->data[r->pos++] : 0;
+}
+
+static uint64_t getVarint(READER *r)
+{
+  uint64_t v = 0;
+  int shift = 0;
+  while (r->pos < r->size && shift < 64) {
+    unsigned char c = r->data[r->pos++];
+    v |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return v;
+    }
+    shift += 7;
+  }
+  r->error = 1;
+  return 0;
+}
+
+static int64_t getSigned(READER *r)
+{
+  uint64_t v = getVarint(r);
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static double getDouble(READER *r)
+{
+  uint64_t bits = 0;
+  double d;
+  int i;
+  if (!available(r, 8)) {
+    return 0;
+  }
+  for (i = 0; i < 8; i++) {
+    bits |= (uint64_t)r->data[r->pos++] << (8*i);
+  }
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+/* continuation of a literal or match length of a packed chunk */
+static uint64_t getLength(READER *r, uint64_t len)
+{
+  int b;
+  if (len == 15) {
+    do {
+      b = getByte(r);
+      len += b;
+    } while (b == 255 && !r->error);
+  }
+  return len;
+}
+
+/* Unpacks a chunk written as OMC_BINLOG_TAG_PACKED into a buffer of the given
+ * size. Returns NULL if the data does not fit exactly. */
+static unsigned char* unpack(READER *r, uint64_t size)
+{
+  unsigned char *out;
+  uint64_t pos = 0;
+  /* every byte of packed data unpacks to at most 255 bytes */
+  if (size > (uint64_t) 255 * r->size + 16) {
+    return NULL;
+  }
+  out = (unsigned char*) malloc(size ? size : 1);
+  while (r->pos < r->size && !r->error) {
+    int token = getByte(r);
+    uint64_t nLiterals = getLength(r, token >> 4), offset, len;
+    if (!available(r, nLiterals) || nLiterals > size - pos) {
+      break;
+    }
+    memcpy(out + pos, r->data + r->pos, nLiterals);
+    r->pos += nLiterals;
+    pos += nLiterals;
+    if (r->pos == r->size) {
+      /* the last sequence has no match */
+      break;
+    }
+    offset = getByte(r);
+    offset |= (uint64_t) getByte(r) << 8;
+    len = getLength(r, token & 15) + OMC_BINLOG_MIN_MATCH;
+    if (r->error || offset == 0 || offset > pos || len > size - pos) {
+      r->error = 1;
+      break;
+    }
+    /* byte by byte, the match may overlap the bytes it produces */
+    for (; len > 0; len--, pos++) {
+      out[pos] = out[pos - offset];
+    }
+  }
+  if (r->error || pos != size) {
+    free(out);
+    return NULL;
+  }
+  return out;
+}
+
+static char* getString(READER *r, uint64_t len)
+{
+  char *s;
+  if (!available(r, len)) {
+    return NULL;
+  }
+  s = (char*) malloc(len + 1);
+  memcpy(s, r->data + r->pos, len);
+  s[len] = '\0';
+  r->pos += len;
+  return s;
+}
+
+static char** getNames(READER *r, int *n)
+{
+  char **names;
+  int i;
+  uint64_t count = getVarint(r);
+  /* every name takes at least one byte */
+  if (!available(r, count)) {
+    count = 0;
+  }
+  *n = (int) count;
+  names = (char**) calloc(*n ? *n : 1, sizeof(char*));
+  for (i = 0; i < *n && !r->error; i++) {
+    names[i] = getString(r, getVarint(r));
+  }
+  return names;
+}
+
+/* appends to a growing output buffer */
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+} BUFFER;
+
+static void append(BUFFER *b, const char *s, size_t len)
+{
+  if (b->size + len + 1 > b->capacity) {
+    b->capacity = 2*(b->size + len + 1);
+    b->data = (char*) realloc(b->data, b->capacity);
+  }
+  memcpy(b->data + b->size, s, len);
+  b->size += len;
+  b->data[b->size] = '\0';
+}
+
+/* Formats one conversion specification with the stored argument */
+static void formatSpec(BUFFER *b, READER *r, const OMC_BINLOG_SPEC *spec)
+{
+  char fmt[64], small[512], *out = small, *f = fmt;
+  int n = 0;
+  const char *p;
+  int star[2], nStar = 0;
+  size_t len = spec->end - spec->start;
+
+  if (spec->widthStar) star[nStar++] = (int) getSigned(r);
+  if (spec->precisionStar) star[nStar++] = (int) getSigned(r);
+
+  if (len + 2 >= sizeof(fmt)) {
+    r->error = 1;
+    return;
+  }
+  /* copy flags, width and precision, replace the length modifier */
+  for (p = spec->start; p < spec->end - 1; p++) {
+    if (strchr("hlLqzjt", *p) == NULL) {
+      *f++ = *p;
+    }
+  }
+  switch (spec->arg) {
+  case OMC_BINLOG_ARG_INT: case OMC_BINLOG_ARG_LONG: case OMC_BINLOG_ARG_LLONG:
+  case OMC_BINLOG_ARG_SIZE: case OMC_BINLOG_ARG_INTMAX: case OMC_BINLOG_ARG_PTRDIFF:
+    if (spec->end[-1] != 'c') {
+      *f++ = 'l';
+      *f++ = 'l';
+    }
+    break;
+  default:
+    break;
+  }
+  *f++ = spec->end[-1];
+  *f = '\0';
+
+  /* value must not have side effects, it is formatted a second time into a
+   * heap buffer if the result does not fit into small */
+#define SNPRINTF_ARG(buf, size, value) \
+  (nStar == 2 ? snprintf(buf, size, fmt, star[0], star[1], value) : \
+   nStar == 1 ? snprintf(buf, size, fmt, star[0], value) : \
+                snprintf(buf, size, fmt, value))
+#define FORMAT_ARG(value) \
+  do { \
+    n = SNPRINTF_ARG(small, sizeof(small), value); \
+    if (n >= (int) sizeof(small)) { \
+      out = (char*) malloc(n + 1); \
+      if (out) { \
+        SNPRINTF_ARG(out, n + 1, value); \
+      } else { \
+        out = small; \
+        n = (int) sizeof(small) - 1; \
+      } \
+    } \
+  } while (0)
+
+  switch (spec->arg) {
+  case OMC_BINLOG_ARG_NONE:
+    append(b, "%", 1);
+    return;
+  case OMC_BINLOG_ARG_INT:
+    if (spec->end[-1] == 'c') {
+      int c = (int) getSigned(r);
+      FORMAT_ARG(c);
+    } else if (spec->isUnsigned) {
+      unsigned long long u = getVarint(r);
+      FORMAT_ARG(u);
+    } else {
+      long long i = getSigned(r);
+      FORMAT_ARG(i);
+    }
+    break;
+  case OMC_BINLOG_ARG_LONG: case OMC_BINLOG_ARG_LLONG: case OMC_BINLOG_ARG_INTMAX:
+    if (spec->isUnsigned) {
+      unsigned long long u = getVarint(r);
+      FORMAT_ARG(u);
+    } else {
+      long long i = getSigned(r);
+      FORMAT_ARG(i);
+    }
+    break;
+  case OMC_BINLOG_ARG_SIZE:
+    {
+      unsigned long long u = getVarint(r);
+      FORMAT_ARG(u);
+    }
+    break;
+  case OMC_BINLOG_ARG_PTRDIFF:
+    {
+      long long i = getSigned(r);
+      FORMAT_ARG(i);
+    }
+    break;
+  case OMC_BINLOG_ARG_DOUBLE: case OMC_BINLOG_ARG_LDOUBLE:
+    {
+      double d = getDouble(r);
+      FORMAT_ARG(d);
+    }
+    break;
+  case OMC_BINLOG_ARG_POINTER:
+    {
+      void *ptr = (void*)(uintptr_t) getVarint(r);
+      FORMAT_ARG(ptr);
+    }
+    break;
+  case OMC_BINLOG_ARG_STRING:
+    {
+      uint64_t len = getVarint(r);
+      char *s = len ? getString(r, len - 1) : NULL;
+      const char *str = s ? s : "(null)";
+      if (!r->error) {
+        FORMAT_ARG(str);
+      }
+      free(s);
+    }
+    break;
+  default:
+    r->error = 1;
+    return;
+  }
+#undef FORMAT_ARG
+#undef SNPRINTF_ARG
+  if (n > 0) {
+    append(b, out, n);
+  }
+  if (out != small) {
+    free(out);
+  }
+}
+
+static void formatMessage(BUFFER *b, READER *r, const char *format)
+{
+  OMC_BINLOG_SPEC spec;
+  const char *p = format, *next;
+  while ((next = omc_binlog_nextSpec(p, &spec)) != NULL && !r->error) {
+    append(b, p, spec.start - p);
+    formatSpec(b, r, &spec);
+    p = next;
+  }
+  append(b, p, strlen(p));
+}
+
+/* Same layout as messageText in omc_error.c */
+static void printMessage(FILE *out, THREAD_STATE *state, long thread, int type, int stream, int indentNext, const FILTER *filter, char *msg)
+{
+  int subline = 0, i;
+  char *line = msg, *nl;
+
+  do {
+    nl = strchr(line, '\n');
+    if (nl) *nl = '\0';
+    if (filter->printTime) {
+      fprintf(out, "%14.9f %3ld | ", state->time*1e-9, thread);
+    }
+    fprintf(out, "%-17s | ", (subline || (state->lastStream == stream && state->level[stream] > 0)) ? "|" : streamNames[stream]);
+    fprintf(out, "%-7s | ", (subline || (state->lastStream == stream && state->lastType[stream] == type && state->level[stream] > 0)) ? "|" : (type < nTypes ? typeNames[type] : "unknown"));
+    state->lastType[stream] = type;
+    state->lastStream = stream;
+    for (i = 0; i < state->level[stream]; ++i) {
+      fputs("| ", out);
+    }
+    fprintf(out, "%s\n", line);
+    subline = 1;
+    line = nl ? nl + 1 : NULL;
+  } while (line && *line);
+
+  if (indentNext) {
+    state->level[stream]++;
+  }
+}
+
+static int selected(const FILTER *filter, const THREAD_STATE *state, long thread, int type, int stream)
+{
+  double t = state->time*1e-9;
+  return (filter->thread < 0 || filter->thread == thread)
+      && (!filter->typeMask || (filter->typeMask & (1 << type)))
+      && streamEnabled[stream]
+      && t >= filter->startTime && t <= filter->stopTime;
+}
+
+static int decodeChunk(READER *r, FILE *out, THREAD_STATE *state, long thread, const FILTER *filter)
+{
+  BUFFER b = {NULL, 0, 0};
+
+  while (r->pos < r->size && !r->error) {
+    int tag = getByte(r);
+    int type = 0, stream, indentNext = 0, show;
+    uint64_t nIndexes, i;
+    state->time += getVarint(r);
+
+    if (tag == OMC_BINLOG_REC_CLOSE) {
+      stream = (int) getVarint(r);
+      (void) getByte(r); /* warning */
+      if (r->error || stream < 0 || stream >= nStreams) {
+        r->error = 1;
+        break;
+      }
+      /* indentation is tracked for filtered records as well, it only affects
+       * the layout of the selected ones */
+      if (state->level[stream] > 0) {
+        state->level[stream]--;
+      }
+      continue;
+    }
+    if (tag != OMC_BINLOG_REC_MESSAGE && tag != OMC_BINLOG_REC_TEXT) {
+      r->error = 1;
+      break;
+    }
+    type = getByte(r);
+    stream = (int) getVarint(r);
+    indentNext = getByte(r);
+    nIndexes = getVarint(r);
+    for (i = 0; i < nIndexes && !r->error; i++) {
+      (void) getSigned(r);
+    }
+    if (r->error || stream < 0 || stream >= nStreams) {
+      r->error = 1;
+      break;
+    }
+    show = selected(filter, state, thread, type, stream);
+
+    b.size = 0;
+    append(&b, "", 0);
+    if (tag == OMC_BINLOG_REC_TEXT) {
+      uint64_t len = getVarint(r);
+      char *s = getString(r, len);
+      if (s) append(&b, s, len);
+      free(s);
+    } else {
+      uint64_t id = getVarint(r);
+      if (id >= nFormats || !formats[id]) {
+        r->error = 1;
+        break;
+      }
+      formatMessage(&b, r, formats[id]);
+    }
+    if (r->error) break;
+    if (show) {
+      printMessage(out, state, thread, type, stream, indentNext, filter, b.data);
+    } else if (indentNext) {
+      state->level[stream]++;
+    }
+  }
+  free(b.data);
+  return r->error;
+}
+
+static int decode(FILE *in, FILE *out, const FILTER *filter)
+{
+  READER file = {NULL, 0, 0, 0};
+  THREAD_STATE *threads = NULL;
+  size_t nThreads = 0, capacity = 0, n, magicLength = strlen(OMC_BINLOG_MAGIC);
+  int i;
+
+  /* read everything, the decoder is not performance critical */
+  do {
+    if (file.size + 65536 > capacity) {
+      capacity = 2*capacity + 65536;
+      file.data = (unsigned char*) realloc(file.data, capacity);
+    }
+    n = fread(file.data + file.size, 1, capacity - file.size, in);
+    file.size += n;
+  } while (n > 0);
+
+  if (file.size < magicLength || memcmp(file.data, OMC_BINLOG_MAGIC, magicLength)) {
+    fprintf(stderr, "not a binary OpenModelica log file\n");
+    return 1;
+  }
+  file.pos = magicLength;
+  streamNames = getNames(&file, &nStreams);
+  typeNames = getNames(&file, &nTypes);
+  if (file.error) {
+    fprintf(stderr, "truncated file header\n");
+    return 1;
+  }
+
+  streamEnabled = (int*) calloc(nStreams ? nStreams : 1, sizeof(int));
+  for (i = 0; i < nStreams; i++) {
+    const char **s;
+    streamEnabled[i] = filter->streams == NULL;
+    for (s = filter->streams; s && *s; s++) {
+      if (0 == strcmp(*s, streamNames[i])) {
+        streamEnabled[i] = 1;
+      }
+    }
+  }
+
+  while (file.pos < file.size && !file.error) {
+    int tag = getByte(&file);
+    if (tag == OMC_BINLOG_TAG_FORMAT) {
+      uint64_t id = getVarint(&file);
+      char *format = getString(&file, getVarint(&file));
+      /* the ids are numbered consecutively, every definition takes a few bytes */
+      if (!file.error && id >= file.size) {
+        file.error = 1;
+      }
+      if (file.error) {
+        free(format);
+        break;
+      }
+      if (id >= nFormats) {
+        size_t newSize = 2*id + 16;
+        formats = (char**) realloc(formats, newSize*sizeof(char*));
+        memset(formats + nFormats, 0, (newSize - nFormats)*sizeof(char*));
+        nFormats = newSize;
+      }
+      formats[id] = format;
+    } else if (tag == OMC_BINLOG_TAG_CHUNK || tag == OMC_BINLOG_TAG_PACKED) {
+      uint64_t thread = getVarint(&file);
+      uint64_t size = getVarint(&file);
+      uint64_t packedSize = tag == OMC_BINLOG_TAG_PACKED ? getVarint(&file) : size;
+      unsigned char *unpacked = NULL;
+      READER chunk;
+      int res;
+      /* the thread ids are numbered consecutively, every chunk takes a few bytes */
+      if (!available(&file, packedSize) || thread >= file.size) {
+        file.error = 1;
+        break;
+      }
+      while (thread >= nThreads) {
+        threads = (THREAD_STATE*) realloc(threads, (nThreads+1)*sizeof(THREAD_STATE));
+        threads[nThreads].level = (int*) calloc(nStreams, sizeof(int));
+        threads[nThreads].lastType = (int*) calloc(nStreams, sizeof(int));
+        threads[nThreads].lastStream = 0;
+        threads[nThreads].time = 0;
+        nThreads++;
+      }
+      chunk.data = file.data + file.pos;
+      chunk.size = packedSize;
+      chunk.pos = 0;
+      chunk.error = 0;
+      if (tag == OMC_BINLOG_TAG_PACKED) {
+        unpacked = unpack(&chunk, size);
+        if (!unpacked) {
+          file.error = 1;
+          break;
+        }
+        chunk.data = unpacked;
+        chunk.size = size;
+        chunk.pos = 0;
+      }
+      res = decodeChunk(&chunk, out, &threads[thread], (long) thread, filter);
+      free(unpacked);
+      if (res) {
+        file.error = 1;
+        break;
+      }
+      file.pos += packedSize;
+    } else {
+      file.error = 1;
+    }
+  }
+
+  if (file.error) {
+    fprintf(stderr, "corrupt or truncated log at byte %lu\n", (unsigned long) file.pos);
+    return 1;
+  }
+  return 0;
+}
+
+/* splits a comma separated list in place */
+static const char** splitList(char *s)
+{
+  size_t n = 2;
+  const char **list;
+  char *c;
+  for (c = s; *c; c++) if (*c == ',') n++;
+  list = (const char**) calloc(n, sizeof(char*));
+  n = 0;
+  list[n++] = s;
+  for (c = s; *c; c++) {
+    if (*c == ',') {
+      *c = '\0';
+      list[n++] = c + 1;
+    }
+  }
+  return list;
+}
+
+int main(int argc, char **argv)
+{
+  FILTER filter = {NULL, 0, -1, 0.0, 1e300, 0};
+  const char *fileName = NULL;
+  FILE *in;
+  int i, res;
+
+  for (i = 1; i < argc; i++) {
+    if (0 == strncmp(argv[i], "-lv=", 4)) {
+      filter.streams = splitList(argv[i] + 4);
+    } else if (0 == strncmp(argv[i], "-type=", 6)) {
+      const char **types = splitList(argv[i] + 6), **t;
+      for (t = types; *t; t++) {
+        /* the type names are fixed, see LOG_TYPE_DESC in omc_error.c */
+        static const char *names[] = {"unknown", "info", "warning", "error", "assert", "debug"};
+        int j, found = 0;
+        for (j = 0; j < (int)(sizeof(names)/sizeof(*names)); j++) {
+          if (0 == strcmp(*t, names[j])) {
+            filter.typeMask |= 1 << j;
+            found = 1;
+          }
+        }
+        if (!found) {
+          fprintf(stderr, "unknown message type %s\n", *t);
+          return 1;
+        }
+      }
+    } else if (0 == strncmp(argv[i], "-thread=", 8)) {
+      filter.thread = atol(argv[i] + 8);
+    } else if (0 == strncmp(argv[i], "-start=", 7)) {
+      filter.startTime = atof(argv[i] + 7);
+    } else if (0 == strncmp(argv[i], "-stop=", 6)) {
+      filter.stopTime = atof(argv[i] + 6);
+    } else if (0 == strcmp(argv[i], "-time")) {
+      filter.printTime = 1;
+    } else if (argv[i][0] != '-' && !fileName) {
+      fileName = argv[i];
+    } else {
+      fileName = NULL;
+      break;
+    }
+  }
+
+  if (!fileName) {
+    fprintf(stderr, "usage: %s [-lv=STREAM,...] [-type=TYPE,...] [-thread=N] [-start=T] [-stop=T] [-time] file.bin\n", argv[0]);
+    return 1;
+  }
+  in = fopen(fileName, "rb");
+  if (!in) {
+    fprintf(stderr, "could not open %s\n", fileName);
+    return 1;
+  }
+  res = decode(in, stdout, &filter);
+  fclose(in);
+  return res;
+}
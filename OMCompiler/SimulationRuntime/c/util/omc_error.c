@@ -170,6 +170,9 @@ void initDumpSystem()
   useStream[LOG_STDOUT] = 1;
   useStream[LOG_ASSERT] = 1;
   useStream[LOG_SUCCESS] = 1;
+
+  showAllWarnings = 0;
+  streamsActive = 1;
 }
 
 /* Deactivates streams for logging except for stdout, assert and success. */
@@ -339,6 +342,16 @@ static void messageCloseTextWarning(int stream)
 void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes) = messageText;
 void (*messageClose)(int stream) = messageCloseText;
 void (*messageCloseWarning)(int stream) = messageCloseTextWarning;
+void (*messageDeferred)(int type, int stream, int indentNext, const int *indexes, int isLiteral, const char *format, va_list args) = NULL;
+
+/* Restores the default text output, e.g. after -logFormat=xml or binary */
+void setStreamPrintText()
+{
+  messageFunction = messageText;
+  messageClose = messageCloseText;
+  messageCloseWarning = messageCloseTextWarning;
+  messageDeferred = NULL;
+}
 
 #define SIZE_LOG_BUFFER 2048
 
@@ -347,6 +360,10 @@ void va_infoStreamPrint(int stream, int indentNext, const char *format, va_list
 {
   if (useStream[stream]) {
     char logBuffer[SIZE_LOG_BUFFER];
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_INFO, stream, indentNext, NULL, 0, format, args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     messageFunction(LOG_TYPE_INFO, stream, indentNext, logBuffer, 0, NULL);
   }
@@ -358,6 +375,11 @@ void infoStreamPrintWithEquationIndexes(int stream, int indentNext, const int *i
     char logBuffer[SIZE_LOG_BUFFER];
     va_list args;
     va_start(args, format);
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_INFO, stream, indentNext, indexes, 1, format, args);
+      va_end(args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     va_end(args);
     messageFunction(LOG_TYPE_INFO, stream, indentNext, logBuffer, 0, indexes);
@@ -370,6 +392,11 @@ void infoStreamPrint(int stream, int indentNext, const char *format, ...)
     char logBuffer[SIZE_LOG_BUFFER];
     va_list args;
     va_start(args, format);
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_INFO, stream, indentNext, NULL, 1, format, args);
+      va_end(args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     va_end(args);
     messageFunction(LOG_TYPE_INFO, stream, indentNext, logBuffer, 0, NULL);
@@ -382,6 +409,11 @@ void warningStreamPrintWithEquationIndexes(int stream, int indentNext, const int
     char logBuffer[SIZE_LOG_BUFFER];
     va_list args;
     va_start(args, format);
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_WARNING, stream, indentNext, indexes, 1, format, args);
+      va_end(args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     va_end(args);
     messageFunction(LOG_TYPE_WARNING, stream, indentNext, logBuffer, 0, indexes);
@@ -394,6 +426,11 @@ void warningStreamPrint(int stream, int indentNext, const char *format, ...)
     char logBuffer[SIZE_LOG_BUFFER];
     va_list args;
     va_start(args, format);
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_WARNING, stream, indentNext, NULL, 1, format, args);
+      va_end(args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     va_end(args);
     messageFunction(LOG_TYPE_WARNING, stream, indentNext, logBuffer, 0, NULL);
@@ -404,6 +441,10 @@ void va_warningStreamPrintWithEquationIndexes(int stream, int indentNext, const
 {
   if (ACTIVE_WARNING_STREAM(stream)) {
     char logBuffer[SIZE_LOG_BUFFER];
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_WARNING, stream, indentNext, indexes, 0, format, args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     messageFunction(LOG_TYPE_WARNING, stream, indentNext, logBuffer, 0, indexes);
   }
@@ -413,6 +454,10 @@ void va_warningStreamPrint(int stream, int indentNext, const char *format, va_li
 {
   if (ACTIVE_WARNING_STREAM(stream)) {
     char logBuffer[SIZE_LOG_BUFFER];
+    if (messageDeferred) {
+      messageDeferred(LOG_TYPE_WARNING, stream, indentNext, NULL, 0, format, args);
+      return;
+    }
     vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
     messageFunction(LOG_TYPE_WARNING, stream, indentNext, logBuffer, 0, NULL);
   }
@@ -423,6 +468,11 @@ void errorStreamPrint(int stream, int indentNext, const char *format, ...)
   char logBuffer[SIZE_LOG_BUFFER];
   va_list args;
   va_start(args, format);
+  if (messageDeferred) {
+    messageDeferred(LOG_TYPE_ERROR, stream, indentNext, NULL, 1, format, args);
+    va_end(args);
+    return;
+  }
   vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
   va_end(args);
   messageFunction(LOG_TYPE_ERROR, stream, indentNext, logBuffer, 0, NULL);
@@ -431,6 +481,10 @@ void errorStreamPrint(int stream, int indentNext, const char *format, ...)
 void va_errorStreamPrint(int stream, int indentNext, const char *format, va_list args)
 {
   char logBuffer[SIZE_LOG_BUFFER];
+  if (messageDeferred) {
+    messageDeferred(LOG_TYPE_ERROR, stream, indentNext, NULL, 0, format, args);
+    return;
+  }
   vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
   messageFunction(LOG_TYPE_ERROR, stream, indentNext, logBuffer, 0, NULL);
 }
@@ -439,6 +493,10 @@ void va_errorStreamPrintWithEquationIndexes(int stream, int indentNext, const in
 {
 
   char logBuffer[SIZE_LOG_BUFFER];
+  if (messageDeferred) {
+    messageDeferred(LOG_TYPE_ERROR, stream, indentNext, indexes, 0, format, args);
+    return;
+  }
   vsnprintf(logBuffer, SIZE_LOG_BUFFER, format, args);
   messageFunction(LOG_TYPE_ERROR, stream, indentNext, logBuffer, 0, indexes);
 }
@@ -65,6 +65,7 @@ DLLExport extern void (*omc_assert_withEquationIndexes)(threadData_t*,FILE_INFO,
 DLLExport extern void (*omc_assert_warning_withEquationIndexes)(FILE_INFO, const int*, const char*, ...);
 
 void initDumpSystem();
+void setStreamPrintText();
 void deactivateLogging();
 void reactivateLogging();
 void omc_assert_function(threadData_t*,FILE_INFO info, const char *msg, ...) __attribute__ ((noreturn));
@@ -173,6 +174,9 @@ extern char logBuffer[2048];
 extern void (*messageFunction)(int type, int stream, int indentNext, char *msg, int subline, const int *indexes);
 extern void (*messageClose)(int stream);
 extern void (*messageCloseWarning)(int stream);
+/* if set, info/warning/error messages are passed unformatted to this function instead of messageFunction;
+ * isLiteral is 1 if the format is a string literal (the printf-like printers) */
+extern void (*messageDeferred)(int type, int stream, int indentNext, const int *indexes, int isLiteral, const char *format, va_list args);
 
 #if !defined(OMC_MINIMAL_LOGGING)
 extern void va_infoStreamPrint(int stream, int indentNext, const char *format, va_list ap);
@@ -116,6 +116,13 @@ void dequeueNFirstRingDatas(RINGBUFFER *rb, int n)
   rb->nElements -= n;
 }
 
+/* removes all elements, the allocated buffer is kept */
+void clearRingBuffer(RINGBUFFER *rb)
+{
+  rb->firstElement = 0;
+  rb->nElements = 0;
+}
+
 int ringBufferLength(RINGBUFFER *rb)
 {
   return rb->nElements;
@@ -51,6 +51,7 @@ extern "C" {
 
   void appendRingData(RINGBUFFER *rb, void *value);
   void dequeueNFirstRingDatas(RINGBUFFER *rb, int n);
+  void clearRingBuffer(RINGBUFFER *rb);
 
   int ringBufferLength(RINGBUFFER *rb);
 
@@ -38,6 +38,7 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_CLOCK */                        "clock",
   /* FLAG_CPU */                          "cpu",
   /* FLAG_CSV_OSTEP */                    "csvOstep",
+  /* FLAG_CSV_THREAD */                   "csvThread",
   /* FLAG_DAE_MODE */                     "daeMode",
   /* FLAG_DELTA_X_LINEARIZE */            "deltaXLinearize",
   /* FLAG_DELTA_X_SOLVER */               "deltaXSolver",
@@ -64,6 +65,8 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_HOMOTOPY_TAU_MAX */             "homTauMax",
   /* FLAG_HOMOTOPY_TAU_MIN */             "homTauMin",
   /* FLAG_HOMOTOPY_TAU_START */           "homTauStart",
+  /* FLAG_HPCOM_ADAPT_PROFILE */          "hpcomAdaptProfile",
+  /* FLAG_HPCOM_ADAPT_STEPS */            "hpcomAdaptSteps",
   /* FLAG_IDA_MAXERRORTESTFAIL */         "idaMaxErrorTestFails",
   /* FLAG_IDA_MAXNONLINITERS */           "idaMaxNonLinIters",
   /* FLAG_IDA_MAXCONVFAILS */             "idaMaxConvFails",
@@ -92,6 +95,7 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_JACOBIAN_THREADS */             "jacobianThreads",
   /* FLAG_L */                            "l",
   /* FLAG_L_DATA_RECOVERY */              "l_datarec",
+  /* FLAG_L_FORMAT */                     "l_format",
   /* FLAG_LOG_FORMAT */                   "logFormat",
   /* FLAG_LS */                           "ls",
   /* FLAG_LS_IPOPT */                     "ls_ipopt",
@@ -133,6 +137,7 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_PORT */                         "port",
   /* FLAG_R */                            "r",
   /* FLAG_DATA_RECONCILE  */              "reconcile",
+  /* FLAG_DATA_RECONCILE_BATCH */         "reconcileBatch",
   /* FLAG_RT */                           "rt",
   /* FLAG_S */                            "s",
   /* FLAG_SINGLE_PRECISION */             "single",
@@ -154,6 +159,7 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_CLOCK */                        "selects the type of clock to use -clock=RT, -clock=CYC or -clock=CPU",
   /* FLAG_CPU */                          "dumps the cpu-time into the result file",
   /* FLAG_CSV_OSTEP */                    "value specifies csv-files for debug values for optimizer step",
+  /* FLAG_CSV_THREAD */                   "formats the csv result file in a background thread",
   /* FLAG_DAE_MODE */                     "flag to let the integrator use daeResiduals",
   /* FLAG_DELTA_X_LINEARIZE */            "value specifies the delta x value for numerical differentiation used by linearization. The default value is 1e-5.",
   /* FLAG_DELTA_X_SOLVER */               "value specifies the delta x value for numerical differentiation used by integrator. The default values is sqrt(DBL_EPSILON).",
@@ -180,6 +186,8 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_HOMOTOPY_TAU_MAX */             "[double (default 10.0)] maximum homotopy step size tau for the homotopy process",
   /* FLAG_HOMOTOPY_TAU_MIN */             "[double (default 1e-4)] minimum homotopy step size tau for the homotopy process",
   /* FLAG_HOMOTOPY_TAU_START */           "[double (default 0.2)] homotopy step size tau at the beginning of the homotopy process",
+  /* FLAG_HPCOM_ADAPT_PROFILE */          "[string] file to which the task times measured by the adaptive hpcom schedule are written",
+  /* FLAG_HPCOM_ADAPT_STEPS */            "[int (default 100)] number of measured evaluations before the adaptive hpcom schedule is recomputed",
   /* FLAG_IDA_MAXERRORTESTFAIL */         "value specifies the maximum number of error test failures in attempting one step. The default value is 7.",
   /* FLAG_IDA_MAXNONLINITERS */           "value specifies the maximum number of nonlinear solver iterations at one step. The default value is 3.",
   /* FLAG_IDA_MAXCONVFAILS */             "value specifies the maximum number of nonlinear solver convergence failures at one step. The default value is 10.",
@@ -206,9 +214,10 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_IPOPT_WARM_START */             "value specifies lvl for a warm start in ipopt: 1,2,3,...",
   /* FLAG_JACOBIAN */                     "select the calculation method of the Jacobian used only by ida and dassl solver.",
   /* FLAG_JACOBIAN_THREADS */             "[int default: 1] value specifies the number of threads for jacobian evaluation in dassl or ida.",
-  /* FLAG_L */                            "value specifies a time where the linearization of the model should be performed",
+  /* FLAG_L */                            "value specifies a time (or a comma separated list of times) where the linearization of the model should be performed",
   /* FLAG_L_DATA_RECOVERY */              "emit data recovery matrices with model linearization",
-  /* FLAG_LOG_FORMAT */                   "value specifies the log format of the executable. -logFormat=text (default), -logFormat=xml or -logFormat=xmltcp",
+  /* FLAG_L_FORMAT */                     "value specifies the format of the linear model: -l_format=mo (default) or -l_format=mat",
+  /* FLAG_LOG_FORMAT */                   "value specifies the log format of the executable. -logFormat=text (default), -logFormat=xml, -logFormat=xmltcp or -logFormat=binary",
   /* FLAG_LS */                           "value specifies the linear solver method (default: lapack, totalpivot (fallback))",
   /* FLAG_LS_IPOPT */                     "value specifies the linear solver method for ipopt",
   /* FLAG_LSS */                          "value specifies the linear sparse solver method (default: umfpack)",
@@ -249,6 +258,7 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_PORT */                         "value specifies the port for simulation status (default disabled)",
   /* FLAG_R */                            "value specifies a new result file than the default Model_res.mat",
   /* FLAG_DATA_RECONCILE */               "Run the DataReconciliation algorithm for constrained equation",
+  /* FLAG_DATA_RECONCILE_BATCH */         "value specifies a csv-file with measurement sets which are reconciled in batch mode",
   /* FLAG_RT */                           "value specifies the scaling factor for real-time synchronization (0 disables)",
   /* FLAG_S */                            "value specifies the integration method",
   /* FLAG_SINGLE */                       "output in single precision",
@@ -277,6 +287,9 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Dumps the cpu-time into the result file using the variable named $cpuTime.",
   /* FLAG_CSV_OSTEP */
   "  Value specifies csv-files for debug values for optimizer step.",
+  /* FLAG_CSV_THREAD */
+  "  Only for -outputFormat=csv: the values of every output point are copied and formatted\n"
+  "  and written to the result file by a background thread, so the simulation does not wait for it.",
   /* FLAG_DAE_MODE */
   "  Enables daeMode simulation if the model was compiled with the omc flag --daeMode and ida method is used.",
   /* FLAG_DELTA_X_LINEARIZE */
@@ -341,6 +354,16 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Minimum homotopy step size tau for the homotopy process (default: 1e-4).",
   /* FLAG_HOMOTOPY_TAU_START */
   "  Homotopy step size tau at the beginning of the homotopy process (default: 0.2).",
+  /* FLAG_HPCOM_ADAPT_PROFILE */
+  "  Only for models compiled with the adaptive hpcom scheduler (+hpcomScheduler=adapt).\n"
+  "  Writes the task times measured during -hpcomAdaptSteps evaluations to the given file, in the format of the equation profiling.\n"
+  "  Name it <model>_eqs_prof.json to use the times as costs for the next compilation of the model.",
+  /* FLAG_HPCOM_ADAPT_STEPS */
+  "  Only for models compiled with the adaptive hpcom scheduler (+hpcomScheduler=adapt).\n"
+  "  The execution time of every task is measured during the given number of evaluations of the ODE system (default: 100).\n"
+  "  Afterwards a new list schedule is computed from the measured times and used for the rest of the simulation.\n"
+  "  The measured times are only written to a file with -hpcomAdaptProfile.\n"
+  "  A value of 0 disables the measurement and keeps the schedule of the compile-time costs.",
   /* FLAG_IDA_MAXERRORTESTFAIL */
   "  Value specifies the maximum number of error test failures in attempting one step. The default value is 7.",
   /* FLAG_IDA_MAXNONLINITERS */
@@ -398,14 +421,25 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies the number of threads for jacobian evaluation in dassl or ida."
   "  The value is an Integer with default value 1.",
   /* FLAG_L */
-  "  Value specifies a time where the linearization of the model should be performed.",
+  "  Value specifies a time where the linearization of the model should be performed.\n"
+  "  A comma separated list of increasing times, e.g. -l=0,0.5,1, linearizes the model\n"
+  "  at each of them during one simulation. The linear models are then numbered\n"
+  "  in the order of the times, e.g. linear_<model>_1.mo.",
   /* FLAG_L_DATA_RECOVERY */
   "  Emit data recovery matrices with model linearization.",
+  /* FLAG_L_FORMAT */
+  "  Value specifies the format of the linear model created with -l:\n\n"
+  "  * mo (default): Modelica model linear_<model>.mo\n"
+  "  * mat: MATLAB v4 file linear_<model>.mat with the matrices A, B, C, D (and Cz, Dz\n"
+  "    with -l_datarec) and the operating point x0, u0 (and z0). Matrices with a\n"
+  "    symbolic sparsity pattern are stored as sparse matrices.",
   /* FLAG_LOG_FORMAT */
   "  Value specifies the log format of the executable:\n\n"
   "  * text (default)\n"
   "  * xml\n"
-  "  * xmltcp (required -port flag)",
+  "  * xmltcp (required -port flag)\n"
+  "  * binary: messages are written unformatted to <model>_log.bin, which is much\n"
+  "    cheaper for verbose logging; decode it with omc_binlog_decode",
   /* FLAG_LS */
   "  Value specifies the linear solver method",
   /* FLAG_LS_IPOPT */
@@ -521,6 +555,11 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  For example: Model_res.mat.",
   /* FLAG_DATA_RECONCILE */
   "  Run the DataReconciliation algorithm for constrained equation",
+  /* FLAG_DATA_RECONCILE_BATCH */
+  "  Value specifies a csv-file with measurement sets for DataReconciliation.\n"
+  "  The first line holds the names of the variables to be reconciled and every\n"
+  "  further line one set of measured values. All sets are reconciled with the\n"
+  "  covariance matrix given by -sx and the results are written to Model_Batch.csv.",
   /* FLAG_RT */
   "  Value specifies the scaling factor for real-time synchronization (0 disables).\n"
   "  A value > 1 means the simulation takes a longer time to simulate.\n",
@@ -552,6 +591,7 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_CLOCK */                        FLAG_TYPE_OPTION,
   /* FLAG_CPU */                          FLAG_TYPE_FLAG,
   /* FLAG_CSV_OSTEP */                    FLAG_TYPE_OPTION,
+  /* FLAG_CSV_THREAD */                   FLAG_TYPE_FLAG,
   /* FLAG_DAE_SOLVING */                  FLAG_TYPE_FLAG,
   /* FLAG_DELTA_X_LINEARIZE */            FLAG_TYPE_OPTION,
   /* FLAG_DELTA_X_SOLVER */               FLAG_TYPE_OPTION,
@@ -578,6 +618,8 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_HOMOTOPY_TAU_MAX */             FLAG_TYPE_OPTION,
   /* FLAG_HOMOTOPY_TAU_MIN */             FLAG_TYPE_OPTION,
   /* FLAG_HOMOTOPY_TAU_START */           FLAG_TYPE_OPTION,
+  /* FLAG_HPCOM_ADAPT_PROFILE */          FLAG_TYPE_OPTION,
+  /* FLAG_HPCOM_ADAPT_STEPS */            FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXERRORTESTFAIL */         FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXNONLINITERS */           FLAG_TYPE_OPTION,
   /* FLAG_IDA_MAXCONVFAILS */             FLAG_TYPE_OPTION,
@@ -606,6 +648,7 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_JACOBIAN_THREADS */             FLAG_TYPE_OPTION,
   /* FLAG_L */                            FLAG_TYPE_OPTION,
   /* FLAG_L_DATA_RECOVERY */              FLAG_TYPE_FLAG,
+  /* FLAG_L_FORMAT */                     FLAG_TYPE_OPTION,
   /* FLAG_LOG_FORMAT */                   FLAG_TYPE_OPTION,
   /* FLAG_LS */                           FLAG_TYPE_OPTION,
   /* FLAG_LS_IPOPT */                     FLAG_TYPE_OPTION,
@@ -647,6 +690,7 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_PORT */                         FLAG_TYPE_OPTION,
   /* FLAG_R */                            FLAG_TYPE_OPTION,
   /* FLAG_DATA_RECONCILE */               FLAG_TYPE_FLAG,
+  /* FLAG_DATA_RECONCILE_BATCH */         FLAG_TYPE_OPTION,
   /* FLAG_RT */                           FLAG_TYPE_OPTION,
   /* FLAG_S */                            FLAG_TYPE_OPTION,
   /* FLAG_SINGLE */                       FLAG_TYPE_FLAG,
@@ -46,6 +46,7 @@ enum _FLAG
   FLAG_CLOCK,
   FLAG_CPU,
   FLAG_CSV_OSTEP,
+  FLAG_CSV_THREAD,
   FLAG_DAE_MODE,
   FLAG_DELTA_X_LINEARIZE,
   FLAG_DELTA_X_SOLVER,
@@ -72,6 +73,8 @@ enum _FLAG
   FLAG_HOMOTOPY_TAU_MAX,
   FLAG_HOMOTOPY_TAU_MIN,
   FLAG_HOMOTOPY_TAU_START,
+  FLAG_HPCOM_ADAPT_PROFILE,
+  FLAG_HPCOM_ADAPT_STEPS,
   FLAG_IDA_MAXERRORTESTFAIL,
   FLAG_IDA_MAXNONLINITERS,
   FLAG_IDA_MAXCONVFAILS,
@@ -100,6 +103,7 @@ enum _FLAG
   FLAG_JACOBIAN_THREADS,
   FLAG_L,
   FLAG_L_DATA_RECOVERY,
+  FLAG_L_FORMAT,
   FLAG_LOG_FORMAT,
   FLAG_LS,
   FLAG_LS_IPOPT,
@@ -141,6 +145,7 @@ enum _FLAG
   FLAG_PORT,
   FLAG_R,
   FLAG_DATA_RECONCILE,
+  FLAG_DATA_RECONCILE_BATCH,
   FLAG_RT,
   FLAG_S,
   FLAG_SINGLE_PRECISION,
@@ -55,25 +55,12 @@ int writeMatVer4AclassNormal(FILE *fout)
   return writeMatVer4Matrix(fout, "Aclass", 4, 11, Aclass_normal, sizeof(int8_t));
 }
 
-// writes MAT-file matrix header to file
-int writeMatVer4MatrixHeader(FILE *fout,const char *name, int rows, int cols, unsigned int size)
+/* writes a MAT-file matrix header with the given type digits (precision and matrix type) to file */
+static int writeMatVer4Header(FILE *fout, const char *name, int rows, int cols, int type)
 {
-  typedef struct MHeader {
-    uint32_t type;
-    uint32_t mrows;
-    uint32_t ncols;
-    uint32_t imagf;
-    uint32_t namelen;
-  } MHeader_t;
   const int endian_test = 1;
   MHeader_t hdr;
 
-  int type = 0;
-  if(size == 1 /* char */)
-    type = 51;
-  if(size == 4 /* int32 */)
-    type = 20;
-
   /* create matrix header structure */
   hdr.type = 1000*((*(char*)&endian_test) == 0) + type;
   hdr.mrows = rows;
@@ -85,8 +72,52 @@ int writeMatVer4MatrixHeader(FILE *fout,const char *name, int rows, int cols, un
   return !(1 == fwrite(&hdr, sizeof(MHeader_t), 1, fout) && 1 == fwrite(name, sizeof(char)*hdr.namelen, 1, fout));
 }
 
+// writes MAT-file matrix header to file
+int writeMatVer4MatrixHeader(FILE *fout,const char *name, int rows, int cols, unsigned int size)
+{
+  int type = 0;
+  if(size == 1 /* char */)
+    type = 51;
+  if(size == 4 /* int32 */)
+    type = 20;
+
+  return writeMatVer4Header(fout, name, rows, cols, type);
+}
+
 int writeMatVer4Matrix(FILE *fout, const char *name, int rows, int cols, const void *matrixData, unsigned int size)
 {
-  /* write data */
-  return !(0==writeMatVer4MatrixHeader(fout, name, rows, cols, size) && 1 == fwrite(matrixData, (size)*rows*cols, 1, fout));
+  /* write data; an empty matrix only has the header */
+  return !(0==writeMatVer4MatrixHeader(fout, name, rows, cols, size) && (0 == rows*cols || 1 == fwrite(matrixData, (size)*rows*cols, 1, fout)));
+}
+
+/* Writes a rows x cols matrix given in compressed column format as sparse
+ * matrix: leadindex[j]..leadindex[j+1]-1 are the positions of the nonzeros of
+ * column j in index (0-based row numbers) and values.
+ * The MAT-file stores the nonzeros as (nnz+1) x 3 matrix of 1-based
+ * (row, column, value) triplets, the last triplet holds the dimensions.
+ */
+int writeMatVer4SparseMatrix(FILE *fout, const char *name, int rows, int cols, const unsigned int *leadindex, const unsigned int *index, const double *values)
+{
+  unsigned int nnz = cols > 0 ? leadindex[cols] : 0;
+  unsigned int j, k;
+  double *triplets = (double*) malloc(3*(nnz+1)*sizeof(double));
+  int ret;
+
+  if(!triplets) {
+    return 1;
+  }
+  for(j=0; j<cols; j++) {
+    for(k=leadindex[j]; k<leadindex[j+1]; k++) {
+      triplets[k] = index[k]+1;
+      triplets[nnz+1+k] = j+1;
+      triplets[2*(nnz+1)+k] = values[k];
+    }
+  }
+  triplets[nnz] = rows;
+  triplets[2*nnz+1] = cols;
+  triplets[3*nnz+2] = 0;
+
+  ret = !(0==writeMatVer4Header(fout, name, nnz+1, 3, 2 /* double, sparse */) && 1 == fwrite(triplets, 3*(nnz+1)*sizeof(double), 1, fout));
+  free(triplets);
+  return ret;
 }
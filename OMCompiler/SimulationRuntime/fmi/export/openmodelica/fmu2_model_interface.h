@@ -91,8 +91,30 @@ typedef struct {
   int _need_update;
   int _has_jacobian;
   ANALYTIC_JACOBIAN* fmiDerJac;
+  int _need_jacobian_update;  /* evaluation point changed since constantEqns of fmiDerJac was called */
+  int _has_full_jacobian;     /* fmiDerJacValues holds the full Jacobian of the current evaluation point */
+  int _unit_seed_column;      /* column of the last unit seed call at the current evaluation point, or -1 */
+  fmi2Real* fmiDerJacValues;  /* full Jacobian, stored in the sparsity pattern of fmiDerJac */
+
+  /* co-simulation work buffers, allocated once in fmi2Instantiate */
+  fmi2Real* states;
+  fmi2Real* states_der;
+  fmi2Real* event_indicators;
+  fmi2Real* event_indicators_prev;
+  fmi2Real* rkWork;           /* stages and start values of the rk23 sub-steps */
+  fmi2Real rkStepSize;        /* last accepted rk23 sub-step size, 0 if none yet */
+  int _need_event_iteration;  /* inputs changed since the last fmi2DoStep */
 } ModelInstance;
 
+/* Snapshot of a ModelInstance created by fmi2GetFMUstate.
+ * All values are stored by value in one flat byte buffer, so the
+ * serialized form is just a small header followed by data. */
+typedef struct {
+  size_t capacity;  /* number of allocated bytes in data */
+  size_t size;      /* number of used bytes in data */
+  fmi2Byte *data;
+} ModelInstanceSnapshot;
+
 /* reset alignment policy to the one set before reading this file */
 #if defined _MSC_VER || defined __GNUC__
 #pragma pack(pop)
@@ -0,0 +1,256 @@
+#!/usr/bin/env python3
+"""
+Runs the benchmark models listed in benchmarks.json through all phases
+(omc front end, back end, code generation; C compilation; simulation and
+result writing) with pinned flags and collects the timers into a history
+file with one JSON record per benchmark and run of this script.
+
+Collected metrics (times in seconds, memory in bytes):
+  omc.<execStat entry>       timers printed by -d=execstat (summed per name)
+  omc.wall, omc.peakRSS      the whole omc process
+  compile.wall, compile.peakRSS
+                             make -j<jobs> on the generated makefile, ccache disabled
+  simulation.<timer>         timers printed by -lv=LOG_STATS, e.g.
+                             simulation.creating output-file
+  simulation.wall, simulation.peakRSS
+
+Every benchmark is run --repeat times. The median of the samples is
+compared against the stored baseline (see --update-baseline); a metric is
+flagged as regression if it exceeds
+
+  baseline median + max(rel * baseline median, k * 1.4826 * baseline MAD, floor)
+
+where MAD is the median absolute deviation of the baseline samples (a robust
+estimate of the standard deviation), rel is --rel-threshold, k is --sigma and
+floor is --min-time (times) or 0 (memory). Timers with a baseline median
+below --min-time are too noisy to be compared and are only recorded.
+
+The exit code is 1 if a regression was found or a benchmark failed.
+
+Needs a POSIX system (peak RSS is read from os.wait4).
+
+Example:
+  ./runBenchmarks.py --omc ../../../build/bin/omc --repeat 5 --update-baseline
+  ./runBenchmarks.py --omc ../../../build/bin/omc --repeat 5 EngineV6
+"""
+
+import argparse
+import datetime
+import json
+import os
+import platform
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import threading
+import time
+
+execStatRe = re.compile(r"Performance of ([^:]*): time ([0-9.eE+-]+)/")
+# nested messages of a stream start with "|" instead of the stream name
+logStatsRe = re.compile(r"^[^|]*\|[^|]*\|[\s|]*([0-9.eE+-]+)s\s+(?:\[\s*[0-9.]+%\]\s+)?(.*?)\s*$")
+
+def rssBytes(ru):
+  # ru_maxrss is in kilobytes on Linux, in bytes on macOS
+  return ru.ru_maxrss * (1 if sys.platform == "darwin" else 1024)
+
+def run(cmd, cwd, logFile, timeout, env=None):
+  """Runs cmd, writes the output to logFile and returns (wait status, wall time, peak RSS)"""
+  with open(logFile, "w") as log:
+    start = time.time()
+    p = subprocess.Popen(cmd, cwd=cwd, stdout=log, stderr=subprocess.STDOUT, env=env)
+    timer = threading.Timer(timeout, p.kill)
+    timer.start()
+    try:
+      _, status, ru = os.wait4(p.pid, 0)
+    finally:
+      timer.cancel()
+    wall = time.time() - start
+  return status, wall, rssBytes(ru)
+
+def addTimer(metrics, name, value):
+  metrics[name] = metrics.get(name, 0.0) + value
+
+def mosString(s):
+  return '"%s"' % s.replace("\\", "\\\\").replace('"', '\\"')
+
+def runBenchmark(bench, args, workDir):
+  """Runs all phases of one benchmark once and returns the metrics"""
+  metrics = {}
+  prefix = "bench"
+  if os.path.isdir(workDir):
+    shutil.rmtree(workDir)
+  os.makedirs(workDir)
+
+  script = ["setCommandLineOptions(%s); getErrorString();" % mosString(bench["omcFlags"])]
+  for lib in bench["libraries"]:
+    name, version = (lib, None) if isinstance(lib, str) else lib
+    script.append("loadModel(%s%s); getErrorString();" % (name, ', {"%s"}' % version if version else ""))
+  for f in bench["files"]:
+    script.append("loadFile(%s); getErrorString();" % mosString(os.path.join(args.dir, f)))
+  translateArgs = (", " + bench["translateArgs"]) if bench["translateArgs"] else ""
+  script.append('translateModel(%s, fileNamePrefix="%s"%s); getErrorString();' % (bench["model"], prefix, translateArgs))
+  with open(os.path.join(workDir, "bench.mos"), "w") as mos:
+    mos.write("\n".join(script) + "\n")
+
+  # front end, back end and code generation
+  log = os.path.join(workDir, "omc.log")
+  status, wall, rss = run([args.omc, "bench.mos"], workDir, log, args.timeout)
+  with open(log) as fin:
+    for line in fin:
+      res = execStatRe.search(line)
+      if res:
+        addTimer(metrics, "omc." + res.group(1).strip(), float(res.group(2)))
+  metrics["omc.wall"] = wall
+  metrics["omc.peakRSS"] = rss
+  if status != 0 or not os.path.exists(os.path.join(workDir, prefix + ".makefile")):
+    raise Exception("omc failed, see %s" % log)
+
+  # C compilation, ccache disabled to measure the compiler and not the cache
+  log = os.path.join(workDir, "compile.log")
+  status, wall, rss = run(["make", "-j%d" % args.jobs, "-f", prefix + ".makefile", "CCACHE="], workDir, log, args.timeout)
+  metrics["compile.wall"] = wall
+  metrics["compile.peakRSS"] = rss
+  if status != 0:
+    raise Exception("compilation failed, see %s" % log)
+
+  if not bench["simulate"]:
+    return metrics
+
+  # simulation and result writing
+  log = os.path.join(workDir, "simulation.log")
+  status, wall, rss = run([os.path.join(workDir, prefix)] + bench["simFlags"].split(), workDir, log, args.timeout)
+  with open(log) as fin:
+    inStats = False
+    for line in fin:
+      if not line.startswith("|"):
+        inStats = line.startswith("LOG_STATS")
+      res = inStats and logStatsRe.search(line)
+      if res:
+        addTimer(metrics, "simulation." + res.group(2), float(res.group(1)))
+  metrics["simulation.wall"] = wall
+  metrics["simulation.peakRSS"] = rss
+  if status != 0:
+    raise Exception("simulation failed, see %s" % log)
+  return metrics
+
+def summarize(samples):
+  med = statistics.median(samples)
+  return {"median": med, "mad": statistics.median([abs(s - med) for s in samples]), "n": len(samples)}
+
+def compare(name, samples, base, args):
+  """Returns a message if the metric regressed compared to the baseline"""
+  isMemory = name.endswith("peakRSS")
+  floor = 0.0 if isMemory else args.min_time
+  if not isMemory and base["median"] < args.min_time:
+    return None
+  med = statistics.median(samples)
+  limit = base["median"] + max(args.rel_threshold * base["median"], args.sigma * 1.4826 * base["mad"], floor)
+  if med > limit:
+    unit = "B" if isMemory else "s"
+    return "%s: %.4g%s, baseline %.4g%s (limit %.4g%s, +%.1f%%)" % (name, med, unit, base["median"], unit, limit, unit, 100.0 * (med / base["median"] - 1.0) if base["median"] else 0.0)
+  return None
+
+def omcVersion(omc):
+  try:
+    return subprocess.check_output([omc, "--version"], universal_newlines=True).strip()
+  except Exception:
+    return "unknown"
+
+def main():
+  here = os.path.dirname(os.path.abspath(__file__))
+  parser = argparse.ArgumentParser(description="Runs the OpenModelica benchmark models and checks for timing regressions.")
+  parser.add_argument("benchmarks", nargs="*", help="names of the benchmarks to run (default: all)")
+  parser.add_argument("--omc", default="omc", help="omc executable")
+  parser.add_argument("--config", default=os.path.join(here, "benchmarks.json"), help="list of benchmarks and their pinned flags")
+  parser.add_argument("--dir", default=here, help="directory of the model files")
+  parser.add_argument("--workdir", default="benchmark-work", help="directory the models are translated and simulated in")
+  parser.add_argument("--history", default="benchmarks-history.jsonl", help="file the results are appended to")
+  parser.add_argument("--baseline", default="benchmarks-baseline.json", help="baseline to check for regressions")
+  parser.add_argument("--update-baseline", action="store_true", help="store the results of this run as new baseline")
+  parser.add_argument("--repeat", type=int, default=3, help="number of runs of every benchmark")
+  parser.add_argument("--jobs", type=int, default=1, help="parallel make jobs for the C compilation")
+  parser.add_argument("--timeout", type=float, default=3600, help="timeout in seconds for every phase")
+  parser.add_argument("--rel-threshold", type=float, default=0.10, help="relative slowdown that is always tolerated")
+  parser.add_argument("--sigma", type=float, default=3.0, help="tolerated slowdown in robust standard deviations of the baseline")
+  parser.add_argument("--min-time", type=float, default=0.05, help="timers below this (in seconds) are not compared")
+  args = parser.parse_args()
+  args.dir = os.path.abspath(args.dir)
+  args.workdir = os.path.abspath(args.workdir)
+
+  with open(args.config) as fin:
+    config = json.load(fin)
+  benchmarks = []
+  for b in config["benchmarks"]:
+    bench = dict(config.get("defaults", {}))
+    bench.update(b)
+    if not args.benchmarks or bench["name"] in args.benchmarks:
+      benchmarks.append(bench)
+  unknown = set(args.benchmarks) - set(b["name"] for b in benchmarks)
+  if unknown:
+    parser.error("unknown benchmarks: %s" % ", ".join(sorted(unknown)))
+
+  baseline = {}
+  if os.path.exists(args.baseline):
+    with open(args.baseline) as fin:
+      baseline = json.load(fin)
+  elif not args.update_baseline:
+    print("No baseline %s, only recording the results" % args.baseline)
+
+  runInfo = {
+    "date": datetime.datetime.now().isoformat(timespec="seconds"),
+    "omc": omcVersion(args.omc),
+    "host": platform.node(),
+    "platform": platform.platform(),
+    "cpus": os.cpu_count(),
+    "jobs": args.jobs,
+  }
+  failed = False
+  regressions = []
+  for bench in benchmarks:
+    name = bench["name"]
+    samples = {}
+    error = None
+    for i in range(args.repeat):
+      print("%s: run %d/%d" % (name, i + 1, args.repeat), flush=True)
+      try:
+        metrics = runBenchmark(bench, args, os.path.join(args.workdir, name))
+      except Exception as e:
+        error = str(e)
+        break
+      for m, v in metrics.items():
+        samples.setdefault(m, []).append(v)
+    record = dict(runInfo)
+    record.update({"benchmark": name, "model": bench["model"], "omcFlags": bench["omcFlags"], "simFlags": bench["simFlags"] if bench["simulate"] else None})
+    if error:
+      print("%s: FAILED: %s" % (name, error))
+      record["error"] = error
+      failed = True
+    else:
+      record["samples"] = samples
+      record["summary"] = dict((m, summarize(s)) for m, s in samples.items())
+      for m in sorted(baseline.get(name, {})):
+        if m not in samples:
+          continue
+        msg = compare(m, samples[m], baseline[name][m], args)
+        if msg:
+          regressions.append("%s: %s" % (name, msg))
+      if args.update_baseline:
+        baseline[name] = record["summary"]
+    with open(args.history, "a") as fout:
+      fout.write(json.dumps(record, sort_keys=True) + "\n")
+
+  if args.update_baseline:
+    with open(args.baseline, "w") as fout:
+      json.dump(baseline, fout, indent=2, sort_keys=True)
+      fout.write("\n")
+    print("Updated baseline %s" % args.baseline)
+  for r in regressions:
+    print("REGRESSION %s" % r)
+  if not (regressions or failed) and baseline and not args.update_baseline:
+    print("No regressions")
+  return 1 if (failed or regressions) else 0
+
+if __name__ == "__main__":
+  sys.exit(main())
@@ -0,0 +1,472 @@
+/*
+ * Small FMI 2.0 co-simulation driver used by the tests in this directory to
+ * call functions that the FMU importers do not expose.
+ *
+ *   fmuTestDriver <test> <unzipped fmu directory> <model identifier> [args]
+ *
+ * Real variables are given by their names in the model description.
+ *
+ * state <var...> Simulates to 0.5, gets and serializes the FMU state,
+ *                simulates to 1, restores the de-serialized state into a new
+ *                FMU state and simulates to 1 again. Prints whether the
+ *                variables <var...> are equal at the end of both runs.
+ *
+ * dirder <known var...> -- <unknown var...>
+ *                Prints the Jacobian of the unknowns with respect to the knowns
+ *                after initialization: twice with unit seeds, once with seeds
+ *                of 2 and once for all knowns at once with the seeds 1, 2, ...
+ *                Then does one step of 0.1 and prints it with unit seeds
+ *                again. Also prints when the FMU evaluates the full Jacobian.
+ *
+ * simulate <h> <steps> <arg...>
+ *                Simulates <steps> communication steps of size <h>. An
+ *                argument <k>:<var>=<value> sets the input <var> before step
+ *                <k>, any other argument is a variable printed at the end.
+ *                Also prints the number of event iterations of the FMU.
+ *
+ * bench <repetitions> <var...>
+ *                Simulates to 0.5 and measures the mean time of getting,
+ *                setting, serializing and de-serializing the FMU state over
+ *                <repetitions> calls each. Prints the serialized size and the
+ *                times, then simulates on, restores the de-serialized state
+ *                and prints whether the variables <var...> are restored.
+ */
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef void* fmi2Component;
+typedef void* fmi2ComponentEnvironment;
+typedef void* fmi2FMUstate;
+typedef unsigned int fmi2ValueReference;
+typedef double fmi2Real;
+typedef int fmi2Integer;
+typedef int fmi2Boolean;
+typedef char fmi2Byte;
+typedef const char* fmi2String;
+typedef enum { fmi2OK, fmi2Warning, fmi2Discard, fmi2Error, fmi2Fatal, fmi2Pending } fmi2Status;
+typedef enum { fmi2ModelExchange, fmi2CoSimulation } fmi2Type;
+
+typedef struct {
+  void (*logger)(fmi2ComponentEnvironment, fmi2String, fmi2Status, fmi2String, fmi2String, ...);
+  void* (*allocateMemory)(size_t, size_t);
+  void (*freeMemory)(void*);
+  void (*stepFinished)(fmi2ComponentEnvironment, fmi2Status);
+  fmi2ComponentEnvironment componentEnvironment;
+} fmi2CallbackFunctions;
+
+static void* lib;
+
+static void* getFunction(const char *name)
+{
+  void *f = dlsym(lib, name);
+  if (!f) {
+    printf("missing function %s\n", name);
+    exit(1);
+  }
+  return f;
+}
+
+#define FMI2(name) ((name##TYPE*)getFunction(#name))
+
+typedef fmi2Component fmi2InstantiateTYPE(fmi2String, fmi2Type, fmi2String, fmi2String, const fmi2CallbackFunctions*, fmi2Boolean, fmi2Boolean);
+typedef void fmi2FreeInstanceTYPE(fmi2Component);
+typedef fmi2Status fmi2SetupExperimentTYPE(fmi2Component, fmi2Boolean, fmi2Real, fmi2Real, fmi2Boolean, fmi2Real);
+typedef fmi2Status fmi2EnterInitializationModeTYPE(fmi2Component);
+typedef fmi2Status fmi2ExitInitializationModeTYPE(fmi2Component);
+typedef fmi2Status fmi2TerminateTYPE(fmi2Component);
+typedef fmi2Status fmi2DoStepTYPE(fmi2Component, fmi2Real, fmi2Real, fmi2Boolean);
+typedef fmi2Status fmi2GetRealTYPE(fmi2Component, const fmi2ValueReference[], size_t, fmi2Real[]);
+typedef fmi2Status fmi2SetRealTYPE(fmi2Component, const fmi2ValueReference[], size_t, const fmi2Real[]);
+typedef fmi2Status fmi2GetFMUstateTYPE(fmi2Component, fmi2FMUstate*);
+typedef fmi2Status fmi2SetFMUstateTYPE(fmi2Component, fmi2FMUstate);
+typedef fmi2Status fmi2FreeFMUstateTYPE(fmi2Component, fmi2FMUstate*);
+typedef fmi2Status fmi2SerializedFMUstateSizeTYPE(fmi2Component, fmi2FMUstate, size_t*);
+typedef fmi2Status fmi2SerializeFMUstateTYPE(fmi2Component, fmi2FMUstate, fmi2Byte[], size_t);
+typedef fmi2Status fmi2DeSerializeFMUstateTYPE(fmi2Component, const fmi2Byte[], size_t, fmi2FMUstate*);
+typedef fmi2Status fmi2SetDebugLoggingTYPE(fmi2Component, fmi2Boolean, size_t, const fmi2String[]);
+typedef fmi2Status fmi2GetDirectionalDerivativeTYPE(fmi2Component, const fmi2ValueReference[], size_t, const fmi2ValueReference[], size_t, const fmi2Real[], fmi2Real[]);
+
+/* messages below fmi2Error are only printed if they start with logFilter */
+static const char *logFilter = NULL;
+static int eventIterations = 0;
+static char *modelDescription;
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  if (0 == strcmp(message, "fmi2EnterEventMode")) {
+    eventIterations++;
+  }
+  if (status < fmi2Error && (!logFilter || strncmp(message, logFilter, strlen(logFilter)) != 0)) {
+    return;
+  }
+  va_start(args, message);
+  printf("%s: ", category);
+  vprintf(message, args);
+  printf("\n");
+  va_end(args);
+}
+
+#define CHECK(call) do { if ((call) != fmi2OK) { printf("%s failed\n", #call); exit(1); } } while (0)
+
+/* reads the model description and returns its guid attribute */
+static char* readModelDescription(const char *dir)
+{
+  char fileName[PATH_MAX], *buffer, *start, *end, *guid;
+  FILE *file;
+  long size;
+
+  snprintf(fileName, sizeof(fileName), "%s/modelDescription.xml", dir);
+  file = fopen(fileName, "rb");
+  if (!file) {
+    printf("could not open %s\n", fileName);
+    exit(1);
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  buffer = (char*) calloc(size + 1, 1);
+  if (fread(buffer, 1, size, file) != (size_t) size) {
+    printf("could not read %s\n", fileName);
+    exit(1);
+  }
+  fclose(file);
+  modelDescription = buffer;
+  start = strstr(buffer, "guid=\"");
+  if (!start) {
+    printf("no guid in %s\n", fileName);
+    exit(1);
+  }
+  start += 6;
+  end = strchr(start, '"');
+  guid = (char*) calloc(end - start + 1, 1);
+  memcpy(guid, start, end - start);
+  return guid;
+}
+
+/* looks up the value reference of a variable in the model description */
+static fmi2ValueReference valueReference(const char *name)
+{
+  char pattern[256];
+  const char *p = modelDescription;
+
+  snprintf(pattern, sizeof(pattern), "name=\"%s\"", name);
+  while ((p = strstr(p, pattern)) && p[-1] != ' ' && p[-1] != '\n') {
+    p++;
+  }
+  if (!p || !(p = strstr(p, "valueReference=\""))) {
+    printf("unknown variable %s\n", name);
+    exit(1);
+  }
+  return (fmi2ValueReference) strtoul(p + 16, NULL, 10);
+}
+
+static fmi2Component instantiate(const char *dir, const char *modelIdentifier)
+{
+  static fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+  char libName[PATH_MAX], resources[PATH_MAX + 32], absDir[PATH_MAX];
+  fmi2Component c;
+
+  snprintf(libName, sizeof(libName), "%s/binaries/%s/%s.so", dir,
+           sizeof(void*) == 8 ? "linux64" : "linux32", modelIdentifier);
+  lib = dlopen(libName, RTLD_NOW | RTLD_LOCAL);
+  if (!lib) {
+    printf("could not load %s: %s\n", libName, dlerror());
+    exit(1);
+  }
+  if (!realpath(dir, absDir)) {
+    printf("could not resolve %s\n", dir);
+    exit(1);
+  }
+  snprintf(resources, sizeof(resources), "file://%s/resources", absDir);
+  c = FMI2(fmi2Instantiate)(modelIdentifier, fmi2CoSimulation, readModelDescription(dir), resources, &callbacks, 0, 0);
+  if (!c) {
+    printf("fmi2Instantiate failed\n");
+    exit(1);
+  }
+  return c;
+}
+
+static void initialize(fmi2Component c)
+{
+  CHECK(FMI2(fmi2SetupExperiment)(c, 0, 0.0, 0.0, 0, 0.0));
+  CHECK(FMI2(fmi2EnterInitializationMode)(c));
+  CHECK(FMI2(fmi2ExitInitializationMode)(c));
+}
+
+/* simulates from step first to step last with communication steps of h;
+ * the time is computed from the step number, so a run repeated from a
+ * restored FMU state uses exactly the same communication points */
+static void simulate(fmi2Component c, int first, int last, double h)
+{
+  int k;
+  for (k = first; k < last; k++) {
+    CHECK(FMI2(fmi2DoStep)(c, k*h, h, 0));
+  }
+}
+
+static void printValues(const char *label, size_t n, const fmi2Real *values)
+{
+  size_t i;
+  printf("%s:", label);
+  for (i = 0; i < n; i++) {
+    printf(" %.6g", values[i]);
+  }
+  printf("\n");
+}
+
+static int testState(fmi2Component c, int argc, char **argv)
+{
+  size_t n = argc, i, size;
+  fmi2ValueReference *vr = (fmi2ValueReference*) calloc(n, sizeof(fmi2ValueReference));
+  fmi2Real *first = (fmi2Real*) calloc(n, sizeof(fmi2Real));
+  fmi2Real *second = (fmi2Real*) calloc(n, sizeof(fmi2Real));
+  fmi2FMUstate state = NULL, restored;
+  fmi2Byte *buffer;
+  int equal = 1;
+
+  for (i = 0; i < n; i++) {
+    vr[i] = valueReference(argv[i]);
+  }
+
+  simulate(c, 0, 50, 0.01);
+  CHECK(FMI2(fmi2GetFMUstate)(c, &state));
+  CHECK(FMI2(fmi2SerializedFMUstateSize)(c, state, &size));
+  buffer = (fmi2Byte*) malloc(size);
+  CHECK(FMI2(fmi2SerializeFMUstate)(c, state, buffer, size));
+  CHECK(FMI2(fmi2FreeFMUstate)(c, &state));
+
+  simulate(c, 50, 100, 0.01);
+  CHECK(FMI2(fmi2GetReal)(c, vr, n, first));
+
+  /* the FMU state argument of fmi2DeSerializeFMUstate is only an output */
+  restored = (fmi2FMUstate) buffer;
+  CHECK(FMI2(fmi2DeSerializeFMUstate)(c, buffer, size, &restored));
+  free(buffer);
+  CHECK(FMI2(fmi2SetFMUstate)(c, restored));
+  CHECK(FMI2(fmi2FreeFMUstate)(c, &restored));
+
+  simulate(c, 50, 100, 0.01);
+  CHECK(FMI2(fmi2GetReal)(c, vr, n, second));
+
+  for (i = 0; i < n; i++) {
+    equal = equal && first[i] == second[i];
+  }
+  printf("equal: %s\n", equal ? "true" : "false");
+  if (!equal) {
+    printValues("first run", n, first);
+    printValues("second run", n, second);
+  }
+  return !equal;
+}
+
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static void printTime(const char *label, double start, int repetitions)
+{
+  printf("%-12s %10.3f us\n", label, 1e6*(seconds() - start)/repetitions);
+}
+
+static int testBenchmark(fmi2Component c, int argc, char **argv)
+{
+  int repetitions = atoi(argv[0]), k;
+  size_t n = argc - 1, i, size;
+  fmi2ValueReference *vr = (fmi2ValueReference*) calloc(n, sizeof(fmi2ValueReference));
+  fmi2Real *saved = (fmi2Real*) calloc(n, sizeof(fmi2Real));
+  fmi2Real *restored = (fmi2Real*) calloc(n, sizeof(fmi2Real));
+  fmi2FMUstate state = NULL, copy = NULL;
+  fmi2Byte *buffer;
+  double start;
+  int equal = 1;
+
+  for (i = 0; i < n; i++) {
+    vr[i] = valueReference(argv[i + 1]);
+  }
+
+  simulate(c, 0, 50, 0.01);
+  CHECK(FMI2(fmi2GetReal)(c, vr, n, saved));
+
+  /* the first call allocates the FMU state, the timed ones reuse it */
+  CHECK(FMI2(fmi2GetFMUstate)(c, &state));
+  start = seconds();
+  for (k = 0; k < repetitions; k++) {
+    CHECK(FMI2(fmi2GetFMUstate)(c, &state));
+  }
+  printTime("get:", start, repetitions);
+
+  start = seconds();
+  for (k = 0; k < repetitions; k++) {
+    CHECK(FMI2(fmi2SetFMUstate)(c, state));
+  }
+  printTime("set:", start, repetitions);
+
+  CHECK(FMI2(fmi2SerializedFMUstateSize)(c, state, &size));
+  buffer = (fmi2Byte*) malloc(size);
+  start = seconds();
+  for (k = 0; k < repetitions; k++) {
+    CHECK(FMI2(fmi2SerializedFMUstateSize)(c, state, &size));
+    CHECK(FMI2(fmi2SerializeFMUstate)(c, state, buffer, size));
+  }
+  printTime("serialize:", start, repetitions);
+
+  /* fmi2DeSerializeFMUstate always allocates a new FMU state */
+  start = seconds();
+  for (k = 0; k < repetitions; k++) {
+    CHECK(FMI2(fmi2DeSerializeFMUstate)(c, buffer, size, &copy));
+    CHECK(FMI2(fmi2FreeFMUstate)(c, &copy));
+  }
+  printTime("deserialize:", start, repetitions);
+  printf("size: %lu bytes\n", (unsigned long) size);
+  CHECK(FMI2(fmi2FreeFMUstate)(c, &state));
+
+  simulate(c, 50, 100, 0.01);
+  CHECK(FMI2(fmi2DeSerializeFMUstate)(c, buffer, size, &copy));
+  free(buffer);
+  CHECK(FMI2(fmi2SetFMUstate)(c, copy));
+  CHECK(FMI2(fmi2FreeFMUstate)(c, &copy));
+  CHECK(FMI2(fmi2GetReal)(c, vr, n, restored));
+
+  for (i = 0; i < n; i++) {
+    equal = equal && saved[i] == restored[i];
+  }
+  printf("restored: %s\n", equal ? "true" : "false");
+  if (!equal) {
+    printValues("saved", n, saved);
+    printValues("restored", n, restored);
+  }
+  free(vr);
+  free(saved);
+  free(restored);
+  return !equal;
+}
+
+static void printJacobian(fmi2Component c, const char *label, char **names, const fmi2ValueReference *known, size_t nKnown,
+                          const fmi2ValueReference *unknown, size_t nUnknown, fmi2Real seed)
+{
+  fmi2Real *values = (fmi2Real*) calloc(nUnknown, sizeof(fmi2Real));
+  char column[256];
+  size_t j;
+
+  printf("%s\n", label);
+  for (j = 0; j < nKnown; j++) {
+    CHECK(FMI2(fmi2GetDirectionalDerivative)(c, unknown, nUnknown, known + j, 1, &seed, values));
+    snprintf(column, sizeof(column), "  d/d%s", names[j]);
+    printValues(column, nUnknown, values);
+  }
+  free(values);
+}
+
+static int testDirectionalDerivative(fmi2Component c, int argc, char **argv)
+{
+  static const fmi2String categories[] = {"logFmi2Call"};
+  fmi2ValueReference *known = (fmi2ValueReference*) calloc(argc, sizeof(fmi2ValueReference));
+  fmi2ValueReference *unknown = (fmi2ValueReference*) calloc(argc, sizeof(fmi2ValueReference));
+  fmi2Real *seeds = (fmi2Real*) calloc(argc, sizeof(fmi2Real));
+  fmi2Real *values = (fmi2Real*) calloc(argc, sizeof(fmi2Real));
+  size_t nKnown = 0, nUnknown = 0, j;
+  int i;
+
+  for (i = 0; i < argc && strcmp(argv[i], "--"); i++) {
+    known[nKnown++] = valueReference(argv[i]);
+  }
+  for (i++; i < argc; i++) {
+    unknown[nUnknown++] = valueReference(argv[i]);
+  }
+
+  logFilter = "fmi2GetDirectionalDerivative: full";
+  CHECK(FMI2(fmi2SetDebugLogging)(c, 1, 1, categories));
+
+  /* fmi2GetReal also updates the model at the current point */
+  CHECK(FMI2(fmi2GetReal)(c, known, nKnown, values));
+  printValues("knowns", nKnown, values);
+  printJacobian(c, "unit seeds", argv, known, nKnown, unknown, nUnknown, 1.0);
+  printJacobian(c, "unit seeds again", argv, known, nKnown, unknown, nUnknown, 1.0);
+  printJacobian(c, "seeds of 2", argv, known, nKnown, unknown, nUnknown, 2.0);
+  for (j = 0; j < nKnown; j++) {
+    seeds[j] = j + 1;
+  }
+  CHECK(FMI2(fmi2GetDirectionalDerivative)(c, unknown, nUnknown, known, nKnown, seeds, values));
+  printValues("all seeds", nUnknown, values);
+
+  simulate(c, 0, 1, 0.1);
+  CHECK(FMI2(fmi2GetReal)(c, known, nKnown, values));
+  printValues("knowns after step", nKnown, values);
+  printJacobian(c, "unit seeds after step", argv, known, nKnown, unknown, nUnknown, 1.0);
+
+  free(known);
+  free(unknown);
+  free(seeds);
+  free(values);
+  return 0;
+}
+
+static int testSimulate(fmi2Component c, int argc, char **argv)
+{
+  static const fmi2String categories[] = {"logEvents"};
+  double h = atof(argv[0]);
+  int steps = atoi(argv[1]), k, i;
+  char name[256];
+  fmi2ValueReference vr;
+  fmi2Real value;
+
+  CHECK(FMI2(fmi2SetDebugLogging)(c, 1, 1, categories));
+  for (k = 0; k < steps; k++) {
+    for (i = 2; i < argc; i++) {
+      int step, n;
+      if (2 == sscanf(argv[i], "%d:%255[^=]=%n", &step, name, &n) && step == k) {
+        vr = valueReference(name);
+        value = atof(argv[i] + n);
+        CHECK(FMI2(fmi2SetReal)(c, &vr, 1, &value));
+      }
+    }
+    simulate(c, k, k + 1, h);
+  }
+  for (i = 2; i < argc; i++) {
+    if (!strchr(argv[i], ':')) {
+      vr = valueReference(argv[i]);
+      CHECK(FMI2(fmi2GetReal)(c, &vr, 1, &value));
+      printf("%s: %.4g\n", argv[i], value);
+    }
+  }
+  printf("event iterations: %d\n", eventIterations);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  fmi2Component c;
+  int res;
+
+  if (argc < 4) {
+    printf("usage: %s <test> <fmu directory> <model identifier> [args]\n", argv[0]);
+    return 1;
+  }
+  c = instantiate(argv[2], argv[3]);
+  initialize(c);
+  if (0 == strcmp(argv[1], "state")) {
+    res = testState(c, argc - 4, argv + 4);
+  } else if (0 == strcmp(argv[1], "dirder")) {
+    res = testDirectionalDerivative(c, argc - 4, argv + 4);
+  } else if (0 == strcmp(argv[1], "simulate") && argc >= 6) {
+    res = testSimulate(c, argc - 4, argv + 4);
+  } else if (0 == strcmp(argv[1], "bench") && argc >= 6) {
+    res = testBenchmark(c, argc - 4, argv + 4);
+  } else {
+    printf("unknown test %s\n", argv[1]);
+    return 1;
+  }
+  CHECK(FMI2(fmi2Terminate)(c));
+  FMI2(fmi2FreeInstance)(c);
+  return res;
+}
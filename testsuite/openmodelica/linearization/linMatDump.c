@@ -0,0 +1,117 @@
+/*
+ * Prints the matrices of a linear model written with -l_format=mat.
+ *
+ *   linMatDump <file.mat>
+ *
+ * Reads every MAT v4 matrix of the file (full, sparse and text) and prints
+ * it in the syntax of the Modelica text output (-l_format=mo), so both
+ * formats can be compared.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t type;
+  uint32_t mrows;
+  uint32_t ncols;
+  uint32_t imagf;
+  uint32_t namelen;
+} MHeader_t;
+
+static void printReal(double value)
+{
+  printf("%.16g", value);
+}
+
+/* prints a rows x cols matrix stored column by column */
+static void printMatrix(const double *values, uint32_t rows, uint32_t cols)
+{
+  uint32_t i, j;
+
+  if (rows == 0 || cols == 0) {
+    printf("zeros(%u, %u)", rows, cols);
+    return;
+  }
+  printf("[");
+  for (i = 0; i < rows; i++) {
+    for (j = 0; j < cols; j++) {
+      printReal(values[j*rows + i]);
+      printf(j + 1 < cols ? ", " : "");
+    }
+    printf(i + 1 < rows ? "; " : "");
+  }
+  printf("]");
+}
+
+int main(int argc, char **argv)
+{
+  MHeader_t hdr;
+  char name[256];
+  FILE *file;
+
+  if (argc != 2) {
+    printf("usage: %s <file.mat>\n", argv[0]);
+    return 1;
+  }
+  file = fopen(argv[1], "rb");
+  if (!file) {
+    printf("could not open %s\n", argv[1]);
+    return 1;
+  }
+  while (1 == fread(&hdr, sizeof(MHeader_t), 1, file)) {
+    unsigned int precision = (hdr.type / 10) % 10, matrixType = hdr.type % 10;
+    size_t n = (size_t) hdr.mrows * hdr.ncols, i, j;
+
+    if (hdr.namelen > sizeof(name) || 1 != fread(name, hdr.namelen, 1, file) || hdr.imagf) {
+      printf("invalid matrix header\n");
+      return 1;
+    }
+    if (matrixType == 1 && precision == 5) {
+      /* text: one name per row */
+      unsigned char *chars = (unsigned char*) calloc(n + 1, 1);
+      if (n && 1 != fread(chars, n, 1, file)) {
+        printf("could not read %s\n", name);
+        return 1;
+      }
+      printf("%s = {", name);
+      for (i = 0; i < hdr.mrows; i++) {
+        printf("\"");
+        for (j = 0; j < hdr.ncols && chars[j*hdr.mrows + i]; j++) {
+          printf("%c", chars[j*hdr.mrows + i]);
+        }
+        printf(i + 1 < hdr.mrows ? "\", " : "\"");
+      }
+      printf("}\n");
+      free(chars);
+    } else if (precision == 0) {
+      double *values = (double*) malloc((n + 1) * sizeof(double));
+      if (n && 1 != fread(values, n * sizeof(double), 1, file)) {
+        printf("could not read %s\n", name);
+        return 1;
+      }
+      printf("%s = ", name);
+      if (matrixType == 2) {
+        /* sparse: (nnz+1) x 3 triplets (row, column, value), the last one holds the dimensions */
+        uint32_t nnz = hdr.mrows - 1, rows = (uint32_t) values[nnz], cols = (uint32_t) values[hdr.mrows + nnz];
+        double *dense = (double*) calloc((size_t) rows * cols + 1, sizeof(double));
+        for (i = 0; i < nnz; i++) {
+          dense[((size_t) values[hdr.mrows + i] - 1) * rows + (size_t) values[i] - 1] = values[2*hdr.mrows + i];
+        }
+        printMatrix(dense, rows, cols);
+        free(dense);
+      } else {
+        printMatrix(values, hdr.mrows, hdr.ncols);
+      }
+      printf("\n");
+      free(values);
+    } else {
+      printf("unsupported matrix type %u of %s\n", hdr.type, name);
+      return 1;
+    }
+  }
+  fclose(file);
+  return 0;
+}
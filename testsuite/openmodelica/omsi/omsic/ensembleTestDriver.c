@@ -0,0 +1,261 @@
+/*
+ * Small driver for the ensemble functions of an OMSIC OMSU.
+ *
+ *   ensembleTestDriver <unzipped fmu directory> <model identifier> <n> <h> <steps> <var...>
+ *
+ * Instantiates the OMSU 2*<n> times as model exchange FMU and scales the
+ * start states of the instances k and <n>+k with 1+k. The first <n>
+ * instances are simulated as one ensemble with omsu_ensemble_explicit_euler_step,
+ * the others one by one with the explicit Euler method through the FMI 2.0
+ * functions. Prints the variables <var...> of the ensemble at the end and
+ * whether they are equal to the ones of the single instance runs.
+ * Also checks that an ensemble with a NULL instance is rejected.
+ */
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void* fmi2Component;
+typedef void* fmi2ComponentEnvironment;
+typedef unsigned int fmi2ValueReference;
+typedef double fmi2Real;
+typedef int fmi2Boolean;
+typedef const char* fmi2String;
+typedef enum { fmi2OK, fmi2Warning, fmi2Discard, fmi2Error, fmi2Fatal, fmi2Pending } fmi2Status;
+typedef enum { fmi2ModelExchange, fmi2CoSimulation } fmi2Type;
+
+typedef struct {
+  void (*logger)(fmi2ComponentEnvironment, fmi2String, fmi2Status, fmi2String, fmi2String, ...);
+  void* (*allocateMemory)(size_t, size_t);
+  void (*freeMemory)(void*);
+  void (*stepFinished)(fmi2ComponentEnvironment, fmi2Status);
+  fmi2ComponentEnvironment componentEnvironment;
+} fmi2CallbackFunctions;
+
+static void* lib;
+
+static void* getFunction(const char *name)
+{
+  void *f = dlsym(lib, name);
+  if (!f) {
+    printf("missing function %s\n", name);
+    exit(1);
+  }
+  return f;
+}
+
+#define FMI2(name) ((name##TYPE*)getFunction(#name))
+
+typedef fmi2Component fmi2InstantiateTYPE(fmi2String, fmi2Type, fmi2String, fmi2String, const fmi2CallbackFunctions*, fmi2Boolean, fmi2Boolean);
+typedef fmi2Status fmi2SetupExperimentTYPE(fmi2Component, fmi2Boolean, fmi2Real, fmi2Real, fmi2Boolean, fmi2Real);
+typedef fmi2Status fmi2EnterInitializationModeTYPE(fmi2Component);
+typedef fmi2Status fmi2ExitInitializationModeTYPE(fmi2Component);
+typedef fmi2Status fmi2EnterContinuousTimeModeTYPE(fmi2Component);
+typedef fmi2Status fmi2GetRealTYPE(fmi2Component, const fmi2ValueReference[], size_t, fmi2Real[]);
+typedef fmi2Status fmi2SetTimeTYPE(fmi2Component, fmi2Real);
+typedef fmi2Status fmi2GetContinuousStatesTYPE(fmi2Component, fmi2Real[], size_t);
+typedef fmi2Status fmi2SetContinuousStatesTYPE(fmi2Component, const fmi2Real[], size_t);
+typedef fmi2Status fmi2GetDerivativesTYPE(fmi2Component, fmi2Real[], size_t);
+
+/* omsi_status and omsi_unsigned_int of the OMSI runtime */
+typedef void* omsu_new_ensembleTYPE(fmi2Component*, unsigned int);
+typedef void omsu_free_ensembleTYPE(void*);
+typedef int omsu_ensemble_get_realTYPE(void*, const unsigned int[], unsigned int, double[]);
+typedef int omsu_ensemble_get_continuous_statesTYPE(void*, double[]);
+typedef int omsu_ensemble_set_continuous_statesTYPE(void*, const double[]);
+typedef int omsu_ensemble_explicit_euler_stepTYPE(void*, double, double[], double[]);
+
+static char *modelDescription;
+
+/* errors are expected from the negative test, they are not printed */
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+}
+
+#define CHECK(call) do { if ((call) != fmi2OK) { printf("%s failed\n", #call); exit(1); } } while (0)
+
+/* reads the model description and returns its guid attribute */
+static char* readModelDescription(const char *dir)
+{
+  char fileName[PATH_MAX], *buffer, *start, *end, *guid;
+  FILE *file;
+  long size;
+
+  snprintf(fileName, sizeof(fileName), "%s/modelDescription.xml", dir);
+  file = fopen(fileName, "rb");
+  if (!file) {
+    printf("could not open %s\n", fileName);
+    exit(1);
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  buffer = (char*) calloc(size + 1, 1);
+  if (fread(buffer, 1, size, file) != (size_t) size) {
+    printf("could not read %s\n", fileName);
+    exit(1);
+  }
+  fclose(file);
+  modelDescription = buffer;
+  start = strstr(buffer, "guid=\"");
+  if (!start) {
+    printf("no guid in %s\n", fileName);
+    exit(1);
+  }
+  start += 6;
+  end = strchr(start, '"');
+  guid = (char*) calloc(end - start + 1, 1);
+  memcpy(guid, start, end - start);
+  return guid;
+}
+
+/* looks up the value reference of a variable in the model description */
+static fmi2ValueReference valueReference(const char *name)
+{
+  char pattern[256];
+  const char *p = modelDescription;
+
+  snprintf(pattern, sizeof(pattern), "name=\"%s\"", name);
+  while ((p = strstr(p, pattern)) && p[-1] != ' ' && p[-1] != '\n') {
+    p++;
+  }
+  if (!p || !(p = strstr(p, "valueReference=\""))) {
+    printf("unknown variable %s\n", name);
+    exit(1);
+  }
+  return (fmi2ValueReference) strtoul(p + 16, NULL, 10);
+}
+
+/* counts the continuous states, every state has a derivative attribute */
+static size_t numberOfStates(void)
+{
+  size_t n = 0;
+  const char *p = modelDescription;
+
+  while ((p = strstr(p, "derivative=\""))) {
+    n++;
+    p++;
+  }
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  static fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+  char libName[PATH_MAX], resources[PATH_MAX + 32], absDir[PATH_MAX];
+  const char *dir, *modelIdentifier, *guid;
+  fmi2Component *c;
+  fmi2ValueReference *vr;
+  fmi2Real *x, *der, *values, *single, time, h;
+  size_t n, nx, nvr, i, k;
+  int steps, step, equal = 1;
+  void *ensemble;
+
+  if (argc < 7) {
+    printf("usage: %s <unzipped fmu directory> <model identifier> <n> <h> <steps> <var...>\n", argv[0]);
+    return 1;
+  }
+  dir = argv[1];
+  modelIdentifier = argv[2];
+  n = (size_t) atoi(argv[3]);
+  h = atof(argv[4]);
+  steps = atoi(argv[5]);
+  nvr = argc - 6;
+
+  snprintf(libName, sizeof(libName), "%s/binaries/%s/%s.so", dir,
+           sizeof(void*) == 8 ? "linux64" : "linux32", modelIdentifier);
+  lib = dlopen(libName, RTLD_NOW | RTLD_LOCAL);
+  if (!lib) {
+    printf("could not load %s: %s\n", libName, dlerror());
+    return 1;
+  }
+  if (!realpath(dir, absDir)) {
+    printf("could not resolve %s\n", dir);
+    return 1;
+  }
+  snprintf(resources, sizeof(resources), "file://%s/resources", absDir);
+  guid = readModelDescription(dir);
+  nx = numberOfStates();
+
+  c = (fmi2Component*) calloc(2*n, sizeof(fmi2Component));
+  x = (fmi2Real*) calloc(nx*n, sizeof(fmi2Real));
+  der = (fmi2Real*) calloc(nx*n, sizeof(fmi2Real));
+  single = (fmi2Real*) calloc(nx, sizeof(fmi2Real));
+  vr = (fmi2ValueReference*) calloc(nvr, sizeof(fmi2ValueReference));
+  values = (fmi2Real*) calloc(nvr*n, sizeof(fmi2Real));
+  for (i = 0; i < nvr; i++) {
+    vr[i] = valueReference(argv[6 + i]);
+  }
+
+  for (k = 0; k < 2*n; k++) {
+    c[k] = FMI2(fmi2Instantiate)(modelIdentifier, fmi2ModelExchange, guid, resources, &callbacks, 0, 0);
+    if (!c[k]) {
+      printf("fmi2Instantiate failed\n");
+      return 1;
+    }
+    CHECK(FMI2(fmi2SetupExperiment)(c[k], 0, 0.0, 0.0, 0, 0.0));
+    CHECK(FMI2(fmi2EnterInitializationMode)(c[k]));
+    CHECK(FMI2(fmi2ExitInitializationMode)(c[k]));
+    CHECK(FMI2(fmi2EnterContinuousTimeMode)(c[k]));
+  }
+
+  /* ensemble of the instances 0..n-1, states are stored x[i*n + k] */
+  ensemble = FMI2(omsu_new_ensemble)(c, n);
+  if (!ensemble) {
+    printf("omsu_new_ensemble failed\n");
+    return 1;
+  }
+  CHECK(FMI2(omsu_ensemble_get_continuous_states)(ensemble, x));
+  for (i = 0; i < nx; i++) {
+    for (k = 0; k < n; k++) {
+      x[i*n + k] *= 1 + k;
+    }
+  }
+  CHECK(FMI2(omsu_ensemble_set_continuous_states)(ensemble, x));
+  for (step = 0; step < steps; step++) {
+    CHECK(FMI2(omsu_ensemble_explicit_euler_step)(ensemble, h, x, der));
+  }
+  CHECK(FMI2(omsu_ensemble_get_real)(ensemble, vr, nvr, values));
+
+  /* the same runs instance by instance */
+  for (k = 0; k < n; k++) {
+    CHECK(FMI2(fmi2GetContinuousStates)(c[n + k], single, nx));
+    for (i = 0; i < nx; i++) {
+      single[i] *= 1 + k;
+    }
+    CHECK(FMI2(fmi2SetContinuousStates)(c[n + k], single, nx));
+    time = 0.0;
+    for (step = 0; step < steps; step++) {
+      CHECK(FMI2(fmi2GetDerivatives)(c[n + k], der, nx));
+      for (i = 0; i < nx; i++) {
+        single[i] += h * der[i];
+      }
+      time += h;
+      CHECK(FMI2(fmi2SetTime)(c[n + k], time));
+      CHECK(FMI2(fmi2SetContinuousStates)(c[n + k], single, nx));
+    }
+    for (i = 0; i < nvr; i++) {
+      fmi2Real value;
+      CHECK(FMI2(fmi2GetReal)(c[n + k], &vr[i], 1, &value));
+      equal = equal && value == values[i*n + k];
+    }
+  }
+
+  for (i = 0; i < nvr; i++) {
+    printf("%s:", argv[6 + i]);
+    for (k = 0; k < n; k++) {
+      printf(" %.4g", values[i*n + k]);
+    }
+    printf("\n");
+  }
+  printf("equal: %s\n", equal ? "true" : "false");
+
+  FMI2(omsu_free_ensemble)(ensemble);
+  c[1] = NULL;
+  ensemble = FMI2(omsu_new_ensemble)(c, n);
+  printf("NULL instance rejected: %s\n", ensemble ? "false" : "true");
+  return 0;
+}